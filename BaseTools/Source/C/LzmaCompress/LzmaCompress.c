@@ -27,6 +27,17 @@
 
 #define LZMA_HEADER_SIZE (LZMA_PROPS_SIZE + 8)
 
+//
+// Chunked LZMA stream, see LzmaDecompressLibInternal.h in LzmaCustomDecompressLib:
+//   UINT32 Signature, UINT32 ChunkCount, UINT64 DecodedSize,
+//   UINT32 ChunkSize, UINT32 Reserved, UINT32 ChunkStreamSize[ChunkCount],
+// followed by ChunkCount independent LZMA streams with a regular LZMA header.
+//
+#define LZMA_CHUNKED_SIGNATURE          0x4B435A4C    // "LZCK"
+#define LZMA_CHUNKED_HEADER_SIZE        24
+#define LZMA_CHUNKED_DEFAULT_CHUNK_SIZE (1 << 20)
+#define LZMA_CHUNKED_MIN_CHUNK_SIZE     (1 << 12)
+
 typedef enum {
   NoConverter,
   X86Converter,
@@ -44,6 +55,8 @@ static CONVERTER_TYPE mConType = NoConverter;
 
 UINT64 mDictionarySize = 28;
 UINT64 mCompressionMode = 2;
+UINT64 mNumThreads = 0;
+UINT64 mChunkSize = 0;
 
 #define UTILITY_NAME "LzmaCompress"
 #define UTILITY_MAJOR_VERSION 0
@@ -60,11 +73,17 @@ void PrintHelp(char *buffer)
              "  -d: decode file\n"
              "  -o FileName, --output FileName: specify the output filename\n"
              "  --f86: enable converter for x86 code\n"
+             "  --chunked: split the data into independently compressed chunks\n"
+             "             which can be decoded in parallel\n"
+             "  --chunk-size Size: decoded size of each chunk, implies --chunked,\n"
+             "                     default: 0x100000 (1MB)\n"
              "  -v, --verbose: increase output messages\n"
              "  -q, --quiet: reduce output messages\n"
              "  --debug [0-9]: set debug level\n"
              "  -a: set compression mode 0 = fast, 1 = normal, default: 1 (normal)\n"
              "  d: sets Dictionary size - [0, 27], default: 24 (16MB)\n"
+             "  --threads [1, 2]: number of threads used by the match finder,\n"
+             "                    default: 2 if multithreading is supported\n"
              "  --version: display the program version and exit\n"
              "  -h, --help: display this help text\n"
              );
@@ -174,6 +193,176 @@ Done:
   return res;
 }
 
+static void SetUInt32(Byte *p, UInt32 v)
+{
+  int i;
+  for (i = 0; i < 4; i++)
+    p[i] = (Byte)(v >> (8 * i));
+}
+
+static UInt32 GetUInt32(const Byte *p)
+{
+  return (UInt32)p[0] | ((UInt32)p[1] << 8) | ((UInt32)p[2] << 16) | ((UInt32)p[3] << 24);
+}
+
+static SRes EncodeChunked(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize, CLzmaEncProps *props)
+{
+  SRes res;
+  size_t inSize = (size_t)fileSize;
+  size_t chunkSize = (size_t)mChunkSize;
+  size_t chunkCount;
+  size_t headerSize;
+  size_t outSize;
+  size_t outPos;
+  size_t index;
+  Byte *inBuffer = 0;
+  Byte *outBuffer = 0;
+
+  if (inSize == 0)
+    return SZ_ERROR_INPUT_EOF;
+
+  chunkCount = (inSize + chunkSize - 1) / chunkSize;
+  if (fileSize > 0xFFFFFFFF)
+    return SZ_ERROR_PARAM;
+
+  inBuffer = (Byte *)MyAlloc(inSize);
+  if (inBuffer == 0)
+    return SZ_ERROR_MEM;
+
+  if (SeqInStream_Read(inStream, inBuffer, inSize) != SZ_OK) {
+    res = SZ_ERROR_READ;
+    goto Done;
+  }
+
+  // same 105% + 64KB worst case as Encode(), for every chunk
+  headerSize = LZMA_CHUNKED_HEADER_SIZE + chunkCount * 4;
+  outSize = headerSize + inSize / 20 * 21 + chunkCount * (LZMA_HEADER_SIZE + (1 << 16));
+  outBuffer = (Byte *)MyAlloc(outSize);
+  if (outBuffer == 0) {
+    res = SZ_ERROR_MEM;
+    goto Done;
+  }
+
+  SetUInt32(outBuffer, LZMA_CHUNKED_SIGNATURE);
+  SetUInt32(outBuffer + 4, (UInt32)chunkCount);
+  SetUInt32(outBuffer + 8, (UInt32)fileSize);
+  SetUInt32(outBuffer + 12, 0);
+  SetUInt32(outBuffer + 16, (UInt32)chunkSize);
+  SetUInt32(outBuffer + 20, 0);
+
+  res = SZ_OK;
+  outPos = headerSize;
+  for (index = 0; index < chunkCount; index++) {
+    const Byte *chunk = inBuffer + index * chunkSize;
+    size_t size = inSize - index * chunkSize;
+    size_t outSizeProcessed;
+    size_t outPropsSize = LZMA_PROPS_SIZE;
+    CLzmaEncProps chunkProps = *props;
+    int i;
+
+    if (size > chunkSize)
+      size = chunkSize;
+    for (i = 0; i < 8; i++)
+      outBuffer[outPos + i + LZMA_PROPS_SIZE] = (Byte)((UInt64)size >> (8 * i));
+
+    // no need for a dictionary larger than the chunk itself
+    chunkProps.reduceSize = size;
+    outSizeProcessed = outSize - outPos - LZMA_HEADER_SIZE;
+    res = LzmaEncode(outBuffer + outPos + LZMA_HEADER_SIZE, &outSizeProcessed,
+        chunk, size, &chunkProps, outBuffer + outPos, &outPropsSize, 0,
+        NULL, &g_Alloc, &g_Alloc);
+    if (res != SZ_OK)
+      goto Done;
+
+    SetUInt32(outBuffer + LZMA_CHUNKED_HEADER_SIZE + index * 4, (UInt32)(LZMA_HEADER_SIZE + outSizeProcessed));
+    outPos += LZMA_HEADER_SIZE + outSizeProcessed;
+  }
+
+  if (outStream->Write(outStream, outBuffer, outPos) != outPos)
+    res = SZ_ERROR_WRITE;
+
+Done:
+  MyFree(outBuffer);
+  MyFree(inBuffer);
+
+  return res;
+}
+
+static SRes DecodeChunked(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize)
+{
+  SRes res;
+  size_t inSize = (size_t)fileSize;
+  Byte *inBuffer = 0;
+  Byte *outBuffer = 0;
+  size_t outSize;
+  size_t chunkSize;
+  size_t chunkCount;
+  size_t inPos;
+  size_t index;
+
+  if (inSize < LZMA_CHUNKED_HEADER_SIZE)
+    return SZ_ERROR_INPUT_EOF;
+
+  inBuffer = (Byte *)MyAlloc(inSize);
+  if (inBuffer == 0)
+    return SZ_ERROR_MEM;
+
+  if (SeqInStream_Read(inStream, inBuffer, inSize) != SZ_OK) {
+    res = SZ_ERROR_READ;
+    goto Done;
+  }
+
+  chunkCount = GetUInt32(inBuffer + 4);
+  outSize = GetUInt32(inBuffer + 8);
+  chunkSize = GetUInt32(inBuffer + 16);
+  if (GetUInt32(inBuffer) != LZMA_CHUNKED_SIGNATURE || GetUInt32(inBuffer + 12) != 0 ||
+      chunkCount == 0 || chunkSize == 0 ||
+      chunkCount != (outSize + chunkSize - 1) / chunkSize ||
+      (inSize - LZMA_CHUNKED_HEADER_SIZE) / 4 < chunkCount) {
+    res = SZ_ERROR_DATA;
+    goto Done;
+  }
+
+  outBuffer = (Byte *)MyAlloc(outSize);
+  if (outBuffer == 0) {
+    res = SZ_ERROR_MEM;
+    goto Done;
+  }
+
+  res = SZ_OK;
+  inPos = LZMA_CHUNKED_HEADER_SIZE + chunkCount * 4;
+  for (index = 0; index < chunkCount; index++) {
+    size_t streamSize = GetUInt32(inBuffer + LZMA_CHUNKED_HEADER_SIZE + index * 4);
+    size_t size = outSize - index * chunkSize;
+    size_t inSizePure;
+    ELzmaStatus status;
+
+    if (size > chunkSize)
+      size = chunkSize;
+    if (streamSize < LZMA_HEADER_SIZE || inSize - inPos < streamSize) {
+      res = SZ_ERROR_DATA;
+      goto Done;
+    }
+
+    inSizePure = streamSize - LZMA_HEADER_SIZE;
+    res = LzmaDecode(outBuffer + index * chunkSize, &size, inBuffer + inPos + LZMA_HEADER_SIZE,
+        &inSizePure, inBuffer + inPos, LZMA_PROPS_SIZE, LZMA_FINISH_END, &status, &g_Alloc);
+    if (res != SZ_OK)
+      goto Done;
+
+    inPos += streamSize;
+  }
+
+  if (outStream->Write(outStream, outBuffer, outSize) != outSize)
+    res = SZ_ERROR_WRITE;
+
+Done:
+  MyFree(outBuffer);
+  MyFree(inBuffer);
+
+  return res;
+}
+
 static SRes Decode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize)
 {
   SRes res;
@@ -272,6 +461,18 @@ int main2(int numArgs, const char *args[], char *rs)
       modeWasSet = True;
     } else if (strcmp(args[param], "--f86") == 0) {
       mConType = X86Converter;
+    } else if (strcmp(args[param], "--chunked") == 0) {
+      if (mChunkSize == 0) {
+        mChunkSize = LZMA_CHUNKED_DEFAULT_CHUNK_SIZE;
+      }
+    } else if (strcmp(args[param], "--chunk-size") == 0) {
+      if (numArgs < (param + 2)) {
+        return PrintUserError(rs);
+      }
+      if (AsciiStringToUint64(args[++param], FALSE, &mChunkSize) != EFI_SUCCESS ||
+          mChunkSize < LZMA_CHUNKED_MIN_CHUNK_SIZE || mChunkSize > 0x80000000) {
+        return PrintError(rs, kInvalidParamValMessage);
+      }
     } else if (strcmp(args[param], "-o") == 0 ||
                strcmp(args[param], "--output") == 0) {
       if (numArgs < (param + 2)) {
@@ -296,6 +497,18 @@ int main2(int numArgs, const char *args[], char *rs)
       } else {
         return PrintError(rs, kInvalidParamValMessage);
       }
+    } else if (strcmp(args[param], "--threads") == 0) {
+      if (numArgs < (param + 2)) {
+        return PrintUserError(rs);
+      }
+      AsciiStringToUint64(args[param + 1],FALSE,&mNumThreads);
+      if ((mNumThreads == 1)||(mNumThreads == 2)){
+        props.numThreads = (int)mNumThreads;
+        param++;
+        continue;
+      } else {
+        return PrintError(rs, kInvalidParamValMessage);
+      }
     } else if (strcmp(args[param], "d") == 0) {
       AsciiStringToUint64(args[param + 1],FALSE,&mDictionarySize);
       if (mDictionarySize <= 27) {
@@ -342,6 +555,14 @@ int main2(int numArgs, const char *args[], char *rs)
     return PrintUserError(rs);
   }
 
+  //
+  // The x86 converter works on absolute offsets, it is not supported
+  // together with chunks that are decoded independently.
+  //
+  if ((mChunkSize != 0) && (mConType != NoConverter)) {
+    return PrintUserError(rs);
+  }
+
   {
     size_t t4 = sizeof(UInt32);
     size_t t8 = sizeof(UInt64);
@@ -364,14 +585,22 @@ int main2(int numArgs, const char *args[], char *rs)
     if (!mQuietMode) {
       printf("Encoding\n");
     }
-    res = Encode(&outStream.vt, &inStream.vt, fileSize, &props);
+    if (mChunkSize != 0) {
+      res = EncodeChunked(&outStream.vt, &inStream.vt, fileSize, &props);
+    } else {
+      res = Encode(&outStream.vt, &inStream.vt, fileSize, &props);
+    }
   }
   else
   {
     if (!mQuietMode) {
       printf("Decoding\n");
     }
-    res = Decode(&outStream.vt, &inStream.vt, fileSize);
+    if (mChunkSize != 0) {
+      res = DecodeChunked(&outStream.vt, &inStream.vt, fileSize);
+    } else {
+      res = Decode(&outStream.vt, &inStream.vt, fileSize);
+    }
   }
 
   File_Close(&outStream.file);
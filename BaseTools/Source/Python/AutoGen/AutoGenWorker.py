@@ -25,6 +25,8 @@ import sys
 from AutoGen.DataPipe import MemoryDataPipe
 import logging
 import time
+import cProfile
+import tempfile
 
 def clearQ(q):
     try:
@@ -171,6 +173,7 @@ class AutoGenWorkerInProcess(mp.Process):
             self.PlatformMetaFileSet[(filepath,root)]  = filepath
             return self.PlatformMetaFileSet[(filepath,root)]
     def run(self):
+        Profiler = None
         try:
             taskname = "Init"
             with self.file_lock:
@@ -215,6 +218,11 @@ class AutoGenWorkerInProcess(mp.Process):
             GlobalData.gModuleHashFile = dict()
             GlobalData.gFileHashDict = dict()
             GlobalData.gEnableGenfdsMultiThread = self.data_pipe.Get("EnableGenfdsMultiThread")
+            GlobalData.gMetaFileCacheDir = self.data_pipe.Get("MetaFileCacheDir")
+            GlobalData.gProfileDir = self.data_pipe.Get("ProfileDir")
+            if GlobalData.gProfileDir:
+                Profiler = cProfile.Profile()
+                Profiler.enable()
             GlobalData.file_lock = self.file_lock
             CommandTarget = self.data_pipe.Get("CommandTarget")
             pcd_from_build_option = []
@@ -298,6 +306,14 @@ class AutoGenWorkerInProcess(mp.Process):
             EdkLogger.debug(EdkLogger.DEBUG_9, "Worker %s: %s" % (os.getpid(), str(e)))
             self.feedback_q.put(taskname)
         finally:
+            if Profiler is not None:
+                Profiler.disable()
+                try:
+                    ProfileFd, ProfileFile = tempfile.mkstemp(suffix=".prof", dir=GlobalData.gProfileDir)
+                    os.close(ProfileFd)
+                    Profiler.dump_stats(ProfileFile)
+                except:
+                    EdkLogger.debug(EdkLogger.DEBUG_9, "Worker %s: %s" % (os.getpid(), "Failed to save profile."))
             EdkLogger.debug(EdkLogger.DEBUG_9, "Worker %s: %s" % (os.getpid(), "Done"))
             self.feedback_q.put("Done")
             self.cache_q.put("CacheDone")
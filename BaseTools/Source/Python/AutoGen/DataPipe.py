@@ -167,3 +167,7 @@ class MemoryDataPipe(DataPipe):
         self.DataContainer = {"BinCacheDest":GlobalData.gBinCacheDest}
 
         self.DataContainer = {"EnableGenfdsMultiThread":GlobalData.gEnableGenfdsMultiThread}
+
+        self.DataContainer = {"MetaFileCacheDir":GlobalData.gMetaFileCacheDir}
+
+        self.DataContainer = {"ProfileDir":GlobalData.gProfileDir}
@@ -14,6 +14,7 @@ import hashlib
 from collections import defaultdict
 from GenFds.FdfParser import FdfParser
 from Workspace.WorkspaceCommon import GetModuleLibInstances
+from Workspace import MetaFileCache
 from AutoGen import GenMake
 from AutoGen.AutoGen import AutoGen
 from AutoGen.PlatformAutoGen import PlatformAutoGen
@@ -109,6 +110,11 @@ class WorkspaceAutoGen(AutoGen):
         # Mark now build in AutoGen Phase
         #
         #
+        # Parse the modules and packages of the platform in parallel, so that
+        # the serial processing below finds them in meta file cache.
+        #
+        self.PreloadMetaFiles()
+        #
         # Collect Platform Guids to support Guid name in Fdfparser.
         #
         self.CollectPlatformGuids()
@@ -158,6 +164,23 @@ class WorkspaceAutoGen(AutoGen):
                             ExtraData="Build target [%s] is not supported by the platform. [Valid target: %s]"
                                       % (self.BuildTarget, " ".join(self.Platform.BuildTargets)))
 
+    ## Fill the meta file cache with the INF files used by all arches
+    def PreloadMetaFiles(self):
+        if not GlobalData.gMetaFileCacheDir or GlobalData.gMetaFileParseJobs <= 1:
+            return
+        InfList = []
+        for Arch in self.ArchList:
+            Platform = self.BuildDatabase[self.MetaFile, Arch, self.BuildTarget, self.ToolChain]
+            Macros = Platform._Macros
+            PathList = [Record[0] for Record in Platform._RawData[MODEL_META_DATA_COMPONENT, Arch]]
+            PathList += [Record[1] for Record in Platform._RawData[MODEL_EFI_LIBRARY_CLASS, Arch]]
+            for Path in PathList:
+                File = PathClass(NormPath(Path, Macros), GlobalData.gWorkspace)
+                # invalid paths are reported by the normal processing
+                if File.Validate('.inf')[0] == 0:
+                    InfList.append(File)
+        MetaFileCache.Preload(InfList, GlobalData.gMetaFileParseJobs)
+
     def CollectPlatformGuids(self):
         oriInfList = []
         oriPkgSet = set()
@@ -899,6 +922,8 @@ class WorkspaceAutoGen(AutoGen):
             FdsCommandDict["quiet"] = True
 
         FdsCommandDict["GenfdsMultiThread"] = GlobalData.gEnableGenfdsMultiThread
+        if GlobalData.gSectionCacheDir:
+            FdsCommandDict["section_cache_dir"] = GlobalData.gSectionCacheDir
         if GlobalData.gIgnoreSource:
             FdsCommandDict["IgnoreSources"] = True
 
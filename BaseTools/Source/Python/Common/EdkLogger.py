@@ -151,6 +151,11 @@ _DebugMessageTemplate = '%(file)s(%(line)s): debug: \n    %(msg)s'
 #
 _WarningAsError = False
 
+#
+# List recording the warnings reported, see RecordWarnings().
+#
+_WarningRecord = None
+
 ## Log debug message
 #
 #   @param  Level       DEBUG level (DEBUG0~9)
@@ -197,13 +202,18 @@ def verbose(Message):
 #   @param  ExtraData   More information associated with "Message"
 #
 def warn(ToolName, Message, File=None, Line=None, ExtraData=None):
-    if _InfoLogger.level > WARN:
+    if _InfoLogger.level > WARN and _WarningRecord is None:
         return
 
     # if no tool name given, use caller's source file name as tool name
     if ToolName is None or ToolName == "":
         ToolName = os.path.basename(traceback.extract_stack()[-2][0])
 
+    if _WarningRecord is not None:
+        _WarningRecord.append((ToolName, Message, None if File is None else str(File), Line, ExtraData))
+        if _InfoLogger.level > WARN:
+            return
+
     if Line is None:
         Line = "..."
     else:
@@ -358,6 +368,19 @@ def SetWarningAsError():
     global _WarningAsError
     _WarningAsError = True
 
+## Record the arguments of the following warn() calls, whatever the log level
+#
+#   @param  Record      List to append the (ToolName, Message, File, Line,
+#                       ExtraData) of each warning to, or None to stop recording
+#
+#   @retval             The list previously recording warnings, or None
+#
+def RecordWarnings(Record):
+    global _WarningRecord
+    Previous = _WarningRecord
+    _WarningRecord = Record
+    return Previous
+
 ## Specify a file to store the log message as well as put on console
 #
 #   @param  LogFile     The file path used to store the log message
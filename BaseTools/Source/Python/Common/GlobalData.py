@@ -118,6 +118,14 @@ gModuleAllCacheStatus = None
 gModuleCacheHit = None
 
 gEnableGenfdsMultiThread = True
+# Directory of the GenFds section and FFS cache, None to disable
+gSectionCacheDir = None
+# Directory of the INF/DEC parse result cache, None to always re-parse
+gMetaFileCacheDir = None
+# Number of processes filling the meta file cache before AutoGen
+gMetaFileParseJobs = 1
+# Directory receiving the profile of AutoGen worker processes, None if not profiling
+gProfileDir = None
 gSikpAutoGenCache = set()
 # Common lock for the file access in multiple process AutoGens
 file_lock = None
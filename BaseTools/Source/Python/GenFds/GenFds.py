@@ -31,6 +31,7 @@ from Common.BuildVersion import gBUILD_VERSION
 from Common.MultipleWorkspace import MultipleWorkspace as mws
 from Common.BuildToolError import FatalError, GENFDS_ERROR, CODE_ERROR, FORMAT_INVALID, RESOURCE_NOT_AVAILABLE, FILE_NOT_FOUND, OPTION_MISSING, FORMAT_NOT_SUPPORTED, OPTION_VALUE_INVALID, PARAMETER_INVALID
 from Workspace.WorkspaceDatabase import WorkspaceDatabase
+from Workspace import MetaFileCache
 
 from .FdfParser import FdfParser, Warning
 from .GenFdsGlobalVariable import GenFdsGlobalVariable
@@ -94,6 +95,10 @@ def resetFdsGlobalVariable():
     GenFdsGlobalVariable.CopyList   = []
     GenFdsGlobalVariable.ModuleFile = ''
     GenFdsGlobalVariable.EnableGenfdsMultiThread = True
+    GenFdsGlobalVariable.SectionCacheDir = ''
+    GenFdsGlobalVariable.SectionCacheHit = 0
+    GenFdsGlobalVariable.SectionCacheMiss = 0
+    GenFdsGlobalVariable.ToolDigestDict = {}
 
     GenFdsGlobalVariable.LargeFileInFvFlags = []
     GenFdsGlobalVariable.EFI_FIRMWARE_FILE_SYSTEM3_GUID = '5473C07A-3DCB-4dca-BD6F-1E9689E7349A'
@@ -142,6 +147,12 @@ def GenFdsApi(FdsCommandDict, WorkSpaceDataBase=None):
                 GenFdsGlobalVariable.EnableGenfdsMultiThread = True
             else:
                 GenFdsGlobalVariable.EnableGenfdsMultiThread = False
+            if FdsCommandDict.get("section_cache_dir"):
+                SectionCacheDir = os.path.normpath(FdsCommandDict.get("section_cache_dir"))
+                if not os.path.isabs(SectionCacheDir):
+                    SectionCacheDir = os.path.join(Workspace, SectionCacheDir)
+                GenFdsGlobalVariable.SectionCacheDir = SectionCacheDir
+                MetaFileCache.Prune(SectionCacheDir)
         os.chdir(GenFdsGlobalVariable.WorkSpaceDir)
 
         # set multiple workspace
@@ -376,6 +387,10 @@ def GenFdsApi(FdsCommandDict, WorkSpaceDataBase=None):
         """Display FV space info."""
         GenFds.DisplayFvSpaceInfo(FdfParserObj)
 
+        if GenFdsGlobalVariable.SectionCacheDir:
+            GenFdsGlobalVariable.VerboseLogger("Section cache: %d hit(s), %d miss(es)" %
+                                               (GenFdsGlobalVariable.SectionCacheHit, GenFdsGlobalVariable.SectionCacheMiss))
+
     except Warning as X:
         EdkLogger.error(X.ToolName, FORMAT_INVALID, File=X.FileName, Line=X.LineNumber, ExtraData=X.Message, RaiseError=False)
         ReturnCode = FORMAT_INVALID
@@ -407,6 +422,7 @@ def OptionsToCommandDict(Options):
     FdsCommandDict["debug"] = Options.debug
     FdsCommandDict["Workspace"] = Options.Workspace
     FdsCommandDict["GenfdsMultiThread"] = not Options.NoGenfdsMultiThread
+    FdsCommandDict["section_cache_dir"] = Options.SectionCacheDir
     FdsCommandDict["fdf_file"] = [PathClass(Options.filename)] if Options.filename else []
     FdsCommandDict["build_target"] = Options.BuildTarget
     FdsCommandDict["toolchain_tag"] = Options.ToolChain
@@ -465,6 +481,7 @@ def myOptionParser():
     Parser.add_option("--pcd", action="append", dest="OptionPcd", help="Set PCD value by command line. Format: \"PcdName=Value\" ")
     Parser.add_option("--genfds-multi-thread", action="store_true", dest="GenfdsMultiThread", default=True, help="Enable GenFds multi thread to generate ffs file.")
     Parser.add_option("--no-genfds-multi-thread", action="store_true", dest="NoGenfdsMultiThread", default=False, help="Disable GenFds multi thread to generate ffs file.")
+    Parser.add_option("--section-cache", action="store", type="string", dest="SectionCacheDir", help="Reuse section and FFS files generated by previous builds from the specified cache directory.")
 
     Options, _ = Parser.parse_args()
     return Options
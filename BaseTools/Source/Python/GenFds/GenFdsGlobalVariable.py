@@ -14,6 +14,10 @@ from __future__ import absolute_import
 
 import Common.LongFilePathOs as os
 import sys
+import re
+import shutil
+import tempfile
+from hashlib import md5
 from sys import stdout
 from subprocess import PIPE,Popen
 from struct import Struct
@@ -33,6 +37,7 @@ from Common.MultipleWorkspace import MultipleWorkspace as mws
 import Common.GlobalData as GlobalData
 from Common.BuildToolError import *
 from AutoGen.AutoGen import CalculatePriorityValue
+from Workspace import MetaFileCache
 
 ## Global variables
 #
@@ -74,6 +79,15 @@ class GenFdsGlobalVariable:
     ModuleFile = ''
     EnableGenfdsMultiThread = True
 
+    #
+    # Content-addressed cache of section and FFS files, keyed by the tool,
+    # its arguments and the digests of its input files. Disabled if empty.
+    #
+    SectionCacheDir = ''
+    SectionCacheHit = 0
+    SectionCacheMiss = 0
+    ToolDigestDict = {}
+
     #
     # The list whose element are flags to indicate if large FFS or SECTION files exist in FV.
     # At the beginning of each generation of FV, false flag is appended to the list,
@@ -501,7 +515,7 @@ class GenFdsGlobalVariable:
             else:
                 if not GenFdsGlobalVariable.NeedsUpdate(Output, list(Input) + [CommandFile]):
                     return
-                GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to generate section")
+                GenFdsGlobalVariable.CallCachedTool(Cmd, Output, "Failed to generate section")
         else:
             Cmd += ("-o", Output)
             Cmd += Input
@@ -516,7 +530,7 @@ class GenFdsGlobalVariable:
                     GenFdsGlobalVariable.SecCmdList.append(' '.join(Cmd).strip())
             elif GenFdsGlobalVariable.NeedsUpdate(Output, list(Input) + [CommandFile]):
                 GenFdsGlobalVariable.DebugLogger(EdkLogger.DEBUG_5, "%s needs update because of newer %s" % (Output, Input))
-                GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to generate section")
+                GenFdsGlobalVariable.CallCachedTool(Cmd, Output, "Failed to generate section")
                 if (os.path.getsize(Output) >= GenFdsGlobalVariable.LARGE_FILE_SIZE and
                     GenFdsGlobalVariable.LargeFileInFvFlags):
                     GenFdsGlobalVariable.LargeFileInFvFlags[-1] = True
@@ -572,7 +586,7 @@ class GenFdsGlobalVariable:
         else:
             if not GenFdsGlobalVariable.NeedsUpdate(Output, list(Input) + [CommandFile]):
                 return
-            GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to generate FFS")
+            GenFdsGlobalVariable.CallCachedTool(Cmd, Output, "Failed to generate FFS")
 
     @staticmethod
     def GenerateFirmwareVolume(Output, Input, BaseAddress=None, ForceRebase=None, Capsule=False, Dump=False,
@@ -700,7 +714,183 @@ class GenFdsGlobalVariable:
             if " ".join(Cmd).strip() not in GenFdsGlobalVariable.SecCmdList:
                 GenFdsGlobalVariable.SecCmdList.append(" ".join(Cmd).strip())
         else:
-            GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to call " + ToolPath, returnValue)
+            GenFdsGlobalVariable.CallCachedTool(Cmd, Output, "Failed to call " + ToolPath, returnValue)
+
+    ## Get the files making up a tool found in PATH
+    #
+    #   The wrapper scripts in BaseTools/BinWrappers and the .bat files used on
+    #   Windows don't change when the tool they run is rebuilt or edited, so the
+    #   files they run are looked up too:
+    #     - a C tool binary, found with the same search order as the script
+    #     - all files in the directory of a Python tool run from source, like
+    #       Rsa2048Sha256Sign.py and its TestSigningPrivateKey.pem
+    #     - the files of another tool in PATH, like LzmaCompress run by
+    #       LzmaF86Compress
+    #
+    #   @param  ToolPath        Path of the tool found in PATH
+    #
+    #   @retval list            Paths of the tool and the files it runs, or None
+    #                           if a wrapper can't be resolved
+    #
+    @staticmethod
+    def _GetToolFiles(ToolPath):
+        WrapperDir = os.path.dirname(os.path.realpath(ToolPath))
+        IsBatch = os.path.splitext(ToolPath)[1].lower() in ('.bat', '.cmd')
+        if not IsBatch and WrapperDir.lower().split(os.sep)[-2:] not in (['binwrappers', 'posixlike'], ['binpipwrappers', 'posixlike']):
+            return [ToolPath]
+        with open(ToolPath, 'r') as File:
+            Script = File.read()
+        Tool = os.path.splitext(os.path.basename(ToolPath))[0]
+        ToolsPath = os.path.join(WrapperDir, '..', '..')
+        if IsBatch and os.environ.get('BASE_TOOLS_PATH'):
+            ToolsPath = os.environ.get('BASE_TOOLS_PATH')
+
+        # the script runs a Python tool from source
+        if re.search(r'Source[/\\]Python[/\\]', Script):
+            PythonDir = os.path.normpath(os.path.join(ToolsPath, 'Source', 'Python', Tool))
+            if not os.path.isfile(os.path.join(PythonDir, Tool + '.py')):
+                return None
+            return [ToolPath] + sorted(os.path.join(PythonDir, Name) for Name in os.listdir(PythonDir)
+                                       if os.path.isfile(os.path.join(PythonDir, Name)))
+
+        # the script runs a C tool binary
+        if 'Source/C/bin' in Script:
+            Workspace = os.environ.get('WORKSPACE')
+            EdkToolsPath = os.environ.get('EDK_TOOLS_PATH', '')
+            if Workspace and os.path.exists(os.path.join(Workspace, 'Conf', 'BaseToolsCBinaries')):
+                BinPath = os.path.join(Workspace, 'Conf', 'BaseToolsCBinaries', Tool)
+            elif Workspace and os.path.exists(os.path.join(EdkToolsPath, 'Source', 'C')):
+                BinPath = os.path.join(EdkToolsPath, 'Source', 'C', 'bin', Tool)
+            else:
+                BinPath = os.path.join(ToolsPath, 'Source', 'C', 'bin', Tool)
+            if not os.path.isfile(BinPath):
+                return None
+            return [ToolPath, os.path.normpath(BinPath)]
+
+        # the script runs another tool in PATH
+        NextTool = GenFdsGlobalVariable._GetScriptTool(Script, IsBatch)
+        NextPath = shutil.which(NextTool) if NextTool else None
+        if not NextPath or os.path.realpath(NextPath) == os.path.realpath(ToolPath):
+            return None
+        ToolFiles = GenFdsGlobalVariable._GetToolFiles(NextPath)
+        return [ToolPath] + ToolFiles if ToolFiles else None
+
+    ## Commands of .bat files which don't run another tool
+    _BatchCommands = ('echo', 'setlocal', 'endlocal', 'set', 'if', 'goto', 'shift', 'rem', 'exit')
+
+    ## Get the name of the tool a wrapper script runs
+    #
+    #   @param  Script          Content of the wrapper script
+    #   @param  IsBatch         Whether the script is a .bat file
+    #
+    #   @retval string          Name of the tool, or None if not found
+    #
+    @staticmethod
+    def _GetScriptTool(Script, IsBatch):
+        if not IsBatch:
+            Match = re.search(r'^\s*exec\s+(\w+)\s', Script, re.MULTILINE)
+            return Match.group(1) if Match else None
+        for Line in Script.splitlines():
+            Match = re.match(r'\s*@?([\w.-]+)(\s|$)', Line)
+            if Match and Match.group(1).lower() not in GenFdsGlobalVariable._BatchCommands:
+                return Match.group(1)
+        return None
+
+    ## Get the digest of a tool, so that rebuilt tools invalidate the section cache
+    #
+    #   @param  Tool            Name or path of the tool
+    #
+    #   @retval string          Digest of the tool executable, or None if not found
+    #
+    @staticmethod
+    def _GetToolDigest(Tool):
+        if Tool not in GenFdsGlobalVariable.ToolDigestDict:
+            Digest = None
+            ToolPath = shutil.which(Tool)
+            ToolFiles = GenFdsGlobalVariable._GetToolFiles(ToolPath) if ToolPath else None
+            if ToolFiles:
+                Digest = md5()
+                for ToolFile in ToolFiles:
+                    with open(ToolFile, 'rb') as File:
+                        Digest.update(File.read())
+                Digest = Digest.hexdigest()
+            GenFdsGlobalVariable.ToolDigestDict[Tool] = Digest
+        return GenFdsGlobalVariable.ToolDigestDict[Tool]
+
+    ## Get the section cache key of a tool invocation
+    #
+    #   Paths are replaced with the digest of the file content, so the same
+    #   section built from another directory or platform maps to the same key.
+    #
+    #   @param  Cmd             Command list of the tool
+    #   @param  Output          Path of output file
+    #
+    #   @retval string          Key of the cache entry, or None if it can't be cached
+    #
+    @staticmethod
+    def _GetSectionCacheKey(Cmd, Output):
+        ToolDigest = GenFdsGlobalVariable._GetToolDigest(Cmd[0])
+        if ToolDigest is None:
+            return None
+        Digest = md5(ToolDigest.encode('utf-8'))
+        for Arg in Cmd[1:]:
+            if Arg == Output:
+                Arg = '<output>'
+            elif os.path.isfile(Arg):
+                with open(Arg, 'rb') as File:
+                    Arg = md5(File.read()).hexdigest()
+            Digest.update(Arg.encode('utf-8') + b'\0')
+        return Digest.hexdigest()
+
+    ## Call external tool through the section cache
+    #
+    #   The output is copied from the cache if the same tool has been run with
+    #   the same arguments and input content before. Otherwise the tool is run
+    #   and its output is stored in the cache.
+    #
+    #   @param  Cmd             Command list of the tool
+    #   @param  Output          Path of output file
+    #   @param  errorMess       Error message if the tool fails
+    #   @param  returnValue     See CallExternalTool
+    #
+    @staticmethod
+    def CallCachedTool(Cmd, Output, errorMess, returnValue=[]):
+        CacheDir = GenFdsGlobalVariable.SectionCacheDir
+        Key = None
+        if CacheDir:
+            Key = GenFdsGlobalVariable._GetSectionCacheKey(Cmd, Output)
+        if Key is None:
+            GenFdsGlobalVariable.CallExternalTool(Cmd, errorMess, returnValue)
+            return
+
+        CacheFile = os.path.join(CacheDir, Key[:2], Key)
+        if os.path.exists(CacheFile):
+            GenFdsGlobalVariable.DebugLogger(EdkLogger.DEBUG_5, "%s is restored from section cache" % Output)
+            MetaFileCache.Touch(CacheFile)
+            CreateDirectory(os.path.dirname(Output))
+            shutil.copyfile(CacheFile, Output)
+            if returnValue != []:
+                returnValue[0] = 0
+            GenFdsGlobalVariable.SectionCacheHit += 1
+            return
+
+        GenFdsGlobalVariable.SectionCacheMiss += 1
+        GenFdsGlobalVariable.CallExternalTool(Cmd, errorMess, returnValue)
+        if (returnValue != [] and returnValue[0] != 0) or not os.path.exists(Output):
+            return
+        #
+        # Copy to a temporary file in the cache then rename it, so that
+        # concurrent builds sharing the cache never see a partial entry.
+        #
+        try:
+            CreateDirectory(os.path.dirname(CacheFile))
+            TempFile = tempfile.NamedTemporaryFile(dir=os.path.dirname(CacheFile), delete=False)
+            with TempFile:
+                with open(Output, 'rb') as File:
+                    shutil.copyfileobj(File, TempFile)
+            os.replace(TempFile.name, CacheFile)
+        except Exception as X:
+            GenFdsGlobalVariable.DebugLogger(EdkLogger.DEBUG_5, "Failed to store %s in section cache: %s" % (Output, str(X)))
 
     @staticmethod
     def CallExternalTool (cmd, errorMess, returnValue=[]):
@@ -0,0 +1,329 @@
+## @file
+# This file is used to keep the raw parse result of INF/DEC files on disk
+#
+# The raw records produced by InfParser and DecParser only depend on the
+# content of the meta file, so they are stored in a content-addressed cache
+# and shared by all platforms and builds using the same Conf directory.
+# Entries no build used for _MAX_AGE_ days are removed by Prune(), and
+# Preload() fills the cache from several processes before a build needs them.
+#
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+##
+# Import Modules
+#
+from __future__ import absolute_import
+import Common.LongFilePathOs as os
+import multiprocessing
+import pickle
+import tempfile
+import time
+from hashlib import md5
+
+import Common.EdkLogger as EdkLogger
+import Common.GlobalData as GlobalData
+from Common.DataType import TAB_ARCH_COMMON
+from Common.Misc import PathClass
+from Common.StringUtils import NormPath
+from Common.LongFilePathSupport import OpenLongFilePath as open
+from CommonDataClass.DataClass import MODEL_FILE_INF, MODEL_FILE_DEC, MODEL_META_DATA_PACKAGE
+
+## Bump this whenever the parsers change the records they store
+_CACHE_FORMAT_VERSION_ = 3
+
+## Days after which an entry no build used is removed
+_MAX_AGE_ = 30
+
+## Seconds between two refreshes of the time stamp of an entry, and between
+## two scans for expired entries
+_TOUCH_INTERVAL_ = 24 * 60 * 60
+
+## File whose time stamp tells when the cache was last scanned
+_PRUNE_STAMP_ = 'LastPrune'
+
+## Column index of the ID and BelongsToItem fields in INF/DEC table rows
+_ID_ = 0
+_BELONGS_TO_ITEM_ = 7
+
+## Statistics of the cache usage in current process
+CacheHit = 0
+CacheMiss = 0
+
+## Database used by the parsers in a Preload() worker process
+_PreloadDb = None
+
+## Get the directory holding the cache, or None if caching is disabled
+def _CacheDir():
+    return GlobalData.gMetaFileCacheDir
+
+## Compute the cache key of a meta file
+#
+#   @param      MetaFile        PathClass object of the meta file
+#   @param      FileType        Model type of the meta file
+#
+#   @retval     string          Key of the cache entry, or None if file can't be read
+#
+def _CacheKey(MetaFile, FileType):
+    try:
+        with open(str(MetaFile), 'rb') as File:
+            Content = File.read()
+    except:
+        return None
+    Digest = md5()
+    Digest.update(("%d:%d:" % (_CACHE_FORMAT_VERSION_, FileType)).encode('utf-8'))
+    # global macros are not permitted in INF/DEC and cause a parse error
+    Digest.update(" ".join(sorted(GlobalData.gGlobalDefines)).encode('utf-8'))
+    Digest.update(Content)
+    return Digest.hexdigest()
+
+## Restore the raw records of a meta file from cache
+#
+#   @param      Parser          InfParser or DecParser object
+#
+#   @retval     True            The records were restored into the parser table
+#   @retval     False           No cache entry found, the file must be parsed
+#
+def Load(Parser):
+    global CacheHit, CacheMiss
+    CacheDir = _CacheDir()
+    if not CacheDir:
+        return False
+    Parser._CacheKey = _CacheKey(Parser.MetaFile, Parser._FileType)
+    if Parser._CacheKey is None:
+        return False
+    CacheFile = os.path.join(CacheDir, Parser._CacheKey[:2], Parser._CacheKey)
+    try:
+        with open(CacheFile, 'rb') as File:
+            Records, Warnings = pickle.load(File)
+    except:
+        CacheMiss += 1
+        return False
+
+    Touch(CacheFile)
+
+    #
+    # Record IDs are re-generated by the table, so BelongsToItem is stored as
+    # the index of the owner record and translated back here.
+    #
+    IdList = []
+    for Record in Records:
+        Owner = Record[_BELONGS_TO_ITEM_ - 1]
+        if Owner >= 0:
+            Owner = IdList[Owner]
+        IdList.append(Parser._Table.Insert(*(Record[:_BELONGS_TO_ITEM_ - 1] + [Owner] + Record[_BELONGS_TO_ITEM_:])))
+    Parser._Done()
+    CacheHit += 1
+    EdkLogger.debug(EdkLogger.DEBUG_5, "Meta file cache hit: %s" % Parser.MetaFile)
+
+    #
+    # Report the warnings the parser gave when the entry was created. Files
+    # with the same content share the entry, so the path is the one parsed now.
+    #
+    for ToolName, Message, HasFile, Line, ExtraData in Warnings:
+        EdkLogger.warn(ToolName, Message, Parser.MetaFile if HasFile else None, Line, ExtraData)
+    return True
+
+## Parse a meta file and store its raw records into cache
+#
+#   @param      Parser          InfParser or DecParser object not parsed yet
+#
+def Parse(Parser):
+    Warnings = []
+    Previous = EdkLogger.RecordWarnings(Warnings)
+    try:
+        Parser.Start()
+    finally:
+        EdkLogger.RecordWarnings(Previous)
+        if Previous is not None:
+            Previous.extend(Warnings)
+    _Save(Parser, Warnings)
+
+## Store the raw records of a parsed meta file into cache
+#
+#   @param      Parser          InfParser or DecParser object which has been parsed
+#   @param      Warnings        Arguments of the EdkLogger.warn() calls made by
+#                               the parser
+#
+def _Save(Parser, Warnings):
+    CacheDir = _CacheDir()
+    if not CacheDir or getattr(Parser, '_CacheKey', None) is None:
+        return
+    Records = []
+    IndexOf = {}
+    for Row in Parser._Table.GetAll():
+        Owner = Row[_BELONGS_TO_ITEM_]
+        if Owner >= 0:
+            if Owner not in IndexOf:
+                # owned by a record not stored in this table, don't cache it
+                return
+            Owner = IndexOf[Owner]
+        IndexOf[Row[_ID_]] = len(Records)
+        Records.append(Row[_ID_ + 1:_BELONGS_TO_ITEM_] + [Owner] + Row[_BELONGS_TO_ITEM_ + 1:])
+
+    # the parser only reports warnings in the meta file itself
+    Warnings = [(ToolName, Message, File is not None, Line, ExtraData)
+                for ToolName, Message, File, Line, ExtraData in Warnings]
+
+    CacheDir = os.path.join(CacheDir, Parser._CacheKey[:2])
+    CacheFile = os.path.join(CacheDir, Parser._CacheKey)
+    try:
+        if not os.path.exists(CacheDir):
+            os.makedirs(CacheDir)
+        #
+        # Write to a temporary file first then rename it, so that concurrent
+        # builds sharing the cache never see a partially written entry.
+        #
+        TempFile = tempfile.NamedTemporaryFile(dir=CacheDir, delete=False)
+        with TempFile:
+            pickle.dump((Records, Warnings), TempFile, pickle.HIGHEST_PROTOCOL)
+        os.replace(TempFile.name, CacheFile)
+    except Exception as Exc:
+        EdkLogger.debug(EdkLogger.DEBUG_5, "Failed to cache meta file %s: %s" % (Parser.MetaFile, str(Exc)))
+
+## Mark a cache entry as used by current build
+#
+# The time stamp of an entry is the last time a build used it, keep it recent
+# enough for Prune() not to remove the entry.
+#
+#   @param      CacheFile       Path of the cache entry
+#
+def Touch(CacheFile):
+    try:
+        if time.time() - os.path.getmtime(CacheFile) > _TOUCH_INTERVAL_:
+            os.utime(CacheFile, None)
+    except:
+        pass
+
+## Remove the entries no build used for _MAX_AGE_ days
+#
+# The cache is scanned at most once every _TOUCH_INTERVAL_ seconds. Other
+# caches storing entries in the same <key[:2]>/<key> layout, like the GenFds
+# section cache, are expired the same way by passing their directory.
+#
+#   @param      CacheDir        Directory of the cache, the meta file cache if None
+#
+def Prune(CacheDir=None):
+    if CacheDir is None:
+        CacheDir = _CacheDir()
+    if not CacheDir or not os.path.isdir(CacheDir):
+        return
+    Now = time.time()
+    Stamp = os.path.join(CacheDir, _PRUNE_STAMP_)
+    try:
+        if Now - os.path.getmtime(Stamp) < _TOUCH_INTERVAL_:
+            return
+    except:
+        pass
+    try:
+        with open(Stamp, 'w'):
+            pass
+    except:
+        return
+
+    Removed = 0
+    for SubDir in os.listdir(CacheDir):
+        SubDir = os.path.join(CacheDir, SubDir)
+        if not os.path.isdir(SubDir):
+            continue
+        for Entry in os.listdir(SubDir):
+            Entry = os.path.join(SubDir, Entry)
+            try:
+                if Now - os.path.getmtime(Entry) > _MAX_AGE_ * 24 * 60 * 60:
+                    os.remove(Entry)
+                    Removed += 1
+            except:
+                pass
+    EdkLogger.debug(EdkLogger.DEBUG_5, "%d expired cache entries removed from %s" % (Removed, CacheDir))
+
+## Get the files in a list which have no cache entry yet
+#
+#   @param      FileList        List of PathClass objects
+#   @param      FileType        Model type of the files
+#
+#   @retval     list            Paths of the files to be parsed
+#
+def _Missing(FileList, FileType):
+    CacheDir = _CacheDir()
+    RetVal = []
+    for File in sorted(set(str(File) for File in FileList)):
+        Key = _CacheKey(File, FileType)
+        if Key is not None and not os.path.exists(os.path.join(CacheDir, Key[:2], Key)):
+            RetVal.append(File)
+    return RetVal
+
+## Set up a Preload() worker process like the build process
+def _InitPreloadWorker(GlobalDefines, CacheDir):
+    from .MetaFileParser import MetaFileParser
+    from .MetaFileTable import MetaFileStorage
+    EdkLogger.Initialize()
+    # warnings are stored with the entry and reported by the build itself
+    EdkLogger.SetLevel(EdkLogger.SILENT)
+    GlobalData.gGlobalDefines = GlobalDefines
+    GlobalData.gMetaFileCacheDir = CacheDir
+    MetaFileParser.MetaFiles.clear()
+    MetaFileStorage._ObjectCache.clear()
+
+## Parse one meta file in a Preload() worker process
+#
+#   @param      Task            Tuple of the file path and its model type
+#
+#   @retval     list            Packages listed in an INF file
+#
+def _PreloadWorker(Task):
+    from .MetaFileParser import InfParser, DecParser
+    from .MetaFileTable import MetaFileStorage
+    from .WorkspaceDatabase import WorkspaceDatabase
+    global _PreloadDb
+    Path, FileType = Task
+    try:
+        if _PreloadDb is None:
+            _PreloadDb = WorkspaceDatabase()
+        MetaFile = PathClass(Path)
+        ParserClass = InfParser if FileType == MODEL_FILE_INF else DecParser
+        Parser = ParserClass(MetaFile, FileType, TAB_ARCH_COMMON, MetaFileStorage(_PreloadDb, MetaFile, FileType))
+        Parser.StartParse()
+        if FileType == MODEL_FILE_INF:
+            return [Record[0] for Record in Parser._RawTable.Query(MODEL_META_DATA_PACKAGE)]
+    except:
+        # errors are reported when the build parses the file itself
+        pass
+    return []
+
+## Parse INF files and the DEC files they use in parallel to fill the cache
+#
+# The build process still parses every file itself, but finds the records in
+# cache then. Files already in cache are skipped, so a warm cache costs one
+# digest per file.
+#
+#   @param      FileList        List of PathClass objects of INF files
+#   @param      Jobs            Maximum number of worker processes
+#
+def Preload(FileList, Jobs):
+    CacheDir = _CacheDir()
+    if not CacheDir or Jobs <= 1:
+        return
+    InfList = _Missing(FileList, MODEL_FILE_INF)
+    # not worth starting processes for
+    if len(InfList) < 2:
+        return
+
+    StartTime = time.time()
+    Pool = multiprocessing.Pool(min(Jobs, len(InfList)), _InitPreloadWorker,
+                                (dict(GlobalData.gGlobalDefines), CacheDir))
+    try:
+        PackageSet = set()
+        for Packages in Pool.imap_unordered(_PreloadWorker, [(File, MODEL_FILE_INF) for File in InfList], 4):
+            PackageSet.update(Packages)
+        DecList = []
+        for Package in PackageSet:
+            File = PathClass(NormPath(Package), GlobalData.gWorkspace)
+            if File.Validate('.dec')[0] == 0:
+                DecList.append(File)
+        DecList = _Missing(DecList, MODEL_FILE_DEC)
+        Pool.map(_PreloadWorker, [(File, MODEL_FILE_DEC) for File in DecList], 1)
+    finally:
+        Pool.close()
+        Pool.join()
+    EdkLogger.verbose("%d INF and %d DEC file(s) pre-parsed into meta file cache in %.2f seconds"
+                      % (len(InfList), len(DecList), time.time() - StartTime))
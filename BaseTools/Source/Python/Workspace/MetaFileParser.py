@@ -29,6 +29,7 @@ from CommonDataClass.Exceptions import *
 from Common.LongFilePathSupport import OpenLongFilePath as open
 from collections import defaultdict
 from .MetaFileTable import MetaFileStorage
+from . import MetaFileCache
 from .MetaFileCommentParser import CheckInfComment
 from Common.DataType import TAB_COMMENT_EDK_START, TAB_COMMENT_EDK_END
 
@@ -116,6 +117,8 @@ def ParseMacro(Parser):
 #   @param      From            ID from which the data comes (for !INCLUDE directive)
 #
 class MetaFileParser(object):
+    # raw records only depend on file content and can be kept in MetaFileCache
+    _Cacheable = False
     # data type (file content) for specific file type
     DataType = {}
 
@@ -258,7 +261,10 @@ class MetaFileParser(object):
             else:
                 self._Table = self._RawTable
                 self._PostProcessed = False
-                self.Start()
+                if not self._Cacheable:
+                    self.Start()
+                elif not MetaFileCache.Load(self):
+                    MetaFileCache.Parse(self)
     ## Data parser for the common format in different type of file
     #
     #   The common format in the meatfile is like
@@ -533,6 +539,8 @@ class MetaFileParser(object):
 #   @param      Macros          Macros used for replacement in file
 #
 class InfParser(MetaFileParser):
+    _Cacheable = True
+
     # INF file supported data types (one type per section)
     DataType = {
         TAB_UNKNOWN.upper() : MODEL_UNKNOWN,
@@ -1749,6 +1757,8 @@ class DscParser(MetaFileParser):
 #   @param      Macros          Macros used for replacement in file
 #
 class DecParser(MetaFileParser):
+    _Cacheable = True
+
     # DEC file supported data types (one type per section)
     DataType = {
         TAB_DEC_DEFINES.upper()                     :   MODEL_META_DATA_HEADER,
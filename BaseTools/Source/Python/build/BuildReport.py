@@ -41,6 +41,7 @@ from Common.DataType import *
 import collections
 from Common.Expression import *
 from GenFds.AprioriSection import DXE_APRIORI_GUID, PEI_APRIORI_GUID
+from GenFds.GenFdsGlobalVariable import GenFdsGlobalVariable
 
 ## Pattern to extract contents in EDK DXS files
 gDxsDependencyPattern = re.compile(r"DEPENDENCY_START(.+)DEPENDENCY_END", re.DOTALL)
@@ -2217,6 +2218,8 @@ class PlatformReport(object):
             FileWrite(File, "Make Duration:        %s" % MakeTime)
         if GenFdsTime:
             FileWrite(File, "GenFds Duration:      %s" % GenFdsTime)
+        if GenFdsGlobalVariable.SectionCacheDir:
+            FileWrite(File, "GenFds Section Cache: %d hit(s), %d miss(es)" % (GenFdsGlobalVariable.SectionCacheHit, GenFdsGlobalVariable.SectionCacheMiss))
         FileWrite(File, "Report Content:       %s" % ", ".join(ReportType))
 
         if GlobalData.MixedPcd:
@@ -22,6 +22,11 @@ import glob
 import time
 import platform
 import traceback
+import cProfile
+import pstats
+import shutil
+import tempfile
+from io import StringIO
 import multiprocessing
 from threading import Thread,Event,BoundedSemaphore
 import threading
@@ -48,6 +53,7 @@ from Common.DataType import *
 import Common.EdkLogger as EdkLogger
 
 from Workspace.WorkspaceDatabase import BuildDB
+from Workspace import MetaFileCache
 
 from BuildReport import BuildReport
 from GenPatchPcdTable.GenPatchPcdTable import PeImageClass,parsePcdInfoFromMapFile
@@ -751,6 +757,7 @@ class Build():
         GlobalData.gBinCacheDest   = BuildOptions.BinCacheDest
         GlobalData.gBinCacheSource = BuildOptions.BinCacheSource
         GlobalData.gEnableGenfdsMultiThread = not BuildOptions.NoGenfdsMultiThread
+        GlobalData.gSectionCacheDir = BuildOptions.SectionCacheDir
         GlobalData.gDisableIncludePathCheck = BuildOptions.DisableIncludePathCheck
 
         if GlobalData.gBinCacheDest and not GlobalData.gUseHashCache:
@@ -780,9 +787,18 @@ class Build():
             if GlobalData.gBinCacheDest is not None:
                 EdkLogger.error("build", OPTION_VALUE_INVALID, ExtraData="Invalid value of option --binary-destination.")
 
+        if GlobalData.gSectionCacheDir:
+            SectionCacheDir = os.path.normpath(GlobalData.gSectionCacheDir)
+            if not os.path.isabs(SectionCacheDir):
+                SectionCacheDir = mws.join(self.WorkspaceDir, SectionCacheDir)
+            GlobalData.gSectionCacheDir = SectionCacheDir
+
         GlobalData.gDatabasePath = os.path.normpath(os.path.join(GlobalData.gConfDirectory, GlobalData.gDatabasePath))
         if not os.path.exists(os.path.join(GlobalData.gConfDirectory, '.cache')):
             os.makedirs(os.path.join(GlobalData.gConfDirectory, '.cache'))
+        if not self.Reparse and not BuildOptions.CheckUsage:
+            GlobalData.gMetaFileCacheDir = os.path.join(GlobalData.gConfDirectory, '.cache', 'MetaFile')
+            MetaFileCache.Prune()
         self.Db = BuildDB
         self.BuildDatabase = self.Db.BuildObject
         self.Platform = None
@@ -1000,6 +1016,7 @@ class Build():
         self.ToolChainFamily = ToolChainFamily
 
         self.ThreadNumber   = ThreadNum()
+        GlobalData.gMetaFileParseJobs = self.ThreadNumber
     ## Initialize build configuration
     #
     #   This method will parse DSC file and merge the configurations from
@@ -2580,6 +2597,32 @@ def ThreadNum():
 #   @retval 0     Tool was successful
 #   @retval 1     Tool failed
 #
+## Report the AutoGen functions taking the most time
+#
+# The profile of the build process is merged with the ones the AutoGen worker
+# processes left in GlobalData.gProfileDir, and saved in Conf/.cache for a
+# closer look with pstats or other tools.
+#
+#   @param  Profiler    cProfile.Profile object of the build process
+#
+def ReportAutoGenProfile(Profiler):
+    Report = StringIO()
+    Stats = pstats.Stats(Profiler, stream=Report)
+    for File in os.listdir(GlobalData.gProfileDir):
+        try:
+            Stats.add(os.path.join(GlobalData.gProfileDir, File))
+        except:
+            EdkLogger.verbose("Failed to load profile %s" % File)
+
+    ProfileFile = os.path.join(GlobalData.gConfDirectory, '.cache', 'AutoGenProfile.prof')
+    Stats.dump_stats(ProfileFile)
+    # don't list the temporary files of the worker processes
+    Stats.files = []
+    Stats.sort_stats('cumulative').print_stats(r'[\\/](AutoGen|Workspace)[\\/]', 40)
+    EdkLogger.quiet("\nAutoGen profile of the build and AutoGen worker processes:")
+    EdkLogger.quiet(Report.getvalue())
+    EdkLogger.quiet("Profile data saved in %s" % ProfileFile)
+
 LogQMaxSize = ThreadNum() * 10
 def Main():
     StartTime = time.time()
@@ -2692,11 +2735,21 @@ def Main():
         if Option.Flag is not None and Option.Flag not in ['-c', '-s']:
             EdkLogger.error("build", OPTION_VALUE_INVALID, "UNI flag must be one of -c or -s")
 
+        Profiler = None
+        if Option.Profile:
+            GlobalData.gProfileDir = tempfile.mkdtemp(prefix='AutoGenProfile')
+            Profiler = cProfile.Profile()
+            Profiler.enable()
+
         MyBuild = Build(Target, Workspace, Option,LogQ)
         GlobalData.gCommandLineDefines['ARCH'] = ' '.join(MyBuild.ArchList)
         if not (MyBuild.LaunchPrebuildFlag and os.path.exists(MyBuild.PlatformBuildPath)):
             MyBuild.Launch()
 
+        if Profiler is not None:
+            Profiler.disable()
+            ReportAutoGenProfile(Profiler)
+
         #
         # All job done, no error found and no exception raised
         #
@@ -2750,6 +2803,8 @@ def Main():
     finally:
         Utils.Progressor.Abort()
         Utils.ClearDuplicatedInf()
+        if GlobalData.gProfileDir:
+            shutil.rmtree(GlobalData.gProfileDir, ignore_errors=True)
 
     if ReturnCode == 0:
         try:
@@ -2773,6 +2828,9 @@ def Main():
         if not BuildError:
             MyBuild.BuildReport.GenerateReport(BuildDurationStr, LogBuildTime(MyBuild.AutoGenTime), LogBuildTime(MyBuild.MakeTime), LogBuildTime(MyBuild.GenFdsTime))
 
+    if GlobalData.gMetaFileCacheDir:
+        EdkLogger.verbose("Meta file cache: %d hit(s), %d miss(es)" % (MetaFileCache.CacheHit, MetaFileCache.CacheMiss))
+
     EdkLogger.SetLevel(EdkLogger.QUIET)
     EdkLogger.quiet("\n- %s -" % Conclusion)
     EdkLogger.quiet(time.strftime("Build end time: %H:%M:%S, %b.%d %Y", time.localtime()))
@@ -101,5 +101,7 @@ class MyOptionParser():
         Parser.add_option("--binary-source", action="store", type="string", dest="BinCacheSource", help="Consume a cache of binary files from the specified directory.")
         Parser.add_option("--genfds-multi-thread", action="store_true", dest="GenfdsMultiThread", default=True, help="Enable GenFds multi thread to generate ffs file.")
         Parser.add_option("--no-genfds-multi-thread", action="store_true", dest="NoGenfdsMultiThread", default=False, help="Disable GenFds multi thread to generate ffs file.")
+        Parser.add_option("--section-cache", action="store", type="string", dest="SectionCacheDir", help="Reuse section and FFS files generated by previous builds from the specified cache directory.")
         Parser.add_option("--disable-include-path-check", action="store_true", dest="DisableIncludePathCheck", default=False, help="Disable the include path check for outside of package.")
+        Parser.add_option("--profile", action="store_true", dest="Profile", default=False, help="Profile build and AutoGen worker processes, and report the AutoGen functions taking the most time.")
         self.BuildOption, self.BuildTarget = Parser.parse_args()
@@ -20,6 +20,10 @@ def TheTestSuite():
     suites.append(CheckPythonSyntax.TheTestSuite())
     import CheckUnicodeSourceFiles
     suites.append(CheckUnicodeSourceFiles.TheTestSuite())
+    import TestMetaFileCache
+    suites.append(TestMetaFileCache.TheTestSuite())
+    import TestSectionCache
+    suites.append(TestSectionCache.TheTestSuite())
     return unittest.TestSuite(suites)
 
 if __name__ == '__main__':
@@ -0,0 +1,180 @@
+## @file
+#  Unit tests for Workspace.MetaFileCache
+#
+#  SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+##
+# Import Modules
+#
+import os
+import time
+import unittest
+
+import TestTools
+
+from Common.Misc import PathClass
+from CommonDataClass.DataClass import MODEL_FILE_INF, MODEL_FILE_DEC, MODEL_EFI_SOURCE_FILE
+import Common.GlobalData as GlobalData
+from Workspace.MetaFileParser import InfParser
+from Workspace.MetaFileTable import MetaFileStorage
+from Workspace.WorkspaceDatabase import WorkspaceDatabase
+from Workspace import MetaFileCache
+
+from Common import EdkLogger
+EdkLogger.InitializeForUnitTest()
+
+class Tests(TestTools.BaseToolsTest):
+
+    SampleInf = u'''
+        [Defines]
+          INF_VERSION    = 0x00010005
+          BASE_NAME      = Sample
+          FILE_GUID      = 7a1c5bde-5c1b-4c35-9d5a-8b8d2e4a0a11
+          MODULE_TYPE    = BASE
+          LIBRARY_CLASS  = SampleLib
+
+        [Sources]
+          %s
+
+        [Packages]
+          MdePkg/MdePkg.dec
+    '''
+
+    SampleDec = u'''
+        [Defines]
+          DEC_SPECIFICATION = 0x00010005
+          PACKAGE_NAME      = MdePkg
+          PACKAGE_GUID      = 1e73767f-8f52-4603-aeb4-f29b510b6766
+          PACKAGE_VERSION   = 1.0
+    '''
+
+    def setUp(self):
+        TestTools.BaseToolsTest.setUp(self)
+        self.SavedCacheDir = GlobalData.gMetaFileCacheDir
+        self.SavedWorkspace = GlobalData.gWorkspace
+        GlobalData.gMetaFileCacheDir = self.GetTmpFilePath('cache')
+        MetaFileCache.CacheHit = 0
+        MetaFileCache.CacheMiss = 0
+
+    def tearDown(self):
+        GlobalData.gMetaFileCacheDir = self.SavedCacheDir
+        GlobalData.gWorkspace = self.SavedWorkspace
+        TestTools.BaseToolsTest.tearDown(self)
+
+    def WriteInf(self, Source='Sample.c', Prefix='', Name='Sample.inf'):
+        self.WriteTmpFile(Name, Prefix + self.SampleInf % Source)
+        return PathClass(self.GetTmpFilePath(Name))
+
+    def Parse(self, MetaFile):
+        #
+        # Use a new database every time, so that nothing is shared with a
+        # previous parse but the cache on disk.
+        #
+        InfParser.MetaFiles.clear()
+        MetaFileStorage._ObjectCache.clear()
+        Parser = InfParser(MetaFile, MODEL_FILE_INF, 'X64',
+                           MetaFileStorage(WorkspaceDatabase(), MetaFile, MODEL_FILE_INF))
+        return [Record[:5] for Record in Parser[MODEL_EFI_SOURCE_FILE]]
+
+    def CacheEntries(self):
+        Entries = []
+        for Root, Dirs, Files in os.walk(GlobalData.gMetaFileCacheDir):
+            Entries += [os.path.join(Root, File) for File in Files if File != MetaFileCache._PRUNE_STAMP_]
+        return Entries
+
+    def testMissThenHit(self):
+        MetaFile = self.WriteInf()
+        Parsed = self.Parse(MetaFile)
+        self.assertEqual((MetaFileCache.CacheHit, MetaFileCache.CacheMiss), (0, 1))
+        self.assertEqual(len(self.CacheEntries()), 1)
+
+        Cached = self.Parse(MetaFile)
+        self.assertEqual((MetaFileCache.CacheHit, MetaFileCache.CacheMiss), (1, 1))
+        self.assertEqual(Cached, Parsed)
+        self.assertEqual(Cached[0][0], 'Sample.c')
+
+    def testContentChangeInvalidates(self):
+        self.Parse(self.WriteInf())
+        Parsed = self.Parse(self.WriteInf(Source='Other.c'))
+        self.assertEqual((MetaFileCache.CacheHit, MetaFileCache.CacheMiss), (0, 2))
+        self.assertEqual(Parsed[0][0], 'Other.c')
+        self.assertEqual(len(self.CacheEntries()), 2)
+
+        # the first content is still cached
+        self.assertEqual(self.Parse(self.WriteInf())[0][0], 'Sample.c')
+        self.assertEqual((MetaFileCache.CacheHit, MetaFileCache.CacheMiss), (1, 2))
+
+    def testDisabled(self):
+        GlobalData.gMetaFileCacheDir = None
+        MetaFile = self.WriteInf()
+        self.Parse(MetaFile)
+        self.Parse(MetaFile)
+        self.assertEqual((MetaFileCache.CacheHit, MetaFileCache.CacheMiss), (0, 0))
+        self.assertFalse(os.path.exists(self.GetTmpFilePath('cache')))
+
+    def testWarningsReplayed(self):
+        #
+        # The copy has the same content, so it uses the entry of the first
+        # file but must report the warning in its own path.
+        #
+        MetaFile = self.WriteInf(Prefix='StrayContent\n')
+        CopyFile = self.WriteInf(Prefix='StrayContent\n', Name='Copy.inf')
+        for File in (MetaFile, MetaFile, CopyFile):
+            Warnings = []
+            EdkLogger.RecordWarnings(Warnings)
+            try:
+                self.Parse(File)
+            finally:
+                EdkLogger.RecordWarnings(None)
+            self.assertEqual(Warnings, [('Parser', 'Unrecognized content', str(File), 1, 'StrayContent')])
+        self.assertEqual((MetaFileCache.CacheHit, MetaFileCache.CacheMiss), (2, 1))
+
+    def testPrune(self):
+        self.Parse(self.WriteInf())
+        self.Parse(self.WriteInf(Source='Other.c'))
+        Expired, Recent = sorted(self.CacheEntries())
+        Old = time.time() - (MetaFileCache._MAX_AGE_ + 1) * 24 * 60 * 60
+        os.utime(Expired, (Old, Old))
+
+        MetaFileCache.Prune()
+        self.assertEqual(self.CacheEntries(), [Recent])
+
+        # the cache is scanned once a day at most
+        os.utime(Recent, (Old, Old))
+        MetaFileCache.Prune()
+        self.assertEqual(self.CacheEntries(), [Recent])
+
+    def testHitRefreshesTimeStamp(self):
+        MetaFile = self.WriteInf()
+        self.Parse(MetaFile)
+        Entry, = self.CacheEntries()
+        Old = time.time() - (MetaFileCache._MAX_AGE_ + 1) * 24 * 60 * 60
+        os.utime(Entry, (Old, Old))
+
+        self.Parse(MetaFile)
+        MetaFileCache.Prune()
+        self.assertEqual(self.CacheEntries(), [Entry])
+
+    def testPreload(self):
+        GlobalData.gWorkspace = self.GetTmpFilePath('')
+        os.makedirs(self.GetTmpFilePath('MdePkg'))
+        self.WriteTmpFile(os.path.join('MdePkg', 'MdePkg.dec'), self.SampleDec)
+        Dec = PathClass(self.GetTmpFilePath(os.path.join('MdePkg', 'MdePkg.dec')))
+        MetaFile = self.WriteInf()
+        self.WriteTmpFile('Other.inf', self.SampleInf % 'Other.c')
+        Other = PathClass(self.GetTmpFilePath('Other.inf'))
+
+        MetaFileCache.Preload([MetaFile, Other], 2)
+        self.assertEqual(len(self.CacheEntries()), 3)
+        self.assertEqual(MetaFileCache._Missing([Dec], MODEL_FILE_DEC), [])
+
+        self.assertEqual(self.Parse(MetaFile)[0][0], 'Sample.c')
+        self.assertEqual(self.Parse(Other)[0][0], 'Other.c')
+        self.assertEqual((MetaFileCache.CacheHit, MetaFileCache.CacheMiss), (2, 0))
+
+TheTestSuite = TestTools.MakeTheTestSuite(locals())
+
+if __name__ == '__main__':
+    allTests = TheTestSuite()
+    unittest.TextTestRunner().run(allTests)
@@ -0,0 +1,168 @@
+## @file
+#  Unit tests for the GenFds section cache
+#
+#  SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+##
+# Import Modules
+#
+import os
+import shutil
+import stat
+import time
+import unittest
+
+import TestTools
+
+from GenFds.GenFdsGlobalVariable import GenFdsGlobalVariable
+from Workspace import MetaFileCache
+
+from Common import EdkLogger
+EdkLogger.InitializeForUnitTest()
+
+BaseToolsDir = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+WrapperDir = os.path.join(BaseToolsDir, 'BinWrappers', 'PosixLike')
+
+@unittest.skipIf(os.name == 'nt', 'BinWrappers/PosixLike is only used on POSIX hosts')
+class Tests(TestTools.BaseToolsTest):
+
+    def setUp(self):
+        TestTools.BaseToolsTest.setUp(self)
+        self.SavedEnviron = dict(os.environ)
+        self.SavedCacheDir = GenFdsGlobalVariable.SectionCacheDir
+        GenFdsGlobalVariable.SectionCacheDir = self.GetTmpFilePath('cache')
+        GenFdsGlobalVariable.ToolDigestDict = {}
+
+        #
+        # A fake BaseTools tree with the real wrapper script of a C tool
+        #
+        self.ToolsDir = self.GetTmpFilePath('BaseTools')
+        self.BinDir = os.path.join(self.ToolsDir, 'Source', 'C', 'bin')
+        os.makedirs(self.BinDir)
+        self.PathDir = os.path.join(self.ToolsDir, 'BinWrappers', 'PosixLike')
+        os.makedirs(self.PathDir)
+        shutil.copy(os.path.join(WrapperDir, 'GenSec'), os.path.join(self.PathDir, 'FakeTool'))
+        shutil.copy(os.path.join(WrapperDir, 'LzmaF86Compress'), os.path.join(self.PathDir, 'FakeF86Tool'))
+        with open(os.path.join(self.PathDir, 'FakeF86Tool')) as File:
+            Script = File.read().replace('exec LzmaCompress', 'exec FakeTool')
+        self.WriteScript(os.path.join(self.PathDir, 'FakeF86Tool'), Script)
+        self.BuildTool('First')
+
+        #
+        # The real wrapper script of a Python tool run from source
+        #
+        shutil.copy(os.path.join(WrapperDir, 'Rsa2048Sha256Sign'), os.path.join(self.PathDir, 'FakePyTool'))
+        self.PythonDir = os.path.join(self.ToolsDir, 'Source', 'Python', 'FakePyTool')
+        os.makedirs(self.PythonDir)
+        self.WriteScript(os.path.join(self.PythonDir, 'FakePyTool.py'), 'print("FakePyTool")\n')
+        self.WriteScript(os.path.join(self.PythonDir, 'TestSigningPrivateKey.pem'), 'First\n')
+
+        os.environ['WORKSPACE'] = self.GetTmpFilePath('')
+        os.environ['EDK_TOOLS_PATH'] = self.ToolsDir
+        os.environ['PATH'] = self.PathDir + os.pathsep + os.environ['PATH']
+        self.WriteTmpFile('Input.bin', 'Input')
+
+    def tearDown(self):
+        os.environ.clear()
+        os.environ.update(self.SavedEnviron)
+        GenFdsGlobalVariable.SectionCacheDir = self.SavedCacheDir
+        GenFdsGlobalVariable.ToolDigestDict = {}
+        TestTools.BaseToolsTest.tearDown(self)
+
+    def WriteScript(self, Path, Script):
+        with open(Path, 'w') as File:
+            File.write(Script)
+        os.chmod(Path, os.stat(Path).st_mode | stat.S_IXUSR)
+
+    ## Put a tool writing Version followed by its input to the output in Source/C/bin
+    def BuildTool(self, Version):
+        self.WriteScript(os.path.join(self.BinDir, 'FakeTool'),
+                         '#!/bin/sh\n{ echo %s; cat "$3"; } > "$2"\n' % Version)
+
+    ## Run a tool through the section cache like a new GenFds process does
+    def RunTool(self, Tool):
+        GenFdsGlobalVariable.ToolDigestDict = {}
+        Output = self.GetTmpFilePath('Output.bin')
+        if os.path.exists(Output):
+            os.remove(Output)
+        GenFdsGlobalVariable.CallCachedTool([Tool, '-o', Output, self.GetTmpFilePath('Input.bin')],
+                                            Output, 'Failed to call ' + Tool)
+        with open(Output) as File:
+            return File.read()
+
+    def testToolBinaryResolved(self):
+        Files = GenFdsGlobalVariable._GetToolFiles(os.path.join(self.PathDir, 'FakeTool'))
+        self.assertEqual(Files, [os.path.join(self.PathDir, 'FakeTool'), os.path.join(self.BinDir, 'FakeTool')])
+
+        # a missing binary disables caching rather than hashing the wrapper only
+        os.remove(os.path.join(self.BinDir, 'FakeTool'))
+        self.assertIsNone(GenFdsGlobalVariable._GetToolFiles(os.path.join(self.PathDir, 'FakeTool')))
+
+    def testPythonToolResolved(self):
+        Files = GenFdsGlobalVariable._GetToolFiles(os.path.join(self.PathDir, 'FakePyTool'))
+        self.assertEqual(Files, [os.path.join(self.PathDir, 'FakePyTool'),
+                                 os.path.join(self.PythonDir, 'FakePyTool.py'),
+                                 os.path.join(self.PythonDir, 'TestSigningPrivateKey.pem')])
+
+        # a new signing key changes the output, so it must change the digest too
+        GenFdsGlobalVariable.ToolDigestDict = {}
+        Digest = GenFdsGlobalVariable._GetToolDigest('FakePyTool')
+        self.WriteScript(os.path.join(self.PythonDir, 'TestSigningPrivateKey.pem'), 'Second\n')
+        GenFdsGlobalVariable.ToolDigestDict = {}
+        self.assertNotEqual(GenFdsGlobalVariable._GetToolDigest('FakePyTool'), Digest)
+
+    def testBatchWrapperResolved(self):
+        with open(os.path.join(BaseToolsDir, 'Source', 'C', 'LzmaCompress', 'LzmaF86Compress.bat')) as File:
+            Script = File.read().replace('LzmaCompress %ARGS%', 'FakeTool %ARGS%')
+        BatchFile = self.GetTmpFilePath('FakeF86Tool.bat')
+        self.WriteScript(BatchFile, Script)
+        Files = GenFdsGlobalVariable._GetToolFiles(BatchFile)
+        self.assertEqual(Files, [BatchFile, os.path.join(self.PathDir, 'FakeTool'), os.path.join(self.BinDir, 'FakeTool')])
+
+    def testUnresolvedWrapper(self):
+        # a tool installed with pip can't be found from its wrapper
+        shutil.copy(os.path.join(BaseToolsDir, 'BinPipWrappers', 'PosixLike', 'Rsa2048Sha256Sign'),
+                    os.path.join(self.PathDir, 'FakePipTool'))
+        self.assertIsNone(GenFdsGlobalVariable._GetToolFiles(os.path.join(self.PathDir, 'FakePipTool')))
+
+    def testUnusedEntriesExpire(self):
+        self.RunTool('FakeTool')
+        SubDir = os.listdir(GenFdsGlobalVariable.SectionCacheDir)[0]
+        SubDir = os.path.join(GenFdsGlobalVariable.SectionCacheDir, SubDir)
+        CacheFile = os.path.join(SubDir, os.listdir(SubDir)[0])
+
+        # a cache hit keeps the entry from expiring
+        Old = time.time() - 2 * MetaFileCache._TOUCH_INTERVAL_
+        os.utime(CacheFile, (Old, Old))
+        self.RunTool('FakeTool')
+        self.assertGreater(os.path.getmtime(CacheFile), Old)
+        MetaFileCache.Prune(GenFdsGlobalVariable.SectionCacheDir)
+        self.assertTrue(os.path.exists(CacheFile))
+
+        Old = time.time() - (MetaFileCache._MAX_AGE_ + 1) * 24 * 60 * 60
+        os.utime(CacheFile, (Old, Old))
+        os.remove(os.path.join(GenFdsGlobalVariable.SectionCacheDir, MetaFileCache._PRUNE_STAMP_))
+        MetaFileCache.Prune(GenFdsGlobalVariable.SectionCacheDir)
+        self.assertFalse(os.path.exists(CacheFile))
+
+    def testRebuiltToolInvalidates(self):
+        Hit = GenFdsGlobalVariable.SectionCacheHit
+        self.assertEqual(self.RunTool('FakeTool'), 'First\nInput')
+        self.assertEqual(self.RunTool('FakeTool'), 'First\nInput')
+        self.assertEqual(GenFdsGlobalVariable.SectionCacheHit, Hit + 1)
+
+        self.BuildTool('Second')
+        self.assertEqual(self.RunTool('FakeTool'), 'Second\nInput')
+        self.assertEqual(GenFdsGlobalVariable.SectionCacheHit, Hit + 1)
+
+    def testRebuiltToolInvalidatesChainedWrapper(self):
+        self.assertEqual(self.RunTool('FakeF86Tool'), 'First\nInput')
+        self.BuildTool('Second')
+        self.assertEqual(self.RunTool('FakeF86Tool'), 'Second\nInput')
+
+TheTestSuite = TestTools.MakeTheTestSuite(locals())
+
+if __name__ == '__main__':
+    allTests = TheTestSuite()
+    unittest.TextTestRunner().run(allTests)
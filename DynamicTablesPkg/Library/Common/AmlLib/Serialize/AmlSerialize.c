@@ -184,32 +184,21 @@ AmlSerializeTree (
     return EFI_INVALID_PARAMETER;
   }
 
-  // Compute the total size of the AML blob.
-  Status = AmlComputeSize (
-              (CONST AML_NODE_HEADER*)RootNode,
-              &TableSize
-              );
-  if (EFI_ERROR (Status)) {
-    ASSERT (0);
-    return Status;
-  }
-
-  // Add the size of the ACPI header.
-  TableSize += (UINT32)sizeof (EFI_ACPI_DESCRIPTION_HEADER);
-
-  // Check the size against the SDT header.
   // The Length field in the SDT Header is updated if the tree has
-  // been modified.
-  if (TableSize != RootNode->SdtHeader->Length) {
+  // been modified, so the tree doesn't need to be walked to get the
+  // size of the table. The size is checked once the tree is serialized.
+  TableSize = RootNode->SdtHeader->Length;
+  if (TableSize < sizeof (EFI_ACPI_DESCRIPTION_HEADER)) {
     ASSERT (0);
     return EFI_INVALID_PARAMETER;
   }
 
   // Buffer is not big enough, or NULL.
-  if ((TableSize < *BufferSize) || (Buffer == NULL)) {
+  if ((*BufferSize < TableSize) || (Buffer == NULL)) {
     *BufferSize = TableSize;
     return EFI_SUCCESS;
   }
+  *BufferSize = TableSize;
 
   // Initialize the stream to the TableSize that is needed.
   Status = AmlStreamInit (
@@ -246,6 +235,13 @@ AmlSerializeTree (
     return Status;
   }
 
+  // Check the size against the SDT header. A tree bigger than the
+  // SDT header Length fails to be written to the stream.
+  if (AmlStreamGetIndex (&FStream) != TableSize) {
+    ASSERT (0);
+    return EFI_INVALID_PARAMETER;
+  }
+
   // Update the checksum.
   return AcpiPlatformChecksum ((EFI_ACPI_DESCRIPTION_HEADER*)Buffer);
 }
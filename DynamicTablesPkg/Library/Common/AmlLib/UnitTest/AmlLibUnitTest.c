@@ -0,0 +1,358 @@
+/** @file
+  Host-based unit tests and benchmarks for AmlLib.
+
+  The tests generate an SSDT describing the CPU topology of a large server
+  with the AML code generation APIs, and check the serialized table.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include <AmlNodeDefines.h>
+#include <AmlCoreInterface.h>
+#include <AmlInclude.h>
+#include <Utils/AmlUtility.h>
+#include <Library/PrintLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "AmlLib Unit Test"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define TEST_CLUSTER_COUNT        8
+#define TEST_CPUS_PER_CLUSTER     64
+#define BENCHMARK_ITERATIONS      20
+
+///=== TEST DATA ==================================================================================
+
+/**
+  Generate an SSDT describing CPUs grouped in clusters, the way the CPU
+  topology generators describe them:
+
+    Scope (\_SB) {
+      Device (CL00) {
+        Name (_HID, "ACPI0010")
+        Name (_UID, 0)
+        Device (C000) {
+          Name (_HID, "ACPI0007")
+          Name (_UID, 0)
+        }
+        ...
+      }
+      ...
+    }
+
+  @param[in]  ClusterCount      The number of clusters.
+  @param[in]  CpusPerCluster    The number of CPUs in each cluster.
+  @param[out] RootNode          The root node of the generated tree.
+
+  @retval EFI_SUCCESS   The tree was generated.
+  @retval Others        The tree could not be generated.
+
+**/
+STATIC
+EFI_STATUS
+GenerateCpuTopologySsdt (
+  IN  UINTN             ClusterCount,
+  IN  UINTN             CpusPerCluster,
+  OUT AML_ROOT_NODE     **RootNode
+  )
+{
+  EFI_STATUS       Status;
+  AML_OBJECT_NODE  *ScopeNode;
+  AML_OBJECT_NODE  *ClusterNode;
+  AML_OBJECT_NODE  *CpuNode;
+  CHAR8            Name[AML_NAME_SEG_SIZE + 1];
+  UINTN            Cluster;
+  UINTN            Cpu;
+  UINTN            CpuIndex;
+
+  Status = AmlCodeGenDefinitionBlock ("SSDT", "EDK2  ", "CPU-TOPO", 1, RootNode);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = AmlCodeGenScope ("\\_SB", (AML_NODE_HEADER *) *RootNode, &ScopeNode);
+  CpuIndex = 0;
+  for (Cluster = 0; !EFI_ERROR (Status) && (Cluster < ClusterCount); Cluster++) {
+    AsciiSPrint (Name, sizeof (Name), "CL%02X", Cluster);
+    Status = AmlCodeGenDevice (Name, (AML_NODE_HEADER *) ScopeNode, &ClusterNode);
+    if (!EFI_ERROR (Status)) {
+      Status = AmlCodeGenNameString ("_HID", "ACPI0010", (AML_NODE_HEADER *) ClusterNode, NULL);
+    }
+    if (!EFI_ERROR (Status)) {
+      Status = AmlCodeGenNameInteger ("_UID", Cluster, (AML_NODE_HEADER *) ClusterNode, NULL);
+    }
+
+    for (Cpu = 0; !EFI_ERROR (Status) && (Cpu < CpusPerCluster); Cpu++, CpuIndex++) {
+      AsciiSPrint (Name, sizeof (Name), "C%03X", CpuIndex);
+      Status = AmlCodeGenDevice (Name, (AML_NODE_HEADER *) ClusterNode, &CpuNode);
+      if (!EFI_ERROR (Status)) {
+        Status = AmlCodeGenNameString ("_HID", "ACPI0007", (AML_NODE_HEADER *) CpuNode, NULL);
+      }
+      if (!EFI_ERROR (Status)) {
+        Status = AmlCodeGenNameInteger ("_UID", CpuIndex, (AML_NODE_HEADER *) CpuNode, NULL);
+      }
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    AmlDeleteTree ((AML_NODE_HEADER *) *RootNode);
+    *RootNode = NULL;
+  }
+  return Status;
+}
+
+///=== TEST CASES =================================================================================
+
+/**
+  The serialized table must have the size of the tree, a valid checksum, and
+  must serialize to the same bytes once parsed again.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SerializedTableShouldRoundTrip (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS                   Status;
+  AML_ROOT_NODE                *RootNode;
+  AML_ROOT_NODE                *ParsedRootNode;
+  EFI_ACPI_DESCRIPTION_HEADER  *Table;
+  EFI_ACPI_DESCRIPTION_HEADER  *ParsedTable;
+  UINT32                       TreeSize;
+
+  Status = GenerateCpuTopologySsdt (TEST_CLUSTER_COUNT, TEST_CPUS_PER_CLUSTER, &RootNode);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  Status = AmlSerializeDefinitionBlock (RootNode, &Table);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  Status = AmlComputeSize ((AML_NODE_HEADER *) RootNode, &TreeSize);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (Table->Length, TreeSize + sizeof (EFI_ACPI_DESCRIPTION_HEADER));
+  UT_ASSERT_EQUAL (CalculateSum8 ((UINT8 *) Table, Table->Length), 0);
+
+  Status = AmlParseDefinitionBlock (Table, &ParsedRootNode);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  Status = AmlSerializeDefinitionBlock (ParsedRootNode, &ParsedTable);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (ParsedTable->Length, Table->Length);
+  UT_ASSERT_MEM_EQUAL (ParsedTable, Table, Table->Length);
+
+  FreePool (ParsedTable);
+  FreePool (Table);
+  AmlDeleteTree ((AML_NODE_HEADER *) ParsedRootNode);
+  AmlDeleteTree ((AML_NODE_HEADER *) RootNode);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  AmlSerializeTree() must report the table size for a NULL or too small
+  buffer, and serialize into a buffer of the exact size or larger.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SerializeTreeShouldHandleBufferSizes (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS                   Status;
+  AML_ROOT_NODE                *RootNode;
+  EFI_ACPI_DESCRIPTION_HEADER  *Table;
+  UINT8                        *Buffer;
+  UINT32                       BufferSize;
+  UINT32                       TableSize;
+
+  Status = GenerateCpuTopologySsdt (2, 4, &RootNode);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  Status = AmlSerializeDefinitionBlock (RootNode, &Table);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  TableSize = Table->Length;
+
+  BufferSize = 0;
+  Status = AmlSerializeTree (RootNode, NULL, &BufferSize);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (BufferSize, TableSize);
+
+  Buffer = AllocateZeroPool (TableSize + 16);
+  UT_ASSERT_NOT_NULL (Buffer);
+
+  BufferSize = TableSize - 1;
+  Status = AmlSerializeTree (RootNode, Buffer, &BufferSize);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (BufferSize, TableSize);
+  UT_ASSERT_EQUAL (((EFI_ACPI_DESCRIPTION_HEADER *) Buffer)->Length, 0);
+
+  BufferSize = TableSize + 16;
+  Status = AmlSerializeTree (RootNode, Buffer, &BufferSize);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (BufferSize, TableSize);
+  UT_ASSERT_MEM_EQUAL (Buffer, Table, TableSize);
+
+  FreePool (Buffer);
+  FreePool (Table);
+  AmlDeleteTree ((AML_NODE_HEADER *) RootNode);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Benchmark: time generating, serializing and parsing a 512 CPU topology SSDT.
+  The serialization is compared with the two extra tree walks computing the
+  table size that AmlSerializeDefinitionBlock() used to make.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BenchmarkCpuTopologySsdt (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS                   Status;
+  AML_ROOT_NODE                *RootNode;
+  AML_ROOT_NODE                *ParsedRootNode;
+  EFI_ACPI_DESCRIPTION_HEADER  *Table;
+  UINT32                       TreeSize;
+  UINTN                        Iteration;
+  clock_t                      Start;
+  clock_t                      GenerateTicks;
+  clock_t                      SerializeTicks;
+  clock_t                      SizeTicks;
+  clock_t                      ParseTicks;
+
+  GenerateTicks  = 0;
+  SerializeTicks = 0;
+  SizeTicks      = 0;
+  ParseTicks     = 0;
+  Table          = NULL;
+  for (Iteration = 0; Iteration < BENCHMARK_ITERATIONS; Iteration++) {
+    Start = clock ();
+    Status = GenerateCpuTopologySsdt (TEST_CLUSTER_COUNT, TEST_CPUS_PER_CLUSTER, &RootNode);
+    GenerateTicks += clock () - Start;
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+
+    Start = clock ();
+    Status = AmlSerializeDefinitionBlock (RootNode, &Table);
+    SerializeTicks += clock () - Start;
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+
+    Start = clock ();
+    AmlComputeSize ((AML_NODE_HEADER *) RootNode, &TreeSize);
+    AmlComputeSize ((AML_NODE_HEADER *) RootNode, &TreeSize);
+    SizeTicks += clock () - Start;
+
+    Start = clock ();
+    Status = AmlParseDefinitionBlock (Table, &ParsedRootNode);
+    ParseTicks += clock () - Start;
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+
+    AmlDeleteTree ((AML_NODE_HEADER *) ParsedRootNode);
+    AmlDeleteTree ((AML_NODE_HEADER *) RootNode);
+    if (Iteration + 1 < BENCHMARK_ITERATIONS) {
+      FreePool (Table);
+    }
+  }
+
+  UT_LOG_INFO (
+    "%d CPU SSDT of %d bytes, average of %d runs: generate %d us, parse %d us\n",
+    TEST_CLUSTER_COUNT * TEST_CPUS_PER_CLUSTER,
+    Table->Length,
+    BENCHMARK_ITERATIONS,
+    (int) ((UINT64) GenerateTicks * 1000000 / CLOCKS_PER_SEC / BENCHMARK_ITERATIONS),
+    (int) ((UINT64) ParseTicks * 1000000 / CLOCKS_PER_SEC / BENCHMARK_ITERATIONS)
+    );
+  UT_LOG_INFO (
+    "Serialize %d us, plus %d us for the two size walks it no longer makes\n",
+    (int) ((UINT64) SerializeTicks * 1000000 / CLOCKS_PER_SEC / BENCHMARK_ITERATIONS),
+    (int) ((UINT64) SizeTicks * 1000000 / CLOCKS_PER_SEC / BENCHMARK_ITERATIONS)
+    );
+
+  FreePool (Table);
+  return UNIT_TEST_PASSED;
+}
+
+///=== TEST ENGINE ================================================================================
+
+/**
+  Initialize the unit test framework, suite, and unit tests for AmlLib and
+  run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      SerializeTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&SerializeTests, Framework, "AML Serialization Tests", "AmlLib.Serialize", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for the AML serialization tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+  AddTestCase (SerializeTests, "Serialized table should round trip", "RoundTrip", SerializedTableShouldRoundTrip, NULL, NULL, NULL);
+  AddTestCase (SerializeTests, "AmlSerializeTree should handle buffer sizes", "BufferSize", SerializeTreeShouldHandleBufferSizes, NULL, NULL, NULL);
+  AddTestCase (SerializeTests, "Time a 512 CPU topology SSDT", "CpuTopologyBenchmark", BenchmarkCpuTopologySsdt, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -641,6 +641,51 @@ EnablePageTableProtection (
   AsmWriteCr0 (AsmReadCr0() | CR0_WP);
 }
 
+/**
+  Get the number of physical address bits needed to cover all memory, MMIO and
+  firmware volumes described by HOBs.
+
+  The space below 4GB is always covered, since the legacy MMIO like local APIC
+  may not be described by resource descriptor HOB.
+
+  @return The number of physical address bits needed.
+
+**/
+STATIC
+UINT8
+GetPhysicalAddressBitsFromHobs (
+  VOID
+  )
+{
+  EFI_PEI_HOB_POINTERS                          Hob;
+  EFI_PHYSICAL_ADDRESS                          MaxAddress;
+
+  MaxAddress = BASE_4GB;
+  for (Hob.Raw = GetHobList (); !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    switch (GET_HOB_TYPE (Hob)) {
+    case EFI_HOB_TYPE_RESOURCE_DESCRIPTOR:
+      if ((Hob.ResourceDescriptor->ResourceType != EFI_RESOURCE_IO) &&
+          (Hob.ResourceDescriptor->ResourceType != EFI_RESOURCE_IO_RESERVED)) {
+        MaxAddress = MAX (MaxAddress, Hob.ResourceDescriptor->PhysicalStart + Hob.ResourceDescriptor->ResourceLength);
+      }
+      break;
+
+    case EFI_HOB_TYPE_MEMORY_ALLOCATION:
+      MaxAddress = MAX (MaxAddress, Hob.MemoryAllocation->AllocDescriptor.MemoryBaseAddress + Hob.MemoryAllocation->AllocDescriptor.MemoryLength);
+      break;
+
+    case EFI_HOB_TYPE_FV:
+      MaxAddress = MAX (MaxAddress, Hob.FirmwareVolume->BaseAddress + Hob.FirmwareVolume->Length);
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  return (UINT8) (HighBitSet64 (MaxAddress - 1) + 1);
+}
+
 /**
   Allocates and fills in the Page Directory and Page Table Entries to
   establish a 1:1 Virtual to Physical mapping.
@@ -665,6 +710,7 @@ CreateIdentityMappingPageTables (
   CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS_ECX   EcxFlags;
   UINT32                                        RegEdx;
   UINT8                                         PhysicalAddressBits;
+  UINT8                                         HobAddressBits;
   EFI_PHYSICAL_ADDRESS                          PageAddress;
   UINTN                                         IndexOfPml5Entries;
   UINTN                                         IndexOfPml4Entries;
@@ -692,6 +738,8 @@ CreateIdentityMappingPageTables (
   //
   PageMapLevel5Entry = NULL;
 
+  PERF_INMODULE_BEGIN ("CreateIdentityMappingPageTables");
+
   //
   // Make sure AddressEncMask is contained to smallest supported address field
   //
@@ -735,6 +783,19 @@ CreateIdentityMappingPageTables (
     }
   }
 
+  //
+  // Only map the address space really used by the platform if it's allowed.
+  // It saves lots of page table memory when the CPU supports a huge physical
+  // address space but 1G page is not used.
+  //
+  if (PcdGetBool (PcdLimitIdentityMapToResourceHobs)) {
+    HobAddressBits = GetPhysicalAddressBitsFromHobs ();
+    if (HobAddressBits < PhysicalAddressBits) {
+      DEBUG ((DEBUG_INFO, "AddressBits limited from %u to %u by resource HOBs\n", PhysicalAddressBits, HobAddressBits));
+      PhysicalAddressBits = HobAddressBits;
+    }
+  }
+
   DEBUG ((DEBUG_INFO, "AddressBits=%u 5LevelPaging=%u 1GPage=%u\n", PhysicalAddressBits, Page5LevelSupport, Page1GSupport));
 
   //
@@ -928,6 +989,8 @@ CreateIdentityMappingPageTables (
     EnableExecuteDisableBit ();
   }
 
+  PERF_INMODULE_END ("CreateIdentityMappingPageTables");
+
   return (UINTN)PageMap;
 }
 
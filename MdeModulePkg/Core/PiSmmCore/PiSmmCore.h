@@ -80,6 +80,7 @@ typedef struct {
 
   EFI_GUID    HandlerType; // Type of interrupt
   LIST_ENTRY  SmiHandlers; // All handlers
+  LIST_ENTRY  HashLink;    // Link on the mSmiEntryHash bucket of HandlerType
 } SMI_ENTRY;
 
 #define SMI_HANDLER_SIGNATURE  SIGNATURE_32('s','m','i','h')
@@ -92,6 +93,9 @@ typedef struct {
   SMI_ENTRY                     *SmiEntry;
   VOID                          *Context;    // for profile
   UINTN                         ContextSize; // for profile
+  UINT64                        CallCount;   // for profile, calls made by SmiManage()
+  UINT64                        TotalTicks;  // for profile, performance counter ticks of all calls
+  UINT64                        MaxTicks;    // for profile, performance counter ticks of the longest call
 } SMI_HANDLER;
 
 //
@@ -1148,6 +1152,24 @@ SmmCoreInitializeSmiHandlerProfile (
   VOID
   );
 
+/**
+  Call an SMI handler and record the number of calls and the time spent in it.
+
+  @param  SmiHandler     The SMI handler to call.
+  @param  Context        Points to an optional context buffer.
+  @param  CommBuffer     Points to the optional communication buffer.
+  @param  CommBufferSize Points to the size of the optional communication buffer.
+
+  @return The status returned by the SMI handler.
+**/
+EFI_STATUS
+SmiHandlerProfileCallHandler (
+  IN     SMI_HANDLER     *SmiHandler,
+  IN     CONST VOID      *Context         OPTIONAL,
+  IN OUT VOID            *CommBuffer      OPTIONAL,
+  IN OUT UINTN           *CommBufferSize  OPTIONAL
+  );
+
 /**
   This function is called by SmmChildDispatcher module to report
   a new SMI handler is registered, to SmmCore.
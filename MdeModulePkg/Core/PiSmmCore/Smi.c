@@ -10,6 +10,34 @@
 
 LIST_ENTRY  mSmiEntryList       = INITIALIZE_LIST_HEAD_VARIABLE (mSmiEntryList);
 
+//
+// SMI entries hashed by HandlerType, so that SmiManage() does not need to walk
+// every registered entry on each SMM communication. The buckets are initialized
+// statically: library constructors may register SMI handlers before SmmMain().
+//
+#define SMI_ENTRY_HASH_BUCKETS(Index) \
+  INITIALIZE_LIST_HEAD_VARIABLE (mSmiEntryHash[(Index)]),     \
+  INITIALIZE_LIST_HEAD_VARIABLE (mSmiEntryHash[(Index) + 1]), \
+  INITIALIZE_LIST_HEAD_VARIABLE (mSmiEntryHash[(Index) + 2]), \
+  INITIALIZE_LIST_HEAD_VARIABLE (mSmiEntryHash[(Index) + 3]), \
+  INITIALIZE_LIST_HEAD_VARIABLE (mSmiEntryHash[(Index) + 4]), \
+  INITIALIZE_LIST_HEAD_VARIABLE (mSmiEntryHash[(Index) + 5]), \
+  INITIALIZE_LIST_HEAD_VARIABLE (mSmiEntryHash[(Index) + 6]), \
+  INITIALIZE_LIST_HEAD_VARIABLE (mSmiEntryHash[(Index) + 7])
+
+LIST_ENTRY  mSmiEntryHash[] = {
+  SMI_ENTRY_HASH_BUCKETS (0),
+  SMI_ENTRY_HASH_BUCKETS (8),
+  SMI_ENTRY_HASH_BUCKETS (16),
+  SMI_ENTRY_HASH_BUCKETS (24),
+  SMI_ENTRY_HASH_BUCKETS (32),
+  SMI_ENTRY_HASH_BUCKETS (40),
+  SMI_ENTRY_HASH_BUCKETS (48),
+  SMI_ENTRY_HASH_BUCKETS (56)
+};
+
+#define SMI_ENTRY_HASH_SIZE  ARRAY_SIZE (mSmiEntryHash)
+
 SMI_ENTRY   mRootSmiEntry = {
   SMI_ENTRY_SIGNATURE,
   INITIALIZE_LIST_HEAD_VARIABLE (mRootSmiEntry.AllEntries),
@@ -33,19 +61,22 @@ SmmCoreFindSmiEntry (
   IN BOOLEAN   Create
   )
 {
+  LIST_ENTRY  *Bucket;
   LIST_ENTRY  *Link;
   SMI_ENTRY   *Item;
   SMI_ENTRY   *SmiEntry;
 
+  Bucket = &mSmiEntryHash[ReadUnaligned32 ((UINT32 *) HandlerType) % SMI_ENTRY_HASH_SIZE];
+
   //
-  // Search the SMI entry list for the matching GUID
+  // Search the SMI entry hash bucket for the matching GUID
   //
   SmiEntry = NULL;
-  for (Link = mSmiEntryList.ForwardLink;
-       Link != &mSmiEntryList;
+  for (Link = Bucket->ForwardLink;
+       Link != Bucket;
        Link = Link->ForwardLink) {
 
-    Item = CR (Link, SMI_ENTRY, AllEntries, SMI_ENTRY_SIGNATURE);
+    Item = CR (Link, SMI_ENTRY, HashLink, SMI_ENTRY_SIGNATURE);
     if (CompareGuid (&Item->HandlerType, HandlerType)) {
       //
       // This is the SMI entry
@@ -73,6 +104,7 @@ SmmCoreFindSmiEntry (
       // Add it to SMI entry list
       //
       InsertTailList (&mSmiEntryList, &SmiEntry->AllEntries);
+      InsertTailList (Bucket, &SmiEntry->HashLink);
     }
   }
   return SmiEntry;
@@ -132,12 +164,16 @@ SmiManage (
   for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
     SmiHandler = CR (Link, SMI_HANDLER, Link, SMI_HANDLER_SIGNATURE);
 
-    Status = SmiHandler->Handler (
-               (EFI_HANDLE) SmiHandler,
-               Context,
-               CommBuffer,
-               CommBufferSize
-               );
+    if ((PcdGet8 (PcdSmiHandlerProfilePropertyMask) & (BIT0 | BIT1)) == (BIT0 | BIT1)) {
+      Status = SmiHandlerProfileCallHandler (SmiHandler, Context, CommBuffer, CommBufferSize);
+    } else {
+      Status = SmiHandler->Handler (
+                 (EFI_HANDLE) SmiHandler,
+                 Context,
+                 CommBuffer,
+                 CommBufferSize
+                 );
+    }
 
     switch (Status) {
     case EFI_INTERRUPT_PENDING:
@@ -325,6 +361,7 @@ SmiHandlerUnRegister (
     // No handler registered for this interrupt now, remove the SMI_ENTRY
     //
     RemoveEntryList (&SmiEntry->AllEntries);
+    RemoveEntryList (&SmiEntry->HashLink);
 
     FreePool (SmiEntry);
   }
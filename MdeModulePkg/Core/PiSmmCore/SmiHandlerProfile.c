@@ -17,6 +17,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/PeCoffGetEntryPointLib.h>
+#include <Library/TimerLib.h>
 #include <Protocol/LoadedImage.h>
 #include <Protocol/SmmAccess2.h>
 #include <Protocol/SmmReadyToLock.h>
@@ -98,6 +99,9 @@ GLOBAL_REMOVE_IF_UNREFERENCED UINTN  mSmmHardwareSmiDatabaseSize;
 
 GLOBAL_REMOVE_IF_UNREFERENCED BOOLEAN  mSmiHandlerProfileRecordingStatus;
 
+GLOBAL_REMOVE_IF_UNREFERENCED UINT64  mPerformanceCounterStartValue;
+GLOBAL_REMOVE_IF_UNREFERENCED UINT64  mPerformanceCounterEndValue;
+
 GLOBAL_REMOVE_IF_UNREFERENCED SMI_HANDLER_PROFILE_PROTOCOL  mSmiHandlerProfile = {
   SmiHandlerProfileRegisterHandler,
   SmiHandlerProfileUnregisterHandler,
@@ -707,6 +711,9 @@ GetSmmSmiHandlerDataOnSmiEntry(
     SmiHandlerStruct->Handler = (UINTN)SmiHandler->Handler;
     SmiHandlerStruct->ImageRef = AddressToImageRef((UINTN)SmiHandler->Handler);
     SmiHandlerStruct->ContextBufferSize = (UINT32)SmiHandler->ContextSize;
+    SmiHandlerStruct->CallCount = SmiHandler->CallCount;
+    SmiHandlerStruct->TotalTimeInNanoSecond = GetTimeInNanoSecond (SmiHandler->TotalTicks);
+    SmiHandlerStruct->MaxTimeInNanoSecond = GetTimeInNanoSecond (SmiHandler->MaxTicks);
     if (SmiHandler->ContextSize != 0) {
       SmiHandlerStruct->ContextBufferOffset = sizeof(SMM_CORE_SMI_HANDLER_STRUCTURE);
       CopyMem ((UINT8 *)SmiHandlerStruct + SmiHandlerStruct->ContextBufferOffset, SmiHandler->Context, SmiHandler->ContextSize);
@@ -891,8 +898,21 @@ SmiHandlerProfileHandlerGetInfo(
   SmiHandlerProfileRecordingStatus = mSmiHandlerProfileRecordingStatus;
   mSmiHandlerProfileRecordingStatus = FALSE;
 
-  SmiHandlerProfileParameterGetInfo->DataSize = mSmiHandlerProfileDatabaseSize;
-  SmiHandlerProfileParameterGetInfo->Header.ReturnStatus = 0;
+  //
+  // The call counters keep changing, so each dump gets a new database.
+  //
+  if ((PcdGet8 (PcdSmiHandlerProfilePropertyMask) & BIT1) != 0) {
+    FreePool (mSmiHandlerProfileDatabase);
+    BuildSmiHandlerProfileDatabase ();
+  }
+
+  if (mSmiHandlerProfileDatabase == NULL) {
+    SmiHandlerProfileParameterGetInfo->DataSize = 0;
+    SmiHandlerProfileParameterGetInfo->Header.ReturnStatus = (UINT64)(INT64)(INTN)EFI_OUT_OF_RESOURCES;
+  } else {
+    SmiHandlerProfileParameterGetInfo->DataSize = mSmiHandlerProfileDatabaseSize;
+    SmiHandlerProfileParameterGetInfo->Header.ReturnStatus = 0;
+  }
 
   mSmiHandlerProfileRecordingStatus = SmiHandlerProfileRecordingStatus;
 }
@@ -1332,6 +1352,64 @@ SmiHandlerProfileUnregisterHandler (
   return EFI_SUCCESS;
 }
 
+/**
+  Call an SMI handler and record the number of calls and the time spent in it.
+
+  @param  SmiHandler     The SMI handler to call.
+  @param  Context        Points to an optional context buffer.
+  @param  CommBuffer     Points to the optional communication buffer.
+  @param  CommBufferSize Points to the size of the optional communication buffer.
+
+  @return The status returned by the SMI handler.
+**/
+EFI_STATUS
+SmiHandlerProfileCallHandler (
+  IN     SMI_HANDLER     *SmiHandler,
+  IN     CONST VOID      *Context         OPTIONAL,
+  IN OUT VOID            *CommBuffer      OPTIONAL,
+  IN OUT UINTN           *CommBufferSize  OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+  UINT64      StartTicks;
+  UINT64      EndTicks;
+  UINT64      Ticks;
+
+  StartTicks = GetPerformanceCounter ();
+  Status = SmiHandler->Handler (
+             (EFI_HANDLE) SmiHandler,
+             Context,
+             CommBuffer,
+             CommBufferSize
+             );
+  EndTicks = GetPerformanceCounter ();
+
+  //
+  // The performance counter may count down, and may wrap around once.
+  //
+  if (mPerformanceCounterEndValue >= mPerformanceCounterStartValue) {
+    if (EndTicks >= StartTicks) {
+      Ticks = EndTicks - StartTicks;
+    } else {
+      Ticks = (mPerformanceCounterEndValue - StartTicks) + (EndTicks - mPerformanceCounterStartValue);
+    }
+  } else {
+    if (StartTicks >= EndTicks) {
+      Ticks = StartTicks - EndTicks;
+    } else {
+      Ticks = (StartTicks - mPerformanceCounterEndValue) + (mPerformanceCounterStartValue - EndTicks);
+    }
+  }
+
+  SmiHandler->CallCount++;
+  SmiHandler->TotalTicks += Ticks;
+  if (Ticks > SmiHandler->MaxTicks) {
+    SmiHandler->MaxTicks = Ticks;
+  }
+
+  return Status;
+}
+
 /**
   Initialize SmiHandler profile feature.
 **/
@@ -1345,6 +1423,10 @@ SmmCoreInitializeSmiHandlerProfile (
   EFI_HANDLE  Handle;
 
   if ((PcdGet8 (PcdSmiHandlerProfilePropertyMask) & 0x1) != 0) {
+    if ((PcdGet8 (PcdSmiHandlerProfilePropertyMask) & BIT1) != 0) {
+      GetPerformanceCounterProperties (&mPerformanceCounterStartValue, &mPerformanceCounterEndValue);
+    }
+
     InsertTailList (&mRootSmiEntryList, &mRootSmiEntry.AllEntries);
 
     Status = gSmst->SmmRegisterProtocolNotify (
@@ -42,7 +42,7 @@ typedef struct {
 } SMM_CORE_IMAGE_DATABASE_STRUCTURE;
 
 #define SMM_CORE_SMI_DATABASE_SIGNATURE SIGNATURE_32 ('S','C','S','D')
-#define SMM_CORE_SMI_DATABASE_REVISION  0x0001
+#define SMM_CORE_SMI_DATABASE_REVISION  0x0002
 
 typedef enum {
   SmmCoreSmiHandlerCategoryRootHandler,
@@ -85,6 +85,13 @@ typedef struct {
   UINT16                ContextBufferOffset;
   UINT8                 Reserved[2];
   UINT32                ContextBufferSize;
+  //
+  // Added in SMM_CORE_SMI_DATABASE_REVISION 0x0002. Only recorded for root and
+  // GUID handlers when BIT1 of PcdSmiHandlerProfilePropertyMask is set.
+  //
+  UINT64                CallCount;
+  UINT64                TotalTimeInNanoSecond;
+  UINT64                MaxTimeInNanoSecond;
 //UINT8                 ContextBuffer[];
 } SMM_CORE_SMI_HANDLER_STRUCTURE;
 
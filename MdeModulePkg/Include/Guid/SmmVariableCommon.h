@@ -77,6 +77,10 @@ typedef struct {
 // The payload for this function is SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO
 //
 #define SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_INFO                14
+//
+// The payload for this function is SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAMES.
+//
+#define SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAMES               15
 
 ///
 /// Size of SMM communicate header, without including the payload.
@@ -118,6 +122,25 @@ typedef struct {
   UINT32          Attributes;
 } SMM_VARIABLE_COMMUNICATE_QUERY_VARIABLE_INFO;
 
+///
+/// This structure is used to communicate with SMI handler by GetNextVariableName
+/// to return as many consecutive variable names as fit in the payload.
+/// On input, Names holds one SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME with
+/// the variable name to start after. On output, Names holds NameCount records of
+/// SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME, each starting on a UINTN
+/// boundary. The ReturnStatus is that of the first name.
+///
+typedef struct {
+  UINTN       NameCount;
+  UINT8       Names[1];
+} SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAMES;
+
+///
+/// Size of one SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAMES record, including padding.
+///
+#define GET_NEXT_VARIABLE_NAMES_RECORD_SIZE(NameSize) \
+  ALIGN_VALUE (OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME, Name) + (NameSize), sizeof (UINTN))
+
 typedef SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME SMM_VARIABLE_COMMUNICATE_LOCK_VARIABLE;
 
 typedef struct {
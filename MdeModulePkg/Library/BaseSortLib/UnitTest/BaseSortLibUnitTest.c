@@ -0,0 +1,521 @@
+/** @file
+  Host based unit tests of PerformQuickSort() in BaseSortLib.
+
+  Every input pattern is sorted at several sizes around the insertion sort
+  threshold, the result is compared with the C library qsort(), and the number
+  of comparisons is checked against an O(n log n) bound. The inputs include the
+  ones that make a plain quick sort quadratic. The median-of-3 killer and an
+  adversary making every partition as uneven as possible stay within the bound
+  only thanks to the heap sort fallback.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/SortLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "SortLib Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define SORT_TEST_SEED            0x534F5254
+#define SORT_ADVERSARY_COUNT      10000
+#define SORT_BENCHMARK_COUNT      1000000
+
+//
+// The comparisons allowed to sort Count elements: introsort does at most
+// 2 (log2 n + 1) partitioning passes of n comparisons each, about 2 n log2 n
+// in heap sort, and the insertion sort of the small partitions.
+//
+#define SORT_COMPARE_LIMIT(Count) (5 * (Count) * ((UINTN)HighBitSet64 ((Count) | 1) + 1))
+
+typedef
+VOID
+(*SORT_TEST_FILL) (
+  OUT UINT32  *Array,
+  IN  UINTN   Count
+  );
+
+typedef struct {
+  CHAR8           *Name;
+  CHAR8           *Description;
+  SORT_TEST_FILL  Fill;
+} SORT_TEST_INPUT;
+
+STATIC CONST UINTN  mTestCounts[] = {
+  0, 1, 2, 3, 15, 16, 17, 18, 33, 100, 1000, 4097, 10000
+};
+
+STATIC UINTN        mCompareCount;
+
+//
+// Values of the elements sorted against the adversary. MAX_UINTN marks the
+// values not decided yet.
+//
+STATIC UINTN        *mAdversaryValue;
+STATIC UINTN        mAdversarySolid;
+STATIC UINTN        mAdversaryCandidate;
+
+/**
+  Compare two UINT32 and count the comparison.
+
+  @param[in]  Buffer1  Pointer to the first UINT32.
+  @param[in]  Buffer2  Pointer to the second UINT32.
+
+  @retval <0  Buffer1 is less than Buffer2.
+  @retval 0   Buffer1 equals Buffer2.
+  @retval >0  Buffer1 is greater than Buffer2.
+**/
+STATIC
+INTN
+EFIAPI
+CompareUint32 (
+  IN CONST VOID  *Buffer1,
+  IN CONST VOID  *Buffer2
+  )
+{
+  UINT32  Value1;
+  UINT32  Value2;
+
+  mCompareCount++;
+  Value1 = *(CONST UINT32 *)Buffer1;
+  Value2 = *(CONST UINT32 *)Buffer2;
+  return (Value1 < Value2) ? -1 : (Value1 > Value2) ? 1 : 0;
+}
+
+/**
+  qsort() flavor of CompareUint32(), for the reference result.
+
+  @param[in]  Buffer1  Pointer to the first UINT32.
+  @param[in]  Buffer2  Pointer to the second UINT32.
+
+  @return The comparison result.
+**/
+STATIC
+int
+ReferenceCompare (
+  const void  *Buffer1,
+  const void  *Buffer2
+  )
+{
+  UINT32  Value1;
+  UINT32  Value2;
+
+  Value1 = *(CONST UINT32 *)Buffer1;
+  Value2 = *(CONST UINT32 *)Buffer2;
+  return (Value1 < Value2) ? -1 : (Value1 > Value2) ? 1 : 0;
+}
+
+/**
+  Fill an array with increasing values.
+
+  @param[out]  Array  The array to fill.
+  @param[in]   Count  The number of elements.
+**/
+STATIC
+VOID
+FillSorted (
+  OUT UINT32  *Array,
+  IN  UINTN   Count
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Count; Index++) {
+    Array[Index] = (UINT32)Index;
+  }
+}
+
+/**
+  Fill an array with decreasing values.
+
+  @param[out]  Array  The array to fill.
+  @param[in]   Count  The number of elements.
+**/
+STATIC
+VOID
+FillReversed (
+  OUT UINT32  *Array,
+  IN  UINTN   Count
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Count; Index++) {
+    Array[Index] = (UINT32)(Count - Index);
+  }
+}
+
+/**
+  Fill an array with a single value.
+
+  @param[out]  Array  The array to fill.
+  @param[in]   Count  The number of elements.
+**/
+STATIC
+VOID
+FillEqual (
+  OUT UINT32  *Array,
+  IN  UINTN   Count
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Count; Index++) {
+    Array[Index] = 7;
+  }
+}
+
+/**
+  Fill an array with values increasing up to the middle, then decreasing.
+
+  @param[out]  Array  The array to fill.
+  @param[in]   Count  The number of elements.
+**/
+STATIC
+VOID
+FillOrganPipe (
+  OUT UINT32  *Array,
+  IN  UINTN   Count
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Count; Index++) {
+    Array[Index] = (UINT32)((Index < Count / 2) ? Index : Count - Index);
+  }
+}
+
+/**
+  Fill an array with the median-of-3 killer sequence of D. R. Musser,
+  "Introspective Sorting and Selection Algorithms", which makes the median of
+  the first, middle and last elements a poor pivot at every step.
+
+  @param[out]  Array  The array to fill.
+  @param[in]   Count  The number of elements.
+**/
+STATIC
+VOID
+FillMedianOf3Killer (
+  OUT UINT32  *Array,
+  IN  UINTN   Count
+  )
+{
+  UINTN  Half;
+  UINTN  Index;
+
+  Half = Count / 2;
+  for (Index = 1; Index <= Half; Index++) {
+    if ((Index & 1) != 0) {
+      Array[Index - 1] = (UINT32)Index;
+      Array[Index]     = (UINT32)(Half + Index);
+    }
+    Array[Half + Index - 1] = (UINT32)(2 * Index);
+  }
+  if ((Count & 1) != 0) {
+    Array[Count - 1] = (UINT32)(Count + 1);
+  }
+}
+
+/**
+  Fill an array with random values, many of them repeated.
+
+  @param[out]  Array  The array to fill.
+  @param[in]   Count  The number of elements.
+**/
+STATIC
+VOID
+FillRandom (
+  OUT UINT32  *Array,
+  IN  UINTN   Count
+  )
+{
+  UINTN  Index;
+
+  srand (SORT_TEST_SEED);
+  for (Index = 0; Index < Count; Index++) {
+    Array[Index] = (UINT32)(rand () % (Count + 1));
+  }
+}
+
+STATIC SORT_TEST_INPUT  mTestInputs[] = {
+  { "sorted",             "Sort sorted input",             FillSorted          },
+  { "reversed",           "Sort reversed input",           FillReversed        },
+  { "all-equal",          "Sort all-equal input",          FillEqual           },
+  { "organ-pipe",         "Sort organ-pipe input",         FillOrganPipe       },
+  { "median-of-3 killer", "Sort median-of-3 killer input", FillMedianOf3Killer },
+  { "random",             "Sort random input",             FillRandom          }
+};
+
+/**
+  Sort the input pattern at every size of mTestCounts.
+
+  @param[in]  Context  Pointer to the SORT_TEST_INPUT.
+
+  @retval UNIT_TEST_PASSED             The input is sorted at every size.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SortShouldOrderInput (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  SORT_TEST_INPUT  *Input;
+  UINT32           *Array;
+  UINT32           *Expected;
+  UINTN            Index;
+  UINTN            Count;
+
+  Input    = (SORT_TEST_INPUT *)Context;
+  Array    = AllocatePool (mTestCounts[ARRAY_SIZE (mTestCounts) - 1] * sizeof (UINT32));
+  Expected = AllocatePool (mTestCounts[ARRAY_SIZE (mTestCounts) - 1] * sizeof (UINT32));
+  UT_ASSERT_NOT_NULL (Array);
+  UT_ASSERT_NOT_NULL (Expected);
+
+  for (Index = 0; Index < ARRAY_SIZE (mTestCounts); Index++) {
+    Count = mTestCounts[Index];
+    Input->Fill (Array, Count);
+    CopyMem (Expected, Array, Count * sizeof (UINT32));
+    qsort (Expected, Count, sizeof (UINT32), ReferenceCompare);
+
+    mCompareCount = 0;
+    PerformQuickSort (Array, Count, sizeof (UINT32), CompareUint32);
+    UT_LOG_INFO ("%a, %Lu elements: %Lu comparisons\n", Input->Name, (UINT64)Count, (UINT64)mCompareCount);
+    UT_ASSERT_MEM_EQUAL (Array, Expected, Count * sizeof (UINT32));
+    UT_ASSERT_TRUE (mCompareCount <= SORT_COMPARE_LIMIT (Count));
+  }
+
+  FreePool (Array);
+  FreePool (Expected);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Compare two elements against the adversary of M. D. McIlroy, "A Killer
+  Adversary for Quicksort". The values are decided only when compared, so that
+  the element the sort seems to use as pivot is always the smallest one left.
+
+  @param[in]  Buffer1  Pointer to the index of the first element.
+  @param[in]  Buffer2  Pointer to the index of the second element.
+
+  @return The comparison result of the values decided so far.
+**/
+STATIC
+INTN
+EFIAPI
+CompareAgainstAdversary (
+  IN CONST VOID  *Buffer1,
+  IN CONST VOID  *Buffer2
+  )
+{
+  UINTN  Index1;
+  UINTN  Index2;
+
+  mCompareCount++;
+  Index1 = *(CONST UINTN *)Buffer1;
+  Index2 = *(CONST UINTN *)Buffer2;
+
+  if ((mAdversaryValue[Index1] == MAX_UINTN) && (mAdversaryValue[Index2] == MAX_UINTN)) {
+    if (Index1 == mAdversaryCandidate) {
+      mAdversaryValue[Index1] = mAdversarySolid++;
+    } else {
+      mAdversaryValue[Index2] = mAdversarySolid++;
+    }
+  }
+
+  if (mAdversaryValue[Index1] == MAX_UINTN) {
+    mAdversaryCandidate = Index1;
+  } else if (mAdversaryValue[Index2] == MAX_UINTN) {
+    mAdversaryCandidate = Index2;
+  }
+
+  if (mAdversaryValue[Index1] == mAdversaryValue[Index2]) {
+    return 0;
+  }
+  return (mAdversaryValue[Index1] < mAdversaryValue[Index2]) ? -1 : 1;
+}
+
+/**
+  The sort should stay O(n log n) against an adversary defeating any choice of
+  pivot, which only the heap sort fallback achieves.
+
+  @param[in]  Context  Ignored.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+AdversaryShouldFallBackToHeapSort (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  *Array;
+  UINTN  Index;
+
+  Array           = AllocatePool (SORT_ADVERSARY_COUNT * sizeof (UINTN));
+  mAdversaryValue = AllocatePool (SORT_ADVERSARY_COUNT * sizeof (UINTN));
+  UT_ASSERT_NOT_NULL (Array);
+  UT_ASSERT_NOT_NULL (mAdversaryValue);
+
+  for (Index = 0; Index < SORT_ADVERSARY_COUNT; Index++) {
+    Array[Index]           = Index;
+    mAdversaryValue[Index] = MAX_UINTN;
+  }
+  mAdversarySolid     = 0;
+  mAdversaryCandidate = 0;
+
+  mCompareCount = 0;
+  PerformQuickSort (Array, SORT_ADVERSARY_COUNT, sizeof (UINTN), CompareAgainstAdversary);
+  UT_LOG_INFO ("adversary, %d elements: %Lu comparisons\n", SORT_ADVERSARY_COUNT, (UINT64)mCompareCount);
+  UT_ASSERT_TRUE (mCompareCount <= SORT_COMPARE_LIMIT (SORT_ADVERSARY_COUNT));
+
+  //
+  // The sort must agree with the values the adversary decided.
+  //
+  for (Index = 1; Index < SORT_ADVERSARY_COUNT; Index++) {
+    UT_ASSERT_TRUE (mAdversaryValue[Array[Index - 1]] <= mAdversaryValue[Array[Index]]);
+  }
+
+  FreePool (Array);
+  FreePool (mAdversaryValue);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Benchmark of PerformQuickSort() on every input pattern.
+
+  The time taken to sort SORT_BENCHMARK_COUNT elements is logged. Every result
+  is checked, so the benchmark also runs as a test.
+
+  @param[in]  Context  Ignored.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SortBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT32   *Array;
+  UINTN    InputIndex;
+  UINTN    Index;
+  clock_t  Start;
+  clock_t  Elapsed;
+
+  Array = AllocatePool (SORT_BENCHMARK_COUNT * sizeof (UINT32));
+  UT_ASSERT_NOT_NULL (Array);
+
+  for (InputIndex = 0; InputIndex < ARRAY_SIZE (mTestInputs); InputIndex++) {
+    mTestInputs[InputIndex].Fill (Array, SORT_BENCHMARK_COUNT);
+
+    mCompareCount = 0;
+    Start         = clock ();
+    PerformQuickSort (Array, SORT_BENCHMARK_COUNT, sizeof (UINT32), CompareUint32);
+    Elapsed       = clock () - Start;
+
+    UT_LOG_INFO (
+      "%a, %d elements: %Lu ms, %Lu comparisons\n",
+      mTestInputs[InputIndex].Name,
+      SORT_BENCHMARK_COUNT,
+      (UINT64)(Elapsed * 1000 / CLOCKS_PER_SEC),
+      (UINT64)mCompareCount
+      );
+    for (Index = 1; Index < SORT_BENCHMARK_COUNT; Index++) {
+      UT_ASSERT_TRUE (Array[Index - 1] <= Array[Index]);
+    }
+  }
+
+  FreePool (Array);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the sort
+  library and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      SortTests;
+  UINTN                       Index;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&SortTests, Framework, "PerformQuickSort Tests", "SortLib.PerformQuickSort", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for SortTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mTestInputs); Index++) {
+    AddTestCase (SortTests, mTestInputs[Index].Description, "Sort", SortShouldOrderInput, NULL, NULL, &mTestInputs[Index]);
+  }
+  AddTestCase (SortTests, "Sort against a quick sort adversary", "Adversary", AdversaryShouldFallBackToHeapSort, NULL, NULL, NULL);
+  AddTestCase (SortTests, "Benchmark PerformQuickSort", "Benchmark", SortBenchmark, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -86,77 +86,48 @@ BrotliDecompress (
   IN VOID *       BuffInfo
   )
 {
-  UINT8 *        Input;
-  UINT8 *        Output;
-  const UINT8 *  NextIn;
-  UINT8 *        NextOut;
-  size_t         TotalOut;
-  size_t         AvailableIn;
-  size_t         AvailableOut;
-  VOID *         Temp;
+  const UINT8 *         NextIn;
+  UINT8 *               NextOut;
+  size_t                TotalOut;
+  size_t                AvailableIn;
+  size_t                AvailableOut;
   BrotliDecoderResult   Result;
   BrotliDecoderState *  BroState;
 
-  TotalOut = 0;
-  AvailableOut = FILE_BUFFER_SIZE;
-  Result = BROTLI_DECODER_RESULT_ERROR;
   BroState = BrotliDecoderCreateInstance(BrAlloc, BrFree, BuffInfo);
-  Temp = Destination;
-
   if (BroState == NULL) {
     return EFI_INVALID_PARAMETER;
   }
-  Input = (UINT8 *)BrAlloc(BuffInfo, FILE_BUFFER_SIZE);
-  Output = (UINT8 *)BrAlloc(BuffInfo, FILE_BUFFER_SIZE);
-  if ((Input==NULL) || (Output==NULL)) {
-    BrFree(BuffInfo, Input);
-    BrFree(BuffInfo, Output);
-    BrotliDecoderDestroyInstance(BroState);
-    return EFI_INVALID_PARAMETER;
-  }
-  NextOut = Output;
-  Result = BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT;
-  while (1) {
-    if (Result == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT) {
-      if (SourceSize == 0) {
-        break;
-      }
-      if (SourceSize >= FILE_BUFFER_SIZE) {
-        AvailableIn = FILE_BUFFER_SIZE;
-      }else{
-        AvailableIn = SourceSize;
-      }
-      CopyMem(Input, Source, AvailableIn);
-      Source = (VOID *)((UINT8 *)Source + AvailableIn);
-      SourceSize -= AvailableIn;
-      NextIn = Input;
-    } else if (Result == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT) {
-      CopyMem(Temp, Output, FILE_BUFFER_SIZE);
-      AvailableOut = FILE_BUFFER_SIZE;
-      Temp = (VOID *)((UINT8 *)Temp +FILE_BUFFER_SIZE);
-      NextOut = Output;
-    } else {
-      break; /* Error or success. */
-    }
-    Result = BrotliDecoderDecompressStream(
-                          BroState,
-                          &AvailableIn,
-                          &NextIn,
-                          &AvailableOut,
-                          &NextOut,
-                          &TotalOut
-                          );
-  }
-  if (NextOut != Output) {
-    CopyMem(Temp, Output, (size_t)(NextOut - Output));
-  }
 
-  DestSize = TotalOut;
+  //
+  // Both the whole compressed stream and the final buffer are in memory, so
+  // the decoder reads and writes them directly instead of going through
+  // FILE_BUFFER_SIZE bounce buffers, which costs two copies of every byte.
+  //
+  NextIn       = (CONST UINT8 *)Source;
+  AvailableIn  = SourceSize;
+  NextOut      = (UINT8 *)Destination;
+  AvailableOut = DestSize;
+  TotalOut     = 0;
+  Result = BrotliDecoderDecompressStream(
+                        BroState,
+                        &AvailableIn,
+                        &NextIn,
+                        &AvailableOut,
+                        &NextOut,
+                        &TotalOut
+                        );
 
-  BrFree(BuffInfo, Input);
-  BrFree(BuffInfo, Output);
   BrotliDecoderDestroyInstance(BroState);
-  return (Result == BROTLI_DECODER_RESULT_SUCCESS) ? EFI_SUCCESS : EFI_INVALID_PARAMETER;
+
+  //
+  // The destination is sized from the header, anything but a complete
+  // stream filling it exactly is corrupted.
+  //
+  if ((Result != BROTLI_DECODER_RESULT_SUCCESS) || (TotalOut != DestSize)) {
+    return EFI_INVALID_PARAMETER;
+  }
+  return EFI_SUCCESS;
 }
 
 /**
@@ -269,12 +240,16 @@ BrotliUefiDecompress (
   IN OUT VOID *     Scratch
   )
 {
-  UINTN          DestSize = 0;
+  UINTN          DestSize;
   EFI_STATUS     Status;
   BROTLI_BUFF    BroBuff;
   UINT64         GetSize;
   UINT8          MaxOffset;
 
+  MaxOffset = BROTLI_DECODE_MAX;
+  GetSize = BrGetDecodedSizeOfBuf((UINT8 *)Source, MaxOffset - BROTLI_INFO_SIZE, MaxOffset);
+  DestSize = (UINTN)GetSize;
+
   MaxOffset = BROTLI_SCRATCH_MAX;
   GetSize = BrGetDecodedSizeOfBuf((UINT8 *)Source, MaxOffset - BROTLI_INFO_SIZE, MaxOffset);
 
@@ -22,6 +22,10 @@ typedef struct
   UINTN    BuffSize;
 } BROTLI_BUFF;
 
+//
+// BrotliCompress still reserves two buffers of this size in the scratch size
+// it writes in the header, they were used as bounce buffers by older decoders.
+//
 #define FILE_BUFFER_SIZE     65536
 #define BROTLI_INFO_SIZE     8
 #define BROTLI_DECODE_MAX    8
@@ -0,0 +1,261 @@
+/** @file
+  Chunked LZMA Decompress interfaces
+
+  The chunks of a chunked LZMA stream are regular LZMA streams decoded into
+  adjacent parts of the destination buffer, so that any number of processors
+  can decode them at the same time.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "LzmaDecompressLibInternal.h"
+#include <Library/SynchronizationLib.h>
+#include "Sdk/C/7zTypes.h"
+#include "Sdk/C/LzmaDec.h"
+
+/**
+  Validates the header and the chunk table of a chunked LZMA stream.
+
+  @param  Source             The source buffer containing the compressed data.
+  @param  SourceSize         The size, in bytes, of the source buffer.
+  @param  ChunkStreamOffset  If not NULL, receives the offset of every chunk
+                             stream in the source buffer.
+
+  @retval RETURN_SUCCESS            The stream is valid.
+  @retval RETURN_INVALID_PARAMETER  The stream is not a valid chunked LZMA stream.
+  @retval RETURN_UNSUPPORTED        The uncompressed size does not fit in a UINT32.
+**/
+STATIC
+RETURN_STATUS
+LzmaChunkedParseHeader (
+  IN  CONST VOID  *Source,
+  IN  UINTN       SourceSize,
+  OUT UINTN       *ChunkStreamOffset  OPTIONAL
+  )
+{
+  CONST LZMA_CHUNKED_HEADER  *Header;
+  CONST UINT32               *ChunkStreamSize;
+  UINT64                     DecodedSize;
+  UINT64                     ChunkDecodedSize;
+  UINTN                      Offset;
+  UINT32                     Index;
+
+  if (SourceSize < sizeof (LZMA_CHUNKED_HEADER)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  //
+  // Sections are only 4 byte aligned.
+  //
+  Header      = (CONST LZMA_CHUNKED_HEADER *) Source;
+  DecodedSize = ReadUnaligned64 (&Header->DecodedSize);
+  if (Header->Signature != LZMA_CHUNKED_SIGNATURE) {
+    return RETURN_INVALID_PARAMETER;
+  }
+  if (DecodedSize > MAX_UINT32) {
+    return RETURN_UNSUPPORTED;
+  }
+  if ((Header->ChunkSize == 0) ||
+      (Header->ChunkCount == 0) ||
+      (Header->ChunkCount != DivU64x32 (DecodedSize + Header->ChunkSize - 1, Header->ChunkSize)) ||
+      ((SourceSize - sizeof (LZMA_CHUNKED_HEADER)) / sizeof (UINT32) < Header->ChunkCount)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  ChunkStreamSize = (CONST UINT32 *) (Header + 1);
+  Offset          = sizeof (LZMA_CHUNKED_HEADER) + Header->ChunkCount * sizeof (UINT32);
+  for (Index = 0; Index < Header->ChunkCount; Index++) {
+    if ((ChunkStreamSize[Index] < LZMA_HEADER_SIZE) ||
+        (SourceSize - Offset < ChunkStreamSize[Index])) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    //
+    // Every chunk must fill exactly its own part of the destination buffer.
+    //
+    ChunkDecodedSize = GetDecodedSizeOfBuf ((UINT8 *) Source + Offset);
+    if (ChunkDecodedSize != MIN (Header->ChunkSize, DecodedSize - MultU64x32 (Index, Header->ChunkSize))) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    if (ChunkStreamOffset != NULL) {
+      ChunkStreamOffset[Index] = Offset;
+    }
+    Offset += ChunkStreamSize[Index];
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Returns the size of the chunk offset table kept at the start of the scratch buffer.
+
+  @param  ChunkCount  The number of chunks in the stream.
+
+  @return The size, in bytes, of the table.
+**/
+STATIC
+UINTN
+LzmaChunkedOffsetTableSize (
+  IN UINT32  ChunkCount
+  )
+{
+  return ALIGN_VALUE (ChunkCount * sizeof (UINTN), 16);
+}
+
+/**
+  Given a chunked Lzma compressed source buffer, this function retrieves the
+  size of the uncompressed buffer and the size of the scratch buffer required
+  to decompress it with up to MaxWorkers processors.
+
+  @param  Source          The source buffer containing the compressed data.
+  @param  SourceSize      The size, in bytes, of the source buffer.
+  @param  MaxWorkers      The maximum number of processors decoding chunks at
+                          the same time.
+  @param  DestinationSize A pointer to the size, in bytes, of the uncompressed buffer.
+  @param  ScratchSize     A pointer to the size, in bytes, of the scratch buffer.
+
+  @retval RETURN_SUCCESS            The sizes were returned.
+  @retval RETURN_INVALID_PARAMETER  The source buffer is not a valid chunked
+                                    Lzma stream.
+  @retval RETURN_UNSUPPORTED        The uncompressed size does not fit in a UINT32.
+**/
+RETURN_STATUS
+EFIAPI
+LzmaChunkedUefiDecompressGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINT32      SourceSize,
+  IN  UINT32      MaxWorkers,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *ScratchSize
+  )
+{
+  RETURN_STATUS              Status;
+  CONST LZMA_CHUNKED_HEADER  *Header;
+  UINT64                     Size;
+
+  Status = LzmaChunkedParseHeader (Source, SourceSize, NULL);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  Header = (CONST LZMA_CHUNKED_HEADER *) Source;
+  Size   = LzmaChunkedOffsetTableSize (Header->ChunkCount) +
+           MultU64x32 (SCRATCH_BUFFER_REQUEST_SIZE, MAX (1, MIN (MaxWorkers, Header->ChunkCount)));
+  if (Size > MAX_UINT32) {
+    return RETURN_UNSUPPORTED;
+  }
+
+  *DestinationSize = (UINT32) ReadUnaligned64 (&Header->DecodedSize);
+  *ScratchSize     = (UINT32) Size;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Prepares the decode of a chunked Lzma compressed source buffer.
+
+  The chunks are then decoded by calling LzmaChunkedDecompressWorker() on one
+  or more processors, and the result of the decode is in Context->Status once
+  all of them have returned.
+
+  @param  Context     The decode state to initialize.
+  @param  Source      The source buffer containing the compressed data.
+  @param  SourceSize  The size, in bytes, of the source buffer.
+  @param  Destination The destination buffer to store the decompressed data.
+  @param  Scratch     The scratch buffer, of the size returned by
+                      LzmaChunkedUefiDecompressGetInfo() for MaxWorkers.
+  @param  MaxWorkers  The value passed to LzmaChunkedUefiDecompressGetInfo().
+
+  @retval RETURN_SUCCESS            The context is ready.
+  @retval RETURN_INVALID_PARAMETER  The source buffer is not a valid chunked
+                                    Lzma stream.
+  @retval RETURN_UNSUPPORTED        The uncompressed size does not fit in a UINT32.
+**/
+RETURN_STATUS
+EFIAPI
+LzmaChunkedDecompressInit (
+  OUT LZMA_CHUNKED_CONTEXT  *Context,
+  IN  CONST VOID            *Source,
+  IN  UINTN                 SourceSize,
+  IN  VOID                  *Destination,
+  IN  VOID                  *Scratch,
+  IN  UINT32                MaxWorkers
+  )
+{
+  RETURN_STATUS              Status;
+  CONST LZMA_CHUNKED_HEADER  *Header;
+
+  ASSERT (Context != NULL);
+  ASSERT (Scratch != NULL);
+
+  //
+  // The offsets of the chunk streams are kept at the start of the scratch
+  // buffer, followed by one SCRATCH_BUFFER_REQUEST_SIZE slice per worker.
+  //
+  Status = LzmaChunkedParseHeader (Source, SourceSize, (UINTN *) Scratch);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  Header = (CONST LZMA_CHUNKED_HEADER *) Source;
+  Context->Source            = (CONST UINT8 *) Source;
+  Context->Destination       = (UINT8 *) Destination;
+  Context->Scratch           = (UINT8 *) Scratch + LzmaChunkedOffsetTableSize (Header->ChunkCount);
+  Context->ChunkStreamSize   = (CONST UINT32 *) (Header + 1);
+  Context->ChunkStreamOffset = (UINTN *) Scratch;
+  Context->ChunkCount        = Header->ChunkCount;
+  Context->ChunkSize         = Header->ChunkSize;
+  Context->WorkerCount       = MAX (1, MIN (MaxWorkers, Header->ChunkCount));
+  Context->NextWorker        = 0;
+  Context->NextChunk         = 0;
+  Context->Status            = RETURN_SUCCESS;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Decodes chunks of a chunked Lzma stream until there is none left.
+
+  It may run on several processors at the same time, each of them takes a
+  slice of the scratch buffer and then the next chunk not yet claimed.
+  Processors beyond the number of slices return immediately.
+
+  @param  Buffer  The LZMA_CHUNKED_CONTEXT initialized by LzmaChunkedDecompressInit().
+**/
+VOID
+EFIAPI
+LzmaChunkedDecompressWorker (
+  IN OUT VOID  *Buffer
+  )
+{
+  LZMA_CHUNKED_CONTEXT  *Context;
+  UINT8                 *Scratch;
+  UINT32                Worker;
+  UINT32                Index;
+  RETURN_STATUS         Status;
+
+  Context = (LZMA_CHUNKED_CONTEXT *) Buffer;
+
+  Worker = InterlockedIncrement (&Context->NextWorker) - 1;
+  if (Worker >= Context->WorkerCount) {
+    return;
+  }
+  Scratch = Context->Scratch + Worker * SCRATCH_BUFFER_REQUEST_SIZE;
+
+  while (TRUE) {
+    Index = InterlockedIncrement (&Context->NextChunk) - 1;
+    if (Index >= Context->ChunkCount) {
+      break;
+    }
+
+    Status = LzmaUefiDecompress (
+               Context->Source + Context->ChunkStreamOffset[Index],
+               Context->ChunkStreamSize[Index],
+               Context->Destination + (UINTN) Index * Context->ChunkSize,
+               Scratch
+               );
+    if (RETURN_ERROR (Status)) {
+      Context->Status = Status;
+    }
+  }
+}
@@ -11,8 +11,6 @@
 #include "Sdk/C/7zVersion.h"
 #include "Sdk/C/LzmaDec.h"
 
-#define SCRATCH_BUFFER_REQUEST_SIZE SIZE_64KB
-
 typedef struct
 {
   ISzAlloc Functions;
@@ -69,8 +67,6 @@ SzFree (
   //
 }
 
-#define LZMA_HEADER_SIZE (LZMA_PROPS_SIZE + 8)
-
 /**
   Get the size of the uncompressed buffer by parsing EncodeData header.
 
@@ -17,6 +17,62 @@
 #include <Library/ExtractGuidedSectionLib.h>
 #include <Guid/LzmaDecompress.h>
 
+#define SCRATCH_BUFFER_REQUEST_SIZE SIZE_64KB
+
+//
+// LZMA_PROPS_SIZE comes from Sdk/C/LzmaDec.h
+//
+#define LZMA_HEADER_SIZE (LZMA_PROPS_SIZE + 8)
+
+#define LZMA_CHUNKED_SIGNATURE      SIGNATURE_32 ('L', 'Z', 'C', 'K')
+
+///
+/// Header of the data in a chunked LZMA section. It is followed by a UINT32
+/// array holding the size of each chunk stream, then by the chunk streams.
+/// Every chunk stream is a regular LZMA stream with its own LZMA header, so
+/// the chunks can be decoded independently of each other.
+///
+typedef struct {
+  UINT32    Signature;
+  UINT32    ChunkCount;
+  UINT64    DecodedSize;
+  ///
+  /// Decoded size of every chunk but the last one.
+  ///
+  UINT32    ChunkSize;
+  UINT32    Reserved;
+} LZMA_CHUNKED_HEADER;
+
+///
+/// State of a chunked LZMA decode shared by all the processors running
+/// LzmaChunkedDecompressWorker().
+///
+typedef struct {
+  CONST UINT8       *Source;
+  UINT8             *Destination;
+  UINT8             *Scratch;
+  CONST UINT32      *ChunkStreamSize;
+  UINTN             *ChunkStreamOffset;
+  UINT32            ChunkCount;
+  UINT32            ChunkSize;
+  UINT32            WorkerCount;
+  volatile UINT32   NextWorker;
+  volatile UINT32   NextChunk;
+  RETURN_STATUS     Status;
+} LZMA_CHUNKED_CONTEXT;
+
+/**
+  Get the size of the uncompressed buffer by parsing EncodeData header.
+
+  @param EncodedData  Pointer to the compressed data.
+
+  @return The size of the uncompressed buffer.
+**/
+UINT64
+GetDecodedSizeOfBuf(
+  UINT8 *EncodedData
+  );
+
 /**
   Given a Lzma compressed source buffer, this function retrieves the size of
   the uncompressed buffer and the size of the scratch buffer required
@@ -91,5 +147,78 @@ LzmaUefiDecompress (
   IN OUT VOID    *Scratch
   );
 
+/**
+  Given a chunked Lzma compressed source buffer, this function retrieves the
+  size of the uncompressed buffer and the size of the scratch buffer required
+  to decompress it with up to MaxWorkers processors.
+
+  @param  Source          The source buffer containing the compressed data.
+  @param  SourceSize      The size, in bytes, of the source buffer.
+  @param  MaxWorkers      The maximum number of processors decoding chunks at
+                          the same time.
+  @param  DestinationSize A pointer to the size, in bytes, of the uncompressed buffer.
+  @param  ScratchSize     A pointer to the size, in bytes, of the scratch buffer.
+
+  @retval RETURN_SUCCESS            The sizes were returned.
+  @retval RETURN_INVALID_PARAMETER  The source buffer is not a valid chunked
+                                    Lzma stream.
+  @retval RETURN_UNSUPPORTED        The uncompressed size does not fit in a UINT32.
+**/
+RETURN_STATUS
+EFIAPI
+LzmaChunkedUefiDecompressGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINT32      SourceSize,
+  IN  UINT32      MaxWorkers,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *ScratchSize
+  );
+
+/**
+  Prepares the decode of a chunked Lzma compressed source buffer.
+
+  The chunks are then decoded by calling LzmaChunkedDecompressWorker() on one
+  or more processors, and the result of the decode is in Context->Status once
+  all of them have returned.
+
+  @param  Context     The decode state to initialize.
+  @param  Source      The source buffer containing the compressed data.
+  @param  SourceSize  The size, in bytes, of the source buffer.
+  @param  Destination The destination buffer to store the decompressed data.
+  @param  Scratch     The scratch buffer, of the size returned by
+                      LzmaChunkedUefiDecompressGetInfo() for MaxWorkers.
+  @param  MaxWorkers  The value passed to LzmaChunkedUefiDecompressGetInfo().
+
+  @retval RETURN_SUCCESS            The context is ready.
+  @retval RETURN_INVALID_PARAMETER  The source buffer is not a valid chunked
+                                    Lzma stream.
+  @retval RETURN_UNSUPPORTED        The uncompressed size does not fit in a UINT32.
+**/
+RETURN_STATUS
+EFIAPI
+LzmaChunkedDecompressInit (
+  OUT LZMA_CHUNKED_CONTEXT  *Context,
+  IN  CONST VOID            *Source,
+  IN  UINTN                 SourceSize,
+  IN  VOID                  *Destination,
+  IN  VOID                  *Scratch,
+  IN  UINT32                MaxWorkers
+  );
+
+/**
+  Decodes chunks of a chunked Lzma stream until there is none left.
+
+  It may run on several processors at the same time, each of them takes a
+  slice of the scratch buffer and then the next chunk not yet claimed.
+  Processors beyond the number of slices return immediately.
+
+  @param  Buffer  The LZMA_CHUNKED_CONTEXT initialized by LzmaChunkedDecompressInit().
+**/
+VOID
+EFIAPI
+LzmaChunkedDecompressWorker (
+  IN OUT VOID  *Buffer
+  );
+
 #endif
 
@@ -0,0 +1,342 @@
+/** @file
+  Host based unit tests of the chunked LZMA decoder of LzmaCustomDecompressLib.
+
+  The test stream was produced by "LzmaCompress -e --chunk-size 4096" from
+  the data built by GenerateTestData(), so decoding it checks the BaseTools
+  encoder and the firmware decoder agree on the format.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../LzmaDecompressLibInternal.h"
+
+#define UNIT_TEST_APP_NAME        "LzmaCustomDecompressLib Chunked Decode Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define TEST_DATA_SIZE            10000
+#define TEST_CHUNK_COUNT          3
+
+STATIC CONST CHAR8  mTestPattern[] = "The quick brown fox jumps over the lazy dog. ";
+
+//
+// LzmaCompress -e --chunk-size 4096 output of GenerateTestData().
+//
+STATIC CONST UINT8  mChunkedStream[] = {
+  0x4c, 0x5a, 0x43, 0x4b, 0x03, 0x00, 0x00, 0x00, 0x10, 0x27, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0xc6, 0x00, 0x00, 0x00, 0xc7, 0x00, 0x00, 0x00, 0x76, 0x00, 0x00, 0x00,
+  0x5d, 0x00, 0x10, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x2a, 0x1a, 0x08, 0xa2, 0x03, 0x25, 0x66, 0xf1, 0x4b, 0x78,
+  0xc5, 0xa2, 0x05, 0xff, 0x2e, 0xe6, 0xd9, 0xd2, 0x20, 0x1a, 0xad, 0x34,
+  0xf8, 0xe2, 0x1d, 0xe8, 0x41, 0x36, 0xfa, 0xdc, 0x06, 0x69, 0xbb, 0x3c,
+  0xe4, 0x10, 0x34, 0x27, 0x09, 0xeb, 0xb3, 0x66, 0xe3, 0xed, 0x37, 0x98,
+  0xed, 0x92, 0xad, 0xd5, 0x27, 0x40, 0xd4, 0x92, 0xb8, 0x96, 0x6a, 0x21,
+  0x27, 0x6c, 0x35, 0xbf, 0x1a, 0x70, 0xf2, 0x9c, 0xad, 0xdd, 0x28, 0xdd,
+  0xb8, 0xce, 0x43, 0x20, 0x68, 0x8d, 0x73, 0x81, 0x6b, 0xb5, 0x12, 0xb7,
+  0x0e, 0xb8, 0x31, 0xf9, 0xe3, 0x29, 0xfa, 0x64, 0x61, 0xfa, 0x49, 0xd0,
+  0xb7, 0x40, 0x17, 0x53, 0xc0, 0x98, 0x5d, 0x7f, 0x45, 0x80, 0x9d, 0x95,
+  0x55, 0xce, 0x68, 0x2d, 0xa9, 0xf0, 0xea, 0x1e, 0xc1, 0x3a, 0xd6, 0x1b,
+  0xd8, 0x52, 0xf2, 0x5c, 0x47, 0xcd, 0x42, 0x61, 0x61, 0x5f, 0x9e, 0x8c,
+  0x3d, 0x91, 0xcd, 0x8d, 0x8d, 0x15, 0x3d, 0x2d, 0x40, 0x8d, 0xb8, 0x1f,
+  0x51, 0xb5, 0x23, 0x8c, 0x2b, 0x57, 0xf0, 0x10, 0xe6, 0x7f, 0x38, 0xd3,
+  0xb7, 0x30, 0xc8, 0xcc, 0x7a, 0x3c, 0xcc, 0x2d, 0xe2, 0x93, 0xcd, 0x36,
+  0x7e, 0x93, 0x79, 0x43, 0x4b, 0xf8, 0xd6, 0x96, 0x99, 0x0e, 0x69, 0x21,
+  0x94, 0x93, 0x62, 0x23, 0xc5, 0x06, 0x5d, 0x00, 0x10, 0x00, 0x00, 0x00,
+  0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x36, 0x1a, 0x40, 0x86,
+  0x32, 0x50, 0xcd, 0x81, 0x2d, 0x23, 0x75, 0x24, 0x9a, 0x13, 0x2d, 0x3e,
+  0x5d, 0xa7, 0xf2, 0x30, 0x07, 0xea, 0x33, 0x39, 0x1d, 0x18, 0x75, 0x0f,
+  0xd5, 0x91, 0xcf, 0x96, 0xeb, 0xcc, 0x6b, 0x83, 0xd8, 0xd2, 0xc7, 0x57,
+  0xbc, 0xa6, 0x7c, 0xe7, 0x79, 0xd1, 0x18, 0x9d, 0x03, 0xdf, 0x5f, 0x1f,
+  0x28, 0xeb, 0xaa, 0x58, 0xe0, 0x16, 0x7a, 0x6d, 0x78, 0x60, 0x03, 0xe6,
+  0x05, 0xd5, 0xda, 0xa6, 0x57, 0x39, 0x8d, 0x8c, 0x80, 0x01, 0x0a, 0x54,
+  0x42, 0xc5, 0x8c, 0x7c, 0xaf, 0xb5, 0xfd, 0xc1, 0xe9, 0x3e, 0x9d, 0x1f,
+  0xdd, 0x1f, 0x9b, 0xc9, 0x49, 0x6c, 0xe8, 0xdb, 0x4c, 0x8c, 0xc4, 0xd3,
+  0x3c, 0x2b, 0xd6, 0x3f, 0x6f, 0x54, 0x8c, 0x4e, 0x0a, 0x9b, 0x19, 0x38,
+  0xc1, 0x10, 0x39, 0xfd, 0xcb, 0x86, 0x5c, 0x3c, 0xe5, 0x3d, 0xe7, 0x13,
+  0x5b, 0x5d, 0xc3, 0x4a, 0xeb, 0x29, 0x38, 0xde, 0xc6, 0x35, 0x39, 0x0b,
+  0x27, 0xf3, 0xcb, 0x8c, 0x81, 0x37, 0x29, 0x72, 0xaa, 0xe6, 0xf3, 0xff,
+  0xf3, 0x00, 0xb8, 0xc9, 0x8d, 0x58, 0x8c, 0x69, 0xc7, 0x19, 0x4e, 0xa9,
+  0x2e, 0xae, 0x14, 0xdf, 0xa3, 0x9b, 0x73, 0x90, 0xaf, 0x53, 0x3b, 0xa6,
+  0x00, 0x90, 0xe1, 0x2f, 0x60, 0xd5, 0xc2, 0xb2, 0x81, 0x31, 0x39, 0x8c,
+  0xaf, 0x5d, 0x00, 0x10, 0x00, 0x00, 0x10, 0x07, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x36, 0x8a, 0x0b, 0x28, 0x13, 0xe1, 0xee, 0xc0, 0x72,
+  0xde, 0xd2, 0x63, 0x37, 0xbb, 0xa0, 0x24, 0x68, 0x61, 0xc6, 0x48, 0x5b,
+  0xba, 0x5c, 0x71, 0xd8, 0x26, 0xdf, 0x3e, 0x2f, 0xf1, 0xab, 0x35, 0x65,
+  0x1c, 0xc4, 0xbd, 0xac, 0xe3, 0xbf, 0x8d, 0xa5, 0xb7, 0x8d, 0x83, 0x53,
+  0x0d, 0x1f, 0xc0, 0xe2, 0x61, 0x28, 0x85, 0x2a, 0x00, 0xe5, 0x9b, 0x5e,
+  0x69, 0x1b, 0xfe, 0x24, 0xd5, 0xb7, 0x64, 0xf8, 0x99, 0x51, 0xce, 0x87,
+  0xea, 0x71, 0x2f, 0xad, 0xb5, 0x90, 0xc9, 0x75, 0x2c, 0xfb, 0x5c, 0x3c,
+  0x8a, 0xf0, 0xe1, 0x64, 0x39, 0x1c, 0x06, 0x40, 0x0e, 0x94, 0x19, 0xb1,
+  0x9b, 0x56, 0xcb, 0xce, 0xdb, 0xe7, 0x2d, 0xa9, 0x7f, 0x10, 0x00,
+};
+
+/**
+  Builds the data the test stream was compressed from.
+
+  @param[out]  Buffer  The buffer receiving TEST_DATA_SIZE bytes.
+**/
+STATIC
+VOID
+GenerateTestData (
+  OUT UINT8  *Buffer
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < TEST_DATA_SIZE; Index++) {
+    Buffer[Index] = (UINT8) (mTestPattern[Index % (sizeof (mTestPattern) - 1)] + Index / SIZE_1KB);
+  }
+}
+
+/**
+  Decodes Stream with MaxWorkers scratch slices, running the worker once per
+  simulated processor.
+
+  @param[in]   Stream       The chunked stream.
+  @param[in]   StreamSize   The size of the chunked stream.
+  @param[in]   MaxWorkers   The number of processors to simulate.
+  @param[out]  Destination  The buffer receiving the decoded data.
+
+  @return The status of the decode.
+**/
+STATIC
+RETURN_STATUS
+DecodeStream (
+  IN  CONST UINT8  *Stream,
+  IN  UINT32       StreamSize,
+  IN  UINT32       MaxWorkers,
+  OUT UINT8        *Destination
+  )
+{
+  RETURN_STATUS         Status;
+  LZMA_CHUNKED_CONTEXT  Context;
+  UINT32                DestinationSize;
+  UINT32                ScratchSize;
+  VOID                  *Scratch;
+  UINT32                Index;
+
+  Status = LzmaChunkedUefiDecompressGetInfo (Stream, StreamSize, MaxWorkers, &DestinationSize, &ScratchSize);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  Scratch = AllocatePool (ScratchSize);
+  if (Scratch == NULL) {
+    return RETURN_OUT_OF_RESOURCES;
+  }
+
+  Status = LzmaChunkedDecompressInit (&Context, Stream, StreamSize, Destination, Scratch, MaxWorkers);
+  if (!RETURN_ERROR (Status)) {
+    for (Index = 0; Index < MaxWorkers; Index++) {
+      LzmaChunkedDecompressWorker (&Context);
+    }
+    Status = Context.Status;
+  }
+
+  FreePool (Scratch);
+  return Status;
+}
+
+/**
+  GetInfo returns the decoded size and a scratch size growing with the number
+  of workers, up to the number of chunks.
+
+  @param[in]  Context  Unit test case context
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+GetInfoShouldScaleScratchWithWorkers (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT32  DestinationSize;
+  UINT32  ScratchSize1;
+  UINT32  ScratchSize3;
+  UINT32  ScratchSize64;
+
+  UT_ASSERT_NOT_EFI_ERROR (LzmaChunkedUefiDecompressGetInfo (mChunkedStream, sizeof (mChunkedStream), 1, &DestinationSize, &ScratchSize1));
+  UT_ASSERT_EQUAL (DestinationSize, TEST_DATA_SIZE);
+  UT_ASSERT_NOT_EFI_ERROR (LzmaChunkedUefiDecompressGetInfo (mChunkedStream, sizeof (mChunkedStream), TEST_CHUNK_COUNT, &DestinationSize, &ScratchSize3));
+  UT_ASSERT_NOT_EFI_ERROR (LzmaChunkedUefiDecompressGetInfo (mChunkedStream, sizeof (mChunkedStream), 64, &DestinationSize, &ScratchSize64));
+
+  UT_ASSERT_EQUAL (ScratchSize3 - ScratchSize1, (TEST_CHUNK_COUNT - 1) * SCRATCH_BUFFER_REQUEST_SIZE);
+  UT_ASSERT_EQUAL (ScratchSize64, ScratchSize3);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The stream decodes back to the original data whatever the number of workers.
+
+  @param[in]  Context  Unit test case context
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+DecodeShouldRoundTrip (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST UINT32  WorkerCounts[] = { 1, 2, TEST_CHUNK_COUNT, 8 };
+  UINT8                *Expected;
+  UINT8                *Decoded;
+  UINTN                Index;
+
+  Expected = AllocatePool (TEST_DATA_SIZE);
+  Decoded  = AllocatePool (TEST_DATA_SIZE);
+  UT_ASSERT_NOT_NULL (Expected);
+  UT_ASSERT_NOT_NULL (Decoded);
+  GenerateTestData (Expected);
+
+  for (Index = 0; Index < ARRAY_SIZE (WorkerCounts); Index++) {
+    SetMem (Decoded, TEST_DATA_SIZE, 0xAA);
+    UT_ASSERT_NOT_EFI_ERROR (DecodeStream (mChunkedStream, sizeof (mChunkedStream), WorkerCounts[Index], Decoded));
+    UT_ASSERT_MEM_EQUAL (Decoded, Expected, TEST_DATA_SIZE);
+  }
+
+  FreePool (Expected);
+  FreePool (Decoded);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Corrupted or truncated streams are rejected before anything is decoded.
+
+  @param[in]  Context  Unit test case context
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+DecodeShouldRejectInvalidStreams (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8   *Stream;
+  UINT8   *Decoded;
+  UINT32  DestinationSize;
+  UINT32  ScratchSize;
+
+  Stream  = AllocateCopyPool (sizeof (mChunkedStream), mChunkedStream);
+  Decoded = AllocatePool (TEST_DATA_SIZE);
+  UT_ASSERT_NOT_NULL (Stream);
+  UT_ASSERT_NOT_NULL (Decoded);
+
+  //
+  // Truncated in the chunk table and in the last chunk stream.
+  //
+  UT_ASSERT_STATUS_EQUAL (
+    LzmaChunkedUefiDecompressGetInfo (Stream, sizeof (LZMA_CHUNKED_HEADER) + 4, 1, &DestinationSize, &ScratchSize),
+    RETURN_INVALID_PARAMETER
+    );
+  UT_ASSERT_STATUS_EQUAL (
+    LzmaChunkedUefiDecompressGetInfo (Stream, sizeof (mChunkedStream) - 1, 1, &DestinationSize, &ScratchSize),
+    RETURN_INVALID_PARAMETER
+    );
+
+  //
+  // Bad signature.
+  //
+  Stream[0] ^= 0xFF;
+  UT_ASSERT_STATUS_EQUAL (DecodeStream (Stream, sizeof (mChunkedStream), 1, Decoded), RETURN_INVALID_PARAMETER);
+  Stream[0] ^= 0xFF;
+
+  //
+  // Chunk count not matching the decoded size.
+  //
+  ((LZMA_CHUNKED_HEADER *) Stream)->ChunkCount++;
+  UT_ASSERT_STATUS_EQUAL (DecodeStream (Stream, sizeof (mChunkedStream), 1, Decoded), RETURN_INVALID_PARAMETER);
+  ((LZMA_CHUNKED_HEADER *) Stream)->ChunkCount--;
+
+  //
+  // Chunk size not matching the decoded size of the chunk streams.
+  //
+  ((LZMA_CHUNKED_HEADER *) Stream)->ChunkSize = 4000;
+  UT_ASSERT_STATUS_EQUAL (DecodeStream (Stream, sizeof (mChunkedStream), 1, Decoded), RETURN_INVALID_PARAMETER);
+
+  FreePool (Stream);
+  FreePool (Decoded);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  chunked LZMA decoder and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ChunkedTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&ChunkedTests, Framework, "Chunked LZMA Decode Tests", "LzmaCustomDecompressLib.Chunked", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ChunkedTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (ChunkedTests, "GetInfo should size the scratch buffer per worker", "GetInfo", GetInfoShouldScaleScratchWithWorkers, NULL, NULL, NULL);
+  AddTestCase (ChunkedTests, "Decode should return the data the stream was encoded from", "RoundTrip", DecodeShouldRoundTrip, NULL, NULL, NULL);
+  AddTestCase (ChunkedTests, "Decode should reject invalid streams", "Invalid", DecodeShouldRejectInvalidStreams, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
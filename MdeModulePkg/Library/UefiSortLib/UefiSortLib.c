@@ -29,11 +29,261 @@ STATIC EFI_UNICODE_COLLATION_PROTOCOL   *mUnicodeCollation = NULL;
   }                                   \
 }
 
+//
+// Partitions with no more elements than this are sorted by insertion sort.
+//
+#define INSERTION_SORT_THRESHOLD  16
+
+/**
+  Swap two elements of the buffer to sort.
+
+  @param[in, out] Element1       The first element.
+  @param[in, out] Element2       The second element.
+  @param[in] ElementSize         Size of an element in bytes.
+  @param[in] Buffer              Buffer of size ElementSize for use in swapping.
+**/
+STATIC
+VOID
+SwapElements (
+  IN OUT VOID                           *Element1,
+  IN OUT VOID                           *Element2,
+  IN CONST UINTN                        ElementSize,
+  IN VOID                               *Buffer
+  )
+{
+  if (Element1 != Element2) {
+    CopyMem (Buffer, Element1, ElementSize);
+    CopyMem (Element1, Element2, ElementSize);
+    CopyMem (Element2, Buffer, ElementSize);
+  }
+}
+
+/**
+  Sort a small buffer of elements by insertion sort.
+
+  @param[in, out] BufferToSort   on call a Buffer of (possibly sorted) elements
+                                 on return a buffer of sorted elements
+  @param[in] Count               the number of elements in the buffer to sort
+  @param[in] ElementSize         Size of an element in bytes
+  @param[in] CompareFunction     The function to call to perform the comparison
+                                 of any 2 elements
+  @param[in] Buffer              Buffer of size ElementSize for use in swapping
+**/
+STATIC
+VOID
+InsertionSortWorker (
+  IN OUT VOID                           *BufferToSort,
+  IN CONST UINTN                        Count,
+  IN CONST UINTN                        ElementSize,
+  IN       SORT_COMPARE                 CompareFunction,
+  IN VOID                               *Buffer
+  )
+{
+  UINTN       LoopCount;
+  UINTN       InsertLocation;
+
+  for (LoopCount = 1; LoopCount < Count; LoopCount++) {
+    InsertLocation = LoopCount;
+    while (InsertLocation > 0 &&
+           CompareFunction (
+             (UINT8 *)BufferToSort + (InsertLocation - 1) * ElementSize,
+             (UINT8 *)BufferToSort + LoopCount * ElementSize
+             ) > 0) {
+      InsertLocation--;
+    }
+
+    //
+    // Shift the sorted elements after the insert location right by one.
+    //
+    if (InsertLocation != LoopCount) {
+      CopyMem (Buffer, (UINT8 *)BufferToSort + LoopCount * ElementSize, ElementSize);
+      CopyMem (
+        (UINT8 *)BufferToSort + (InsertLocation + 1) * ElementSize,
+        (UINT8 *)BufferToSort + InsertLocation * ElementSize,
+        (LoopCount - InsertLocation) * ElementSize
+        );
+      CopyMem ((UINT8 *)BufferToSort + InsertLocation * ElementSize, Buffer, ElementSize);
+    }
+  }
+}
+
+/**
+  Sort a buffer of elements by heap sort. It's used when quick sort partitions
+  the buffer too unevenly, so the sorting time is always O(n log n).
+
+  @param[in, out] BufferToSort   on call a Buffer of (possibly sorted) elements
+                                 on return a buffer of sorted elements
+  @param[in] Count               the number of elements in the buffer to sort
+  @param[in] ElementSize         Size of an element in bytes
+  @param[in] CompareFunction     The function to call to perform the comparison
+                                 of any 2 elements
+  @param[in] Buffer              Buffer of size ElementSize for use in swapping
+**/
+STATIC
+VOID
+HeapSortWorker (
+  IN OUT VOID                           *BufferToSort,
+  IN CONST UINTN                        Count,
+  IN CONST UINTN                        ElementSize,
+  IN       SORT_COMPARE                 CompareFunction,
+  IN VOID                               *Buffer
+  )
+{
+  UINTN       HeapSize;
+  UINTN       Root;
+  UINTN       Child;
+  UINTN       LoopCount;
+
+  //
+  // Build the max heap first, then move the root to the end one by one.
+  //
+  for (LoopCount = Count + Count / 2; LoopCount > 1; LoopCount--) {
+    if (LoopCount > Count) {
+      Root     = LoopCount - Count - 1;
+      HeapSize = Count;
+    } else {
+      SwapElements (BufferToSort, (UINT8 *)BufferToSort + (LoopCount - 1) * ElementSize, ElementSize, Buffer);
+      Root     = 0;
+      HeapSize = LoopCount - 1;
+    }
+
+    //
+    // Sift the root down.
+    //
+    while ((Child = 2 * Root + 1) < HeapSize) {
+      if ((Child + 1 < HeapSize) &&
+          CompareFunction (
+            (UINT8 *)BufferToSort + Child * ElementSize,
+            (UINT8 *)BufferToSort + (Child + 1) * ElementSize
+            ) < 0) {
+        Child++;
+      }
+      if (CompareFunction (
+            (UINT8 *)BufferToSort + Root * ElementSize,
+            (UINT8 *)BufferToSort + Child * ElementSize
+            ) >= 0) {
+        break;
+      }
+      SwapElements (
+        (UINT8 *)BufferToSort + Root * ElementSize,
+        (UINT8 *)BufferToSort + Child * ElementSize,
+        ElementSize,
+        Buffer
+        );
+      Root = Child;
+    }
+  }
+}
+
+/**
+  Sort a buffer of elements by introsort: quick sort using the median of the
+  first, middle and last elements as pivot, falling back to heap sort when the
+  recursion gets too deep, and finishing small partitions by insertion sort.
+
+  Only the smaller partition is recursed into, so the stack depth is bounded
+  by log2(Count).
+
+  @param[in, out] BufferToSort   on call a Buffer of (possibly sorted) elements
+                                 on return a buffer of sorted elements
+  @param[in] Count               the number of elements in the buffer to sort
+  @param[in] ElementSize         Size of an element in bytes
+  @param[in] CompareFunction     The function to call to perform the comparison
+                                 of any 2 elements
+  @param[in] Buffer              Buffer of size ElementSize for use in swapping
+  @param[in] DepthLimit          The number of partitioning levels allowed
+                                 before falling back to heap sort
+**/
+STATIC
+VOID
+IntroSortWorker (
+  IN OUT VOID                           *BufferToSort,
+  IN     UINTN                          Count,
+  IN CONST UINTN                        ElementSize,
+  IN       SORT_COMPARE                 CompareFunction,
+  IN VOID                               *Buffer,
+  IN     UINTN                          DepthLimit
+  )
+{
+  UINT8       *First;
+  UINT8       *Middle;
+  UINT8       *Last;
+  UINTN       Left;
+  UINTN       Right;
+
+  while (Count > INSERTION_SORT_THRESHOLD) {
+    if (DepthLimit == 0) {
+      HeapSortWorker (BufferToSort, Count, ElementSize, CompareFunction, Buffer);
+      return;
+    }
+    DepthLimit--;
+
+    //
+    // Order the first, middle and last elements, then use the median as pivot
+    // and move it to the first element.
+    //
+    First  = (UINT8 *)BufferToSort;
+    Middle = First + (Count / 2) * ElementSize;
+    Last   = First + (Count - 1) * ElementSize;
+    if (CompareFunction (First, Middle) > 0) {
+      SwapElements (First, Middle, ElementSize, Buffer);
+    }
+    if (CompareFunction (Middle, Last) > 0) {
+      SwapElements (Middle, Last, ElementSize, Buffer);
+      if (CompareFunction (First, Middle) > 0) {
+        SwapElements (First, Middle, ElementSize, Buffer);
+      }
+    }
+    SwapElements (First, Middle, ElementSize, Buffer);
+
+    //
+    // Now get the pivot such that all on "left" are not above it
+    // and everything "right" are not below it. The last element is not below
+    // the pivot and the pivot itself stops the scans, so they never run out of
+    // the buffer. Elements equal to the pivot are spread to both sides.
+    //
+    Left  = 1;
+    Right = Count - 1;
+    while (TRUE) {
+      while (CompareFunction (First + Left * ElementSize, First) < 0) {
+        Left++;
+      }
+      while (CompareFunction (First + Right * ElementSize, First) > 0) {
+        Right--;
+      }
+      if (Left >= Right) {
+        break;
+      }
+      SwapElements (First + Left * ElementSize, First + Right * ElementSize, ElementSize, Buffer);
+      Left++;
+      Right--;
+    }
+    SwapElements (First, First + Right * ElementSize, ElementSize, Buffer);
+
+    //
+    // Recurse on the smaller partial list and loop on the larger one.
+    // Neither of them will have the 'pivot' element.
+    //
+    if (Right < Count - Right - 1) {
+      IntroSortWorker (First, Right, ElementSize, CompareFunction, Buffer, DepthLimit);
+      BufferToSort = First + (Right + 1) * ElementSize;
+      Count        = Count - Right - 1;
+    } else {
+      IntroSortWorker (First + (Right + 1) * ElementSize, Count - Right - 1, ElementSize, CompareFunction, Buffer, DepthLimit);
+      Count        = Right;
+    }
+  }
+
+  InsertionSortWorker (BufferToSort, Count, ElementSize, CompareFunction, Buffer);
+}
+
 /**
   Worker function for QuickSorting.  This function is identical to PerformQuickSort,
   except that is uses the pre-allocated buffer so the in place sorting does not need to
   allocate and free buffers constantly.
 
+  The sort is an introsort, so it takes O(n log n) time and O(log n) stack even
+  for already sorted input.
+
   Each element must be equal sized.
 
   if BufferToSort is NULL, then ASSERT.
@@ -61,10 +311,6 @@ QuickSortWorker (
   IN VOID                               *Buffer
   )
 {
-  VOID        *Pivot;
-  UINTN       LoopCount;
-  UINTN       NextSwapLocation;
-
   ASSERT(BufferToSort     != NULL);
   ASSERT(CompareFunction  != NULL);
   ASSERT(Buffer  != NULL);
@@ -75,68 +321,17 @@ QuickSortWorker (
     return;
   }
 
-  NextSwapLocation = 0;
-
-  //
-  // pick a pivot (we choose last element)
-  //
-  Pivot = ((UINT8*)BufferToSort+((Count-1)*ElementSize));
-
-  //
-  // Now get the pivot such that all on "left" are below it
-  // and everything "right" are above it
-  //
-  for ( LoopCount = 0
-      ; LoopCount < Count -1
-      ; LoopCount++
-     ){
-    //
-    // if the element is less than the pivot
-    //
-    if (CompareFunction((VOID*)((UINT8*)BufferToSort+((LoopCount)*ElementSize)),Pivot) <= 0){
-      //
-      // swap
-      //
-      CopyMem (Buffer, (UINT8*)BufferToSort+(NextSwapLocation*ElementSize), ElementSize);
-      CopyMem ((UINT8*)BufferToSort+(NextSwapLocation*ElementSize), (UINT8*)BufferToSort+((LoopCount)*ElementSize), ElementSize);
-      CopyMem ((UINT8*)BufferToSort+((LoopCount)*ElementSize), Buffer, ElementSize);
-
-      //
-      // increment NextSwapLocation
-      //
-      NextSwapLocation++;
-    }
-  }
-  //
-  // swap pivot to it's final position (NextSwapLocaiton)
-  //
-  CopyMem (Buffer, Pivot, ElementSize);
-  CopyMem (Pivot, (UINT8*)BufferToSort+(NextSwapLocation*ElementSize), ElementSize);
-  CopyMem ((UINT8*)BufferToSort+(NextSwapLocation*ElementSize), Buffer, ElementSize);
-
   //
-  // Now recurse on 2 paritial lists.  neither of these will have the 'pivot' element
-  // IE list is sorted left half, pivot element, sorted right half...
+  // Allow twice the depth of a perfectly balanced partitioning.
   //
-  if (NextSwapLocation >= 2) {
-    QuickSortWorker(
-      BufferToSort,
-      NextSwapLocation,
-      ElementSize,
-      CompareFunction,
-      Buffer);
-  }
-
-  if ((Count - NextSwapLocation - 1) >= 2) {
-    QuickSortWorker(
-      (UINT8 *)BufferToSort + (NextSwapLocation+1) * ElementSize,
-      Count - NextSwapLocation - 1,
-      ElementSize,
-      CompareFunction,
-      Buffer);
-  }
-
-  return;
+  IntroSortWorker (
+    BufferToSort,
+    Count,
+    ElementSize,
+    CompareFunction,
+    Buffer,
+    2 * ((UINTN)HighBitSet64 (Count) + 1)
+    );
 }
 /**
   Function to perform a Quick Sort alogrithm on a buffer of comparable elements.
@@ -14,6 +14,7 @@
 
 #include <Protocol/AcpiTable.h>
 #include <Guid/Acpi.h>
+#include <Guid/EventGroup.h>
 #include <Protocol/AcpiSystemDescriptionTable.h>
 
 #include <Library/BaseLib.h>
@@ -115,6 +116,8 @@ typedef struct {
   EFI_ACPI_TABLE_PROTOCOL                       AcpiTableProtocol;
   EFI_ACPI_SDT_PROTOCOL                         AcpiSdtProtocol;
   LIST_ENTRY                                    NotifyList;
+  BOOLEAN                                       DeferPublish;           // Publication is deferred to EndOfDxe
+  EFI_ACPI_TABLE_VERSION                        DeferredVersion;        // Versions to publish at EndOfDxe
 } EFI_ACPI_TABLE_INSTANCE;
 
 //
@@ -125,6 +125,15 @@ PublishTables (
   VOID                      *CurrentXsdtEntry;
   UINT64                    Buffer64;
 
+  //
+  // If the publication is deferred, the RSDT/XSDT are not visible yet, so
+  // only remember which versions must be published at EndOfDxe.
+  //
+  if (AcpiTableInstance->DeferPublish) {
+    AcpiTableInstance->DeferredVersion |= Version;
+    return EFI_SUCCESS;
+  }
+
   //
   // Reorder tables as some operating systems don't seem to find the
   // FADT correctly if it is not in the first few entries
@@ -180,6 +189,37 @@ PublishTables (
   return EFI_SUCCESS;
 }
 
+/**
+  Publish the ACPI tables whose publication was deferred at EndOfDxe.
+
+  This runs at TPL_NOTIFY, so the tables are in the EFI system table before
+  the EndOfDxe handlers at lower TPL, e.g. S3SaveStateDxe looking up the FACS.
+
+  @param  Event    Event whose notification function is being invoked.
+  @param  Context  Pointer to the ACPI table protocol instance.
+
+**/
+VOID
+EFIAPI
+PublishDeferredTables (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_ACPI_TABLE_INSTANCE   *AcpiTableInstance;
+  EFI_STATUS                Status;
+
+  gBS->CloseEvent (Event);
+
+  AcpiTableInstance = (EFI_ACPI_TABLE_INSTANCE *) Context;
+  AcpiTableInstance->DeferPublish = FALSE;
+  if (AcpiTableInstance->DeferredVersion != 0) {
+    Status = PublishTables (AcpiTableInstance, AcpiTableInstance->DeferredVersion);
+    ASSERT_EFI_ERROR (Status);
+    AcpiTableInstance->DeferredVersion = 0;
+  }
+}
+
 
 /**
   Installs an ACPI table into the RSDT/XSDT.
@@ -342,9 +382,10 @@ ReallocateAcpiTableBuffer (
 
   CopyMem (&TempPrivateData, AcpiTableInstance, sizeof (EFI_ACPI_TABLE_INSTANCE));
   //
-  // Enlarge the max table number from mEfiAcpiMaxNumTables to mEfiAcpiMaxNumTables + EFI_ACPI_MAX_NUM_TABLES
+  // Double the max table number, so that the tables are copied a number of
+  // times logarithmic in the number of installed tables.
   //
-  NewMaxTableNumber = mEfiAcpiMaxNumTables + EFI_ACPI_MAX_NUM_TABLES;
+  NewMaxTableNumber = mEfiAcpiMaxNumTables * 2;
   //
   // Create RSDT, XSDT structures and allocate buffers.
   //
@@ -1093,7 +1134,10 @@ AddTableToList (
     }
   }
 
-  ChecksumCommonTables (AcpiTableInstance);
+  //
+  // The common tables are checksummed by PublishTables(), which is always
+  // called once the table is added.
+  //
   return EFI_SUCCESS;
 }
 
@@ -1866,6 +1910,7 @@ AcpiTableAcpiTableConstructor (
   UINTN                 RsdpTableSize;
   UINT8                 *Pointer;
   EFI_PHYSICAL_ADDRESS  PageAddress;
+  EFI_EVENT             EndOfDxeEvent;
 
   //
   // Check for invalid input parameters
@@ -2073,6 +2118,25 @@ AcpiTableAcpiTableConstructor (
 
   ChecksumCommonTables (AcpiTableInstance);
 
+  //
+  // Publish the tables only once at EndOfDxe if the platform asks for it,
+  // instead of each time a table is installed or uninstalled. Tables changed
+  // after EndOfDxe are published immediately.
+  //
+  if (FeaturePcdGet (PcdAcpiTableDeferredPublish)) {
+    Status = gBS->CreateEventEx (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_NOTIFY,
+                    PublishDeferredTables,
+                    AcpiTableInstance,
+                    &gEfiEndOfDxeEventGroupGuid,
+                    &EndOfDxeEvent
+                    );
+    if (!EFI_ERROR (Status)) {
+      AcpiTableInstance->DeferPublish = TRUE;
+    }
+  }
+
   InstallAcpiTableFromHob (AcpiTableInstance);
 
   //
@@ -111,7 +111,10 @@ TERMINAL_DEV  mTerminalDevTemplate = {
     NULL,
     NULL,
   },
-  NULL // KeyNotifyProcessEvent
+  NULL, // KeyNotifyProcessEvent
+  NULL, // ShadowScreen
+  0,    // ShadowColumns
+  0     // ShadowRows
 };
 
 TERMINAL_CONSOLE_MODE_DATA mTerminalConsoleModeData[] = {
@@ -827,6 +830,10 @@ FreeResources:
     FreePool (TerminalDevice->TerminalConsoleModeData);
   }
 
+  if (TerminalDevice->ShadowScreen != NULL) {
+    FreePool (TerminalDevice->ShadowScreen);
+  }
+
   FreePool (TerminalDevice);
 
 CloseProtocols:
@@ -986,6 +993,9 @@ TerminalDriverBindingStop (
         TerminalFreeNotifyList (&TerminalDevice->NotifyList);
         FreePool (TerminalDevice->DevicePath);
         FreePool (TerminalDevice->TerminalConsoleModeData);
+        if (TerminalDevice->ShadowScreen != NULL) {
+          FreePool (TerminalDevice->ShadowScreen);
+        }
         FreePool (TerminalDevice);
       }
     }
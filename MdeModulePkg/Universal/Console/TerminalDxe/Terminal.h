@@ -40,6 +40,11 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define RAW_FIFO_MAX_NUMBER 255
 #define FIFO_MAX_NUMBER     128
 
+//
+// Number of bytes OutputString() collects before writing them to the serial device
+//
+#define TERMINAL_OUTPUT_BUFFER_SIZE 128
+
 typedef struct {
   UINT8 Head;
   UINT8 Tail;
@@ -63,6 +68,15 @@ typedef struct {
   UINTN   Rows;
 } TERMINAL_CONSOLE_MODE_DATA;
 
+//
+// A character cell of the terminal screen as last sent by OutputString().
+// Char is 0 if the content of the cell is unknown.
+//
+typedef struct {
+  CHAR16  Char;
+  UINT8   Attribute;
+} TERMINAL_SCREEN_CELL;
+
 #define KEYBOARD_TIMER_INTERVAL         200000  // 0.02s
 
 #define TERMINAL_DEV_SIGNATURE  SIGNATURE_32 ('t', 'm', 'n', 'l')
@@ -122,6 +136,13 @@ typedef struct {
   EFI_SIMPLE_TEXT_INPUT_EX_PROTOCOL   SimpleInputEx;
   LIST_ENTRY                          NotifyList;
   EFI_EVENT                           KeyNotifyProcessEvent;
+  //
+  // Shadow of the terminal screen, used to avoid sending the characters
+  // which the terminal already shows.
+  //
+  TERMINAL_SCREEN_CELL                *ShadowScreen;
+  UINTN                               ShadowColumns;
+  UINTN                               ShadowRows;
 } TERMINAL_DEV;
 
 #define INPUT_STATE_DEFAULT               0x00
@@ -593,6 +614,18 @@ TerminalConOutEnableCursor (
   IN  BOOLEAN                          Visible
   );
 
+/**
+  Forget the content of the terminal screen recorded by
+  TerminalConOutOutputString(), so that all characters are sent again.
+
+  @param  TerminalDevice          The terminal device.
+
+**/
+VOID
+TerminalInvalidateShadowScreen (
+  IN TERMINAL_DEV  *TerminalDevice
+  );
+
 /**
   Test to see if this driver supports Controller.
 
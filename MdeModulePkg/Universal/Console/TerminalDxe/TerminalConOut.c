@@ -140,6 +140,8 @@ TerminalConOutReset (
     }
   }
 
+  TerminalInvalidateShadowScreen (TerminalDevice);
+
   This->SetAttribute (This, EFI_TEXT_ATTR (This->Mode->Attribute & 0x0F, EFI_BLACK));
 
   Status = This->SetMode (This, 0);
@@ -148,12 +150,115 @@ TerminalConOutReset (
 }
 
 
+/**
+  Forget the content of the terminal screen recorded by
+  TerminalConOutOutputString(), so that all characters are sent again.
+
+  @param  TerminalDevice          The terminal device.
+
+**/
+VOID
+TerminalInvalidateShadowScreen (
+  IN TERMINAL_DEV  *TerminalDevice
+  )
+{
+  if (TerminalDevice->ShadowScreen != NULL) {
+    ZeroMem (
+      TerminalDevice->ShadowScreen,
+      TerminalDevice->ShadowColumns * TerminalDevice->ShadowRows * sizeof (TERMINAL_SCREEN_CELL)
+      );
+  }
+}
+
+/**
+  Send the output data collected by TerminalConOutOutputString() to the
+  serial device.
+
+  @param  TerminalDevice          The terminal device.
+  @param  Buffer                  The collected output data.
+  @param  Length                  On input, the size of the collected data.
+                                  On output, set to 0.
+
+  @retval EFI_SUCCESS             The data is sent.
+  @retval Others                  The serial device fails to send the data.
+
+**/
+EFI_STATUS
+TerminalFlushOutput (
+  IN     TERMINAL_DEV  *TerminalDevice,
+  IN     UINT8         *Buffer,
+  IN OUT UINTN         *Length
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Size;
+
+  if (*Length == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Size    = *Length;
+  *Length = 0;
+  Status  = TerminalDevice->SerialIo->Write (
+                                        TerminalDevice->SerialIo,
+                                        &Size,
+                                        Buffer
+                                        );
+  return Status;
+}
+
+/**
+  Collect output data of TerminalConOutOutputString(), the data is sent to the
+  serial device when the buffer is full.
+
+  @param  TerminalDevice          The terminal device.
+  @param  Buffer                  The buffer of TERMINAL_OUTPUT_BUFFER_SIZE bytes
+                                  collecting the output data.
+  @param  Length                  On input, the size of the collected data.
+                                  On output, the new size of the collected data.
+  @param  Data                    The data to output.
+  @param  DataSize                The size of the data to output.
+
+  @retval EFI_SUCCESS             The data is collected.
+  @retval Others                  The serial device fails to send the data.
+
+**/
+EFI_STATUS
+TerminalBufferOutput (
+  IN     TERMINAL_DEV  *TerminalDevice,
+  IN     UINT8         *Buffer,
+  IN OUT UINTN         *Length,
+  IN     VOID          *Data,
+  IN     UINTN         DataSize
+  )
+{
+  EFI_STATUS  Status;
+
+  ASSERT (DataSize <= TERMINAL_OUTPUT_BUFFER_SIZE);
+
+  if (*Length + DataSize > TERMINAL_OUTPUT_BUFFER_SIZE) {
+    Status = TerminalFlushOutput (TerminalDevice, Buffer, Length);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  CopyMem (Buffer + *Length, Data, DataSize);
+  *Length += DataSize;
+  return EFI_SUCCESS;
+}
+
 /**
   Implements EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL.OutputString().
 
   The Unicode string will be converted to terminal expressible data stream
   and send to terminal via serial port.
 
+  If PcdTerminalSkipUnchangedOutput is TRUE, the characters which the terminal
+  already shows at the cursor position with the current attribute are not sent
+  again, the cursor is moved past them by a single cursor position control
+  sequence instead.
+
   @param  This                    Indicates the calling context.
   @param  WString                 The Null-terminated Unicode string to be displayed
                                   on the terminal screen.
@@ -176,22 +281,28 @@ TerminalConOutOutputString (
   EFI_SIMPLE_TEXT_OUTPUT_MODE *Mode;
   UINTN                       MaxColumn;
   UINTN                       MaxRow;
-  UINTN                       Length;
   UTF8_CHAR                   Utf8Char;
   CHAR8                       GraphicChar;
   CHAR8                       AsciiChar;
   EFI_STATUS                  Status;
   UINT8                       ValidBytes;
   CHAR8                       CrLfStr[2];
+  UINT8                       OutputBuffer[TERMINAL_OUTPUT_BUFFER_SIZE];
+  UINTN                       OutputLength;
+  TERMINAL_SCREEN_CELL        *Cell;
+  BOOLEAN                     CursorOutOfSync;
+  BOOLEAN                     UnknownGlyph;
   //
   //  flag used to indicate whether condition happens which will cause
   //  return EFI_WARN_UNKNOWN_GLYPH
   //
   BOOLEAN                     Warning;
 
-  ValidBytes  = 0;
-  Warning     = FALSE;
-  AsciiChar   = 0;
+  ValidBytes      = 0;
+  Warning         = FALSE;
+  AsciiChar       = 0;
+  OutputLength    = 0;
+  CursorOutOfSync = FALSE;
 
   //
   //  get Terminal device data structure pointer.
@@ -214,73 +325,147 @@ TerminalConOutOutputString (
           &MaxRow
           );
 
-  for (; *WString != CHAR_NULL; WString++) {
-
-    switch (TerminalDevice->TerminalType) {
+  //
+  // Track the screen content for the text, not for the control sequences.
+  // TtyTerm relies on the terminal wrapping the cursor by itself, and the
+  // cursor position control sequence only holds 2 digits, so neither is
+  // tracked. The shadow is only correct if nothing else writes to the
+  // terminal, so the platform must enable it.
+  //
+  if (!FeaturePcdGet (PcdTerminalSkipUnchangedOutput) ||
+      TerminalDevice->OutputEscChar || TerminalDevice->TerminalType == TerminalTypeTtyTerm ||
+      MaxColumn > 99 || MaxRow > 99) {
+    Cell = NULL;
+  } else {
+    if (TerminalDevice->ShadowScreen != NULL &&
+        (TerminalDevice->ShadowColumns != MaxColumn || TerminalDevice->ShadowRows != MaxRow)) {
+      FreePool (TerminalDevice->ShadowScreen);
+      TerminalDevice->ShadowScreen = NULL;
+    }
+    if (TerminalDevice->ShadowScreen == NULL) {
+      TerminalDevice->ShadowScreen  = AllocateZeroPool (MaxColumn * MaxRow * sizeof (TERMINAL_SCREEN_CELL));
+      TerminalDevice->ShadowColumns = MaxColumn;
+      TerminalDevice->ShadowRows    = MaxRow;
+    }
+    Cell = TerminalDevice->ShadowScreen;
+  }
 
-    case TerminalTypePcAnsi:
-    case TerminalTypeVt100:
-    case TerminalTypeVt100Plus:
-    case TerminalTypeTtyTerm:
-    case TerminalTypeLinux:
-    case TerminalTypeXtermR6:
-    case TerminalTypeVt400:
-    case TerminalTypeSCO:
+  for (; *WString != CHAR_NULL; WString++) {
 
-      if (!TerminalIsValidTextGraphics (*WString, &GraphicChar, &AsciiChar)) {
+    UnknownGlyph = FALSE;
+    if (Cell != NULL) {
+      Cell = &TerminalDevice->ShadowScreen[Mode->CursorRow * MaxColumn + Mode->CursorColumn];
+      if (*WString >= L' ' && Cell->Char == *WString && Cell->Attribute == (UINT8) Mode->Attribute) {
         //
-        // If it's not a graphic character convert Unicode to ASCII.
+        // The terminal already shows this character, only move the cursor.
         //
-        GraphicChar = (CHAR8) *WString;
+        CursorOutOfSync = TRUE;
+      } else if (CursorOutOfSync) {
+        Status = TerminalFlushOutput (TerminalDevice, OutputBuffer, &OutputLength);
+        if (EFI_ERROR (Status)) {
+          goto OutputError;
+        }
+        Status = This->SetCursorPosition (This, Mode->CursorColumn, Mode->CursorRow);
+        if (EFI_ERROR (Status)) {
+          goto OutputError;
+        }
+        CursorOutOfSync = FALSE;
+      }
+    }
+
+    if (!CursorOutOfSync) {
+      switch (TerminalDevice->TerminalType) {
 
-        if (!(TerminalIsValidAscii (GraphicChar) || TerminalIsValidEfiCntlChar (GraphicChar))) {
+      case TerminalTypePcAnsi:
+      case TerminalTypeVt100:
+      case TerminalTypeVt100Plus:
+      case TerminalTypeTtyTerm:
+      case TerminalTypeLinux:
+      case TerminalTypeXtermR6:
+      case TerminalTypeVt400:
+      case TerminalTypeSCO:
+
+        if (!TerminalIsValidTextGraphics (*WString, &GraphicChar, &AsciiChar)) {
           //
-          // when this driver use the OutputString to output control string,
-          // TerminalDevice->OutputEscChar is set to let the Esc char
-          // to be output to the terminal emulation software.
+          // If it's not a graphic character convert Unicode to ASCII.
           //
-          if ((GraphicChar == 27) && TerminalDevice->OutputEscChar) {
-            GraphicChar = 27;
-          } else {
-            GraphicChar = '?';
-            Warning     = TRUE;
+          GraphicChar = (CHAR8) *WString;
+
+          if (!(TerminalIsValidAscii (GraphicChar) || TerminalIsValidEfiCntlChar (GraphicChar))) {
+            //
+            // when this driver use the OutputString to output control string,
+            // TerminalDevice->OutputEscChar is set to let the Esc char
+            // to be output to the terminal emulation software.
+            //
+            if ((GraphicChar == 27) && TerminalDevice->OutputEscChar) {
+              GraphicChar = 27;
+            } else {
+              GraphicChar  = '?';
+              Warning      = TRUE;
+              UnknownGlyph = TRUE;
+            }
           }
-        }
 
-        AsciiChar = GraphicChar;
+          AsciiChar = GraphicChar;
 
-      }
+        }
 
-      if (TerminalDevice->TerminalType != TerminalTypePcAnsi) {
-        GraphicChar = AsciiChar;
-      }
+        if (TerminalDevice->TerminalType != TerminalTypePcAnsi) {
+          GraphicChar = AsciiChar;
+        }
 
-      Length = 1;
+        Status = TerminalBufferOutput (
+                   TerminalDevice,
+                   OutputBuffer,
+                   &OutputLength,
+                   &GraphicChar,
+                   1
+                   );
 
-      Status = TerminalDevice->SerialIo->Write (
-                                          TerminalDevice->SerialIo,
-                                          &Length,
-                                          &GraphicChar
-                                          );
+        if (EFI_ERROR (Status)) {
+          goto OutputError;
+        }
 
-      if (EFI_ERROR (Status)) {
-        goto OutputError;
+        break;
+
+      case TerminalTypeVtUtf8:
+        UnicodeToUtf8 (*WString, &Utf8Char, &ValidBytes);
+        Status = TerminalBufferOutput (
+                   TerminalDevice,
+                   OutputBuffer,
+                   &OutputLength,
+                   &Utf8Char,
+                   ValidBytes
+                   );
+        if (EFI_ERROR (Status)) {
+          goto OutputError;
+        }
+        break;
       }
 
-      break;
+      if (Cell != NULL) {
+        //
+        // Record the character sent to the terminal. Control characters and
+        // unknown glyphs don't leave a known character in the cell, so they
+        // are always sent and EFI_WARN_UNKNOWN_GLYPH is always returned.
+        //
+        if (*WString >= L' ' && !UnknownGlyph) {
+          Cell->Char      = *WString;
+          Cell->Attribute = (UINT8) Mode->Attribute;
+        } else if (UnknownGlyph ||
+                   (*WString != CHAR_BACKSPACE && *WString != CHAR_LINEFEED && *WString != CHAR_CARRIAGE_RETURN)) {
+          Cell->Char      = 0;
+        }
 
-    case TerminalTypeVtUtf8:
-      UnicodeToUtf8 (*WString, &Utf8Char, &ValidBytes);
-      Length = ValidBytes;
-      Status = TerminalDevice->SerialIo->Write (
-                                          TerminalDevice->SerialIo,
-                                          &Length,
-                                          (UINT8 *) &Utf8Char
-                                          );
-      if (EFI_ERROR (Status)) {
-        goto OutputError;
+        //
+        // Writing the last cell of the screen, or a line feed on the last row,
+        // scrolls the screen. Forget the content of the screen then.
+        //
+        if ((UINTN) Mode->CursorRow == MaxRow - 1 &&
+            ((UINTN) Mode->CursorColumn == MaxColumn - 1 || *WString == CHAR_LINEFEED)) {
+          ZeroMem (TerminalDevice->ShadowScreen, MaxColumn * MaxRow * sizeof (TERMINAL_SCREEN_CELL));
+        }
       }
-      break;
     }
     //
     //  Update cursor position.
@@ -290,6 +475,13 @@ TerminalConOutOutputString (
     case CHAR_BACKSPACE:
       if (Mode->CursorColumn > 0) {
         Mode->CursorColumn--;
+      } else if (Cell != NULL) {
+        //
+        // Some terminals move the cursor to the end of the previous row, so
+        // where the next characters land is unknown.
+        //
+        TerminalInvalidateShadowScreen (TerminalDevice);
+        CursorOutOfSync = TRUE;
       }
       break;
 
@@ -315,6 +507,14 @@ TerminalConOutOutputString (
           Mode->CursorRow++;
         }
 
+        if (Cell != NULL) {
+          //
+          // Terminals differ on when the cursor wraps after the last column,
+          // so position it explicitly before anything else is sent.
+          //
+          CursorOutOfSync = TRUE;
+        }
+
         if (TerminalDevice->TerminalType == TerminalTypeTtyTerm &&
             !TerminalDevice->OutputEscChar) {
           //
@@ -328,13 +528,13 @@ TerminalConOutOutputString (
           CrLfStr[0] = '\r';
           CrLfStr[1] = '\n';
 
-          Length = sizeof(CrLfStr);
-
-          Status = TerminalDevice->SerialIo->Write (
-                                                TerminalDevice->SerialIo,
-                                                &Length,
-                                                CrLfStr
-                                                );
+          Status = TerminalBufferOutput (
+                     TerminalDevice,
+                     OutputBuffer,
+                     &OutputLength,
+                     CrLfStr,
+                     sizeof (CrLfStr)
+                     );
 
           if (EFI_ERROR (Status)) {
             goto OutputError;
@@ -347,6 +547,21 @@ TerminalConOutOutputString (
 
   }
 
+  Status = TerminalFlushOutput (TerminalDevice, OutputBuffer, &OutputLength);
+  if (EFI_ERROR (Status)) {
+    goto OutputError;
+  }
+
+  //
+  // Move the terminal cursor past the characters which are not sent.
+  //
+  if (CursorOutOfSync) {
+    Status = This->SetCursorPosition (This, Mode->CursorColumn, Mode->CursorRow);
+    if (EFI_ERROR (Status)) {
+      goto OutputError;
+    }
+  }
+
   if (Warning) {
     return EFI_WARN_UNKNOWN_GLYPH;
   }
@@ -496,6 +711,8 @@ TerminalConOutSetMode (
   //
   This->Mode->Mode = (INT32) ModeNumber;
 
+  TerminalInvalidateShadowScreen (TerminalDevice);
+
   This->ClearScreen (This);
 
   TerminalDevice->OutputEscChar = TRUE;
@@ -725,6 +942,12 @@ TerminalConOutClearScreen (
     return EFI_DEVICE_ERROR;
   }
 
+  //
+  // The terminal may fill the screen with a color other than the current
+  // background, so the content of the screen is unknown.
+  //
+  TerminalInvalidateShadowScreen (TerminalDevice);
+
   Status = This->SetCursorPosition (This, 0, 0);
 
   return Status;
@@ -851,6 +1074,12 @@ TerminalConOutEnableCursor (
   IN  BOOLEAN                          Visible
   )
 {
+  //
+  // A caller toggling the cursor usually redraws the screen, possibly after
+  // the terminal has been reattached, so send every character again.
+  //
+  TerminalInvalidateShadowScreen (TERMINAL_CON_OUT_DEV_FROM_THIS (This));
+
   if (!Visible) {
     return EFI_UNSUPPORTED;
   }
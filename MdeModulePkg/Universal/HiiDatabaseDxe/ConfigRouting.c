@@ -10,6 +10,16 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "HiiDatabase.h"
 extern HII_DATABASE_PRIVATE_DATA mPrivate;
 
+//
+// The form packages exported for the HII handle last queried by the config
+// routing functions. A single ExtractConfig/ExportConfig call walks the same
+// package list several times, so the export is kept until the form packages
+// of any package list change.
+//
+EFI_HII_HANDLE  mCachedFormPackageHandle = NULL;
+UINT8           *mCachedFormPackage      = NULL;
+UINTN           mCachedFormPackageSize   = 0;
+
 /**
   Calculate the number of Unicode characters of the incoming Configuration string,
   not including NULL terminator.
@@ -382,6 +392,35 @@ OutputConfigBody (
   return EFI_SUCCESS;
 }
 
+/**
+  Get the buffer size used to hold a multi-string of the given size.
+
+  The buffer starts at MAX_STRING_LENGTH and is doubled each time it runs out
+  of space, so appending N strings costs O(N) copies in total.
+
+  This is a internal function.
+
+  @param  StringSize             Size in bytes of the multi-string, including
+                                 the NULL terminator.
+
+  @return The size in bytes of the buffer holding the multi-string.
+
+**/
+UINTN
+GetMultiStringBufferSize (
+  IN UINTN                         StringSize
+  )
+{
+  UINTN BufferSize;
+
+  BufferSize = MAX_STRING_LENGTH;
+  while (BufferSize < StringSize) {
+    BufferSize *= 2;
+  }
+
+  return BufferSize;
+}
+
 /**
   Append a string to a multi-string format.
 
@@ -390,11 +429,13 @@ OutputConfigBody (
   @param  MultiString            String in <MultiConfigRequest>,
                                  <MultiConfigAltResp>, or <MultiConfigResp>. On
                                  input, the buffer length of  this string is
-                                 MAX_STRING_LENGTH. On output, the  buffer length
-                                 might be updated.
+                                 MAX_STRING_LENGTH or the length returned by
+                                 GetMultiStringBufferSize() for its size. On
+                                 output, the  buffer length might be updated.
   @param  AppendString           NULL-terminated Unicode string.
 
   @retval EFI_INVALID_PARAMETER  Any incoming parameter is invalid.
+  @retval EFI_OUT_OF_RESOURCES   Not enough memory to enlarge MultiString.
   @retval EFI_SUCCESS            AppendString is append to the end of MultiString
 
 **/
@@ -406,7 +447,8 @@ AppendToMultiString (
 {
   UINTN AppendStringSize;
   UINTN MultiStringSize;
-  UINTN MaxLen;
+  UINTN OldBufferSize;
+  UINTN NewBufferSize;
 
   if (MultiString == NULL || *MultiString == NULL || AppendString == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -414,25 +456,31 @@ AppendToMultiString (
 
   AppendStringSize = StrSize (AppendString);
   MultiStringSize  = StrSize (*MultiString);
-  MaxLen = MAX_STRING_LENGTH / sizeof (CHAR16);
 
   //
-  // Enlarge the buffer each time when length exceeds MAX_STRING_LENGTH.
+  // Enlarge the buffer geometrically, only when the new string no longer fits.
   //
-  if (MultiStringSize + AppendStringSize > MAX_STRING_LENGTH ||
-      MultiStringSize > MAX_STRING_LENGTH) {
+  OldBufferSize = GetMultiStringBufferSize (MultiStringSize);
+  NewBufferSize = GetMultiStringBufferSize (MultiStringSize + AppendStringSize - sizeof (CHAR16));
+  if (NewBufferSize > OldBufferSize) {
     *MultiString = (EFI_STRING) ReallocatePool (
-                                  MultiStringSize,
-                                  MultiStringSize + AppendStringSize,
+                                  OldBufferSize,
+                                  NewBufferSize,
                                   (VOID *) (*MultiString)
                                   );
-    MaxLen = (MultiStringSize + AppendStringSize) / sizeof (CHAR16);
-    ASSERT (*MultiString != NULL);
+    if (*MultiString == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
   }
   //
-  // Append the incoming string
+  // Append the incoming string, including its NULL terminator, right after
+  // the existing one.
   //
-  StrCatS (*MultiString, MaxLen, AppendString);
+  CopyMem (
+    (UINT8 *) (*MultiString) + MultiStringSize - sizeof (CHAR16),
+    AppendString,
+    AppendStringSize
+    );
 
   return EFI_SUCCESS;
 }
@@ -1528,9 +1576,32 @@ BlockArrayCheck (
   return FALSE;
 }
 
+/**
+  Drop the cached form packages returned by GetFormPackageData.
+
+  It must be called whenever a form package is added to or removed from any
+  package list.
+
+**/
+VOID
+InvalidateFormPackageCache (
+  VOID
+  )
+{
+  if (mCachedFormPackage != NULL) {
+    FreePool (mCachedFormPackage);
+  }
+  mCachedFormPackageHandle = NULL;
+  mCachedFormPackage       = NULL;
+  mCachedFormPackageSize   = 0;
+}
+
 /**
   Get form package data from data base.
 
+  The returned buffer is owned by the form package cache and stays valid until
+  the form packages in the database change. Caller must not free it.
+
   @param  DataBaseRecord         The DataBaseRecord instance contains the found Hii handle and package.
   @param  HiiFormPackage         The buffer saves the package data.
   @param  PackageSize            The buffer size of the package data.
@@ -1551,6 +1622,12 @@ GetFormPackageData (
     return EFI_INVALID_PARAMETER;
   }
 
+  if (mCachedFormPackage != NULL && mCachedFormPackageHandle == DataBaseRecord->Handle) {
+    *HiiFormPackage = mCachedFormPackage;
+    *PackageSize    = mCachedFormPackageSize;
+    return EFI_SUCCESS;
+  }
+
   Size       = 0;
   ResultSize = 0;
   //
@@ -1591,10 +1668,17 @@ GetFormPackageData (
            );
   if (EFI_ERROR (Status)) {
     FreePool (*HiiFormPackage);
+    *HiiFormPackage = NULL;
+    return Status;
   }
 
   *PackageSize = Size;
 
+  InvalidateFormPackageCache ();
+  mCachedFormPackageHandle = DataBaseRecord->Handle;
+  mCachedFormPackage       = *HiiFormPackage;
+  mCachedFormPackageSize   = Size;
+
   return Status;
 }
 
@@ -1729,9 +1813,6 @@ GetVarStoreType (
     }
   }
 Done:
-  if (HiiFormPackage != NULL) {
-    FreePool (HiiFormPackage);
-  }
 
   return Status;
 }
@@ -1955,9 +2036,6 @@ IsThisPackageList (
     }
   }
 Done:
-  if (HiiFormPackage != NULL) {
-    FreePool (HiiFormPackage);
-  }
 
   if (VarStoreName != NULL) {
     FreePool (VarStoreName);
@@ -4278,9 +4356,6 @@ Done:
   //
   // Free Package data
   //
-  if (HiiFormPackage != NULL) {
-    FreePool (HiiFormPackage);
-  }
 
   if (PointerProgress != NULL) {
     if (*Request == NULL) {
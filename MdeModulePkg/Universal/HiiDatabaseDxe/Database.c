@@ -1126,6 +1126,7 @@ InsertFormPackage (
 
   InsertTailList (&PackageList->FormPkgHdr, &FormPackage->IfrEntry);
   *Package = FormPackage;
+  InvalidateFormPackageCache ();
 
   //
   // Update FormPackage with the default setting
@@ -1271,6 +1272,7 @@ RemoveFormPackages (
     PackageList->PackageListHdr.PackageLength -= Package->FormPkgHdr.Length;
     FreePool (Package->IfrData);
     FreePool (Package);
+    InvalidateFormPackageCache ();
     //
     // If Hii runtime support feature is enabled,
     // will export Hii info for runtime use after ReadyToBoot event triggered.
@@ -1500,6 +1502,7 @@ AdjustStringPackage (
       StringPackage->StringPkgHdr->Header.Length += Skip2BlockSize;
       PackageList->PackageListHdr.PackageLength += Skip2BlockSize;
       StringPackage->MaxStringId = MaxStringId;
+      InvalidateStringIndex (StringPackage);
     }
   }
 
@@ -1636,6 +1639,7 @@ RemoveStringPackages (
 
     RemoveEntryList (&Package->StringEntry);
     PackageList->PackageListHdr.PackageLength -= Package->StringPkgHdr->Header.Length;
+    InvalidateStringIndex (Package);
     FreePool (Package->StringBlock);
     FreePool (Package->StringPkgHdr);
     //
@@ -1970,6 +1974,9 @@ RemoveFontPackages (
     for (Link = Private->FontInfoList.ForwardLink; Link != &Private->FontInfoList; Link = Link->ForwardLink) {
       GlobalFont = CR (Link, HII_GLOBAL_FONT_INFO, Entry, HII_GLOBAL_FONT_INFO_SIGNATURE);
       if (GlobalFont->FontPackage == Package) {
+        if (Private->LastMatchedFont == GlobalFont) {
+          Private->LastMatchedFont = NULL;
+        }
         RemoveEntryList (&GlobalFont->Entry);
         FreePool (GlobalFont->FontInfo);
         FreePool (GlobalFont);
@@ -1191,6 +1191,20 @@ IsFontInfoExisted (
   //
   if (FontHandle == NULL) {
     Link = Private->FontInfoList.ForwardLink;
+    //
+    // Strings are mostly rendered with the same font, so try the font found
+    // by the last exact match first. RemoveFontPackages() clears it when the
+    // font is removed, and a font matching exactly can't have an earlier
+    // duplicate in the list.
+    //
+    GlobalFont = Private->LastMatchedFont;
+    if (FontInfoMask == NULL && GlobalFont != NULL &&
+        CompareMem (GlobalFont->FontInfo, FontInfo, GlobalFont->FontInfoSize) == 0) {
+      if (GlobalFontInfo != NULL) {
+        *GlobalFontInfo = GlobalFont;
+      }
+      return TRUE;
+    }
   } else {
     Link = (LIST_ENTRY     *) FontHandle;
   }
@@ -1202,6 +1216,9 @@ IsFontInfoExisted (
         if (GlobalFontInfo != NULL) {
           *GlobalFontInfo = GlobalFont;
         }
+        if (FontHandle == NULL) {
+          Private->LastMatchedFont = GlobalFont;
+        }
         return TRUE;
       }
     } else {
@@ -151,6 +151,14 @@ typedef struct {
 //
 // String Package definitions
 //
+// Location of the text of a string id, relative to the string blocks of its
+// string package. TextOffset is 0 if the location of the string is unknown.
+//
+typedef struct {
+  UINT32                                BlockOffset;
+  UINT32                                TextOffset;
+} HII_STRING_INDEX_ENTRY;
+
 #define HII_STRING_PACKAGE_SIGNATURE    SIGNATURE_32 ('h','i','s','p')
 typedef struct _HII_STRING_PACKAGE_INSTANCE {
   UINTN                                 Signature;
@@ -160,6 +168,8 @@ typedef struct _HII_STRING_PACKAGE_INSTANCE {
   LIST_ENTRY                            FontInfoList;  // local font info list
   UINT8                                 FontId;
   EFI_STRING_ID                         MaxStringId;   // record StringId
+  HII_STRING_INDEX_ENTRY                *StringIndex;  // lazily built, indexed by StringId
+  UINTN                                 StringIndexCount;
 } HII_STRING_PACKAGE_INSTANCE;
 
 //
@@ -321,6 +331,7 @@ typedef struct _HII_DATABASE_PRIVATE_DATA {
   UINTN                                 Attribute;     // default system color
   EFI_GUID                              CurrentLayoutGuid;
   EFI_HII_KEYBOARD_LAYOUT               *CurrentLayout;
+  HII_GLOBAL_FONT_INFO                  *LastMatchedFont; // last exact match of IsFontInfoExisted
 } HII_DATABASE_PRIVATE_DATA;
 
 #define HII_FONT_DATABASE_PRIVATE_DATA_FROM_THIS(a) \
@@ -540,6 +551,19 @@ FindStringBlock (
   );
 
 
+/**
+  Free the StringId lookup table of a string package. It must be called
+  whenever the string blocks or the MaxStringId of the package change.
+
+  @param  StringPackage           Hii string package instance.
+
+**/
+VOID
+InvalidateStringIndex (
+  IN HII_STRING_PACKAGE_INSTANCE     *StringPackage
+  );
+
+
 /**
   Parse all glyph blocks to find a glyph block specified by CharValue.
   If CharValue = (CHAR16) (-1), collect all default character cell information
@@ -570,6 +594,18 @@ FindGlyphBlock (
   OUT UINTN                          *GlyphBufferLen OPTIONAL
   );
 
+/**
+  Drop the cached form packages returned by GetFormPackageData.
+
+  It must be called whenever a form package is added to or removed from any
+  package list.
+
+**/
+VOID
+InvalidateFormPackageCache (
+  VOID
+  );
+
 /**
   This function exports Form packages to a buffer.
   This is a internal function.
@@ -95,6 +95,7 @@ HII_DATABASE_PRIVATE_DATA mPrivate = {
     0x0000,
     {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}
   },
+  NULL,
   NULL
 };
 
@@ -227,6 +227,186 @@ GetStringFontInfo (
 }
 
 
+/**
+  Free the StringId lookup table of a string package. It must be called
+  whenever the string blocks or the MaxStringId of the package change.
+
+  @param  StringPackage           Hii string package instance.
+
+**/
+VOID
+InvalidateStringIndex (
+  IN HII_STRING_PACKAGE_INSTANCE     *StringPackage
+  )
+{
+  if (StringPackage->StringIndex != NULL) {
+    FreePool (StringPackage->StringIndex);
+    StringPackage->StringIndex = NULL;
+  }
+  StringPackage->StringIndexCount = 0;
+}
+
+
+/**
+  Parse all string blocks once to build the StringId lookup table of a string
+  package, so FindStringBlock does not need to parse the string blocks from
+  the beginning for every string.
+
+  Only the string ids whose text lives in a string block are recorded. The
+  skipped ids, and the duplicate ids referring to a later id, are left out
+  and still found by parsing the string blocks.
+
+  This is a internal function.
+
+  @param  StringPackage           Hii string package instance.
+
+  @retval EFI_SUCCESS             The lookup table is built.
+  @retval EFI_OUT_OF_RESOURCES    The system is out of resources to accomplish the
+                                  task.
+
+**/
+EFI_STATUS
+BuildStringIndex (
+  IN HII_STRING_PACKAGE_INSTANCE     *StringPackage
+  )
+{
+  HII_STRING_INDEX_ENTRY               *StringIndex;
+  UINTN                                StringIndexCount;
+  UINT8                                *BlockHdr;
+  UINT8                                *StringTextPtr;
+  UINTN                                CurrentStringId;
+  UINTN                                Index;
+  UINT16                               StringCount;
+  UINT16                               SkipCount;
+  BOOLEAN                              IsAscii;
+  UINTN                                StringSize;
+  EFI_STRING_ID                        DuplicateId;
+  UINT8                                Length8;
+  UINT32                               Length32;
+  EFI_HII_SIBT_EXT2_BLOCK              Ext2;
+
+  ASSERT (StringPackage->StringIndex == NULL);
+
+  StringIndexCount = (UINTN) StringPackage->MaxStringId + 1;
+  StringIndex      = (HII_STRING_INDEX_ENTRY *) AllocateZeroPool (StringIndexCount * sizeof (HII_STRING_INDEX_ENTRY));
+  if (StringIndex == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CurrentStringId = 1;
+  BlockHdr        = StringPackage->StringBlock;
+  while (*BlockHdr != EFI_HII_SIBT_END) {
+    StringCount   = 1;
+    IsAscii       = FALSE;
+    StringTextPtr = NULL;
+
+    switch (*BlockHdr) {
+    case EFI_HII_SIBT_STRING_SCSU:
+      IsAscii       = TRUE;
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_STRING_BLOCK);
+      break;
+
+    case EFI_HII_SIBT_STRING_SCSU_FONT:
+      IsAscii       = TRUE;
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRING_SCSU_FONT_BLOCK) - sizeof (UINT8);
+      break;
+
+    case EFI_HII_SIBT_STRINGS_SCSU:
+      IsAscii       = TRUE;
+      CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_SCSU_BLOCK) - sizeof (UINT8);
+      break;
+
+    case EFI_HII_SIBT_STRINGS_SCSU_FONT:
+      IsAscii       = TRUE;
+      CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT16));
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_SCSU_FONT_BLOCK) - sizeof (UINT8);
+      break;
+
+    case EFI_HII_SIBT_STRING_UCS2:
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_STRING_BLOCK);
+      break;
+
+    case EFI_HII_SIBT_STRING_UCS2_FONT:
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRING_UCS2_FONT_BLOCK) - sizeof (CHAR16);
+      break;
+
+    case EFI_HII_SIBT_STRINGS_UCS2:
+      CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_UCS2_BLOCK) - sizeof (CHAR16);
+      break;
+
+    case EFI_HII_SIBT_STRINGS_UCS2_FONT:
+      CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT16));
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_UCS2_FONT_BLOCK) - sizeof (CHAR16);
+      break;
+
+    case EFI_HII_SIBT_DUPLICATE:
+      CopyMem (&DuplicateId, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (EFI_STRING_ID));
+      if (DuplicateId < CurrentStringId && CurrentStringId < StringIndexCount) {
+        CopyMem (&StringIndex[CurrentStringId], &StringIndex[DuplicateId], sizeof (HII_STRING_INDEX_ENTRY));
+      }
+      CurrentStringId++;
+      BlockHdr += sizeof (EFI_HII_SIBT_DUPLICATE_BLOCK);
+      continue;
+
+    case EFI_HII_SIBT_SKIP1:
+      CurrentStringId += *(BlockHdr + sizeof (EFI_HII_STRING_BLOCK));
+      BlockHdr        += sizeof (EFI_HII_SIBT_SKIP1_BLOCK);
+      continue;
+
+    case EFI_HII_SIBT_SKIP2:
+      CopyMem (&SkipCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+      CurrentStringId += SkipCount;
+      BlockHdr        += sizeof (EFI_HII_SIBT_SKIP2_BLOCK);
+      continue;
+
+    case EFI_HII_SIBT_EXT1:
+      CopyMem (&Length8, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT8));
+      BlockHdr += Length8;
+      continue;
+
+    case EFI_HII_SIBT_EXT2:
+      CopyMem (&Ext2, BlockHdr, sizeof (EFI_HII_SIBT_EXT2_BLOCK));
+      BlockHdr += Ext2.Length;
+      continue;
+
+    case EFI_HII_SIBT_EXT4:
+      CopyMem (&Length32, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT32));
+      BlockHdr += Length32;
+      continue;
+
+    default:
+      //
+      // Unknown block, the ids after it are found by parsing the string blocks.
+      //
+      goto Done;
+    }
+
+    for (Index = 0; Index < StringCount; Index++) {
+      if (IsAscii) {
+        StringSize = AsciiStrSize ((CHAR8 *) StringTextPtr);
+      } else {
+        GetUnicodeStringTextOrSize (NULL, StringTextPtr, &StringSize);
+      }
+      if (CurrentStringId < StringIndexCount) {
+        StringIndex[CurrentStringId].BlockOffset = (UINT32) (BlockHdr - StringPackage->StringBlock);
+        StringIndex[CurrentStringId].TextOffset  = (UINT32) (StringTextPtr - BlockHdr);
+      }
+      StringTextPtr += StringSize;
+      CurrentStringId++;
+    }
+    BlockHdr = StringTextPtr;
+  }
+
+Done:
+  StringPackage->StringIndex      = StringIndex;
+  StringPackage->StringIndexCount = StringIndexCount;
+  return EFI_SUCCESS;
+}
+
+
+
 /**
   Parse all string blocks to find a String block specified by StringId.
   If StringId = (EFI_STRING_ID) (-1), find out all EFI_HII_SIBT_FONT blocks
@@ -297,6 +477,21 @@ FindStringBlock (
     if (StringId > StringPackage->MaxStringId) {
       return EFI_NOT_FOUND;
     }
+
+    //
+    // Look the string up in the StringId lookup table first. It's built on
+    // the first lookup, and the string blocks are parsed if it can't be built.
+    //
+    if (StringPackage->StringIndex == NULL) {
+      BuildStringIndex (StringPackage);
+    }
+    if (StringId < StringPackage->StringIndexCount &&
+        StringPackage->StringIndex[StringId].TextOffset != 0) {
+      *StringBlockAddr  = StringPackage->StringBlock + StringPackage->StringIndex[StringId].BlockOffset;
+      *BlockType        = **StringBlockAddr;
+      *StringTextOffset = StringPackage->StringIndex[StringId].TextOffset;
+      return EFI_SUCCESS;
+    }
   } else {
     ASSERT (Private != NULL && Private->Signature == HII_DATABASE_PRIVATE_DATA_SIGNATURE);
     if (StringId == 0 && LastStringId != NULL) {
@@ -911,6 +1106,11 @@ SetStringWorker (
              NULL,
              &StartStringId
              );
+  //
+  // The string blocks are going to be updated.
+  //
+  InvalidateStringIndex (StringPackage);
+
   if (EFI_ERROR (Status) && (BlockType == EFI_HII_SIBT_SKIP1 || BlockType == EFI_HII_SIBT_SKIP2)) {
     Status = InsertLackStringBlock(StringPackage,
                           StartStringId,
@@ -1553,6 +1753,7 @@ Done:
       ) {
         StringPackage = CR (Link, HII_STRING_PACKAGE_INSTANCE, StringEntry, HII_STRING_PACKAGE_SIGNATURE);
         StringPackage->MaxStringId = *StringId;
+        InvalidateStringIndex (StringPackage);
     }
   } else if (NewStringPackageCreated) {
     //
@@ -0,0 +1,920 @@
+/** @file
+  Host-based unit tests and benchmarks for HiiDatabaseDxe.
+
+  The driver sources are built into the test, and the HII database is set up
+  the way InitializeHiiDatabase() does it, without installing the protocols.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "HiiDatabase.h"
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "HiiDatabaseDxe Unit Test"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define CONFIG_ELEMENT_COUNT        2000
+#define FORM_PACKAGE_LOOKUP_COUNT   10000
+#define STRING_ID_COUNT             2000
+#define TEST_STRING_LENGTH          32
+
+///=== CODE UNDER TEST ===========================================================================
+
+extern HII_DATABASE_PRIVATE_DATA  mPrivate;
+extern UINT8                      *mCachedFormPackage;
+
+EFI_STATUS
+AppendToMultiString (
+  IN OUT EFI_STRING                *MultiString,
+  IN EFI_STRING                    AppendString
+  );
+
+EFI_STATUS
+GetFormPackageData (
+  IN     HII_DATABASE_RECORD        *DataBaseRecord,
+  IN OUT UINT8                      **HiiFormPackage,
+  OUT    UINTN                      *PackageSize
+  );
+
+///=== DRIVER DEPENDENCIES =======================================================================
+
+/**
+  No handle in the test has a device path.
+
+  @param[in]  UserHandle  The handle being queried.
+  @param[in]  Protocol    The published unique identifier of the protocol.
+  @param[out] Interface   Supplies the address where a pointer to the
+                          corresponding Protocol Interface is returned.
+
+  @retval EFI_UNSUPPORTED  The handle does not support the protocol.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockHandleProtocol (
+  IN  EFI_HANDLE               UserHandle,
+  IN  EFI_GUID                 *Protocol,
+  OUT VOID                     **Interface
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+STATIC EFI_BOOT_SERVICES  mMockBootServices;
+EFI_BOOT_SERVICES         *gBS = &mMockBootServices;
+EFI_RUNTIME_SERVICES      *gRT;
+
+VOID
+EFIAPI
+EfiAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+}
+
+VOID
+EFIAPI
+EfiReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+}
+
+EFI_STATUS
+EFIAPI
+EfiCreateEventReadyToBootEx (
+  IN  EFI_TPL           NotifyTpl,
+  IN  EFI_EVENT_NOTIFY  NotifyFunction,  OPTIONAL
+  IN  VOID              *NotifyContext,  OPTIONAL
+  OUT EFI_EVENT         *ReadyToBootEvent
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+EFI_STATUS
+EFIAPI
+GetEfiGlobalVariable2 (
+  IN CONST CHAR16    *Name,
+  OUT VOID           **Value,
+  OUT UINTN          *Size OPTIONAL
+  )
+{
+  *Value = NULL;
+  if (Size != NULL) {
+    *Size = 0;
+  }
+  return EFI_NOT_FOUND;
+}
+
+CHAR8 *
+EFIAPI
+GetBestLanguage (
+  IN CONST CHAR8  *SupportedLanguages,
+  IN UINTN        Iso639Language,
+  ...
+  )
+{
+  return NULL;
+}
+
+//
+// PcdNvStoreDefaultValueBuffer is DynamicEx, which BasePcdLibNull does not
+// support. The test platform has no default value store.
+//
+UINTN
+EFIAPI
+LibPcdGetSku (
+  VOID
+  )
+{
+  return 0;
+}
+
+VOID *
+EFIAPI
+LibPcdGetExPtr (
+  IN CONST GUID        *Guid,
+  IN UINTN             TokenNumber
+  )
+{
+  return NULL;
+}
+
+UINTN
+EFIAPI
+LibPcdGetExSize (
+  IN CONST GUID        *Guid,
+  IN UINTN             TokenNumber
+  )
+{
+  return 0;
+}
+
+EFI_DEVICE_PATH_PROTOCOL *
+EFIAPI
+DevicePathFromHandle (
+  IN EFI_HANDLE                      Handle
+  )
+{
+  return NULL;
+}
+
+UINTN
+EFIAPI
+DevicePathNodeLength (
+  IN CONST VOID  *Node
+  )
+{
+  return ReadUnaligned16 ((UINT16 *) &((EFI_DEVICE_PATH_PROTOCOL *) Node)->Length[0]);
+}
+
+EFI_DEVICE_PATH_PROTOCOL *
+EFIAPI
+NextDevicePathNode (
+  IN CONST VOID  *Node
+  )
+{
+  return (EFI_DEVICE_PATH_PROTOCOL *) ((UINT8 *) Node + DevicePathNodeLength (Node));
+}
+
+BOOLEAN
+EFIAPI
+IsDevicePathEnd (
+  IN CONST VOID  *Node
+  )
+{
+  return (BOOLEAN) (((EFI_DEVICE_PATH_PROTOCOL *) Node)->Type == END_DEVICE_PATH_TYPE &&
+                    ((EFI_DEVICE_PATH_PROTOCOL *) Node)->SubType == END_ENTIRE_DEVICE_PATH_SUBTYPE);
+}
+
+UINTN
+EFIAPI
+GetDevicePathSize (
+  IN CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath
+  )
+{
+  CONST EFI_DEVICE_PATH_PROTOCOL  *Start;
+
+  if (DevicePath == NULL) {
+    return 0;
+  }
+
+  Start = DevicePath;
+  while (!IsDevicePathEnd (DevicePath)) {
+    DevicePath = NextDevicePathNode (DevicePath);
+  }
+
+  return ((UINTN) DevicePath - (UINTN) Start) + DevicePathNodeLength (DevicePath);
+}
+
+///=== TEST DATA ==================================================================================
+
+#pragma pack(1)
+typedef struct {
+  EFI_HII_PACKAGE_HEADER  Header;
+  EFI_IFR_FORM_SET        FormSet;
+  EFI_GUID                ClassGuid;
+  EFI_IFR_END             End;
+} TEST_FORM_PACKAGE;
+
+typedef struct {
+  EFI_HII_PACKAGE_LIST_HEADER  Header;
+  TEST_FORM_PACKAGE            Form;
+  EFI_HII_PACKAGE_HEADER       End;
+} TEST_FORM_PACKAGE_LIST;
+#pragma pack()
+
+STATIC EFI_GUID  mTestPackageListGuid = {
+  0x9a7c1e3d, 0x52b8, 0x4f06, { 0x8d, 0x1a, 0x6e, 0x4b, 0x2f, 0x90, 0xc3, 0x57 }
+};
+
+STATIC EFI_GUID  mTestFormSetGuid = {
+  0x3f0e8a64, 0x1d27, 0x4c9b, { 0xa5, 0x6e, 0x0b, 0x73, 0xd8, 0x41, 0x2c, 0xe9 }
+};
+
+/**
+  Fill in a package list holding a single form package with an empty form set.
+
+  @param[out] PackageList   The package list.
+  @param[in]  TitleId       The string id of the form set title, to tell the
+                            form packages apart.
+
+**/
+STATIC
+VOID
+InitFormPackageList (
+  OUT TEST_FORM_PACKAGE_LIST  *PackageList,
+  IN  EFI_STRING_ID           TitleId
+  )
+{
+  ZeroMem (PackageList, sizeof (*PackageList));
+  CopyGuid (&PackageList->Header.PackageListGuid, &mTestPackageListGuid);
+  PackageList->Header.PackageLength = sizeof (*PackageList);
+
+  PackageList->Form.Header.Length                = sizeof (TEST_FORM_PACKAGE);
+  PackageList->Form.Header.Type                  = EFI_HII_PACKAGE_FORMS;
+  PackageList->Form.FormSet.Header.OpCode        = EFI_IFR_FORM_SET_OP;
+  PackageList->Form.FormSet.Header.Length        = sizeof (EFI_IFR_FORM_SET) + sizeof (EFI_GUID);
+  PackageList->Form.FormSet.Header.Scope         = 1;
+  CopyGuid (&PackageList->Form.FormSet.Guid, &mTestFormSetGuid);
+  PackageList->Form.FormSet.FormSetTitle         = TitleId;
+  PackageList->Form.FormSet.Flags                = 1;
+  CopyGuid (&PackageList->Form.ClassGuid, &gEfiHiiPlatformSetupFormsetGuid);
+  PackageList->Form.End.Header.OpCode            = EFI_IFR_END_OP;
+  PackageList->Form.End.Header.Length            = sizeof (EFI_IFR_END);
+
+  PackageList->End.Length = sizeof (EFI_HII_PACKAGE_HEADER);
+  PackageList->End.Type   = EFI_HII_PACKAGE_END;
+}
+
+/**
+  Find the database record of an HII handle.
+
+  @param[in] Handle     The HII handle.
+
+  @return The database record, or NULL if the handle is not in the database.
+
+**/
+STATIC
+HII_DATABASE_RECORD *
+FindDatabaseRecord (
+  IN EFI_HII_HANDLE  Handle
+  )
+{
+  LIST_ENTRY           *Link;
+  HII_DATABASE_RECORD  *Record;
+
+  for (Link = mPrivate.DatabaseList.ForwardLink; Link != &mPrivate.DatabaseList; Link = Link->ForwardLink) {
+    Record = CR (Link, HII_DATABASE_RECORD, DatabaseEntry, HII_DATABASE_RECORD_SIGNATURE);
+    if (Record->Handle == Handle) {
+      return Record;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Build a package list holding one "en-US" string package with StringCount
+  string ids. The ids are stored in SIBT_STRING_UCS2 blocks, with a
+  SIBT_STRINGS_UCS2 block every 100 ids, a SIBT_SKIP1 block every 250 ids and
+  a SIBT_DUPLICATE block every 333 ids, so the lookup table has to handle
+  every kind of block the parser handles.
+
+  @param[in]  StringCount   The number of string ids.
+  @param[out] Expected      Array of StringCount + 1 strings receiving the text
+                            of each id, empty for the skipped ids.
+
+  @return The package list, to be freed by the caller.
+
+**/
+STATIC
+EFI_HII_PACKAGE_LIST_HEADER *
+CreateStringPackageList (
+  IN  UINTN   StringCount,
+  OUT CHAR16  (*Expected)[TEST_STRING_LENGTH]
+  )
+{
+  EFI_HII_PACKAGE_LIST_HEADER  *PackageList;
+  EFI_HII_STRING_PACKAGE_HDR   *StringPackage;
+  EFI_HII_PACKAGE_HEADER       *EndPackage;
+  UINT8                        *Block;
+  UINTN                        HdrSize;
+  UINTN                        StringId;
+  UINT16                       Count;
+  UINT16                       Index;
+
+  HdrSize     = sizeof (EFI_HII_STRING_PACKAGE_HDR) - 1 + sizeof ("en-US");
+  PackageList = AllocateZeroPool (sizeof (EFI_HII_PACKAGE_LIST_HEADER) + HdrSize + (StringCount + 1) * sizeof (Expected[0]) * 2);
+  if (PackageList == NULL) {
+    return NULL;
+  }
+  CopyGuid (&PackageList->PackageListGuid, &mTestPackageListGuid);
+
+  StringPackage                   = (EFI_HII_STRING_PACKAGE_HDR *) (PackageList + 1);
+  StringPackage->Header.Type      = EFI_HII_PACKAGE_STRINGS;
+  StringPackage->HdrSize          = (UINT32) HdrSize;
+  StringPackage->StringInfoOffset = (UINT32) HdrSize;
+  StringPackage->LanguageName     = 1;
+  CopyMem (StringPackage->Language, "en-US", sizeof ("en-US"));
+
+  ZeroMem (Expected, (StringCount + 1) * sizeof (Expected[0]));
+  Block    = (UINT8 *) StringPackage + HdrSize;
+  StringId = 1;
+  while (StringId <= StringCount) {
+    if (StringId % 250 == 0 && StringId + 2 <= StringCount) {
+      *Block++  = EFI_HII_SIBT_SKIP1;
+      *Block++  = 2;
+      StringId += 2;
+      continue;
+    }
+
+    if (StringId % 333 == 0) {
+      *Block++ = EFI_HII_SIBT_DUPLICATE;
+      WriteUnaligned16 ((UINT16 *) Block, (UINT16) (StringId - 5));
+      Block += sizeof (UINT16);
+      StrCpyS (Expected[StringId], TEST_STRING_LENGTH, Expected[StringId - 5]);
+      StringId++;
+      continue;
+    }
+
+    Count = 1;
+    if (StringId % 100 == 0) {
+      Count    = (UINT16) MIN (3, StringCount - StringId + 1);
+      *Block++ = EFI_HII_SIBT_STRINGS_UCS2;
+      WriteUnaligned16 ((UINT16 *) Block, Count);
+      Block += sizeof (UINT16);
+    } else {
+      *Block++ = EFI_HII_SIBT_STRING_UCS2;
+    }
+    for (Index = 0; Index < Count; Index++, StringId++) {
+      if (StringId == 1) {
+        StrCpyS (Expected[StringId], TEST_STRING_LENGTH, L"English");
+      } else {
+        UnicodeSPrint (Expected[StringId], sizeof (Expected[0]), L"String %04d", StringId);
+      }
+      CopyMem (Block, Expected[StringId], StrSize (Expected[StringId]));
+      Block += StrSize (Expected[StringId]);
+    }
+  }
+  *Block++ = EFI_HII_SIBT_END;
+
+  StringPackage->Header.Length = (UINT32) (Block - (UINT8 *) StringPackage);
+  EndPackage                   = (EFI_HII_PACKAGE_HEADER *) Block;
+  EndPackage->Length           = sizeof (EFI_HII_PACKAGE_HEADER);
+  EndPackage->Type             = EFI_HII_PACKAGE_END;
+  PackageList->PackageLength   = (UINT32) ((UINT8 *) (EndPackage + 1) - (UINT8 *) PackageList);
+
+  return PackageList;
+}
+
+/**
+  Find the string package instance of an HII handle.
+
+  @param[in] Handle     The HII handle.
+
+  @return The first string package of the package list, or NULL.
+
+**/
+STATIC
+HII_STRING_PACKAGE_INSTANCE *
+FindStringPackage (
+  IN EFI_HII_HANDLE  Handle
+  )
+{
+  HII_DATABASE_RECORD  *Record;
+  LIST_ENTRY           *Link;
+
+  Record = FindDatabaseRecord (Handle);
+  if (Record == NULL) {
+    return NULL;
+  }
+
+  Link = Record->PackageList->StringPkgHdr.ForwardLink;
+  if (Link == &Record->PackageList->StringPkgHdr) {
+    return NULL;
+  }
+
+  return CR (Link, HII_STRING_PACKAGE_INSTANCE, StringEntry, HII_STRING_PACKAGE_SIGNATURE);
+}
+
+/**
+  Look up every string id with the StringId lookup table and by parsing the
+  string blocks, and check both against the expected text.
+
+  @param[in] Handle         The HII handle of the string package.
+  @param[in] StringCount    The number of string ids.
+  @param[in] Expected       The expected text of each id, empty for skipped ids.
+
+  @retval UNIT_TEST_PASSED              All ids matched.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   A lookup returned something else.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+VerifyAllStrings (
+  IN EFI_HII_HANDLE  Handle,
+  IN UINTN           StringCount,
+  IN CHAR16          (*Expected)[TEST_STRING_LENGTH]
+  )
+{
+  HII_STRING_PACKAGE_INSTANCE  *StringPackage;
+  EFI_STATUS                   Status;
+  EFI_STATUS                   ParsedStatus;
+  CHAR16                       String[TEST_STRING_LENGTH];
+  CHAR16                       ParsedString[TEST_STRING_LENGTH];
+  UINTN                        StringSize;
+  UINTN                        ParsedStringSize;
+  UINTN                        StringIndexCount;
+  UINTN                        StringId;
+
+  StringPackage = FindStringPackage (Handle);
+  UT_ASSERT_NOT_NULL (StringPackage);
+
+  for (StringId = 1; StringId <= StringCount; StringId++) {
+    StringSize = sizeof (String);
+    ZeroMem (String, sizeof (String));
+    Status = mPrivate.HiiString.GetString (&mPrivate.HiiString, "en-US", Handle, (EFI_STRING_ID) StringId, String, &StringSize, NULL);
+    UT_ASSERT_NOT_NULL (StringPackage->StringIndex);
+
+    //
+    // An empty lookup table sends FindStringBlock to the parser.
+    //
+    StringIndexCount                = StringPackage->StringIndexCount;
+    StringPackage->StringIndexCount = 0;
+    ParsedStringSize                = sizeof (ParsedString);
+    ZeroMem (ParsedString, sizeof (ParsedString));
+    ParsedStatus = mPrivate.HiiString.GetString (&mPrivate.HiiString, "en-US", Handle, (EFI_STRING_ID) StringId, ParsedString, &ParsedStringSize, NULL);
+    StringPackage->StringIndexCount = StringIndexCount;
+
+    UT_ASSERT_STATUS_EQUAL (Status, ParsedStatus);
+    if (Expected[StringId][0] == L'\0') {
+      UT_ASSERT_TRUE (EFI_ERROR (Status));
+      continue;
+    }
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_EQUAL (StringSize, StrSize (Expected[StringId]));
+    UT_ASSERT_MEM_EQUAL (String, Expected[StringId], StringSize);
+    UT_ASSERT_EQUAL (ParsedStringSize, StringSize);
+    UT_ASSERT_MEM_EQUAL (ParsedString, String, StringSize);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Set up the HII database the way InitializeHiiDatabase() does.
+
+**/
+STATIC
+VOID
+EFIAPI
+InitializeTestHiiDatabase (
+  VOID
+  )
+{
+  mMockBootServices.HandleProtocol = MockHandleProtocol;
+
+  InitializeListHead (&mPrivate.DatabaseList);
+  InitializeListHead (&mPrivate.DatabaseNotifyList);
+  InitializeListHead (&mPrivate.HiiHandleList);
+  InitializeListHead (&mPrivate.FontInfoList);
+}
+
+/**
+  Append to a multi-string the way AppendToMultiString() did before the
+  buffer grew geometrically: reallocate to the exact size and StrCatS.
+
+  @param[in, out] MultiString   The multi-string.
+  @param[in]      AppendString  NULL-terminated Unicode string.
+
+**/
+STATIC
+VOID
+AppendToMultiStringExactSize (
+  IN OUT EFI_STRING  *MultiString,
+  IN     EFI_STRING  AppendString
+  )
+{
+  UINTN  AppendStringSize;
+  UINTN  MultiStringSize;
+  UINTN  MaxLen;
+
+  AppendStringSize = StrSize (AppendString);
+  MultiStringSize  = StrSize (*MultiString);
+  MaxLen           = MAX_STRING_LENGTH / sizeof (CHAR16);
+
+  if (MultiStringSize + AppendStringSize > MAX_STRING_LENGTH ||
+      MultiStringSize > MAX_STRING_LENGTH) {
+    *MultiString = (EFI_STRING) ReallocatePool (
+                                  MultiStringSize,
+                                  MultiStringSize + AppendStringSize,
+                                  (VOID *) (*MultiString)
+                                  );
+    MaxLen = (MultiStringSize + AppendStringSize) / sizeof (CHAR16);
+  }
+  StrCatS (*MultiString, MaxLen, AppendString);
+}
+
+/**
+  Write the <ConfigBody> element of a numeric question at the given offset.
+
+  @param[out] Element   Buffer of 64 CHAR16.
+  @param[in]  Offset    The offset of the question in the varstore.
+
+**/
+STATIC
+VOID
+FormatConfigElement (
+  OUT CHAR16  *Element,
+  IN  UINTN   Offset
+  )
+{
+  UnicodeSPrint (Element, 64 * sizeof (CHAR16), L"&OFFSET=%04x&WIDTH=0004&VALUE=%08x", Offset, Offset * 7);
+}
+
+///=== TEST CASES =================================================================================
+
+/**
+  AppendToMultiString() must produce the plain concatenation while the buffer
+  grows past MAX_STRING_LENGTH many times, and be faster than growing the
+  buffer by exact size.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+AppendToMultiStringShouldConcatenate (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS        Status;
+  EFI_STRING        MultiString;
+  EFI_STRING        Reference;
+  CHAR16            Element[64];
+  UINTN             Index;
+  clock_t           Start;
+  clock_t           GeometricTicks;
+  clock_t           ExactTicks;
+  UNIT_TEST_STATUS  TestStatus;
+
+  MultiString = AllocateZeroPool (MAX_STRING_LENGTH);
+  Reference   = AllocateZeroPool (MAX_STRING_LENGTH);
+  UT_ASSERT_NOT_NULL (MultiString);
+  UT_ASSERT_NOT_NULL (Reference);
+  StrCpyS (MultiString, MAX_STRING_LENGTH / sizeof (CHAR16), L"GUID=0123&NAME=0041&PATH=00");
+  StrCpyS (Reference, MAX_STRING_LENGTH / sizeof (CHAR16), L"GUID=0123&NAME=0041&PATH=00");
+
+  Status = EFI_SUCCESS;
+  Start  = clock ();
+  for (Index = 0; Index < CONFIG_ELEMENT_COUNT && !EFI_ERROR (Status); Index++) {
+    FormatConfigElement (Element, Index);
+    Status = AppendToMultiString (&MultiString, Element);
+  }
+  GeometricTicks = clock () - Start;
+
+  Start = clock ();
+  for (Index = 0; Index < CONFIG_ELEMENT_COUNT; Index++) {
+    FormatConfigElement (Element, Index);
+    AppendToMultiStringExactSize (&Reference, Element);
+  }
+  ExactTicks = clock () - Start;
+
+  UT_LOG_INFO (
+    "%d appends, %d characters: geometric growth %d us, exact size growth %d us\n",
+    CONFIG_ELEMENT_COUNT,
+    (int) StrLen (Reference),
+    (int) ((UINT64) GeometricTicks * 1000000 / CLOCKS_PER_SEC),
+    (int) ((UINT64) ExactTicks * 1000000 / CLOCKS_PER_SEC)
+    );
+
+  TestStatus = UNIT_TEST_PASSED;
+  if (EFI_ERROR (Status) || StrCmp (MultiString, Reference) != 0) {
+    TestStatus = UNIT_TEST_ERROR_TEST_FAILED;
+  }
+  if (MultiString != NULL) {
+    FreePool (MultiString);
+  }
+  FreePool (Reference);
+
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (TestStatus, UNIT_TEST_PASSED);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  GetFormPackageData() returns the cached export until a form package changes,
+  and the cache is dropped when the package list is updated or removed.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FormPackageCacheShouldFollowUpdates (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS              Status;
+  TEST_FORM_PACKAGE_LIST  PackageList;
+  EFI_HII_HANDLE          Handle;
+  HII_DATABASE_RECORD     *Record;
+  UINT8                   *FormPackage;
+  UINT8                   *CachedFormPackage;
+  UINTN                   FormPackageSize;
+  UINTN                   Index;
+  clock_t                 Start;
+  clock_t                 CachedTicks;
+  clock_t                 ExportTicks;
+
+  InitFormPackageList (&PackageList, 1);
+  Status = mPrivate.HiiDatabase.NewPackageList (&mPrivate.HiiDatabase, &PackageList.Header, NULL, &Handle);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  Record = FindDatabaseRecord (Handle);
+  UT_ASSERT_NOT_NULL (Record);
+
+  Status = GetFormPackageData (Record, &FormPackage, &FormPackageSize);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (FormPackageSize, sizeof (TEST_FORM_PACKAGE));
+  UT_ASSERT_MEM_EQUAL (FormPackage, &PackageList.Form, sizeof (TEST_FORM_PACKAGE));
+
+  Status = GetFormPackageData (Record, &CachedFormPackage, &FormPackageSize);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_TRUE (CachedFormPackage == FormPackage);
+
+  //
+  // Replacing the form package must drop the cached export.
+  //
+  InitFormPackageList (&PackageList, 2);
+  Status = mPrivate.HiiDatabase.UpdatePackageList (&mPrivate.HiiDatabase, Handle, &PackageList.Header);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_TRUE (mCachedFormPackage == NULL);
+
+  Status = GetFormPackageData (Record, &FormPackage, &FormPackageSize);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (FormPackageSize, sizeof (TEST_FORM_PACKAGE));
+  UT_ASSERT_MEM_EQUAL (FormPackage, &PackageList.Form, sizeof (TEST_FORM_PACKAGE));
+
+  //
+  // Benchmark the cached lookups against exporting the form packages for
+  // each lookup, which is what every lookup did without the cache.
+  //
+  Start = clock ();
+  for (Index = 0; Index < FORM_PACKAGE_LOOKUP_COUNT; Index++) {
+    GetFormPackageData (Record, &FormPackage, &FormPackageSize);
+  }
+  CachedTicks = clock () - Start;
+
+  Start = clock ();
+  for (Index = 0; Index < FORM_PACKAGE_LOOKUP_COUNT; Index++) {
+    InvalidateFormPackageCache ();
+    GetFormPackageData (Record, &FormPackage, &FormPackageSize);
+  }
+  ExportTicks = clock () - Start;
+
+  UT_LOG_INFO (
+    "%d form package lookups: cached %d us, exported %d us\n",
+    FORM_PACKAGE_LOOKUP_COUNT,
+    (int) ((UINT64) CachedTicks * 1000000 / CLOCKS_PER_SEC),
+    (int) ((UINT64) ExportTicks * 1000000 / CLOCKS_PER_SEC)
+    );
+
+  Status = mPrivate.HiiDatabase.RemovePackageList (&mPrivate.HiiDatabase, Handle);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_TRUE (mCachedFormPackage == NULL);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The StringId lookup table must return what the parser returns for every id,
+  also after HiiSetString() and HiiNewString() changed the string blocks.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StringIndexShouldMatchParser (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS                   Status;
+  EFI_HII_PACKAGE_LIST_HEADER  *PackageList;
+  EFI_HII_HANDLE               Handle;
+  EFI_STRING_ID                StringId;
+  UNIT_TEST_STATUS             TestStatus;
+  STATIC CHAR16                Expected[STRING_ID_COUNT + 2][TEST_STRING_LENGTH];
+
+  PackageList = CreateStringPackageList (STRING_ID_COUNT, Expected);
+  UT_ASSERT_NOT_NULL (PackageList);
+  Status = mPrivate.HiiDatabase.NewPackageList (&mPrivate.HiiDatabase, PackageList, NULL, &Handle);
+  FreePool (PackageList);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  TestStatus = VerifyAllStrings (Handle, STRING_ID_COUNT, Expected);
+  UT_ASSERT_EQUAL (TestStatus, UNIT_TEST_PASSED);
+
+  //
+  // Make a string longer, so the blocks after it move.
+  //
+  Status = mPrivate.HiiString.SetString (&mPrivate.HiiString, Handle, 10, "en-US", L"Longer String 10", NULL);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (FindStringPackage (Handle)->StringIndex, NULL);
+  StrCpyS (Expected[10], TEST_STRING_LENGTH, L"Longer String 10");
+  TestStatus = VerifyAllStrings (Handle, STRING_ID_COUNT, Expected);
+  UT_ASSERT_EQUAL (TestStatus, UNIT_TEST_PASSED);
+
+  Status = mPrivate.HiiString.NewString (&mPrivate.HiiString, Handle, &StringId, "en-US", NULL, L"New String", NULL);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (StringId, STRING_ID_COUNT + 1);
+  StrCpyS (Expected[StringId], TEST_STRING_LENGTH, L"New String");
+  TestStatus = VerifyAllStrings (Handle, StringId, Expected);
+  UT_ASSERT_EQUAL (TestStatus, UNIT_TEST_PASSED);
+  UT_ASSERT_TRUE (FindStringPackage (Handle)->StringIndexCount > StringId);
+
+  Status = mPrivate.HiiDatabase.RemovePackageList (&mPrivate.HiiDatabase, Handle);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Benchmark: time HiiGetString() for every id of a string package with the
+  StringId lookup table and by parsing the string blocks.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BenchmarkStringLookup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS                   Status;
+  EFI_HII_PACKAGE_LIST_HEADER  *PackageList;
+  EFI_HII_HANDLE               Handle;
+  HII_STRING_PACKAGE_INSTANCE  *StringPackage;
+  CHAR16                       String[TEST_STRING_LENGTH];
+  UINTN                        StringSize;
+  UINTN                        StringIndexCount;
+  UINTN                        StringId;
+  clock_t                      Start;
+  clock_t                      IndexTicks;
+  clock_t                      ParseTicks;
+  STATIC CHAR16                Expected[STRING_ID_COUNT + 1][TEST_STRING_LENGTH];
+
+  PackageList = CreateStringPackageList (STRING_ID_COUNT, Expected);
+  UT_ASSERT_NOT_NULL (PackageList);
+  Status = mPrivate.HiiDatabase.NewPackageList (&mPrivate.HiiDatabase, PackageList, NULL, &Handle);
+  FreePool (PackageList);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  StringPackage = FindStringPackage (Handle);
+  UT_ASSERT_NOT_NULL (StringPackage);
+
+  Start = clock ();
+  for (StringId = 1; StringId <= STRING_ID_COUNT; StringId++) {
+    StringSize = sizeof (String);
+    mPrivate.HiiString.GetString (&mPrivate.HiiString, "en-US", Handle, (EFI_STRING_ID) StringId, String, &StringSize, NULL);
+  }
+  IndexTicks = clock () - Start;
+
+  StringIndexCount                = StringPackage->StringIndexCount;
+  StringPackage->StringIndexCount = 0;
+  Start = clock ();
+  for (StringId = 1; StringId <= STRING_ID_COUNT; StringId++) {
+    StringSize = sizeof (String);
+    mPrivate.HiiString.GetString (&mPrivate.HiiString, "en-US", Handle, (EFI_STRING_ID) StringId, String, &StringSize, NULL);
+  }
+  ParseTicks = clock () - Start;
+  StringPackage->StringIndexCount = StringIndexCount;
+
+  UT_LOG_INFO (
+    "HiiGetString for %d string ids: lookup table %d us, parsing %d us\n",
+    STRING_ID_COUNT,
+    (int) ((UINT64) IndexTicks * 1000000 / CLOCKS_PER_SEC),
+    (int) ((UINT64) ParseTicks * 1000000 / CLOCKS_PER_SEC)
+    );
+
+  Status = mPrivate.HiiDatabase.RemovePackageList (&mPrivate.HiiDatabase, Handle);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  return UNIT_TEST_PASSED;
+}
+
+///=== TEST ENGINE ================================================================================
+
+/**
+  Initialize the unit test framework, suite, and unit tests for
+  HiiDatabaseDxe and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ConfigRoutingTests;
+  UNIT_TEST_SUITE_HANDLE      StringTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&ConfigRoutingTests, Framework, "Config Routing Tests", "HiiDatabaseDxe.ConfigRouting", InitializeTestHiiDatabase, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for the config routing tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+  AddTestCase (ConfigRoutingTests, "AppendToMultiString should concatenate", "AppendToMultiString", AppendToMultiStringShouldConcatenate, NULL, NULL, NULL);
+  AddTestCase (ConfigRoutingTests, "Form package cache should follow updates", "FormPackageCache", FormPackageCacheShouldFollowUpdates, NULL, NULL, NULL);
+
+  Status = CreateUnitTestSuite (&StringTests, Framework, "String Tests", "HiiDatabaseDxe.String", InitializeTestHiiDatabase, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for the string tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+  AddTestCase (StringTests, "String id lookup table should match the parser", "StringIndex", StringIndexShouldMatchParser, NULL, NULL, NULL);
+  AddTestCase (StringTests, "Time string lookups", "StringLookupBenchmark", BenchmarkStringLookup, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -28,6 +28,8 @@ BOOLEAN        mDxeExMapTableEmpty;
 BOOLEAN        mPeiDatabaseEmpty;
 
 LIST_ENTRY    *mCallbackFnTable;
+EX_TOKEN_INDEX_ENTRY *mExTokenIndex;
+UINTN          mExTokenIndexMask;
 EFI_GUID     **TmpTokenSpaceBuffer;
 UINTN          TmpTokenSpaceBufferCount;
 
@@ -934,6 +936,8 @@ BuildPcdDxeDataBase (
   for (Index = 0; Index + 1 < mPcdTotalTokenCount + 1; Index++) {
     InitializeListHead (&mCallbackFnTable[Index]);
   }
+
+  BuildExTokenIndex ();
 }
 
 /**
@@ -1547,6 +1551,118 @@ SetHiiVariable (
   return Status;
 }
 
+/**
+  Get the slot of the DynamicEx PCD hash index to start probing from.
+
+  @param Guid            Token space guid for dynamic-ex PCD entry.
+  @param ExTokenNumber   Dynamic-ex PCD token number.
+
+  @return Index of the first slot to probe in mExTokenIndex.
+
+**/
+UINTN
+GetExTokenIndexSlot (
+  IN CONST EFI_GUID             *Guid,
+  IN UINT32                     ExTokenNumber
+  )
+{
+  UINT32              Hash;
+
+  Hash = ReadUnaligned32 ((CONST UINT32 *) Guid) ^ (ExTokenNumber * 0x9E3779B1);
+  Hash ^= Hash >> 16;
+
+  return (UINTN) Hash & mExTokenIndexMask;
+}
+
+/**
+  Insert the entries of one DynamicEx mapping table into the hash index.
+
+  An entry is not inserted if the same {token space guid: token number} pair
+  is already present, so that PEI database entries, inserted first, take
+  precedence the same way as in the search of the mapping tables.
+
+  @param Database        PCD database which contains the mapping table.
+
+**/
+VOID
+InsertExTokenIndex (
+  IN PCD_DATABASE_INIT          *Database
+  )
+{
+  UINT32              Index;
+  UINTN               Slot;
+  DYNAMICEX_MAPPING   *ExMap;
+  EFI_GUID            *GuidTable;
+  CONST EFI_GUID      *Guid;
+
+  ExMap     = (DYNAMICEX_MAPPING *)((UINT8 *)Database + Database->ExMapTableOffset);
+  GuidTable = (EFI_GUID *)((UINT8 *)Database + Database->GuidTableOffset);
+
+  for (Index = 0; Index < Database->ExTokenCount; Index++) {
+    Guid = GuidTable + ExMap[Index].ExGuidIndex;
+    Slot = GetExTokenIndexSlot (Guid, ExMap[Index].ExTokenNumber);
+    while (mExTokenIndex[Slot].Guid != NULL) {
+      if ((mExTokenIndex[Slot].ExTokenNumber == ExMap[Index].ExTokenNumber) &&
+          CompareGuid (mExTokenIndex[Slot].Guid, Guid)) {
+        break;
+      }
+      Slot = (Slot + 1) & mExTokenIndexMask;
+    }
+
+    if (mExTokenIndex[Slot].Guid == NULL) {
+      mExTokenIndex[Slot].Guid          = Guid;
+      mExTokenIndex[Slot].ExTokenNumber = ExMap[Index].ExTokenNumber;
+      mExTokenIndex[Slot].TokenNumber   = ExMap[Index].TokenNumber;
+    }
+  }
+}
+
+/**
+  Build the hash index used by GetExPcdTokenNumber() over the DynamicEx mapping
+  tables of both the PEI and DXE PCD databases.
+
+  If the index can't be allocated, GetExPcdTokenNumber() falls back to search
+  the mapping tables.
+
+**/
+VOID
+BuildExTokenIndex (
+  VOID
+  )
+{
+  UINTN               Count;
+  UINTN               Size;
+
+  Count = mPcdDatabase.DxeDb->ExTokenCount;
+  if (!mPeiDatabaseEmpty) {
+    Count += mPcdDatabase.PeiDb->ExTokenCount;
+  }
+
+  if (Count == 0) {
+    return;
+  }
+
+  //
+  // Keep the load factor at or below one half so that probe sequences
+  // stay short.
+  //
+  Size = GetPowerOfTwo64 (Count) << 1;
+  if (Size < Count * 2) {
+    Size <<= 1;
+  }
+
+  mExTokenIndex = AllocateZeroPool (Size * sizeof (EX_TOKEN_INDEX_ENTRY));
+  if (mExTokenIndex == NULL) {
+    return;
+  }
+  mExTokenIndexMask = Size - 1;
+
+  if (!mPeiDatabaseEmpty) {
+    InsertExTokenIndex (mPcdDatabase.PeiDb);
+  }
+  InsertExTokenIndex (mPcdDatabase.DxeDb);
+}
+
 /**
   Get Token Number according to dynamic-ex PCD's {token space guid:token number}
 
@@ -1571,6 +1687,23 @@ GetExPcdTokenNumber (
   EFI_GUID            *GuidTable;
   EFI_GUID            *MatchGuid;
   UINTN               MatchGuidIdx;
+  UINTN               Slot;
+
+  if (mExTokenIndex != NULL) {
+    Slot = GetExTokenIndexSlot (Guid, ExTokenNumber);
+    while (mExTokenIndex[Slot].Guid != NULL) {
+      if ((mExTokenIndex[Slot].ExTokenNumber == ExTokenNumber) &&
+          CompareGuid (mExTokenIndex[Slot].Guid, Guid)) {
+        return mExTokenIndex[Slot].TokenNumber;
+      }
+      Slot = (Slot + 1) & mExTokenIndexMask;
+    }
+
+    DEBUG ((DEBUG_ERROR, "%a: Failed to find PCD with GUID: %g and token number: %d\n", __FUNCTION__, Guid, ExTokenNumber));
+    ASSERT (FALSE);
+
+    return 0;
+  }
 
   if (!mPeiDatabaseEmpty) {
     ExMap       = (DYNAMICEX_MAPPING *)((UINT8 *)mPcdDatabase.PeiDb + mPcdDatabase.PeiDb->ExMapTableOffset);
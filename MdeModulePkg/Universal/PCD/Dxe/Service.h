@@ -808,6 +808,17 @@ typedef struct {
 
 #define CR_FNENTRY_FROM_LISTNODE(Record, Type, Field) BASE_CR(Record, Type, Field)
 
+//
+// Entry of the hash index built over the DynamicEx mapping tables, so that a
+// {token space guid: token number} pair can be translated without scanning
+// the GUID table and the mapping table. Guid is NULL for an empty slot.
+//
+typedef struct {
+  CONST EFI_GUID          *Guid;
+  UINT32                  ExTokenNumber;
+  UINT32                  TokenNumber;
+} EX_TOKEN_INDEX_ENTRY;
+
 //
 // Internal Functions
 //
@@ -1074,6 +1085,19 @@ GetExPcdTokenNumber (
   IN UINT32                     ExTokenNumber
   );
 
+/**
+  Build the hash index used by GetExPcdTokenNumber() over the DynamicEx mapping
+  tables of both the PEI and DXE PCD databases.
+
+  If the index can't be allocated, GetExPcdTokenNumber() falls back to search
+  the mapping tables.
+
+**/
+VOID
+BuildExTokenIndex (
+  VOID
+  );
+
 /**
   Get next token number in given token space.
 
@@ -1186,6 +1210,9 @@ extern  BOOLEAN        mPeiExMapTableEmpty;
 extern  BOOLEAN        mDxeExMapTableEmpty;
 extern  BOOLEAN        mPeiDatabaseEmpty;
 
+extern  EX_TOKEN_INDEX_ENTRY  *mExTokenIndex;
+extern  UINTN          mExTokenIndexMask;
+
 extern  EFI_GUID     **TmpTokenSpaceBuffer;
 extern  UINTN          TmpTokenSpaceBufferCount;
 
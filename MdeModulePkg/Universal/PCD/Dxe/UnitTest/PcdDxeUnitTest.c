@@ -0,0 +1,457 @@
+/** @file
+  Host based unit tests of the DynamicEx token number lookup of the PCD DXE
+  driver.
+
+  GetExPcdTokenNumber() is run on synthetic PEI and DXE PCD databases which
+  only contain the DynamicEx mapping and GUID tables, once with the hash index
+  built by BuildExTokenIndex() and once with the search of the mapping tables,
+  and both are expected to return the same token numbers. The time taken by
+  either way is logged for several database sizes.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "../Service.h"
+#include <Library/DxeServicesLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "PCD DXE DynamicEx Lookup Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+//
+// Number of DynamicEx PCDs declared in each token space of the synthetic
+// databases, and first DynamicEx token number of a token space.
+//
+#define PCD_TOKEN_SPACE_SIZE      16
+#define PCD_EX_TOKEN_NUMBER_BASE  0x30000001
+
+//
+// Number of lookups timed for each database size of the benchmark.
+//
+#define PCD_LOOKUP_COUNT          (1 << 18)
+
+//
+// Mocked services used by Service.c and the variables of Pcd.c. None of them
+// is reached by the DynamicEx token number lookup.
+//
+EFI_BOOT_SERVICES     *gBS;
+EFI_RUNTIME_SERVICES  *gRT;
+EFI_LOCK              mPcdDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
+UINTN                 mVpdBaseAddress  = 0;
+
+VOID
+EFIAPI
+EfiAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+}
+
+VOID
+EFIAPI
+EfiReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+}
+
+VOID *
+EFIAPI
+GetFirstGuidHob (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  return NULL;
+}
+
+VOID *
+EFIAPI
+GetNextGuidHob (
+  IN CONST EFI_GUID  *Guid,
+  IN CONST VOID      *HobStart
+  )
+{
+  return NULL;
+}
+
+EFI_STATUS
+EFIAPI
+GetSectionFromFfs (
+  IN  EFI_SECTION_TYPE  SectionType,
+  IN  UINTN             SectionInstance,
+  OUT VOID              **Buffer,
+  OUT UINTN             *Size
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+UINTN
+EFIAPI
+DxePcdGetSize (
+  IN UINTN  TokenNumber
+  )
+{
+  return 0;
+}
+
+/**
+  Create a PCD database that only contains a DynamicEx mapping table and its
+  GUID table.
+
+  The token spaces get pseudo random GUIDs, which only depend on the index of
+  the token space, and PCD_TOKEN_SPACE_SIZE DynamicEx PCDs each. So two
+  databases created with the same token space count declare the same
+  {token space guid: token number} pairs for their first entries.
+
+  @param[in]  ExTokenCount      Number of DynamicEx PCDs.
+  @param[in]  TokenNumberBase   Token number of the first DynamicEx PCD, minus 1.
+
+  @return The database, to be freed with FreePool(), or NULL.
+**/
+STATIC
+PCD_DATABASE_INIT *
+CreateExMapDatabase (
+  IN UINT16  ExTokenCount,
+  IN UINT16  TokenNumberBase
+  )
+{
+  PCD_DATABASE_INIT  *Database;
+  DYNAMICEX_MAPPING  *ExMap;
+  EFI_GUID           *GuidTable;
+  UINT16             GuidTableCount;
+  UINT32             Seed;
+  UINTN              Index;
+
+  GuidTableCount = (UINT16)((ExTokenCount + PCD_TOKEN_SPACE_SIZE - 1) / PCD_TOKEN_SPACE_SIZE);
+  Database       = AllocateZeroPool (
+                     sizeof (PCD_DATABASE_INIT) +
+                     ExTokenCount * sizeof (DYNAMICEX_MAPPING) +
+                     GuidTableCount * sizeof (EFI_GUID)
+                     );
+  if (Database == NULL) {
+    return NULL;
+  }
+
+  Database->ExTokenCount     = ExTokenCount;
+  Database->GuidTableCount   = GuidTableCount;
+  Database->ExMapTableOffset = sizeof (PCD_DATABASE_INIT);
+  Database->GuidTableOffset  = Database->ExMapTableOffset + ExTokenCount * sizeof (DYNAMICEX_MAPPING);
+
+  ExMap     = (DYNAMICEX_MAPPING *)((UINT8 *)Database + Database->ExMapTableOffset);
+  GuidTable = (EFI_GUID *)((UINT8 *)Database + Database->GuidTableOffset);
+
+  Seed = 1;
+  for (Index = 0; Index < GuidTableCount * sizeof (EFI_GUID); Index++) {
+    Seed                        = Seed * 1103515245 + 12345;
+    ((UINT8 *)GuidTable)[Index] = (UINT8)(Seed >> 16);
+  }
+
+  for (Index = 0; Index < ExTokenCount; Index++) {
+    ExMap[Index].ExGuidIndex   = (UINT16)(Index / PCD_TOKEN_SPACE_SIZE);
+    ExMap[Index].ExTokenNumber = PCD_EX_TOKEN_NUMBER_BASE + (UINT32)(Index % PCD_TOKEN_SPACE_SIZE);
+    ExMap[Index].TokenNumber   = (UINT16)(TokenNumberBase + Index + 1);
+  }
+
+  return Database;
+}
+
+/**
+  Install the PCD databases the lookup runs on.
+
+  @param[in]  PeiDb  PEI PCD database, or NULL if there is none.
+  @param[in]  DxeDb  DXE PCD database.
+**/
+STATIC
+VOID
+InstallDatabases (
+  IN PCD_DATABASE_INIT  *PeiDb  OPTIONAL,
+  IN PCD_DATABASE_INIT  *DxeDb
+  )
+{
+  mPcdDatabase.PeiDb = PeiDb;
+  mPcdDatabase.DxeDb = DxeDb;
+  mPeiDatabaseEmpty  = (BOOLEAN)(PeiDb == NULL);
+  mPeiGuidTableSize  = (PeiDb == NULL) ? 0 : PeiDb->GuidTableCount * sizeof (EFI_GUID);
+  mDxeGuidTableSize  = DxeDb->GuidTableCount * sizeof (EFI_GUID);
+  mExTokenIndex      = NULL;
+}
+
+/**
+  Free the hash index, so that GetExPcdTokenNumber() searches the mapping
+  tables.
+**/
+STATIC
+VOID
+FreeExTokenIndex (
+  VOID
+  )
+{
+  if (mExTokenIndex != NULL) {
+    FreePool (mExTokenIndex);
+    mExTokenIndex = NULL;
+  }
+}
+
+/**
+  Look up every DynamicEx PCD of a database.
+
+  @param[in]   Database      PCD database which contains the mapping table.
+  @param[out]  TokenNumber   Token numbers returned by GetExPcdTokenNumber().
+**/
+STATIC
+VOID
+LookUpAll (
+  IN  PCD_DATABASE_INIT  *Database,
+  OUT UINTN              *TokenNumber
+  )
+{
+  DYNAMICEX_MAPPING  *ExMap;
+  EFI_GUID           *GuidTable;
+  UINTN              Index;
+
+  ExMap     = (DYNAMICEX_MAPPING *)((UINT8 *)Database + Database->ExMapTableOffset);
+  GuidTable = (EFI_GUID *)((UINT8 *)Database + Database->GuidTableOffset);
+
+  for (Index = 0; Index < Database->ExTokenCount; Index++) {
+    TokenNumber[Index] = GetExPcdTokenNumber (&GuidTable[ExMap[Index].ExGuidIndex], ExMap[Index].ExTokenNumber);
+  }
+}
+
+/**
+  Verify the hash index returns the token numbers the search of the mapping
+  tables returns, including the precedence of the PEI database over the DXE
+  one for a DynamicEx PCD declared in both.
+
+  @param[in]  Context  Ignored.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+ExTokenIndexShouldMatchSearch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  PCD_DATABASE_INIT  *PeiDb;
+  PCD_DATABASE_INIT  *DxeDb;
+  UINTN              *Searched;
+  UINTN              *Indexed;
+  UINTN              Index;
+
+  //
+  // The first 256 DynamicEx PCDs of the DXE database are also in the PEI one.
+  //
+  PeiDb    = CreateExMapDatabase (256, 0);
+  DxeDb    = CreateExMapDatabase (1000, 256);
+  Searched = AllocatePool (1000 * sizeof (UINTN));
+  Indexed  = AllocatePool (1000 * sizeof (UINTN));
+  UT_ASSERT_NOT_NULL (PeiDb);
+  UT_ASSERT_NOT_NULL (DxeDb);
+  UT_ASSERT_NOT_NULL (Searched);
+  UT_ASSERT_NOT_NULL (Indexed);
+
+  InstallDatabases (PeiDb, DxeDb);
+  LookUpAll (PeiDb, Searched);
+  for (Index = 0; Index < PeiDb->ExTokenCount; Index++) {
+    UT_ASSERT_EQUAL (Searched[Index], Index + 1);
+  }
+  LookUpAll (DxeDb, Searched);
+  for (Index = 0; Index < DxeDb->ExTokenCount; Index++) {
+    UT_ASSERT_EQUAL (Searched[Index], (Index < PeiDb->ExTokenCount) ? Index + 1 : Index + 256 + 1);
+  }
+
+  BuildExTokenIndex ();
+  UT_ASSERT_NOT_NULL (mExTokenIndex);
+  LookUpAll (DxeDb, Indexed);
+  UT_ASSERT_MEM_EQUAL (Indexed, Searched, DxeDb->ExTokenCount * sizeof (UINTN));
+  LookUpAll (PeiDb, Indexed);
+  UT_ASSERT_MEM_EQUAL (Indexed, Searched, PeiDb->ExTokenCount * sizeof (UINTN));
+  FreeExTokenIndex ();
+
+  //
+  // Without PEI database, the DXE database only.
+  //
+  InstallDatabases (NULL, DxeDb);
+  LookUpAll (DxeDb, Searched);
+  BuildExTokenIndex ();
+  UT_ASSERT_NOT_NULL (mExTokenIndex);
+  LookUpAll (DxeDb, Indexed);
+  UT_ASSERT_MEM_EQUAL (Indexed, Searched, DxeDb->ExTokenCount * sizeof (UINTN));
+  for (Index = 0; Index < DxeDb->ExTokenCount; Index++) {
+    UT_ASSERT_EQUAL (Indexed[Index], Index + 256 + 1);
+  }
+  FreeExTokenIndex ();
+
+  FreePool (Indexed);
+  FreePool (Searched);
+  FreePool (DxeDb);
+  FreePool (PeiDb);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Time PCD_LOOKUP_COUNT lookups of the DynamicEx PCDs of a database.
+
+  @param[in]   Database  PCD database which contains the mapping table.
+  @param[out]  Sum       Sum of the returned token numbers.
+
+  @return The time taken in microseconds.
+**/
+STATIC
+UINT64
+TimeLookUps (
+  IN  PCD_DATABASE_INIT  *Database,
+  OUT UINTN              *Sum
+  )
+{
+  DYNAMICEX_MAPPING  *ExMap;
+  EFI_GUID           *GuidTable;
+  UINTN              Index;
+  UINTN              Lookup;
+  clock_t            Start;
+
+  ExMap     = (DYNAMICEX_MAPPING *)((UINT8 *)Database + Database->ExMapTableOffset);
+  GuidTable = (EFI_GUID *)((UINT8 *)Database + Database->GuidTableOffset);
+
+  *Sum  = 0;
+  Index = 0;
+  Start = clock ();
+  for (Lookup = 0; Lookup < PCD_LOOKUP_COUNT; Lookup++) {
+    *Sum += GetExPcdTokenNumber (&GuidTable[ExMap[Index].ExGuidIndex], ExMap[Index].ExTokenNumber);
+    if (++Index == Database->ExTokenCount) {
+      Index = 0;
+    }
+  }
+
+  return (UINT64)(clock () - Start) * 1000000 / CLOCKS_PER_SEC;
+}
+
+/**
+  Benchmark of GetExPcdTokenNumber() with and without the hash index.
+
+  The time taken by PCD_LOOKUP_COUNT lookups is logged for several numbers of
+  DynamicEx PCDs in the DXE database.
+
+  @param[in]  Context  Ignored.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+ExTokenLookupBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST UINT16  ExTokenCount[] = { 16, 256, 4096 };
+  PCD_DATABASE_INIT    *DxeDb;
+  UINTN                Index;
+  UINT64               Searched;
+  UINT64               Indexed;
+  UINTN                SearchedSum;
+  UINTN                IndexedSum;
+
+  for (Index = 0; Index < ARRAY_SIZE (ExTokenCount); Index++) {
+    DxeDb = CreateExMapDatabase (ExTokenCount[Index], 0);
+    UT_ASSERT_NOT_NULL (DxeDb);
+    InstallDatabases (NULL, DxeDb);
+
+    Searched = TimeLookUps (DxeDb, &SearchedSum);
+    BuildExTokenIndex ();
+    UT_ASSERT_NOT_NULL (mExTokenIndex);
+    Indexed = TimeLookUps (DxeDb, &IndexedSum);
+    FreeExTokenIndex ();
+
+    UT_LOG_INFO (
+      "%d DynamicEx PCDs, %d lookups: %Lu us searched, %Lu us indexed\n",
+      ExTokenCount[Index],
+      PCD_LOOKUP_COUNT,
+      Searched,
+      Indexed
+      );
+    UT_ASSERT_EQUAL (IndexedSum, SearchedSum);
+
+    FreePool (DxeDb);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the DynamicEx
+  token number lookup and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      LookupTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&LookupTests, Framework, "DynamicEx Token Number Lookup Tests", "PcdDxe.GetExPcdTokenNumber", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for LookupTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (LookupTests, "Hash index returns the searched token numbers", "Index", ExTokenIndexShouldMatchSearch, NULL, NULL, NULL);
+  AddTestCase (LookupTests, "Benchmark GetExPcdTokenNumber", "Benchmark", ExTokenLookupBenchmark, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
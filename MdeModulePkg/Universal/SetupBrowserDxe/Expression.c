@@ -2500,6 +2500,247 @@ Done:
   return GetTheVal;
 }
 
+/**
+  Check whether an expression opcode only works on constants, the expression
+  stack and Question values. The result of an expression made of such opcodes
+  only changes when the values of the referenced Questions change.
+
+  @param  Operand                The expression opcode.
+
+  @retval TRUE                   The opcode has no other input.
+  @retval FALSE                  The opcode reads storage, strings or other state.
+
+**/
+BOOLEAN
+IsQuestionValueOnlyOpCode (
+  IN UINT8  Operand
+  )
+{
+  switch (Operand) {
+  case EFI_IFR_EQ_ID_VAL_OP:
+  case EFI_IFR_EQ_ID_ID_OP:
+  case EFI_IFR_EQ_ID_VAL_LIST_OP:
+  case EFI_IFR_QUESTION_REF1_OP:
+  case EFI_IFR_THIS_OP:
+  case EFI_IFR_DUP_OP:
+  case EFI_IFR_TRUE_OP:
+  case EFI_IFR_FALSE_OP:
+  case EFI_IFR_ONE_OP:
+  case EFI_IFR_ONES_OP:
+  case EFI_IFR_ZERO_OP:
+  case EFI_IFR_UINT8_OP:
+  case EFI_IFR_UINT16_OP:
+  case EFI_IFR_UINT32_OP:
+  case EFI_IFR_UINT64_OP:
+  case EFI_IFR_UNDEFINED_OP:
+  case EFI_IFR_VERSION_OP:
+  case EFI_IFR_NOT_OP:
+  case EFI_IFR_BITWISE_NOT_OP:
+  case EFI_IFR_ADD_OP:
+  case EFI_IFR_SUBTRACT_OP:
+  case EFI_IFR_MULTIPLY_OP:
+  case EFI_IFR_DIVIDE_OP:
+  case EFI_IFR_MODULO_OP:
+  case EFI_IFR_BITWISE_AND_OP:
+  case EFI_IFR_BITWISE_OR_OP:
+  case EFI_IFR_SHIFT_LEFT_OP:
+  case EFI_IFR_SHIFT_RIGHT_OP:
+  case EFI_IFR_AND_OP:
+  case EFI_IFR_OR_OP:
+  case EFI_IFR_EQUAL_OP:
+  case EFI_IFR_NOT_EQUAL_OP:
+  case EFI_IFR_GREATER_EQUAL_OP:
+  case EFI_IFR_GREATER_THAN_OP:
+  case EFI_IFR_LESS_EQUAL_OP:
+  case EFI_IFR_LESS_THAN_OP:
+  case EFI_IFR_CONDITIONAL_OP:
+    return TRUE;
+
+  default:
+    return FALSE;
+  }
+}
+
+/**
+  Collect the Questions the result of an expression depends on.
+
+  The result is only cached for expressions which are made of the opcodes
+  accepted by IsQuestionValueOnlyOpCode() and only refer to Questions with
+  numeric, boolean, date or time value in the same Form. IdToQuestion() may
+  reload the value of Questions in other Forms from storage, so expressions
+  referring to them are always evaluated.
+
+  @param  Form                   Form associated with this expression.
+  @param  Expression             The expression.
+
+**/
+VOID
+CollectExpressionDependency (
+  IN     FORM_BROWSER_FORM  *Form,
+  IN OUT FORM_EXPRESSION    *Expression
+  )
+{
+  LIST_ENTRY              *Link;
+  EXPRESSION_OPCODE       *OpCode;
+  EXPRESSION_DEPENDENCY   *Dependency;
+  UINTN                   Count;
+  UINTN                   Index;
+  EFI_QUESTION_ID         QuestionId[2];
+  UINTN                   QuestionCount;
+  FORM_BROWSER_STATEMENT  *Question;
+
+  Expression->DependencyChecked = TRUE;
+  Expression->DependencyForm    = Form;
+
+  Count = 0;
+  Link = GetFirstNode (&Expression->OpCodeListHead);
+  while (!IsNull (&Expression->OpCodeListHead, Link)) {
+    OpCode = EXPRESSION_OPCODE_FROM_LINK (Link);
+    Link = GetNextNode (&Expression->OpCodeListHead, Link);
+
+    if (!IsQuestionValueOnlyOpCode (OpCode->Operand)) {
+      return;
+    }
+    if (OpCode->Operand == EFI_IFR_EQ_ID_ID_OP) {
+      Count += 2;
+    } else if (OpCode->Operand == EFI_IFR_EQ_ID_VAL_OP ||
+               OpCode->Operand == EFI_IFR_EQ_ID_VAL_LIST_OP ||
+               OpCode->Operand == EFI_IFR_QUESTION_REF1_OP ||
+               OpCode->Operand == EFI_IFR_THIS_OP) {
+      Count++;
+    }
+  }
+
+  Dependency = NULL;
+  if (Count != 0) {
+    Dependency = AllocateZeroPool (Count * sizeof (EXPRESSION_DEPENDENCY));
+    if (Dependency == NULL) {
+      return;
+    }
+  }
+
+  Count = 0;
+  Link = GetFirstNode (&Expression->OpCodeListHead);
+  while (!IsNull (&Expression->OpCodeListHead, Link)) {
+    OpCode = EXPRESSION_OPCODE_FROM_LINK (Link);
+    Link = GetNextNode (&Expression->OpCodeListHead, Link);
+
+    QuestionCount = 0;
+    switch (OpCode->Operand) {
+    case EFI_IFR_EQ_ID_ID_OP:
+      QuestionId[0] = OpCode->QuestionId;
+      QuestionId[1] = OpCode->QuestionId2;
+      QuestionCount = 2;
+      break;
+
+    case EFI_IFR_EQ_ID_VAL_OP:
+    case EFI_IFR_EQ_ID_VAL_LIST_OP:
+    case EFI_IFR_QUESTION_REF1_OP:
+    case EFI_IFR_THIS_OP:
+      QuestionId[0] = OpCode->QuestionId;
+      QuestionCount = 1;
+      break;
+
+    default:
+      break;
+    }
+
+    for (Index = 0; Index < QuestionCount; Index++) {
+      Question = IdToQuestion2 (Form, QuestionId[Index]);
+      //
+      // Forms are only evaluated once they are fully parsed: ParseOpCodes()
+      // evaluates Form level DisableIf expressions with a NULL Form only. A
+      // Question missing here lives in another Form, so the expression is
+      // never cacheable.
+      //
+      if (Question == NULL || Question->HiiValue.Type >= EFI_IFR_TYPE_STRING) {
+        FreePool (Dependency);
+        return;
+      }
+      Dependency[Count++].Question = Question;
+    }
+  }
+
+  Expression->Dependency      = Dependency;
+  Expression->DependencyCount = Count;
+  Expression->Cacheable       = TRUE;
+}
+
+/**
+  Check whether the last result of an expression is still valid, i.e. none
+  of the Question values it depends on has changed since it was evaluated.
+
+  @param  Form                   Form associated with this expression.
+  @param  Expression             The expression.
+
+  @retval TRUE                   Expression->Result can be used as is.
+  @retval FALSE                  The expression must be evaluated.
+
+**/
+BOOLEAN
+IsExpressionResultValid (
+  IN     FORM_BROWSER_FORM  *Form,
+  IN OUT FORM_EXPRESSION    *Expression
+  )
+{
+  UINTN                   Index;
+  EXPRESSION_DEPENDENCY   *Dependency;
+
+  if (Form == NULL) {
+    return FALSE;
+  }
+
+  if (!Expression->DependencyChecked) {
+    CollectExpressionDependency (Form, Expression);
+  }
+
+  if (!Expression->ResultValid || Expression->DependencyForm != Form) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < Expression->DependencyCount; Index++) {
+    Dependency = &Expression->Dependency[Index];
+    if (Dependency->Question->HiiValue.Type != Dependency->Value.Type ||
+        CompareMem (&Dependency->Question->HiiValue.Value, &Dependency->Value.Value, sizeof (EFI_IFR_TYPE_VALUE)) != 0) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Record the Question values the result of an expression is evaluated with.
+
+  @param  Form                   Form associated with this expression.
+  @param  Expression             The evaluated expression.
+
+**/
+VOID
+SaveExpressionDependency (
+  IN     FORM_BROWSER_FORM  *Form,
+  IN OUT FORM_EXPRESSION    *Expression
+  )
+{
+  UINTN                   Index;
+  EXPRESSION_DEPENDENCY   *Dependency;
+
+  //
+  // Only cache the results which don't own a buffer.
+  //
+  if (!Expression->Cacheable || Expression->DependencyForm != Form ||
+      (Expression->Result.Type > EFI_IFR_TYPE_BOOLEAN && Expression->Result.Type != EFI_IFR_TYPE_UNDEFINED)) {
+    return;
+  }
+
+  for (Index = 0; Index < Expression->DependencyCount; Index++) {
+    Dependency = &Expression->Dependency[Index];
+    Dependency->Value.Type = Dependency->Question->HiiValue.Type;
+    CopyMem (&Dependency->Value.Value, &Dependency->Question->HiiValue.Value, sizeof (EFI_IFR_TYPE_VALUE));
+  }
+  Expression->ResultValid = TRUE;
+}
+
 /**
   Evaluate the result of a HII expression.
 
@@ -2553,12 +2794,22 @@ EvaluateExpression (
 
   StrPtr = NULL;
 
+  ASSERT (Expression != NULL);
+
+  //
+  // Skip the evaluation if the Questions the expression depends on keep
+  // the values of last evaluation.
+  //
+  if (IsExpressionResultValid (Form, Expression)) {
+    return EFI_SUCCESS;
+  }
+  Expression->ResultValid = FALSE;
+
   //
   // Save current stack offset.
   //
   StackOffset = SaveExpressionEvaluationStackOffset ();
 
-  ASSERT (Expression != NULL);
   Expression->Result.Type = EFI_IFR_TYPE_OTHER;
 
   Link = GetFirstNode (&Expression->OpCodeListHead);
@@ -3614,6 +3865,7 @@ Done:
   RestoreExpressionEvaluationStackOffset (StackOffset);
   if (!EFI_ERROR (Status)) {
     CopyMem (&Expression->Result, Value, sizeof (EFI_HII_VALUE));
+    SaveExpressionDependency (Form, Expression);
   }
 
   return Status;
@@ -731,6 +731,10 @@ DestroyExpression (
     }
   }
 
+  if (Expression->Dependency != NULL) {
+    FreePool (Expression->Dependency);
+  }
+
   //
   // Free this Expression
   //
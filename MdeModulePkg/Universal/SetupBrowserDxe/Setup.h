@@ -217,6 +217,15 @@ typedef struct {
 
 #define EXPRESSION_OPCODE_FROM_LINK(a)  CR (a, EXPRESSION_OPCODE, Link, EXPRESSION_OPCODE_SIGNATURE)
 
+//
+// A Question value an expression result depends on, and the value it had
+// when the expression was last evaluated.
+//
+typedef struct {
+  struct _FORM_BROWSER_STATEMENT *Question;
+  EFI_HII_VALUE                  Value;
+} EXPRESSION_DEPENDENCY;
+
 #define FORM_EXPRESSION_SIGNATURE  SIGNATURE_32 ('F', 'E', 'X', 'P')
 
 typedef struct {
@@ -234,6 +243,13 @@ typedef struct {
   EFI_IFR_OP_HEADER *OpCode;         // Save the opcode buffer.
 
   LIST_ENTRY        OpCodeListHead;  // OpCodes consist of this expression (EXPRESSION_OPCODE)
+
+  BOOLEAN               DependencyChecked; // Dependency of the expression has been collected
+  BOOLEAN               Cacheable;         // Result only depends on the Questions in Dependency
+  BOOLEAN               ResultValid;       // Result is still valid if Dependency values don't change
+  VOID                  *DependencyForm;   // FORM_BROWSER_FORM which Dependency is collected in
+  UINTN                 DependencyCount;
+  EXPRESSION_DEPENDENCY *Dependency;
 } FORM_EXPRESSION;
 
 #define FORM_EXPRESSION_FROM_LINK(a)  CR (a, FORM_EXPRESSION, Link, FORM_EXPRESSION_SIGNATURE)
@@ -149,6 +149,44 @@ SMBIOS_TABLE_3_0_ENTRY_POINT Smbios30EntryPointStructureData = {
   0
 };
 
+/**
+  Validates a SMBIOS 3.0 table entry point.
+
+  @param  TableEntry       The SmBios table entry to validate.
+  @param  TableAddress     On exit, point to the smbios table addres.
+  @param  TableMaximumSize On exit, point to the maximum size of the table.
+
+  @retval TRUE           SMBIOS table entry point is valid.
+  @retval FALSE          SMBIOS table entry point is malformed.
+
+**/
+STATIC
+BOOLEAN
+IsValidSmbios30Table (
+  IN  VOID               *TableEntry,
+  OUT VOID               **TableAddress,
+  OUT UINTN              *TableMaximumSize
+  );
+
+/**
+  Validates a SMBIOS 2.0 table entry point.
+
+  @param  TableEntry       The SmBios table entry to validate.
+  @param  TableAddress     On exit, point to the smbios table addres.
+  @param  TableMaximumSize On exit, point to the maximum size of the table.
+
+  @retval TRUE           SMBIOS table entry point is valid.
+  @retval FALSE          SMBIOS table entry point is malformed.
+
+**/
+STATIC
+BOOLEAN
+IsValidSmbios20Table (
+  IN  VOID               *TableEntry,
+  OUT VOID               **TableAddress,
+  OUT UINTN              *TableMaximumSize
+  );
+
 IS_SMBIOS_TABLE_VALID_ENTRY mIsSmbiosTableValid[] = {
   {&gUniversalPayloadSmbios3TableGuid, IsValidSmbios30Table },
   {&gUniversalPayloadSmbiosTableGuid,  IsValidSmbios20Table }
@@ -246,7 +284,7 @@ GetSmbiosStructureSize (
 
   Determin whether an SmbiosHandle has already in use.
 
-  @param Head        Pointer to the beginning of SMBIOS structure.
+  @param Private     Pointer to the SMBIOS instance.
   @param Handle      A unique handle will be assigned to the SMBIOS record.
 
   @retval TRUE       Smbios handle already in use.
@@ -256,21 +294,37 @@ GetSmbiosStructureSize (
 BOOLEAN
 EFIAPI
 CheckSmbiosHandleExistance (
-  IN  LIST_ENTRY           *Head,
+  IN  SMBIOS_INSTANCE      *Private,
   IN  EFI_SMBIOS_HANDLE    Handle
   )
 {
-  LIST_ENTRY              *Link;
-  SMBIOS_HANDLE_ENTRY     *HandleEntry;
+  return (BOOLEAN) ((Private->AllocatedHandleBitmap[Handle / 8] & (1 << (Handle % 8))) != 0);
+}
 
-  for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
-    HandleEntry = SMBIOS_HANDLE_ENTRY_FROM_LINK(Link);
-    if (HandleEntry->SmbiosHandle == Handle) {
-      return TRUE;
+/**
+
+  Mark an SmbiosHandle as allocated or free.
+
+  @param Private     Pointer to the SMBIOS instance.
+  @param Handle      The SMBIOS handle to update.
+  @param Allocated   TRUE if the handle gets allocated, FALSE if it gets freed.
+
+**/
+VOID
+SetSmbiosHandleAllocated (
+  IN  SMBIOS_INSTANCE      *Private,
+  IN  EFI_SMBIOS_HANDLE    Handle,
+  IN  BOOLEAN              Allocated
+  )
+{
+  if (Allocated) {
+    Private->AllocatedHandleBitmap[Handle / 8] |= (UINT8) (1 << (Handle % 8));
+  } else {
+    Private->AllocatedHandleBitmap[Handle / 8] &= (UINT8) ~(1 << (Handle % 8));
+    if (Handle < Private->FirstFreeHandle) {
+      Private->FirstFreeHandle = Handle;
     }
   }
-
-  return FALSE;
 }
 
 /**
@@ -313,7 +367,6 @@ GetAvailableSmbiosHandle (
   IN OUT   EFI_SMBIOS_HANDLE     *Handle
   )
 {
-  LIST_ENTRY              *Head;
   SMBIOS_INSTANCE         *Private;
   EFI_SMBIOS_HANDLE       MaxSmbiosHandle;
   EFI_SMBIOS_HANDLE       AvailableHandle;
@@ -321,14 +374,15 @@ GetAvailableSmbiosHandle (
   GetMaxSmbiosHandle(This, &MaxSmbiosHandle);
 
   Private = SMBIOS_INSTANCE_FROM_THIS (This);
-  Head = &Private->AllocatedHandleListHead;
-  for (AvailableHandle = 0; AvailableHandle < MaxSmbiosHandle; AvailableHandle++) {
-    if (!CheckSmbiosHandleExistance(Head, AvailableHandle)) {
+  for (AvailableHandle = Private->FirstFreeHandle; AvailableHandle < MaxSmbiosHandle; AvailableHandle++) {
+    if (!CheckSmbiosHandleExistance(Private, AvailableHandle)) {
+      Private->FirstFreeHandle = AvailableHandle;
       *Handle = AvailableHandle;
       return EFI_SUCCESS;
     }
   }
 
+  Private->FirstFreeHandle = MaxSmbiosHandle;
   return EFI_OUT_OF_RESOURCES;
 }
 
@@ -367,11 +421,9 @@ SmbiosAdd (
   UINTN                       StructureSize;
   UINTN                       NumberOfStrings;
   EFI_STATUS                  Status;
-  LIST_ENTRY                  *Head;
   SMBIOS_INSTANCE             *Private;
   EFI_SMBIOS_ENTRY            *SmbiosEntry;
   EFI_SMBIOS_HANDLE           MaxSmbiosHandle;
-  SMBIOS_HANDLE_ENTRY         *HandleEntry;
   EFI_SMBIOS_RECORD_HEADER    *InternalRecord;
   BOOLEAN                     Smbios32BitTable;
   BOOLEAN                     Smbios64BitTable;
@@ -384,8 +436,7 @@ SmbiosAdd (
   //
   // Check whether SmbiosHandle is already in use
   //
-  Head = &Private->AllocatedHandleListHead;
-  if (*SmbiosHandle != SMBIOS_HANDLE_PI_RESERVED && CheckSmbiosHandleExistance(Head, *SmbiosHandle)) {
+  if (*SmbiosHandle != SMBIOS_HANDLE_PI_RESERVED && CheckSmbiosHandleExistance(Private, *SmbiosHandle)) {
     return EFI_ALREADY_STARTED;
   }
 
@@ -476,18 +527,11 @@ SmbiosAdd (
     EfiReleaseLock (&Private->DataLock);
     return EFI_OUT_OF_RESOURCES;
   }
-  HandleEntry = AllocateZeroPool (sizeof(SMBIOS_HANDLE_ENTRY));
-  if (HandleEntry == NULL) {
-    EfiReleaseLock (&Private->DataLock);
-    return EFI_OUT_OF_RESOURCES;
-  }
 
   //
-  // Build Handle Entry and insert into linked list
+  // Mark the handle as allocated
   //
-  HandleEntry->Signature     = SMBIOS_HANDLE_ENTRY_SIGNATURE;
-  HandleEntry->SmbiosHandle  = *SmbiosHandle;
-  InsertTailList(&Private->AllocatedHandleListHead, &HandleEntry->Link);
+  SetSmbiosHandleAllocated (Private, *SmbiosHandle, TRUE);
 
   InternalRecord  = (EFI_SMBIOS_RECORD_HEADER *) (SmbiosEntry + 1);
   Raw     = (VOID *) (InternalRecord + 1);
@@ -509,6 +553,7 @@ SmbiosAdd (
   SmbiosEntry->Smbios32BitTable = Smbios32BitTable;
   SmbiosEntry->Smbios64BitTable = Smbios64BitTable;
   InsertTailList (&Private->DataListHead, &SmbiosEntry->Link);
+  InsertTailList (&Private->TypeListHead[Record->Type], &SmbiosEntry->TypeLink);
 
   CopyMem (Raw, Record, StructureSize);
   ((EFI_SMBIOS_TABLE_HEADER*)Raw)->Handle = *SmbiosHandle;
@@ -519,7 +564,7 @@ SmbiosAdd (
   // configuration table, so other UEFI drivers can get SMBIOS table from
   // configuration table without depending on PI SMBIOS protocol.
   //
-  SmbiosTableConstruction (Smbios32BitTable, Smbios64BitTable);
+  SmbiosTableAppend (SmbiosEntry);
 
   //
   // Leave critical section
@@ -567,6 +612,8 @@ SmbiosUpdateString (
   EFI_SMBIOS_HANDLE         MaxSmbiosHandle;
   EFI_SMBIOS_TABLE_HEADER   *Record;
   EFI_SMBIOS_RECORD_HEADER  *InternalRecord;
+  BOOLEAN                   Smbios32BitTable;
+  BOOLEAN                   Smbios64BitTable;
 
   //
   // Check args validity
@@ -677,6 +724,12 @@ SmbiosUpdateString (
         return EFI_SUCCESS;
       }
 
+      //
+      // Remember which tables the record is in, they must be rebuilt
+      // if the record moves out of them.
+      //
+      Smbios32BitTable = SmbiosEntry->Smbios32BitTable;
+      Smbios64BitTable = SmbiosEntry->Smbios64BitTable;
       SmbiosEntry->Smbios32BitTable = FALSE;
       SmbiosEntry->Smbios64BitTable = FALSE;
       if ((This->MajorVersion < 0x3) ||
@@ -712,6 +765,11 @@ SmbiosUpdateString (
       }
 
       if ((!SmbiosEntry->Smbios32BitTable) && (!SmbiosEntry->Smbios64BitTable)) {
+        //
+        // The record is left unchanged in the tables it was in.
+        //
+        SmbiosEntry->Smbios32BitTable = Smbios32BitTable;
+        SmbiosEntry->Smbios64BitTable = Smbios64BitTable;
         EfiReleaseLock (&Private->DataLock);
         return EFI_UNSUPPORTED;
       }
@@ -758,11 +816,16 @@ SmbiosUpdateString (
       ResizedSmbiosEntry->Smbios32BitTable = SmbiosEntry->Smbios32BitTable;
       ResizedSmbiosEntry->Smbios64BitTable = SmbiosEntry->Smbios64BitTable;
       InsertTailList (Link->ForwardLink, &ResizedSmbiosEntry->Link);
+      InsertTailList (SmbiosEntry->TypeLink.ForwardLink, &ResizedSmbiosEntry->TypeLink);
+      if (Private->GetNextLink == Link) {
+        Private->GetNextLink = &ResizedSmbiosEntry->Link;
+      }
 
       //
       // Remove old record
       //
       RemoveEntryList(Link);
+      RemoveEntryList(&SmbiosEntry->TypeLink);
       FreePool(SmbiosEntry);
       //
       // Some UEFI drivers (such as network) need some information in SMBIOS table.
@@ -770,7 +833,10 @@ SmbiosUpdateString (
       // configuration table, so other UEFI drivers can get SMBIOS table from
       // configuration table without depending on PI SMBIOS protocol.
       //
-      SmbiosTableConstruction (ResizedSmbiosEntry->Smbios32BitTable, ResizedSmbiosEntry->Smbios64BitTable);
+      SmbiosTableConstruction (
+        (BOOLEAN) (Smbios32BitTable || ResizedSmbiosEntry->Smbios32BitTable),
+        (BOOLEAN) (Smbios64BitTable || ResizedSmbiosEntry->Smbios64BitTable)
+        );
       EfiReleaseLock (&Private->DataLock);
       return EFI_SUCCESS;
     }
@@ -803,7 +869,6 @@ SmbiosRemove (
   EFI_SMBIOS_HANDLE          MaxSmbiosHandle;
   SMBIOS_INSTANCE            *Private;
   EFI_SMBIOS_ENTRY           *SmbiosEntry;
-  SMBIOS_HANDLE_ENTRY        *HandleEntry;
   EFI_SMBIOS_TABLE_HEADER    *Record;
 
   //
@@ -833,18 +898,14 @@ SmbiosRemove (
       // Remove specified smobios record from DataList
       //
       RemoveEntryList(Link);
+      RemoveEntryList(&SmbiosEntry->TypeLink);
+      if (Private->GetNextLink == Link) {
+        Private->GetNextLink = NULL;
+      }
       //
-      // Remove this handle from AllocatedHandleList
+      // Free this handle
       //
-      Head = &Private->AllocatedHandleListHead;
-      for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
-        HandleEntry = SMBIOS_HANDLE_ENTRY_FROM_LINK(Link);
-        if (HandleEntry->SmbiosHandle == SmbiosHandle) {
-          RemoveEntryList(Link);
-          FreePool(HandleEntry);
-          break;
-        }
-      }
+      SetSmbiosHandleAllocated (Private, SmbiosHandle, FALSE);
       //
       // Some UEFI drivers (such as network) need some information in SMBIOS table.
       // Here we create SMBIOS table and publish it in
@@ -903,9 +964,9 @@ SmbiosGetNext (
   OUT EFI_HANDLE                    *ProducerHandle OPTIONAL
   )
 {
-  BOOLEAN                  StartPointFound;
   LIST_ENTRY               *Link;
   LIST_ENTRY               *Head;
+  LIST_ENTRY               *StartLink;
   SMBIOS_INSTANCE          *Private;
   EFI_SMBIOS_ENTRY         *SmbiosEntry;
   EFI_SMBIOS_TABLE_HEADER  *SmbiosTableHeader;
@@ -914,54 +975,86 @@ SmbiosGetNext (
     return EFI_INVALID_PARAMETER;
   }
 
-  StartPointFound = FALSE;
   Private = SMBIOS_INSTANCE_FROM_THIS (This);
   Head = &Private->DataListHead;
-  for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
-    SmbiosEntry = SMBIOS_ENTRY_FROM_LINK(Link);
-    SmbiosTableHeader = (EFI_SMBIOS_TABLE_HEADER*)(SmbiosEntry->RecordHeader + 1);
-
-    //
-    // If SmbiosHandle is 0xFFFE, the first matched SMBIOS record handle will be returned
-    //
-    if (*SmbiosHandle == SMBIOS_HANDLE_PI_RESERVED) {
-      if ((Type != NULL) && (*Type != SmbiosTableHeader->Type)) {
-        continue;
-      }
 
-      *SmbiosHandle = SmbiosTableHeader->Handle;
-      *Record =SmbiosTableHeader;
-      if (ProducerHandle != NULL) {
-        *ProducerHandle = SmbiosEntry->RecordHeader->ProducerHandle;
-      }
-      return EFI_SUCCESS;
+  //
+  // If SmbiosHandle is 0xFFFE, the first matched SMBIOS record handle will be returned,
+  // otherwise start this round search from the next SMBIOS handle. The record returned
+  // by the last call is checked first, as the caller usually walks through the records.
+  //
+  StartLink = NULL;
+  if (*SmbiosHandle == SMBIOS_HANDLE_PI_RESERVED) {
+    StartLink = Head;
+  } else if (Private->GetNextLink != NULL) {
+    SmbiosEntry = SMBIOS_ENTRY_FROM_LINK (Private->GetNextLink);
+    SmbiosTableHeader = (EFI_SMBIOS_TABLE_HEADER*)(SmbiosEntry->RecordHeader + 1);
+    if (SmbiosTableHeader->Handle == *SmbiosHandle) {
+      StartLink = Private->GetNextLink;
     }
+  }
 
-    //
-    // Start this round search from the next SMBIOS handle
-    //
-    if (!StartPointFound && (*SmbiosHandle == SmbiosTableHeader->Handle)) {
-      StartPointFound = TRUE;
-      continue;
+  if ((StartLink == NULL) && CheckSmbiosHandleExistance (Private, *SmbiosHandle)) {
+    for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
+      SmbiosEntry = SMBIOS_ENTRY_FROM_LINK(Link);
+      SmbiosTableHeader = (EFI_SMBIOS_TABLE_HEADER*)(SmbiosEntry->RecordHeader + 1);
+      if (SmbiosTableHeader->Handle == *SmbiosHandle) {
+        StartLink = Link;
+        break;
+      }
     }
+  }
 
-    if (StartPointFound) {
-      if ((Type != NULL) && (*Type != SmbiosTableHeader->Type)) {
-        continue;
+  SmbiosEntry = NULL;
+  if (StartLink != NULL) {
+    if (Type == NULL) {
+      if (StartLink->ForwardLink != Head) {
+        SmbiosEntry = SMBIOS_ENTRY_FROM_LINK (StartLink->ForwardLink);
       }
-
-      *SmbiosHandle = SmbiosTableHeader->Handle;
-      *Record = SmbiosTableHeader;
-      if (ProducerHandle != NULL) {
-        *ProducerHandle = SmbiosEntry->RecordHeader->ProducerHandle;
+    } else {
+      //
+      // Follow the list of the records of this type, unless the start point
+      // is a record of another type.
+      //
+      Link = &Private->TypeListHead[*Type];
+      if (StartLink != Head) {
+        SmbiosEntry = SMBIOS_ENTRY_FROM_LINK (StartLink);
+        SmbiosTableHeader = (EFI_SMBIOS_TABLE_HEADER*)(SmbiosEntry->RecordHeader + 1);
+        if (SmbiosTableHeader->Type == *Type) {
+          Link = &SmbiosEntry->TypeLink;
+        } else {
+          for (Link = StartLink->ForwardLink; Link != Head; Link = Link->ForwardLink) {
+            SmbiosEntry = SMBIOS_ENTRY_FROM_LINK(Link);
+            SmbiosTableHeader = (EFI_SMBIOS_TABLE_HEADER*)(SmbiosEntry->RecordHeader + 1);
+            if (SmbiosTableHeader->Type == *Type) {
+              break;
+            }
+          }
+          Link = (Link == Head) ? Private->TypeListHead[*Type].BackLink : SmbiosEntry->TypeLink.BackLink;
+        }
       }
 
-      return EFI_SUCCESS;
+      SmbiosEntry = NULL;
+      if (Link->ForwardLink != &Private->TypeListHead[*Type]) {
+        SmbiosEntry = SMBIOS_ENTRY_FROM_TYPE_LINK (Link->ForwardLink);
+      }
     }
   }
 
-  *SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
-  return EFI_NOT_FOUND;
+  if (SmbiosEntry == NULL) {
+    *SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+    return EFI_NOT_FOUND;
+  }
+
+  SmbiosTableHeader = (EFI_SMBIOS_TABLE_HEADER*)(SmbiosEntry->RecordHeader + 1);
+  *SmbiosHandle = SmbiosTableHeader->Handle;
+  *Record = SmbiosTableHeader;
+  if (ProducerHandle != NULL) {
+    *ProducerHandle = SmbiosEntry->RecordHeader->ProducerHandle;
+  }
+  Private->GetNextLink = &SmbiosEntry->Link;
+
+  return EFI_SUCCESS;
 
 }
 
@@ -1048,6 +1141,7 @@ SmbiosCreateTable (
   EFI_SMBIOS_TABLE_HEADER         *SmbiosRecord;
   EFI_SMBIOS_TABLE_END_STRUCTURE  EndStructure;
   EFI_SMBIOS_ENTRY                *CurrentSmbiosEntry;
+  UINTN                           Pages;
 
   Status            = EFI_SUCCESS;
   BufferPointer     = NULL;
@@ -1141,10 +1235,13 @@ SmbiosCreateTable (
   if (EFI_SIZE_TO_PAGES ((UINT32) EntryPointStructure->TableLength) > mPreAllocatedPages) {
     //
     // If new SMBIOS table size exceeds the previous allocated page,
-    // it is time to re-allocate memory (below 4GB).
+    // it is time to re-allocate memory (below 4GB). At least double
+    // the allocation so that records added later can be appended in place.
     //
     DEBUG ((EFI_D_INFO, "%a() re-allocate SMBIOS 32-bit table\n",
       __FUNCTION__));
+    Pages = MAX (EFI_SIZE_TO_PAGES ((UINT32) EntryPointStructure->TableLength), 2 * mPreAllocatedPages);
+    Pages = MIN (Pages, EFI_SIZE_TO_PAGES (SMBIOS_TABLE_MAX_LENGTH));
     if (EntryPointStructure->TableAddress != 0) {
       //
       // Free the previous allocated page
@@ -1161,7 +1258,7 @@ SmbiosCreateTable (
     Status = gBS->AllocatePages (
                     AllocateMaxAddress,
                     EfiRuntimeServicesData,
-                    EFI_SIZE_TO_PAGES (EntryPointStructure->TableLength),
+                    Pages,
                     &PhysicalAddress
                     );
     if (EFI_ERROR (Status)) {
@@ -1170,7 +1267,7 @@ SmbiosCreateTable (
       return EFI_OUT_OF_RESOURCES;
     } else {
       EntryPointStructure->TableAddress = (UINT32) PhysicalAddress;
-      mPreAllocatedPages = EFI_SIZE_TO_PAGES (EntryPointStructure->TableLength);
+      mPreAllocatedPages = Pages;
     }
   }
 
@@ -1240,6 +1337,7 @@ SmbiosCreate64BitTable (
   EFI_SMBIOS_TABLE_HEADER         *SmbiosRecord;
   EFI_SMBIOS_TABLE_END_STRUCTURE  EndStructure;
   EFI_SMBIOS_ENTRY                *CurrentSmbiosEntry;
+  UINTN                           Pages;
 
   Status            = EFI_SUCCESS;
   BufferPointer     = NULL;
@@ -1310,10 +1408,12 @@ SmbiosCreate64BitTable (
   if (EFI_SIZE_TO_PAGES (Smbios30EntryPointStructure->TableMaximumSize) > mPre64BitAllocatedPages) {
     //
     // If new SMBIOS table size exceeds the previous allocated page,
-    // it is time to re-allocate memory at anywhere.
+    // it is time to re-allocate memory at anywhere. At least double
+    // the allocation so that records added later can be appended in place.
     //
     DEBUG ((EFI_D_INFO, "%a() re-allocate SMBIOS 64-bit table\n",
       __FUNCTION__));
+    Pages = MAX (EFI_SIZE_TO_PAGES (Smbios30EntryPointStructure->TableMaximumSize), 2 * mPre64BitAllocatedPages);
     if (Smbios30EntryPointStructure->TableAddress != 0) {
       //
       // Free the previous allocated page
@@ -1329,7 +1429,7 @@ SmbiosCreate64BitTable (
     Status = gBS->AllocatePages (
                     AllocateAnyPages,
                     EfiRuntimeServicesData,
-                    EFI_SIZE_TO_PAGES (Smbios30EntryPointStructure->TableMaximumSize),
+                    Pages,
                     &PhysicalAddress
                     );
     if (EFI_ERROR (Status)) {
@@ -1338,7 +1438,7 @@ SmbiosCreate64BitTable (
       return EFI_OUT_OF_RESOURCES;
     } else {
       Smbios30EntryPointStructure->TableAddress = PhysicalAddress;
-      mPre64BitAllocatedPages = EFI_SIZE_TO_PAGES (Smbios30EntryPointStructure->TableMaximumSize);
+      mPre64BitAllocatedPages = Pages;
     }
   }
 
@@ -1414,6 +1514,152 @@ SmbiosTableConstruction (
   }
 }
 
+/**
+  Append the record of a new SMBIOS entry to the SMBIOS 32-bit table in place.
+
+  The table must have been assembled from all the other entries and have room
+  left in its allocated pages for the record.
+
+  @param  SmbiosEntry                The SMBIOS entry at the tail of the record list.
+  @param  TableEntryPointStructure   On exit, points to the SMBIOS entrypoint structure.
+
+  @retval EFI_SUCCESS                The record was appended.
+  @retval EFI_BUFFER_TOO_SMALL       The table must be assembled again.
+
+**/
+EFI_STATUS
+SmbiosAppendTableRecord (
+  IN  EFI_SMBIOS_ENTRY  *SmbiosEntry,
+  OUT VOID              **TableEntryPointStructure
+  )
+{
+  UINT8       *BufferPointer;
+  UINTN       RecordSize;
+
+  RecordSize = SmbiosEntry->RecordHeader->RecordSize - sizeof (EFI_SMBIOS_RECORD_HEADER);
+  if ((EntryPointStructure == NULL) || (EntryPointStructure->TableAddress == 0) ||
+      (EntryPointStructure->TableLength + RecordSize > EFI_PAGES_TO_SIZE (mPreAllocatedPages))) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  //
+  // Move End-Of-Table structure and put the record in its place
+  //
+  BufferPointer = (UINT8 *) (UINTN) EntryPointStructure->TableAddress +
+                  EntryPointStructure->TableLength - sizeof (EFI_SMBIOS_TABLE_END_STRUCTURE);
+  CopyMem (BufferPointer + RecordSize, BufferPointer, sizeof (EFI_SMBIOS_TABLE_END_STRUCTURE));
+  CopyMem (BufferPointer, SmbiosEntry->RecordHeader + 1, RecordSize);
+
+  EntryPointStructure->NumberOfSmbiosStructures++;
+  EntryPointStructure->TableLength = (UINT16) (EntryPointStructure->TableLength + RecordSize);
+  if (RecordSize > EntryPointStructure->MaxStructureSize) {
+    EntryPointStructure->MaxStructureSize = (UINT16) RecordSize;
+  }
+
+  //
+  // Fixup checksums in the Entry Point Structure
+  //
+  EntryPointStructure->IntermediateChecksum = 0;
+  EntryPointStructure->EntryPointStructureChecksum = 0;
+
+  EntryPointStructure->IntermediateChecksum =
+    CalculateCheckSum8 ((UINT8 *) EntryPointStructure + 0x10, EntryPointStructure->EntryPointLength - 0x10);
+  EntryPointStructure->EntryPointStructureChecksum =
+    CalculateCheckSum8 ((UINT8 *) EntryPointStructure, EntryPointStructure->EntryPointLength);
+
+  *TableEntryPointStructure = EntryPointStructure;
+  return EFI_SUCCESS;
+}
+
+/**
+  Append the record of a new SMBIOS entry to the SMBIOS 64-bit table in place.
+
+  The table must have been assembled from all the other entries and have room
+  left in its allocated pages for the record.
+
+  @param  SmbiosEntry                The SMBIOS entry at the tail of the record list.
+  @param  TableEntryPointStructure   On exit, points to the SMBIOS entrypoint structure.
+
+  @retval EFI_SUCCESS                The record was appended.
+  @retval EFI_BUFFER_TOO_SMALL       The table must be assembled again.
+
+**/
+EFI_STATUS
+SmbiosAppend64BitTableRecord (
+  IN  EFI_SMBIOS_ENTRY  *SmbiosEntry,
+  OUT VOID              **TableEntryPointStructure
+  )
+{
+  UINT8       *BufferPointer;
+  UINTN       RecordSize;
+
+  RecordSize = SmbiosEntry->RecordHeader->RecordSize - sizeof (EFI_SMBIOS_RECORD_HEADER);
+  if ((Smbios30EntryPointStructure == NULL) || (Smbios30EntryPointStructure->TableAddress == 0) ||
+      (Smbios30EntryPointStructure->TableMaximumSize + RecordSize > EFI_PAGES_TO_SIZE (mPre64BitAllocatedPages))) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  //
+  // Move End-Of-Table structure and put the record in its place
+  //
+  BufferPointer = (UINT8 *) (UINTN) Smbios30EntryPointStructure->TableAddress +
+                  Smbios30EntryPointStructure->TableMaximumSize - sizeof (EFI_SMBIOS_TABLE_END_STRUCTURE);
+  CopyMem (BufferPointer + RecordSize, BufferPointer, sizeof (EFI_SMBIOS_TABLE_END_STRUCTURE));
+  CopyMem (BufferPointer, SmbiosEntry->RecordHeader + 1, RecordSize);
+
+  Smbios30EntryPointStructure->TableMaximumSize = (UINT32) (Smbios30EntryPointStructure->TableMaximumSize + RecordSize);
+
+  //
+  // Fixup checksums in the Entry Point Structure
+  //
+  Smbios30EntryPointStructure->EntryPointStructureChecksum = 0;
+  Smbios30EntryPointStructure->EntryPointStructureChecksum =
+    CalculateCheckSum8 ((UINT8 *) Smbios30EntryPointStructure, Smbios30EntryPointStructure->EntryPointLength);
+
+  *TableEntryPointStructure = Smbios30EntryPointStructure;
+  return EFI_SUCCESS;
+}
+
+/**
+  Add the record of a new SMBIOS entry to the Smbios Tables it belongs to and
+  installs the Smbios Tables to the System Table.
+
+  The record is appended in place when possible, otherwise the whole table is
+  created again.
+
+  @param  SmbiosEntry    The SMBIOS entry at the tail of the record list.
+
+**/
+VOID
+SmbiosTableAppend (
+  IN EFI_SMBIOS_ENTRY  *SmbiosEntry
+  )
+{
+  UINT8       *Eps;
+  UINT8       *Eps64Bit;
+  EFI_STATUS  Status;
+
+  if (SmbiosEntry->Smbios32BitTable) {
+    Status = SmbiosAppendTableRecord (SmbiosEntry, (VOID **) &Eps);
+    if (EFI_ERROR (Status)) {
+      Status = SmbiosCreateTable ((VOID **) &Eps);
+    }
+    if (!EFI_ERROR (Status)) {
+      gBS->InstallConfigurationTable (&gEfiSmbiosTableGuid, Eps);
+    }
+  }
+
+  if (SmbiosEntry->Smbios64BitTable) {
+    Status = SmbiosAppend64BitTableRecord (SmbiosEntry, (VOID **) &Eps64Bit);
+    if (EFI_ERROR (Status)) {
+      Status = SmbiosCreate64BitTable ((VOID **) &Eps64Bit);
+    }
+    if (!EFI_ERROR (Status)) {
+      gBS->InstallConfigurationTable (&gEfiSmbios3TableGuid, Eps64Bit);
+    }
+  }
+}
+
 /**
   Validates a SMBIOS 2.0 table entry point.
 
@@ -1717,6 +1963,7 @@ SmbiosDriverEntryPoint (
   )
 {
   EFI_STATUS            Status;
+  UINTN                 Index;
 
   mPrivateData.Signature                = SMBIOS_INSTANCE_SIGNATURE;
   mPrivateData.Smbios.Add               = SmbiosAdd;
@@ -1727,7 +1974,9 @@ SmbiosDriverEntryPoint (
   mPrivateData.Smbios.MinorVersion      = (UINT8) (PcdGet16 (PcdSmbiosVersion) & 0x00ff);
 
   InitializeListHead (&mPrivateData.DataListHead);
-  InitializeListHead (&mPrivateData.AllocatedHandleListHead);
+  for (Index = 0; Index < SMBIOS_TYPE_COUNT; Index++) {
+    InitializeListHead (&mPrivateData.TypeListHead[Index]);
+  }
   EfiInitializeLock (&mPrivateData.DataLock, TPL_NOTIFY);
 
   //
@@ -27,6 +27,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/HobLib.h>
 #include <UniversalPayload/SmbiosTable.h>
 
+//
+// Size of the bitmap of allocated SMBIOS handles, and number of SMBIOS types.
+//
+#define SMBIOS_HANDLE_BITMAP_SIZE  ((MAX_UINT16 + 1) / 8)
+#define SMBIOS_TYPE_COUNT          (MAX_UINT8 + 1)
+
 #define SMBIOS_INSTANCE_SIGNATURE SIGNATURE_32 ('S', 'B', 'i', 's')
 typedef struct {
   UINT32                Signature;
@@ -44,9 +50,22 @@ typedef struct {
   //
   LIST_ENTRY            DataListHead;
   //
-  // List of allocated SMBIOS handle.
+  // Bitmap of allocated SMBIOS handles. All handles below FirstFreeHandle
+  // are allocated.
+  //
+  UINT8                 AllocatedHandleBitmap[SMBIOS_HANDLE_BITMAP_SIZE];
+  EFI_SMBIOS_HANDLE     FirstFreeHandle;
+  //
+  // Lists of EFI_SMBIOS_ENTRY structures of each SMBIOS type, in the same
+  // order as in DataListHead.
+  //
+  LIST_ENTRY            TypeListHead[SMBIOS_TYPE_COUNT];
   //
-  LIST_ENTRY            AllocatedHandleListHead;
+  // Link of the EFI_SMBIOS_ENTRY returned by the last GetNext() call, so a
+  // walk through the records doesn't search its start point from the list
+  // head each time. NULL if there is none.
+  //
+  LIST_ENTRY            *GetNextLink;
 } SMBIOS_INSTANCE;
 
 #define SMBIOS_INSTANCE_FROM_THIS(this)  CR (this, SMBIOS_INSTANCE, Smbios, SMBIOS_INSTANCE_SIGNATURE)
@@ -76,6 +95,10 @@ typedef struct {
 typedef struct {
   UINT32                    Signature;
   LIST_ENTRY                Link;
+  //
+  // Link in the list of the entries of the same SMBIOS type.
+  //
+  LIST_ENTRY                TypeLink;
   EFI_SMBIOS_RECORD_HEADER  *RecordHeader;
   UINTN                     RecordSize;
   //
@@ -86,23 +109,7 @@ typedef struct {
 } EFI_SMBIOS_ENTRY;
 
 #define SMBIOS_ENTRY_FROM_LINK(link)  CR (link, EFI_SMBIOS_ENTRY, Link, EFI_SMBIOS_ENTRY_SIGNATURE)
-
-//
-// Private data to contain the Smbios handle that already allocated.
-//
-#define SMBIOS_HANDLE_ENTRY_SIGNATURE  SIGNATURE_32 ('S', 'h', 'r', 'd')
-
-typedef struct {
-  UINT32               Signature;
-  LIST_ENTRY           Link;
-  //
-  // Filter driver will register what record guid filter should be used.
-  //
-  EFI_SMBIOS_HANDLE    SmbiosHandle;
-
-} SMBIOS_HANDLE_ENTRY;
-
-#define SMBIOS_HANDLE_ENTRY_FROM_LINK(link)  CR (link, SMBIOS_HANDLE_ENTRY, Link, SMBIOS_HANDLE_ENTRY_SIGNATURE)
+#define SMBIOS_ENTRY_FROM_TYPE_LINK(link)  CR (link, EFI_SMBIOS_ENTRY, TypeLink, EFI_SMBIOS_ENTRY_SIGNATURE)
 
 typedef struct {
   EFI_SMBIOS_TABLE_HEADER  Header;
@@ -124,41 +131,18 @@ SmbiosTableConstruction (
   );
 
 /**
-  Validates a SMBIOS 3.0 table entry point.
-
-  @param  TableEntry       The SmBios table entry to validate.
-  @param  TableAddress     On exit, point to the smbios table addres.
-  @param  TableMaximumSize On exit, point to the maximum size of the table.
-
-  @retval TRUE           SMBIOS table entry point is valid.
-  @retval FALSE          SMBIOS table entry point is malformed.
-
-**/
-STATIC
-BOOLEAN
-IsValidSmbios30Table (
-  IN  VOID               *TableEntry,
-  OUT VOID               **TableAddress,
-  OUT UINTN              *TableMaximumSize
-  );
-
-/**
-  Validates a SMBIOS 2.0 table entry point.
+  Add the record of a new SMBIOS entry to the Smbios Tables it belongs to and
+  installs the Smbios Tables to the System Table.
 
-  @param  TableEntry       The SmBios table entry to validate.
-  @param  TableAddress     On exit, point to the smbios table addres.
-  @param  TableMaximumSize On exit, point to the maximum size of the table.
+  The record is appended in place when possible, otherwise the whole table is
+  created again.
 
-  @retval TRUE           SMBIOS table entry point is valid.
-  @retval FALSE          SMBIOS table entry point is malformed.
+  @param  SmbiosEntry    The SMBIOS entry at the tail of the record list.
 
 **/
-STATIC
-BOOLEAN
-IsValidSmbios20Table (
-  IN  VOID               *TableEntry,
-  OUT VOID               **TableAddress,
-  OUT UINTN              *TableMaximumSize
+VOID
+SmbiosTableAppend (
+  IN EFI_SMBIOS_ENTRY  *SmbiosEntry
   );
 
 /**
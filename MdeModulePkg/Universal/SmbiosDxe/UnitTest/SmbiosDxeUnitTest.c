@@ -0,0 +1,702 @@
+/** @file
+  Host-based unit tests and benchmarks for SmbiosDxe.
+
+  The driver sources are built into the test and the driver entry point runs
+  against mocked boot services. The tables the driver installs are compared
+  with the tables SmbiosTableConstruction() assembles from all the records.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "SmbiosDxe.h"
+#include <Library/PrintLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "SmbiosDxe Unit Test"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define SMBIOS_RECORD_COUNT            3000
+#define SMBIOS_BENCHMARK_RECORD_COUNT  10000
+#define SMBIOS_REBUILD_RECORD_COUNT    2000
+#define TEST_PAGE_POOL_PAGES           256
+
+///=== CODE UNDER TEST ===========================================================================
+
+extern SMBIOS_INSTANCE                    mPrivateData;
+extern SMBIOS_TABLE_ENTRY_POINT           *EntryPointStructure;
+extern SMBIOS_TABLE_3_0_ENTRY_POINT       *Smbios30EntryPointStructure;
+
+EFI_STATUS
+EFIAPI
+SmbiosDriverEntryPoint (
+  IN EFI_HANDLE           ImageHandle,
+  IN EFI_SYSTEM_TABLE     *SystemTable
+  );
+
+///=== DRIVER DEPENDENCIES =======================================================================
+
+//
+// The SMBIOS 2.x entry point holds a 32-bit table address, so the pages below
+// 4GB the driver asks for come from a pool in the test image.
+//
+STATIC UINT8  mPagePool[EFI_PAGES_TO_SIZE (TEST_PAGE_POOL_PAGES + 1)];
+STATIC UINTN  mPagePoolUsed;
+
+//
+// The tables installed last.
+//
+STATIC VOID   *mInstalledSmbiosTable;
+STATIC VOID   *mInstalledSmbios3Table;
+
+/**
+  Allocate pages from the test pool when they have to be below 4GB, and from
+  the host heap otherwise. Pages from the test pool are never given back.
+
+  @param[in]      Type          The type of allocation to perform.
+  @param[in]      MemoryType    The type of memory to allocate.
+  @param[in]      Pages         The number of contiguous 4 KB pages to allocate.
+  @param[in, out] Memory        The address of the allocated pages.
+
+  @retval EFI_SUCCESS           The pages were allocated.
+  @retval EFI_OUT_OF_RESOURCES  The pages could not be allocated.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockAllocatePages (
+  IN     EFI_ALLOCATE_TYPE            Type,
+  IN     EFI_MEMORY_TYPE              MemoryType,
+  IN     UINTN                        Pages,
+  IN OUT EFI_PHYSICAL_ADDRESS         *Memory
+  )
+{
+  UINTN  Base;
+  VOID   *Buffer;
+
+  if (Type == AllocateAnyPages) {
+    Buffer = AllocatePages (Pages);
+    if (Buffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    *Memory = (UINTN) Buffer;
+    return EFI_SUCCESS;
+  }
+
+  Base = ALIGN_VALUE ((UINTN) mPagePool, EFI_PAGE_SIZE);
+  if ((mPagePoolUsed + Pages > TEST_PAGE_POOL_PAGES) ||
+      (Base + EFI_PAGES_TO_SIZE (mPagePoolUsed + Pages) - 1 > *Memory)) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  *Memory = Base + EFI_PAGES_TO_SIZE (mPagePoolUsed);
+  mPagePoolUsed += Pages;
+  return EFI_SUCCESS;
+}
+
+/**
+  Remember the SMBIOS tables the driver installs.
+
+  @param[in] Guid       The GUID of the configuration table.
+  @param[in] Table      The configuration table.
+
+  @retval EFI_SUCCESS   The table was recorded.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockInstallConfigurationTable (
+  IN EFI_GUID                 *Guid,
+  IN VOID                     *Table
+  )
+{
+  if (CompareGuid (Guid, &gEfiSmbiosTableGuid)) {
+    mInstalledSmbiosTable = Table;
+  } else if (CompareGuid (Guid, &gEfiSmbios3TableGuid)) {
+    mInstalledSmbios3Table = Table;
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Accept the SMBIOS protocol without installing it anywhere.
+
+  @param[in, out] Handle          The handle to install the protocol on.
+  @param[in]      Protocol        The GUID of the protocol.
+  @param[in]      InterfaceType   The interface type.
+  @param[in]      Interface       The protocol interface.
+
+  @retval EFI_SUCCESS   The protocol was accepted.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockInstallProtocolInterface (
+  IN OUT EFI_HANDLE               *Handle,
+  IN     EFI_GUID                 *Protocol,
+  IN     EFI_INTERFACE_TYPE       InterfaceType,
+  IN     VOID                     *Interface
+  )
+{
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_BOOT_SERVICES  mMockBootServices;
+EFI_BOOT_SERVICES         *gBS = &mMockBootServices;
+
+EFI_LOCK *
+EFIAPI
+EfiInitializeLock (
+  IN OUT EFI_LOCK  *Lock,
+  IN EFI_TPL       Priority
+  )
+{
+  Lock->Tpl       = Priority;
+  Lock->OwnerTpl  = TPL_APPLICATION;
+  Lock->Lock      = EfiLockReleased;
+  return Lock;
+}
+
+EFI_STATUS
+EFIAPI
+EfiAcquireLockOrFail (
+  IN EFI_LOCK  *Lock
+  )
+{
+  if (Lock->Lock == EfiLockAcquired) {
+    return EFI_ACCESS_DENIED;
+  }
+  Lock->Lock = EfiLockAcquired;
+  return EFI_SUCCESS;
+}
+
+VOID
+EFIAPI
+EfiReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockAcquired);
+  Lock->Lock = EfiLockReleased;
+}
+
+//
+// There is no SMBIOS table from a previous boot phase.
+//
+VOID *
+EFIAPI
+GetFirstGuidHob (
+  IN CONST EFI_GUID         *Guid
+  )
+{
+  return NULL;
+}
+
+///=== TEST DATA ==================================================================================
+
+//
+// The record types used by the tests, in the order records are added.
+//
+STATIC CONST EFI_SMBIOS_TYPE  mRecordTypes[] = {
+  EFI_SMBIOS_TYPE_MEMORY_DEVICE,
+  EFI_SMBIOS_TYPE_SYSTEM_SLOTS,
+  EFI_SMBIOS_TYPE_MEMORY_DEVICE,
+  EFI_SMBIOS_TYPE_PROCESSOR_INFORMATION,
+  EFI_SMBIOS_TYPE_CACHE_INFORMATION,
+  EFI_SMBIOS_TYPE_ONBOARD_DEVICES_EXTENDED_INFORMATION,
+  EFI_SMBIOS_TYPE_MEMORY_DEVICE
+};
+
+#pragma pack(1)
+typedef struct {
+  EFI_SMBIOS_TABLE_HEADER  Header;
+  SMBIOS_TABLE_STRING      Name;
+  UINT8                    Instance[7];
+  CHAR8                    Strings[32];
+} TEST_SMBIOS_RECORD;
+#pragma pack()
+
+/**
+  Add a record with one string, of the type the record index selects.
+
+  @param[in]      Index         The index of the record.
+  @param[in, out] SmbiosHandle  The handle of the record, or SMBIOS_HANDLE_PI_RESERVED.
+
+  @return The status of EFI_SMBIOS_PROTOCOL.Add().
+
+**/
+STATIC
+EFI_STATUS
+AddTestRecord (
+  IN     UINTN              Index,
+  IN OUT EFI_SMBIOS_HANDLE  *SmbiosHandle
+  )
+{
+  TEST_SMBIOS_RECORD  Record;
+
+  ZeroMem (&Record, sizeof (Record));
+  Record.Header.Type   = mRecordTypes[Index % ARRAY_SIZE (mRecordTypes)];
+  Record.Header.Length = OFFSET_OF (TEST_SMBIOS_RECORD, Strings);
+  Record.Name          = 1;
+  Record.Instance[0]   = (UINT8) Index;
+  Record.Instance[1]   = (UINT8) (Index >> 8);
+  AsciiSPrint (Record.Strings, sizeof (Record.Strings), "Device %d", Index);
+
+  return mPrivateData.Smbios.Add (&mPrivateData.Smbios, NULL, SmbiosHandle, &Record.Header);
+}
+
+/**
+  Free all the records and assemble the empty tables. Remove() assembles the
+  tables again for each record, which takes long with thousands of records.
+
+  @param[in] Context    Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+RemoveAllRecords (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_SMBIOS_ENTRY  *SmbiosEntry;
+
+  while (!IsListEmpty (&mPrivateData.DataListHead)) {
+    SmbiosEntry = SMBIOS_ENTRY_FROM_LINK (mPrivateData.DataListHead.ForwardLink);
+    RemoveEntryList (&SmbiosEntry->Link);
+    RemoveEntryList (&SmbiosEntry->TypeLink);
+    FreePool (SmbiosEntry);
+  }
+  ZeroMem (mPrivateData.AllocatedHandleBitmap, sizeof (mPrivateData.AllocatedHandleBitmap));
+  mPrivateData.FirstFreeHandle = 0;
+  mPrivateData.GetNextLink     = NULL;
+
+  SmbiosTableConstruction (TRUE, TRUE);
+  mInstalledSmbiosTable  = NULL;
+  mInstalledSmbios3Table = NULL;
+}
+
+/**
+  Run the driver entry point once for all the tests.
+
+**/
+STATIC
+VOID
+EFIAPI
+InitializeTestSmbios (
+  VOID
+  )
+{
+  if (mPrivateData.Signature != SMBIOS_INSTANCE_SIGNATURE) {
+    mMockBootServices.AllocatePages             = MockAllocatePages;
+    mMockBootServices.InstallProtocolInterface  = MockInstallProtocolInterface;
+    mMockBootServices.InstallConfigurationTable = MockInstallConfigurationTable;
+    SmbiosDriverEntryPoint (NULL, NULL);
+  }
+}
+
+/**
+  Check that the installed tables are the tables assembled again from all the
+  records.
+
+  @retval UNIT_TEST_PASSED              The tables match.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The tables differ.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+VerifyTablesMatchRebuild (
+  VOID
+  )
+{
+  SMBIOS_TABLE_ENTRY_POINT      Eps;
+  SMBIOS_TABLE_3_0_ENTRY_POINT  Eps64Bit;
+  UINT8                         *Table;
+  UINT8                         *Table64Bit;
+
+  UT_ASSERT_NOT_NULL (mInstalledSmbiosTable);
+  UT_ASSERT_NOT_NULL (mInstalledSmbios3Table);
+  UT_ASSERT_TRUE (mInstalledSmbiosTable == EntryPointStructure);
+  UT_ASSERT_TRUE (mInstalledSmbios3Table == Smbios30EntryPointStructure);
+
+  CopyMem (&Eps, EntryPointStructure, sizeof (Eps));
+  CopyMem (&Eps64Bit, Smbios30EntryPointStructure, sizeof (Eps64Bit));
+  Table      = AllocateCopyPool (Eps.TableLength, (VOID *) (UINTN) Eps.TableAddress);
+  Table64Bit = AllocateCopyPool (Eps64Bit.TableMaximumSize, (VOID *) (UINTN) Eps64Bit.TableAddress);
+  UT_ASSERT_NOT_NULL (Table);
+  UT_ASSERT_NOT_NULL (Table64Bit);
+
+  SmbiosTableConstruction (TRUE, TRUE);
+
+  UT_ASSERT_MEM_EQUAL (&Eps, EntryPointStructure, sizeof (Eps));
+  UT_ASSERT_MEM_EQUAL (&Eps64Bit, Smbios30EntryPointStructure, sizeof (Eps64Bit));
+  UT_ASSERT_MEM_EQUAL (Table, (VOID *) (UINTN) EntryPointStructure->TableAddress, Eps.TableLength);
+  UT_ASSERT_MEM_EQUAL (Table64Bit, (VOID *) (UINTN) Smbios30EntryPointStructure->TableAddress, Eps64Bit.TableMaximumSize);
+
+  FreePool (Table);
+  FreePool (Table64Bit);
+  return UNIT_TEST_PASSED;
+}
+
+///=== TEST CASES =================================================================================
+
+/**
+  The tables built by appending records in place must be the tables
+  assembled from all the records, also after strings were updated and records
+  were removed. The records don't all fit in the 32-bit table.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+TablesShouldMatchFullRebuild (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS         Status;
+  EFI_SMBIOS_HANDLE  SmbiosHandle;
+  UINTN              Index;
+  UINTN              StringNumber;
+  UNIT_TEST_STATUS   TestStatus;
+
+  for (Index = 0; Index < SMBIOS_RECORD_COUNT; Index++) {
+    SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+    Status = AddTestRecord (Index, &SmbiosHandle);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_EQUAL (SmbiosHandle, Index);
+    if (Index % 500 == 0) {
+      TestStatus = VerifyTablesMatchRebuild ();
+      UT_ASSERT_EQUAL (TestStatus, UNIT_TEST_PASSED);
+    }
+  }
+  UT_ASSERT_TRUE (EntryPointStructure->NumberOfSmbiosStructures < SMBIOS_RECORD_COUNT);
+  TestStatus = VerifyTablesMatchRebuild ();
+  UT_ASSERT_EQUAL (TestStatus, UNIT_TEST_PASSED);
+
+  //
+  // A longer string moves the record out of the 32-bit table when it is full.
+  //
+  StringNumber = 1;
+  for (Index = 0; Index < SMBIOS_RECORD_COUNT; Index += 97) {
+    SmbiosHandle = (EFI_SMBIOS_HANDLE) Index;
+    Status = mPrivateData.Smbios.UpdateString (&mPrivateData.Smbios, &SmbiosHandle, &StringNumber, "Renamed Device");
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+  }
+  TestStatus = VerifyTablesMatchRebuild ();
+  UT_ASSERT_EQUAL (TestStatus, UNIT_TEST_PASSED);
+
+  for (Index = 0; Index < SMBIOS_RECORD_COUNT; Index += 13) {
+    Status = mPrivateData.Smbios.Remove (&mPrivateData.Smbios, (EFI_SMBIOS_HANDLE) Index);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+  }
+  for (Index = 0; Index < SMBIOS_RECORD_COUNT; Index += 13) {
+    SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+    Status = AddTestRecord (Index, &SmbiosHandle);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+  }
+  TestStatus = VerifyTablesMatchRebuild ();
+  UT_ASSERT_EQUAL (TestStatus, UNIT_TEST_PASSED);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Added records must get the lowest free handle, and a handle in use must be
+  refused.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+HandlesShouldBeAllocatedLowestFirst (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS         Status;
+  EFI_SMBIOS_HANDLE  SmbiosHandle;
+  UINTN              Index;
+
+  for (Index = 0; Index < 100; Index++) {
+    SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+    Status = AddTestRecord (Index, &SmbiosHandle);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_EQUAL (SmbiosHandle, Index);
+  }
+
+  SmbiosHandle = 50;
+  Status = AddTestRecord (0, &SmbiosHandle);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_ALREADY_STARTED);
+
+  SmbiosHandle = 200;
+  Status = AddTestRecord (0, &SmbiosHandle);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  Status = mPrivateData.Smbios.Remove (&mPrivateData.Smbios, 30);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  Status = mPrivateData.Smbios.Remove (&mPrivateData.Smbios, 10);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+  Status = AddTestRecord (0, &SmbiosHandle);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (SmbiosHandle, 10);
+
+  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+  Status = AddTestRecord (0, &SmbiosHandle);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (SmbiosHandle, 30);
+
+  for (Index = 100; Index < 200; Index++) {
+    SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+    Status = AddTestRecord (Index, &SmbiosHandle);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_EQUAL (SmbiosHandle, Index);
+  }
+
+  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+  Status = AddTestRecord (0, &SmbiosHandle);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (SmbiosHandle, 201);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  GetNext() with a type filter must return the records a walk through all the
+  records finds, from any start record.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+GetNextByTypeShouldMatchFullWalk (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS               Status;
+  EFI_SMBIOS_HANDLE        SmbiosHandle;
+  EFI_SMBIOS_HANDLE        TypeHandle;
+  EFI_SMBIOS_HANDLE        ExpectedHandle;
+  EFI_SMBIOS_TABLE_HEADER  *Record;
+  EFI_SMBIOS_TYPE          Type;
+  UINTN                    Index;
+  UINTN                    TypeIndex;
+
+  for (Index = 0; Index < SMBIOS_RECORD_COUNT; Index++) {
+    SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+    Status = AddTestRecord (Index, &SmbiosHandle);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+  }
+  for (Index = 5; Index < SMBIOS_RECORD_COUNT; Index += 11) {
+    Status = mPrivateData.Smbios.Remove (&mPrivateData.Smbios, (EFI_SMBIOS_HANDLE) Index);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+  }
+
+  for (TypeIndex = 0; TypeIndex < ARRAY_SIZE (mRecordTypes); TypeIndex++) {
+    Type = mRecordTypes[TypeIndex];
+
+    //
+    // Walk the records of the type alongside all the records.
+    //
+    SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+    TypeHandle   = SMBIOS_HANDLE_PI_RESERVED;
+    while (TRUE) {
+      do {
+        Status = mPrivateData.Smbios.GetNext (&mPrivateData.Smbios, &SmbiosHandle, NULL, &Record, NULL);
+      } while (!EFI_ERROR (Status) && Record->Type != Type);
+      ExpectedHandle = SmbiosHandle;
+
+      Status = mPrivateData.Smbios.GetNext (&mPrivateData.Smbios, &TypeHandle, &Type, &Record, NULL);
+      UT_ASSERT_EQUAL (TypeHandle, ExpectedHandle);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+      UT_ASSERT_EQUAL (Record->Type, Type);
+      UT_ASSERT_EQUAL (Record->Handle, TypeHandle);
+    }
+
+    //
+    // Start from records of other types.
+    //
+    for (Index = 0; Index < SMBIOS_RECORD_COUNT; Index += 37) {
+      if ((Index % 11) == 5) {
+        continue;
+      }
+      SmbiosHandle = (EFI_SMBIOS_HANDLE) Index;
+      do {
+        Status = mPrivateData.Smbios.GetNext (&mPrivateData.Smbios, &SmbiosHandle, NULL, &Record, NULL);
+      } while (!EFI_ERROR (Status) && Record->Type != Type);
+      ExpectedHandle = SmbiosHandle;
+
+      TypeHandle = (EFI_SMBIOS_HANDLE) Index;
+      Status = mPrivateData.Smbios.GetNext (&mPrivateData.Smbios, &TypeHandle, &Type, &Record, NULL);
+      UT_ASSERT_EQUAL (TypeHandle, ExpectedHandle);
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Benchmark: time adding records and walking the records of one type, and
+  compare with assembling the tables again after each added record, which is
+  what Add() did before records were appended in place.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BenchmarkSmbiosAdd (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS               Status;
+  EFI_SMBIOS_HANDLE        SmbiosHandle;
+  EFI_SMBIOS_TABLE_HEADER  *Record;
+  EFI_SMBIOS_TYPE          Type;
+  UINTN                    Index;
+  UINTN                    Count;
+  clock_t                  Start;
+  clock_t                  FirstAddTicks;
+  clock_t                  AddTicks;
+  clock_t                  WalkTicks;
+  clock_t                  RebuildTicks;
+
+  Start = clock ();
+  for (Index = 0; Index < SMBIOS_BENCHMARK_RECORD_COUNT; Index++) {
+    if (Index == SMBIOS_REBUILD_RECORD_COUNT) {
+      FirstAddTicks = clock () - Start;
+    }
+    SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+    Status = AddTestRecord (Index, &SmbiosHandle);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+  }
+  AddTicks = clock () - Start;
+
+  Type         = EFI_SMBIOS_TYPE_SYSTEM_SLOTS;
+  Count        = 0;
+  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+  Start = clock ();
+  while (!EFI_ERROR (mPrivateData.Smbios.GetNext (&mPrivateData.Smbios, &SmbiosHandle, &Type, &Record, NULL))) {
+    Count++;
+  }
+  WalkTicks = clock () - Start;
+  UT_ASSERT_EQUAL (Count, (SMBIOS_BENCHMARK_RECORD_COUNT + ARRAY_SIZE (mRecordTypes) - 2) / ARRAY_SIZE (mRecordTypes));
+
+  RemoveAllRecords (NULL);
+
+  Start = clock ();
+  for (Index = 0; Index < SMBIOS_REBUILD_RECORD_COUNT; Index++) {
+    SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+    Status = AddTestRecord (Index, &SmbiosHandle);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    SmbiosTableConstruction (TRUE, TRUE);
+  }
+  RebuildTicks = clock () - Start;
+
+  UT_LOG_INFO (
+    "Add %d records: %d us; walk %d records of one type: %d us\n",
+    SMBIOS_BENCHMARK_RECORD_COUNT,
+    (int) ((UINT64) AddTicks * 1000000 / CLOCKS_PER_SEC),
+    Count,
+    (int) ((UINT64) WalkTicks * 1000000 / CLOCKS_PER_SEC)
+    );
+  UT_LOG_INFO (
+    "Add %d records: %d us; add them and assemble the tables after each: %d us\n",
+    SMBIOS_REBUILD_RECORD_COUNT,
+    (int) ((UINT64) FirstAddTicks * 1000000 / CLOCKS_PER_SEC),
+    (int) ((UINT64) RebuildTicks * 1000000 / CLOCKS_PER_SEC)
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
+///=== TEST ENGINE ================================================================================
+
+/**
+  Initialize the unit test framework, suite, and unit tests for SmbiosDxe and
+  run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      SmbiosTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&SmbiosTests, Framework, "SMBIOS Record Tests", "SmbiosDxe.Records", InitializeTestSmbios, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for the SMBIOS record tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+  AddTestCase (SmbiosTests, "Tables should match a full rebuild", "TableAppend", TablesShouldMatchFullRebuild, NULL, RemoveAllRecords, NULL);
+  AddTestCase (SmbiosTests, "Handles should be allocated lowest first", "HandleBitmap", HandlesShouldBeAllocatedLowestFirst, NULL, RemoveAllRecords, NULL);
+  AddTestCase (SmbiosTests, "GetNext by type should match a full walk", "TypeIndex", GetNextByTypeShouldMatchFullWalk, NULL, RemoveAllRecords, NULL);
+  AddTestCase (SmbiosTests, "Time adding records", "AddBenchmark", BenchmarkSmbiosAdd, NULL, RemoveAllRecords, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
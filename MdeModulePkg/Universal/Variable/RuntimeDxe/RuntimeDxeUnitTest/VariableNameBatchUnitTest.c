@@ -0,0 +1,767 @@
+/** @file
+  Host-based unit test and SMI count benchmark for the batched variable name
+  enumeration of VariableSmmRuntimeDxe.
+
+  The MM communication protocol is replaced by a mock which implements
+  SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAME and
+  SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAMES over an in-memory variable list
+  the same way VariableSmm.c does, and counts the SMIs.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include <PiDxe.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MmUnblockMemoryLib.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiRuntimeLib.h>
+#include <Library/UnitTestLib.h>
+
+#include <Protocol/MmCommunication2.h>
+#include <Guid/SmmVariableCommon.h>
+
+#define UNIT_TEST_APP_NAME     "VariableSmmRuntimeDxe Variable Name Batch Unit Test"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+//
+// Payload size of the communicate buffer, the default PcdMaxVariableSize.
+//
+#define MOCK_PAYLOAD_SIZE         0x400
+#define MOCK_MAX_NAME_LENGTH      16
+#define MOCK_VARIABLE_COUNT       200
+#define BENCHMARK_VARIABLE_COUNT  1000
+
+///=== CODE UNDER TEST ===========================================================================
+
+extern EFI_MM_COMMUNICATION2_PROTOCOL  *mMmCommunication2;
+extern UINT8                           *mVariableBuffer;
+extern UINT8                           *mVariableBufferPhysical;
+extern UINTN                           mVariableBufferSize;
+extern UINTN                           mVariableBufferPayloadSize;
+extern UINT8                           *mVariableNameBatch;
+extern UINTN                           mVariableNameBatchCount;
+
+EFI_STATUS
+EFIAPI
+RuntimeServiceGetNextVariableName (
+  IN OUT  UINTN                             *VariableNameSize,
+  IN OUT  CHAR16                            *VariableName,
+  IN OUT  EFI_GUID                          *VendorGuid
+  );
+
+EFI_STATUS
+EFIAPI
+RuntimeServiceSetVariable (
+  IN CHAR16                                 *VariableName,
+  IN EFI_GUID                               *VendorGuid,
+  IN UINT32                                 Attributes,
+  IN UINTN                                  DataSize,
+  IN VOID                                   *Data
+  );
+
+///=== DRIVER DEPENDENCIES =======================================================================
+
+EFI_BOOT_SERVICES     *gBS;
+EFI_RUNTIME_SERVICES  *gRT;
+
+BOOLEAN
+EFIAPI
+EfiAtRuntime (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+EFI_STATUS
+EFIAPI
+EfiConvertPointer (
+  IN UINTN                  DebugDisposition,
+  IN OUT VOID               **Address
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+EFI_LOCK *
+EFIAPI
+EfiInitializeLock (
+  IN OUT EFI_LOCK  *Lock,
+  IN EFI_TPL        Priority
+  )
+{
+  return Lock;
+}
+
+VOID
+EFIAPI
+EfiAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+}
+
+VOID
+EFIAPI
+EfiReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+}
+
+EFI_EVENT
+EFIAPI
+EfiCreateProtocolNotifyEvent (
+  IN  EFI_GUID          *ProtocolGuid,
+  IN  EFI_TPL           NotifyTpl,
+  IN  EFI_EVENT_NOTIFY  NotifyFunction,
+  IN  VOID              *NotifyContext,  OPTIONAL
+  OUT VOID              **Registration
+  )
+{
+  return NULL;
+}
+
+EFI_STATUS
+EFIAPI
+EfiCreateEventLegacyBootEx (
+  IN  EFI_TPL           NotifyTpl,
+  IN  EFI_EVENT_NOTIFY  NotifyFunction,  OPTIONAL
+  IN  VOID              *NotifyContext,  OPTIONAL
+  OUT EFI_EVENT         *LegacyBootEvent
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+EFI_STATUS
+EFIAPI
+EfiCreateEventReadyToBootEx (
+  IN  EFI_TPL           NotifyTpl,
+  IN  EFI_EVENT_NOTIFY  NotifyFunction,  OPTIONAL
+  IN  VOID              *NotifyContext,  OPTIONAL
+  OUT EFI_EVENT         *ReadyToBootEvent
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+EFI_STATUS
+EFIAPI
+MmUnblockMemoryRequest (
+  IN PHYSICAL_ADDRESS       UnblockAddress,
+  IN UINT64                 NumberOfPages
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+VOID
+EFIAPI
+SecureBootHook (
+  IN CHAR16                                 *VariableName,
+  IN EFI_GUID                               *VendorGuid
+  )
+{
+}
+
+VOID
+EFIAPI
+RecordSecureBootPolicyVarData (
+  VOID
+  )
+{
+}
+
+EFI_STATUS
+EFIAPI
+VariablePolicySmmDxeMain (
+  IN    EFI_HANDLE                  ImageHandle,
+  IN    EFI_SYSTEM_TABLE            *SystemTable
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+///=== MOCK SMM VARIABLE DRIVER ==================================================================
+
+typedef struct {
+  EFI_GUID    Guid;
+  CHAR16      Name[MOCK_MAX_NAME_LENGTH];
+} MOCK_VARIABLE;
+
+STATIC MOCK_VARIABLE  *mMockVariables;
+STATIC UINTN          mMockVariableCount;
+STATIC BOOLEAN        mMockNamesSupported;
+STATIC UINTN          mSmiCount;
+
+STATIC EFI_GUID  mMockGuids[] = {
+  { 0x4c19049f, 0x4137, 0x4dd3, { 0x9c, 0x10, 0x8b, 0x97, 0xa8, 0x3f, 0xfd, 0xfa } },
+  { 0x8be4df61, 0x93ca, 0x11d2, { 0xaa, 0x0d, 0x00, 0xe0, 0x98, 0x03, 0x2b, 0x8c } },
+  { 0xd719b2cb, 0x3d3a, 0x4596, { 0xa3, 0xbc, 0xda, 0xd0, 0x0e, 0x67, 0x65, 0x6f } }
+};
+
+/**
+  GetNextVariableName() over the mock variable list.
+
+  @param[in, out] VariableNameSize   Size of the variable name buffer.
+  @param[in, out] VariableName       Pointer to variable name.
+  @param[in, out] VendorGuid         Variable Vendor Guid.
+
+  @retval EFI_SUCCESS                The next variable was returned.
+  @retval EFI_NOT_FOUND              The input variable is the last one.
+  @retval EFI_INVALID_PARAMETER      The input variable does not exist.
+  @retval EFI_BUFFER_TOO_SMALL       VariableNameSize is too small for the result.
+
+**/
+STATIC
+EFI_STATUS
+MockGetNextVariableName (
+  IN OUT  UINTN                             *VariableNameSize,
+  IN OUT  CHAR16                            *VariableName,
+  IN OUT  EFI_GUID                          *VendorGuid
+  )
+{
+  UINTN  Index;
+  UINTN  NameSize;
+
+  if (VariableName[0] == 0) {
+    Index = 0;
+  } else {
+    for (Index = 0; Index < mMockVariableCount; Index++) {
+      if (CompareGuid (&mMockVariables[Index].Guid, VendorGuid) &&
+          StrCmp (mMockVariables[Index].Name, VariableName) == 0) {
+        break;
+      }
+    }
+    if (Index == mMockVariableCount) {
+      return EFI_INVALID_PARAMETER;
+    }
+    Index++;
+  }
+
+  if (Index == mMockVariableCount) {
+    return EFI_NOT_FOUND;
+  }
+
+  NameSize = StrSize (mMockVariables[Index].Name);
+  if (*VariableNameSize < NameSize) {
+    *VariableNameSize = NameSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *VariableNameSize = NameSize;
+  CopyGuid (VendorGuid, &mMockVariables[Index].Guid);
+  CopyMem (VariableName, mMockVariables[Index].Name, NameSize);
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock of EFI_MM_COMMUNICATION2_PROTOCOL.Communicate() for the SMM variable
+  driver. Each call counts as one SMI.
+
+  @param[in] This                The EFI_MM_COMMUNICATION2_PROTOCOL instance.
+  @param[in, out] CommBufferPhysical  Physical address of the buffer to convey into MMRAM.
+  @param[in, out] CommBufferVirtual   Virtual address of the buffer to convey into MMRAM.
+  @param[in, out] CommSize       The size of the data buffer being passed in.
+
+  @retval EFI_SUCCESS            The message was successfully posted.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockCommunicate (
+  IN CONST EFI_MM_COMMUNICATION2_PROTOCOL   *This,
+  IN OUT VOID                               *CommBufferPhysical,
+  IN OUT VOID                               *CommBufferVirtual,
+  IN OUT UINTN                              *CommSize OPTIONAL
+  )
+{
+  EFI_MM_COMMUNICATE_HEADER                         *SmmCommunicateHeader;
+  SMM_VARIABLE_COMMUNICATE_HEADER                   *SmmVariableFunctionHeader;
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAMES  *GetNextVariableNames;
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME   *GetNextVariableName;
+  UINTN                                             CommBufferPayloadSize;
+  UINTN                                             NameBufferSize;
+  UINTN                                             RecordSize;
+  EFI_STATUS                                        Status;
+
+  mSmiCount++;
+
+  SmmCommunicateHeader      = (EFI_MM_COMMUNICATE_HEADER *) CommBufferVirtual;
+  SmmVariableFunctionHeader = (SMM_VARIABLE_COMMUNICATE_HEADER *) SmmCommunicateHeader->Data;
+  CommBufferPayloadSize     = *CommSize - SMM_COMMUNICATE_HEADER_SIZE - SMM_VARIABLE_COMMUNICATE_HEADER_SIZE;
+
+  switch (SmmVariableFunctionHeader->Function) {
+    case SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAME:
+      GetNextVariableName = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME *) SmmVariableFunctionHeader->Data;
+      Status = MockGetNextVariableName (
+                 &GetNextVariableName->NameSize,
+                 GetNextVariableName->Name,
+                 &GetNextVariableName->Guid
+                 );
+      break;
+
+    case SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAMES:
+      if (!mMockNamesSupported) {
+        Status = EFI_UNSUPPORTED;
+        break;
+      }
+      GetNextVariableNames = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAMES *) SmmVariableFunctionHeader->Data;
+      GetNextVariableName  = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME *) GetNextVariableNames->Names;
+      NameBufferSize       = CommBufferPayloadSize - OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAMES, Names) -
+                             OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME, Name);
+
+      GetNextVariableNames->NameCount = 0;
+      while (TRUE) {
+        GetNextVariableName->NameSize = NameBufferSize;
+        Status = MockGetNextVariableName (
+                   &GetNextVariableName->NameSize,
+                   GetNextVariableName->Name,
+                   &GetNextVariableName->Guid
+                   );
+        if (EFI_ERROR (Status)) {
+          break;
+        }
+        GetNextVariableNames->NameCount++;
+
+        RecordSize = GET_NEXT_VARIABLE_NAMES_RECORD_SIZE (GetNextVariableName->NameSize);
+        if (NameBufferSize < RecordSize + GetNextVariableName->NameSize) {
+          break;
+        }
+        CopyMem (
+          (UINT8 *) GetNextVariableName + RecordSize,
+          GetNextVariableName,
+          OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME, Name) + GetNextVariableName->NameSize
+          );
+        GetNextVariableName = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME *) ((UINT8 *) GetNextVariableName + RecordSize);
+        NameBufferSize     -= RecordSize;
+      }
+      if (GetNextVariableNames->NameCount != 0) {
+        Status = EFI_SUCCESS;
+      }
+      break;
+
+    case SMM_VARIABLE_FUNCTION_SET_VARIABLE:
+      Status = EFI_SUCCESS;
+      break;
+
+    default:
+      Status = EFI_UNSUPPORTED;
+      break;
+  }
+
+  SmmVariableFunctionHeader->ReturnStatus = Status;
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_MM_COMMUNICATION2_PROTOCOL  mMockMmCommunication2 = { MockCommunicate };
+
+/**
+  Fill the mock variable store with variables named L"Var0", L"Var1", ...
+  spread over several vendor GUIDs, so the name sizes grow while enumerating.
+
+  @param[in] Count     The number of variables.
+
+**/
+STATIC
+VOID
+CreateMockVariables (
+  IN UINTN  Count
+  )
+{
+  UINTN  Index;
+  UINTN  Value;
+  UINTN  Digits;
+  UINTN  Digit;
+
+  mMockVariables     = AllocateZeroPool (Count * sizeof (MOCK_VARIABLE));
+  mMockVariableCount = Count;
+  for (Index = 0; Index < Count; Index++) {
+    CopyGuid (&mMockVariables[Index].Guid, &mMockGuids[(Index * ARRAY_SIZE (mMockGuids)) / Count]);
+    StrCpyS (mMockVariables[Index].Name, MOCK_MAX_NAME_LENGTH, L"Var");
+    for (Digits = 1, Value = Index; Value >= 10; Value /= 10) {
+      Digits++;
+    }
+    for (Digit = 0, Value = Index; Digit < Digits; Digit++, Value /= 10) {
+      mMockVariables[Index].Name[3 + Digits - 1 - Digit] = (CHAR16) (L'0' + Value % 10);
+    }
+  }
+}
+
+/**
+  Set up the driver globals to talk to the mock SMM variable driver.
+
+  @param[in] Context    The number of mock variables, cast to UNIT_TEST_CONTEXT.
+
+  @retval UNIT_TEST_PASSED    The driver is ready.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SetUpVariableDriver (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CreateMockVariables ((UINTN) Context);
+  mMockNamesSupported = TRUE;
+  mSmiCount           = 0;
+
+  mVariableBufferPayloadSize = MOCK_PAYLOAD_SIZE;
+  mVariableBufferSize        = SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + mVariableBufferPayloadSize;
+  mVariableBuffer            = AllocateZeroPool (mVariableBufferSize);
+  mVariableBufferPhysical    = mVariableBuffer;
+  mMmCommunication2          = &mMockMmCommunication2;
+  mVariableNameBatch         = AllocateRuntimePool (mVariableBufferPayloadSize);
+  mVariableNameBatchCount    = 0;
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free everything allocated by SetUpVariableDriver().
+
+  @param[in] Context    Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+TearDownVariableDriver (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (mVariableNameBatch != NULL) {
+    FreePool (mVariableNameBatch);
+    mVariableNameBatch = NULL;
+  }
+  mVariableNameBatchCount = 0;
+  FreePool (mVariableBuffer);
+  mVariableBuffer         = NULL;
+  mVariableBufferPhysical = NULL;
+  FreePool (mMockVariables);
+  mMockVariables     = NULL;
+  mMockVariableCount = 0;
+}
+
+/**
+  Enumerate all variables the way a shell "dmpstore" does, starting each call
+  with a buffer just large enough for the current name, so growing names hit
+  EFI_BUFFER_TOO_SMALL and are retried.
+
+  @param[out] TooSmallCount   The number of EFI_BUFFER_TOO_SMALL returns.
+
+  @retval UNIT_TEST_PASSED              All variables were returned in order.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   Enumeration went wrong.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EnumerateAndVerify (
+  OUT UINTN  *TooSmallCount
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      Name[MOCK_MAX_NAME_LENGTH];
+  EFI_GUID    Guid;
+  UINTN       NameSize;
+  UINTN       Index;
+
+  *TooSmallCount = 0;
+  ZeroMem (Name, sizeof (Name));
+  ZeroMem (&Guid, sizeof (Guid));
+
+  for (Index = 0; ; Index++) {
+    NameSize = StrSize (Name);
+    Status   = RuntimeServiceGetNextVariableName (&NameSize, Name, &Guid);
+    if (Status == EFI_BUFFER_TOO_SMALL) {
+      (*TooSmallCount)++;
+      UT_ASSERT_TRUE (NameSize <= sizeof (Name));
+      Status = RuntimeServiceGetNextVariableName (&NameSize, Name, &Guid);
+    }
+    if (Status == EFI_NOT_FOUND) {
+      break;
+    }
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_TRUE (Index < mMockVariableCount);
+    UT_ASSERT_EQUAL (NameSize, StrSize (mMockVariables[Index].Name));
+    UT_ASSERT_MEM_EQUAL (Name, mMockVariables[Index].Name, NameSize);
+    UT_ASSERT_MEM_EQUAL (&Guid, &mMockVariables[Index].Guid, sizeof (Guid));
+  }
+
+  UT_ASSERT_EQUAL (Index, mMockVariableCount);
+  return UNIT_TEST_PASSED;
+}
+
+///=== TEST CASES =================================================================================
+
+/**
+  Batched enumeration returns the same names as one SMI per name, in far
+  fewer SMIs.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BatchShouldMatchSingleNameEnumeration (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  TestStatus;
+  UINTN             TooSmallCount;
+  UINTN             BatchSmiCount;
+  UINTN             SingleSmiCount;
+
+  mSmiCount  = 0;
+  TestStatus = EnumerateAndVerify (&TooSmallCount);
+  UT_ASSERT_EQUAL (TestStatus, UNIT_TEST_PASSED);
+  UT_ASSERT_NOT_NULL (mVariableNameBatch);
+  BatchSmiCount = mSmiCount;
+
+  FreePool (mVariableNameBatch);
+  mVariableNameBatch = NULL;
+
+  mSmiCount  = 0;
+  TestStatus = EnumerateAndVerify (&TooSmallCount);
+  UT_ASSERT_EQUAL (TestStatus, UNIT_TEST_PASSED);
+  SingleSmiCount = mSmiCount;
+
+  //
+  // One SMI per name, one per EFI_BUFFER_TOO_SMALL and one for EFI_NOT_FOUND.
+  //
+  UT_ASSERT_EQUAL (SingleSmiCount, mMockVariableCount + TooSmallCount + 1);
+  UT_ASSERT_TRUE (BatchSmiCount * 10 < SingleSmiCount);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A SMM variable driver without SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAMES
+  makes the driver drop the batch buffer and fall back to one SMI per name.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnsupportedBatchShouldFallBackToSingleName (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  TestStatus;
+  UINTN             TooSmallCount;
+
+  mMockNamesSupported = FALSE;
+
+  mSmiCount  = 0;
+  TestStatus = EnumerateAndVerify (&TooSmallCount);
+  UT_ASSERT_EQUAL (TestStatus, UNIT_TEST_PASSED);
+  UT_ASSERT_TRUE (mVariableNameBatch == NULL);
+
+  //
+  // Only the first call tries SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAMES.
+  //
+  UT_ASSERT_EQUAL (mSmiCount, mMockVariableCount + TooSmallCount + 2);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  SetVariable() discards the prefetched names, so the next GetNextVariableName()
+  goes to SMM again.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SetVariableShouldDiscardBatch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      Name[MOCK_MAX_NAME_LENGTH];
+  EFI_GUID    Guid;
+  UINTN       NameSize;
+  UINT8       Data;
+  UINTN       SmiCount;
+
+  ZeroMem (Name, sizeof (Name));
+  ZeroMem (&Guid, sizeof (Guid));
+
+  NameSize = sizeof (Name);
+  Status   = RuntimeServiceGetNextVariableName (&NameSize, Name, &Guid);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_TRUE (mVariableNameBatchCount != 0);
+
+  SmiCount = mSmiCount;
+  NameSize = sizeof (Name);
+  Status   = RuntimeServiceGetNextVariableName (&NameSize, Name, &Guid);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (mSmiCount, SmiCount);
+
+  Data   = 0;
+  Status = RuntimeServiceSetVariable (L"Var0", &mMockGuids[0], EFI_VARIABLE_BOOTSERVICE_ACCESS, sizeof (Data), &Data);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (mVariableNameBatchCount, 0);
+
+  SmiCount = mSmiCount;
+  NameSize = sizeof (Name);
+  Status   = RuntimeServiceGetNextVariableName (&NameSize, Name, &Guid);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (mSmiCount, SmiCount + 1);
+  UT_ASSERT_MEM_EQUAL (Name, mMockVariables[2].Name, NameSize);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Benchmark: count the SMIs and time a full enumeration, batched and one SMI
+  per name. The SMI count is what matters on hardware, where each SMI stops
+  all processors.
+
+  @param[in] Context    Unused.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BenchmarkVariableNameEnumeration (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  TestStatus;
+  UINTN             TooSmallCount;
+  UINTN             BatchSmiCount;
+  UINTN             SingleSmiCount;
+  clock_t           Start;
+  clock_t           BatchTicks;
+  clock_t           SingleTicks;
+
+  mSmiCount  = 0;
+  Start      = clock ();
+  TestStatus = EnumerateAndVerify (&TooSmallCount);
+  BatchTicks = clock () - Start;
+  UT_ASSERT_EQUAL (TestStatus, UNIT_TEST_PASSED);
+  BatchSmiCount = mSmiCount;
+
+  FreePool (mVariableNameBatch);
+  mVariableNameBatch = NULL;
+
+  mSmiCount   = 0;
+  Start       = clock ();
+  TestStatus  = EnumerateAndVerify (&TooSmallCount);
+  SingleTicks = clock () - Start;
+  UT_ASSERT_EQUAL (TestStatus, UNIT_TEST_PASSED);
+  SingleSmiCount = mSmiCount;
+
+  UT_LOG_INFO (
+    "%d variables, %d byte payload: batched %d SMIs in %d us, single name %d SMIs in %d us\n",
+    (int) mMockVariableCount,
+    MOCK_PAYLOAD_SIZE,
+    (int) BatchSmiCount,
+    (int) ((UINT64) BatchTicks * 1000000 / CLOCKS_PER_SEC),
+    (int) SingleSmiCount,
+    (int) ((UINT64) SingleTicks * 1000000 / CLOCKS_PER_SEC)
+    );
+  UT_ASSERT_TRUE (BatchSmiCount < SingleSmiCount);
+
+  return UNIT_TEST_PASSED;
+}
+
+///=== TEST ENGINE ================================================================================
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  batched variable name enumeration and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      BatchTests;
+  UNIT_TEST_SUITE_HANDLE      BenchmarkTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&BatchTests, Framework, "Variable Name Batch Tests", "VariableSmmRuntimeDxe.NameBatch", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for the variable name batch tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+  AddTestCase (BatchTests, "Batched enumeration should match one SMI per name", "BatchMatchesSingle", BatchShouldMatchSingleNameEnumeration, SetUpVariableDriver, TearDownVariableDriver, (UNIT_TEST_CONTEXT) (UINTN) MOCK_VARIABLE_COUNT);
+  AddTestCase (BatchTests, "Unsupported batch should fall back to one SMI per name", "UnsupportedFallBack", UnsupportedBatchShouldFallBackToSingleName, SetUpVariableDriver, TearDownVariableDriver, (UNIT_TEST_CONTEXT) (UINTN) MOCK_VARIABLE_COUNT);
+  AddTestCase (BatchTests, "SetVariable should discard the prefetched names", "SetVariableDiscards", SetVariableShouldDiscardBatch, SetUpVariableDriver, TearDownVariableDriver, (UNIT_TEST_CONTEXT) (UINTN) MOCK_VARIABLE_COUNT);
+
+  Status = CreateUnitTestSuite (&BenchmarkTests, Framework, "Variable Name Batch Benchmark", "VariableSmmRuntimeDxe.NameBatch.Benchmark", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for the variable name batch benchmark\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+  AddTestCase (BenchmarkTests, "Count the SMIs of a full enumeration", "SmiCount", BenchmarkVariableNameEnumeration, SetUpVariableDriver, TearDownVariableDriver, (UNIT_TEST_CONTEXT) (UINTN) BENCHMARK_VARIABLE_COUNT);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
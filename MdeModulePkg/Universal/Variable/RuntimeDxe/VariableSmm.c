@@ -465,6 +465,7 @@ SmmVariableHandler (
   SMM_VARIABLE_COMMUNICATE_HEADER                         *SmmVariableFunctionHeader;
   SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE                *SmmVariableHeader;
   SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME         *GetNextVariableName;
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAMES        *GetNextVariableNames;
   SMM_VARIABLE_COMMUNICATE_QUERY_VARIABLE_INFO            *QueryVariableInfo;
   SMM_VARIABLE_COMMUNICATE_GET_PAYLOAD_SIZE               *GetPayloadSize;
   SMM_VARIABLE_COMMUNICATE_RUNTIME_VARIABLE_CACHE_CONTEXT *RuntimeVariableCacheContext;
@@ -476,6 +477,7 @@ SmmVariableHandler (
   VARIABLE_STORE_HEADER                                   *VariableCache;
   UINTN                                                   InfoSize;
   UINTN                                                   NameBufferSize;
+  UINTN                                                   RecordSize;
   UINTN                                                   CommBufferPayloadSize;
   UINTN                                                   TempCommBufferSize;
 
@@ -604,6 +606,64 @@ SmmVariableHandler (
       CopyMem (SmmVariableFunctionHeader->Data, mVariableBufferPayload, CommBufferPayloadSize);
       break;
 
+    case SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAMES:
+      if (CommBufferPayloadSize < OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAMES, Names) +
+                                  OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME, Name)) {
+        DEBUG ((EFI_D_ERROR, "GetNextVariableNames: SMM communication buffer size invalid!\n"));
+        return EFI_SUCCESS;
+      }
+      //
+      // Copy the input communicate buffer payload to pre-allocated SMM variable buffer payload.
+      //
+      CopyMem (mVariableBufferPayload, SmmVariableFunctionHeader->Data, CommBufferPayloadSize);
+      GetNextVariableNames = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAMES *) mVariableBufferPayload;
+      GetNextVariableName  = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME *) GetNextVariableNames->Names;
+
+      NameBufferSize = CommBufferPayloadSize - OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAMES, Names) -
+                       OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME, Name);
+      if (NameBufferSize < sizeof (CHAR16) || GetNextVariableName->Name[NameBufferSize/sizeof (CHAR16) - 1] != L'\0') {
+        //
+        // Make sure input VariableName is A Null-terminated string.
+        //
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+
+      //
+      // Each name found is the input of the next lookup, so copy it to the
+      // following record and look up again until the payload is full.
+      //
+      GetNextVariableNames->NameCount = 0;
+      while (TRUE) {
+        GetNextVariableName->NameSize = NameBufferSize;
+        Status = VariableServiceGetNextVariableName (
+                   &GetNextVariableName->NameSize,
+                   GetNextVariableName->Name,
+                   &GetNextVariableName->Guid
+                   );
+        if (EFI_ERROR (Status)) {
+          break;
+        }
+        GetNextVariableNames->NameCount++;
+
+        RecordSize = GET_NEXT_VARIABLE_NAMES_RECORD_SIZE (GetNextVariableName->NameSize);
+        if (NameBufferSize < RecordSize + GetNextVariableName->NameSize) {
+          break;
+        }
+        CopyMem (
+          (UINT8 *) GetNextVariableName + RecordSize,
+          GetNextVariableName,
+          OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME, Name) + GetNextVariableName->NameSize
+          );
+        GetNextVariableName = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME *) ((UINT8 *) GetNextVariableName + RecordSize);
+        NameBufferSize     -= RecordSize;
+      }
+      if (GetNextVariableNames->NameCount != 0) {
+        Status = EFI_SUCCESS;
+      }
+      CopyMem (SmmVariableFunctionHeader->Data, mVariableBufferPayload, CommBufferPayloadSize);
+      break;
+
     case SMM_VARIABLE_FUNCTION_SET_VARIABLE:
       if (CommBufferPayloadSize < OFFSET_OF(SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE, Name)) {
         DEBUG ((EFI_D_ERROR, "SetVariable: SMM communication buffer size invalid!\n"));
@@ -53,6 +53,9 @@ VARIABLE_INFO_ENTRY             *mVariableInfo              = NULL;
 VARIABLE_STORE_HEADER           *mVariableRuntimeHobCacheBuffer           = NULL;
 VARIABLE_STORE_HEADER           *mVariableRuntimeNvCacheBuffer            = NULL;
 VARIABLE_STORE_HEADER           *mVariableRuntimeVolatileCacheBuffer      = NULL;
+UINT8                           *mVariableNameBatch                       = NULL;
+UINTN                            mVariableNameBatchOffset;
+UINTN                            mVariableNameBatchCount;
 UINTN                            mVariableBufferSize;
 UINTN                            mVariableRuntimeHobCacheBufferSize;
 UINTN                            mVariableRuntimeNvCacheBufferSize;
@@ -928,6 +931,149 @@ GetNextVariableNameInRuntimeCache (
   return Status;
 }
 
+/**
+  Finds the next available variable in the variable names prefetched from SMM.
+
+  The prefetched names are only used to continue an enumeration, i.e. when the
+  input variable is the one returned by the previous call.
+
+  @param[in, out] VariableNameSize   Size of the variable name.
+  @param[in, out] VariableName       Pointer to variable name.
+  @param[in, out] VendorGuid         Variable Vendor Guid.
+
+  @retval EFI_SUCCESS                Find the specified variable.
+  @retval EFI_NOT_FOUND              The next variable is not prefetched.
+  @retval EFI_BUFFER_TO_SMALL        DataSize is too small for the result.
+
+**/
+EFI_STATUS
+GetNextVariableNameInBatch (
+  IN OUT  UINTN                             *VariableNameSize,
+  IN OUT  CHAR16                            *VariableName,
+  IN OUT  EFI_GUID                          *VendorGuid
+  )
+{
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME *Record;
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME *NextRecord;
+
+  if (mVariableNameBatchCount == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  Record = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME *) (mVariableNameBatch + mVariableNameBatchOffset);
+  if (!CompareGuid (&Record->Guid, VendorGuid) || StrCmp (Record->Name, VariableName) != 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  NextRecord = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME *) ((UINT8 *) Record +
+                 GET_NEXT_VARIABLE_NAMES_RECORD_SIZE (Record->NameSize));
+  if (*VariableNameSize < NextRecord->NameSize) {
+    *VariableNameSize = NextRecord->NameSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *VariableNameSize = NextRecord->NameSize;
+  CopyGuid (VendorGuid, &NextRecord->Guid);
+  CopyMem (VariableName, NextRecord->Name, NextRecord->NameSize);
+
+  mVariableNameBatchOffset = (UINT8 *) NextRecord - mVariableNameBatch;
+  mVariableNameBatchCount--;
+  return EFI_SUCCESS;
+}
+
+/**
+  Finds the next available variable in a SMM variable store and prefetches
+  as many of the following variable names as fit in the communicate buffer.
+
+  @param[in, out] VariableNameSize   Size of the variable name.
+  @param[in, out] VariableName       Pointer to variable name.
+  @param[in, out] VendorGuid         Variable Vendor Guid.
+
+  @retval EFI_INVALID_PARAMETER      Invalid parameter.
+  @retval EFI_SUCCESS                Find the specified variable.
+  @retval EFI_NOT_FOUND              Not found.
+  @retval EFI_BUFFER_TO_SMALL        DataSize is too small for the result.
+  @retval EFI_UNSUPPORTED            The SMM variable driver does not support
+                                     SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAMES.
+
+**/
+EFI_STATUS
+GetNextVariableNamesInSmm (
+  IN OUT  UINTN                             *VariableNameSize,
+  IN OUT  CHAR16                            *VariableName,
+  IN OUT  EFI_GUID                          *VendorGuid
+  )
+{
+  EFI_STATUS                                       Status;
+  UINTN                                            PayloadSize;
+  UINTN                                            NameBufferSize;
+  UINTN                                            InVariableNameSize;
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAMES *SmmGetNextVariableNames;
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME  *Record;
+
+  mVariableNameBatchCount = 0;
+
+  PayloadSize        = mVariableBufferPayloadSize;
+  NameBufferSize     = PayloadSize - OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAMES, Names) -
+                       OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME, Name);
+  InVariableNameSize = StrSize (VariableName);
+  if (InVariableNameSize > NameBufferSize) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = InitCommunicateBuffer ((VOID **)&SmmGetNextVariableNames, PayloadSize, SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAMES);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  ASSERT (SmmGetNextVariableNames != NULL);
+
+  Record = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME *) SmmGetNextVariableNames->Names;
+  Record->NameSize = NameBufferSize;
+  CopyGuid (&Record->Guid, VendorGuid);
+  CopyMem (Record->Name, VariableName, InVariableNameSize);
+  ZeroMem ((UINT8 *) Record->Name + InVariableNameSize, NameBufferSize - InVariableNameSize);
+
+  //
+  // Send data to SMM
+  //
+  Status = SendCommunicateBuffer (PayloadSize);
+  if (Status == EFI_BUFFER_TOO_SMALL) {
+    *VariableNameSize = Record->NameSize;
+  }
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (*VariableNameSize < Record->NameSize) {
+    //
+    // The caller will retry with the same input variable, which does not
+    // match any prefetched name, so there is no point keeping them.
+    //
+    *VariableNameSize = Record->NameSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *VariableNameSize = Record->NameSize;
+  CopyGuid (VendorGuid, &Record->Guid);
+  CopyMem (VariableName, Record->Name, Record->NameSize);
+
+  //
+  // Keep the remaining names for the following calls, the communicate buffer
+  // is reused by every other variable service.
+  //
+  if (SmmGetNextVariableNames->NameCount > 1) {
+    CopyMem (
+      mVariableNameBatch,
+      SmmGetNextVariableNames->Names,
+      PayloadSize - OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAMES, Names)
+      );
+    mVariableNameBatchOffset = 0;
+    mVariableNameBatchCount  = SmmGetNextVariableNames->NameCount - 1;
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Finds the next available variable in a SMM variable store.
 
@@ -954,6 +1100,29 @@ GetNextVariableNameInSmm (
   UINTN                                           OutVariableNameSize;
   UINTN                                           InVariableNameSize;
 
+  if (mVariableNameBatch != NULL) {
+    //
+    // Enumerating all variables one SMI per name stops all processors for
+    // each name, so fetch them in batches when SMM supports it.
+    //
+    Status = GetNextVariableNameInBatch (VariableNameSize, VariableName, VendorGuid);
+    if (Status != EFI_NOT_FOUND) {
+      return Status;
+    }
+    Status = GetNextVariableNamesInSmm (VariableNameSize, VariableName, VendorGuid);
+    if (Status != EFI_UNSUPPORTED) {
+      return Status;
+    }
+
+    //
+    // Runtime pool can't be freed once at runtime, it is then simply unused.
+    //
+    if (!EfiAtRuntime ()) {
+      FreePool (mVariableNameBatch);
+    }
+    mVariableNameBatch = NULL;
+  }
+
   OutVariableNameSize   = *VariableNameSize;
   InVariableNameSize    = StrSize (VariableName);
   SmmGetNextVariableName = NULL;
@@ -1138,6 +1307,11 @@ RuntimeServiceSetVariable (
 
   AcquireLockOnlyAtBootTime(&mVariableServicesLock);
 
+  //
+  // The prefetched variable names may be stale now.
+  //
+  mVariableNameBatchCount = 0;
+
   //
   // Init the communicate buffer. The buffer data size is:
   // SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + PayloadSize.
@@ -1341,6 +1515,7 @@ VariableAddressChangeEvent (
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeHobCacheBuffer);
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeNvCacheBuffer);
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeVolatileCacheBuffer);
+  EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableNameBatch);
 }
 
 /**
@@ -1670,6 +1845,10 @@ SmmVariableReady (
     ASSERT_EFI_ERROR (Status);
   } else {
     DEBUG ((DEBUG_INFO, "Variable driver runtime cache is disabled.\n"));
+    //
+    // Allocate the buffer holding variable names prefetched from SMM.
+    //
+    mVariableNameBatch = AllocateRuntimePool (mVariableBufferPayloadSize);
   }
 
   gRT->GetVariable         = RuntimeServiceGetVariable;
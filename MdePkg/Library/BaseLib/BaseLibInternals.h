@@ -565,6 +565,54 @@ InternalAsciiHexCharToUintn (
   );
 
 
+/**
+  Returns the number of Unicode characters that precede the Null-terminator
+  in the first MaxLength characters of a Unicode string.
+
+  Whole UINTN aligned words are scanned at a time. Such a word never crosses a
+  page boundary, and only words entirely within the first MaxLength characters
+  of String are read.
+
+  @param  String     A pointer to a Unicode string.
+  @param  MaxLength  The maximum number of characters of String to access.
+
+  @retval MaxLength  If there is no Null-terminator in the first MaxLength
+                     characters of String.
+  @return The number of characters that precede the Null-terminator.
+
+**/
+UINTN
+EFIAPI
+InternalStrnLen (
+  IN      CONST CHAR16              *String,
+  IN      UINTN                     MaxLength
+  );
+
+
+/**
+  Returns the number of ASCII characters that precede the Null-terminator in
+  the first MaxLength characters of an ASCII string.
+
+  Whole UINTN aligned words are scanned at a time. Such a word never crosses a
+  page boundary, and only words entirely within the first MaxLength characters
+  of String are read.
+
+  @param  String     A pointer to an ASCII string.
+  @param  MaxLength  The maximum number of characters of String to access.
+
+  @retval MaxLength  If there is no Null-terminator in the first MaxLength
+                     characters of String.
+  @return The number of characters that precede the Null-terminator.
+
+**/
+UINTN
+EFIAPI
+InternalAsciiStrnLen (
+  IN      CONST CHAR8               *String,
+  IN      UINTN                     MaxLength
+  );
+
+
 //
 // Ia32 and x64 specific functions
 //
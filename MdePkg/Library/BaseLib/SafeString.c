@@ -119,8 +119,6 @@ StrnLenS (
   IN UINTN                     MaxSize
   )
 {
-  UINTN                             Length;
-
   ASSERT (((UINTN) String & BIT0) == 0);
 
   //
@@ -136,14 +134,7 @@ StrnLenS (
   // String then StrnLenS returns MaxSize. At most the first MaxSize characters of String shall
   // be accessed by StrnLenS.
   //
-  Length = 0;
-  while (String[Length] != 0) {
-    if (Length >= MaxSize - 1) {
-      return MaxSize;
-    }
-    Length++;
-  }
-  return Length;
+  return InternalStrnLen (String, MaxSize);
 }
 
 /**
@@ -1653,8 +1644,6 @@ AsciiStrnLenS (
   IN UINTN                     MaxSize
   )
 {
-  UINTN                             Length;
-
   //
   // If String is a null pointer or MaxSize is 0, then the AsciiStrnLenS function returns zero.
   //
@@ -1668,14 +1657,7 @@ AsciiStrnLenS (
   // String then AsciiStrnLenS returns MaxSize. At most the first MaxSize characters of String shall
   // be accessed by AsciiStrnLenS.
   //
-  Length = 0;
-  while (String[Length] != 0) {
-    if (Length >= MaxSize - 1) {
-      return MaxSize;
-    }
-    Length++;
-  }
-  return Length;
+  return InternalAsciiStrnLen (String, MaxSize);
 }
 
 /**
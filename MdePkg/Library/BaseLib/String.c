@@ -8,6 +8,110 @@
 
 #include "BaseLibInternals.h"
 
+//
+// A UINTN holding one in the lowest bit of each CHAR16 or CHAR8 lane.
+//
+#define CHAR16_LANES_LOW_BITS  (MAX_UINTN / MAX_UINT16)
+#define CHAR8_LANES_LOW_BITS   (MAX_UINTN / MAX_UINT8)
+
+//
+// Evaluates to non-zero if any CHAR16 or CHAR8 lane of the UINTN Word is zero.
+//
+#define HAS_NULL_CHAR16(Word) \
+  (((Word) - CHAR16_LANES_LOW_BITS) & ~(Word) & (CHAR16_LANES_LOW_BITS * BIT15))
+#define HAS_NULL_CHAR8(Word) \
+  (((Word) - CHAR8_LANES_LOW_BITS) & ~(Word) & (CHAR8_LANES_LOW_BITS * BIT7))
+
+#define CHARS_PER_UINTN(Type)  (sizeof (UINTN) / sizeof (Type))
+
+/**
+  Returns the number of Unicode characters that precede the Null-terminator
+  in the first MaxLength characters of a Unicode string.
+
+  Whole UINTN aligned words are scanned at a time. Such a word never crosses a
+  page boundary, and only words entirely within the first MaxLength characters
+  of String are read.
+
+  @param  String     A pointer to a Unicode string.
+  @param  MaxLength  The maximum number of characters of String to access.
+
+  @retval MaxLength  If there is no Null-terminator in the first MaxLength
+                     characters of String.
+  @return The number of characters that precede the Null-terminator.
+
+**/
+UINTN
+EFIAPI
+InternalStrnLen (
+  IN      CONST CHAR16              *String,
+  IN      UINTN                     MaxLength
+  )
+{
+  UINTN                             Length;
+
+  //
+  // Check the characters up to the first UINTN aligned one. A String not
+  // aligned on a 16-bit boundary never gets there and is checked entirely.
+  //
+  for (Length = 0; ((UINTN) &String[Length] & (sizeof (UINTN) - 1)) != 0; Length++) {
+    if ((Length >= MaxLength) || (String[Length] == L'\0')) {
+      return Length;
+    }
+  }
+
+  while ((MaxLength - Length >= CHARS_PER_UINTN (CHAR16)) &&
+         (HAS_NULL_CHAR16 (*(CONST UINTN *) &String[Length]) == 0)) {
+    Length += CHARS_PER_UINTN (CHAR16);
+  }
+
+  while ((Length < MaxLength) && (String[Length] != L'\0')) {
+    Length++;
+  }
+  return Length;
+}
+
+/**
+  Returns the number of ASCII characters that precede the Null-terminator in
+  the first MaxLength characters of an ASCII string.
+
+  Whole UINTN aligned words are scanned at a time. Such a word never crosses a
+  page boundary, and only words entirely within the first MaxLength characters
+  of String are read.
+
+  @param  String     A pointer to an ASCII string.
+  @param  MaxLength  The maximum number of characters of String to access.
+
+  @retval MaxLength  If there is no Null-terminator in the first MaxLength
+                     characters of String.
+  @return The number of characters that precede the Null-terminator.
+
+**/
+UINTN
+EFIAPI
+InternalAsciiStrnLen (
+  IN      CONST CHAR8               *String,
+  IN      UINTN                     MaxLength
+  )
+{
+  UINTN                             Length;
+
+  for (Length = 0; ((UINTN) &String[Length] & (sizeof (UINTN) - 1)) != 0; Length++) {
+    if ((Length >= MaxLength) || (String[Length] == '\0')) {
+      return Length;
+    }
+  }
+
+  while ((MaxLength - Length >= CHARS_PER_UINTN (CHAR8)) &&
+         (HAS_NULL_CHAR8 (*(CONST UINTN *) &String[Length]) == 0)) {
+    Length += CHARS_PER_UINTN (CHAR8);
+  }
+
+  while ((Length < MaxLength) && (String[Length] != '\0')) {
+    Length++;
+  }
+  return Length;
+}
+
 
 /**
   Returns the length of a Null-terminated Unicode string.
@@ -37,16 +141,22 @@ StrLen (
   ASSERT (String != NULL);
   ASSERT (((UINTN) String & BIT0) == 0);
 
-  for (Length = 0; *String != L'\0'; String++, Length++) {
-    //
-    // If PcdMaximumUnicodeStringLength is not zero,
-    // length should not more than PcdMaximumUnicodeStringLength
-    //
-    if (PcdGet32 (PcdMaximumUnicodeStringLength) != 0) {
-      ASSERT (Length < PcdGet32 (PcdMaximumUnicodeStringLength));
-    }
+  //
+  // If PcdMaximumUnicodeStringLength is not zero,
+  // length should not more than PcdMaximumUnicodeStringLength.
+  // Stop scanning right after the limit, so that the ASSERT() fires before
+  // reading past the end of a string missing its Null terminator.
+  //
+  Length = 0;
+  if (PcdGet32 (PcdMaximumUnicodeStringLength) != 0) {
+    Length = InternalStrnLen (String, (UINTN) PcdGet32 (PcdMaximumUnicodeStringLength) + 1);
+    ASSERT (Length <= PcdGet32 (PcdMaximumUnicodeStringLength));
   }
-  return Length;
+
+  //
+  // Only scans on if ASSERT() is disabled and the string is too long.
+  //
+  return Length + InternalStrnLen (String + Length, MAX_UINTN);
 }
 
 /**
@@ -117,6 +227,26 @@ StrCmp (
   ASSERT (StrSize (FirstString) != 0);
   ASSERT (StrSize (SecondString) != 0);
 
+  //
+  // If both strings are equally aligned, compare whole UINTN aligned words
+  // until one differs or holds the Null-terminator.
+  //
+  if ((((UINTN) FirstString ^ (UINTN) SecondString) & (sizeof (UINTN) - 1)) == 0) {
+    while (((UINTN) FirstString & (sizeof (UINTN) - 1)) != 0) {
+      if ((*FirstString == L'\0') || (*FirstString != *SecondString)) {
+        return *FirstString - *SecondString;
+      }
+      FirstString++;
+      SecondString++;
+    }
+
+    while ((*(CONST UINTN *) FirstString == *(CONST UINTN *) SecondString) &&
+           (HAS_NULL_CHAR16 (*(CONST UINTN *) FirstString) == 0)) {
+      FirstString  += CHARS_PER_UINTN (CHAR16);
+      SecondString += CHARS_PER_UINTN (CHAR16);
+    }
+  }
+
   while ((*FirstString != L'\0') && (*FirstString == *SecondString)) {
     FirstString++;
     SecondString++;
@@ -629,16 +759,22 @@ AsciiStrLen (
 
   ASSERT (String != NULL);
 
-  for (Length = 0; *String != '\0'; String++, Length++) {
-    //
-    // If PcdMaximumUnicodeStringLength is not zero,
-    // length should not more than PcdMaximumUnicodeStringLength
-    //
-    if (PcdGet32 (PcdMaximumAsciiStringLength) != 0) {
-      ASSERT (Length < PcdGet32 (PcdMaximumAsciiStringLength));
-    }
+  //
+  // If PcdMaximumAsciiStringLength is not zero,
+  // length should not more than PcdMaximumAsciiStringLength.
+  // Stop scanning right after the limit, so that the ASSERT() fires before
+  // reading past the end of a string missing its Null terminator.
+  //
+  Length = 0;
+  if (PcdGet32 (PcdMaximumAsciiStringLength) != 0) {
+    Length = InternalAsciiStrnLen (String, (UINTN) PcdGet32 (PcdMaximumAsciiStringLength) + 1);
+    ASSERT (Length <= PcdGet32 (PcdMaximumAsciiStringLength));
   }
-  return Length;
+
+  //
+  // Only scans on if ASSERT() is disabled and the string is too long.
+  //
+  return Length + InternalAsciiStrnLen (String + Length, MAX_UINTN);
 }
 
 /**
@@ -706,6 +842,26 @@ AsciiStrCmp (
   ASSERT (AsciiStrSize (FirstString));
   ASSERT (AsciiStrSize (SecondString));
 
+  //
+  // If both strings are equally aligned, compare whole UINTN aligned words
+  // until one differs or holds the Null-terminator.
+  //
+  if ((((UINTN) FirstString ^ (UINTN) SecondString) & (sizeof (UINTN) - 1)) == 0) {
+    while (((UINTN) FirstString & (sizeof (UINTN) - 1)) != 0) {
+      if ((*FirstString == '\0') || (*FirstString != *SecondString)) {
+        return *FirstString - *SecondString;
+      }
+      FirstString++;
+      SecondString++;
+    }
+
+    while ((*(CONST UINTN *) FirstString == *(CONST UINTN *) SecondString) &&
+           (HAS_NULL_CHAR8 (*(CONST UINTN *) FirstString) == 0)) {
+      FirstString  += CHARS_PER_UINTN (CHAR8);
+      SecondString += CHARS_PER_UINTN (CHAR8);
+    }
+  }
+
   while ((*FirstString != '\0') && (*FirstString == *SecondString)) {
     FirstString++;
     SecondString++;
@@ -0,0 +1,1316 @@
+/** @file
+  An OrderedCollectionLib instance that provides a B-tree implementation, and
+  allocates tree nodes and entries from arenas grown with MemoryAllocationLib.
+
+  This library instance is useful when a fast associative container with many
+  elements is needed. Each tree node holds up to B_TREE_MAX_KEYS user
+  structures, so lookups touch few, densely packed nodes, and allocating an
+  entry seldom calls into MemoryAllocationLib. Worst case time complexity is
+  O(log n) for Find(), Next(), Prev(), Min(), Max(), Insert(), and Delete(),
+  where "n" is the number of elements in the tree. Complete ordered traversal
+  takes O(n) time.
+
+  Memory of deleted entries and nodes is kept by the tree for reuse, and only
+  released by OrderedCollectionUninit().
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Library/OrderedCollectionLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+//
+// A node holds B_TREE_MIN_KEYS to B_TREE_MAX_KEYS user structures, except the
+// root, which holds at least one.
+//
+#define B_TREE_MIN_DEGREE         8
+#define B_TREE_MAX_KEYS           (2 * B_TREE_MIN_DEGREE - 1)
+#define B_TREE_MIN_KEYS           (B_TREE_MIN_DEGREE - 1)
+
+//
+// The number of entries and nodes carved from one arena chunk.
+//
+#define B_TREE_ENTRIES_PER_CHUNK  64
+#define B_TREE_NODES_PER_CHUNK    8
+
+//
+// Incomplete types and convenience typedefs are present in the library class
+// header. Beside completing the types, we introduce typedefs here that reflect
+// the implementation closely.
+//
+typedef ORDERED_COLLECTION              B_TREE;
+typedef ORDERED_COLLECTION_ENTRY        B_TREE_ENTRY;
+typedef ORDERED_COLLECTION_USER_COMPARE B_TREE_USER_COMPARE;
+typedef ORDERED_COLLECTION_KEY_COMPARE  B_TREE_KEY_COMPARE;
+
+typedef struct B_TREE_NODE B_TREE_NODE;
+
+//
+// Entries are the handles given to the caller. They never move, while the user
+// structures they link move between nodes when the tree is rebalanced.
+//
+struct ORDERED_COLLECTION_ENTRY {
+  VOID         *UserStruct;
+  B_TREE_NODE  *Node;
+};
+
+//
+// Child[Index] is NULL for Index > KeyCount, and for all Index in leaves.
+//
+struct B_TREE_NODE {
+  B_TREE_NODE   *Parent;
+  UINTN         KeyCount;
+  B_TREE_ENTRY  *Entry[B_TREE_MAX_KEYS];
+  B_TREE_NODE   *Child[B_TREE_MAX_KEYS + 1];
+};
+
+//
+// Fixed size elements are carved from chunks. Free elements are linked through
+// their first pointer.
+//
+typedef struct {
+  VOID   *ChunkList;
+  VOID   *FreeList;
+  UINTN  FreeCount;
+  UINTN  ElementSize;
+  UINTN  ElementsPerChunk;
+} B_TREE_ARENA;
+
+struct ORDERED_COLLECTION {
+  B_TREE_NODE          *Root;
+  B_TREE_USER_COMPARE  UserStructCompare;
+  B_TREE_KEY_COMPARE   KeyCompare;
+  B_TREE_ARENA         EntryArena;
+  B_TREE_ARENA         NodeArena;
+};
+
+
+/**
+  Return an element to the arena.
+
+  @param[in,out] Arena    The arena the element was allocated from.
+
+  @param[in]     Element  The element to free.
+**/
+STATIC
+VOID
+ArenaFree (
+  IN OUT B_TREE_ARENA *Arena,
+  IN     VOID         *Element
+  )
+{
+  *(VOID **)Element = Arena->FreeList;
+  Arena->FreeList   = Element;
+  Arena->FreeCount++;
+}
+
+
+/**
+  Make sure the arena has at least Count free elements.
+
+  @param[in,out] Arena  The arena to grow.
+
+  @param[in]     Count  The number of free elements needed.
+
+  @retval TRUE   The arena has Count free elements.
+
+  @retval FALSE  AllocatePool() failed to allocate a new chunk.
+**/
+STATIC
+BOOLEAN
+ArenaReserve (
+  IN OUT B_TREE_ARENA *Arena,
+  IN     UINTN        Count
+  )
+{
+  UINT8 *Chunk;
+  UINTN Index;
+
+  while (Arena->FreeCount < Count) {
+    Chunk = AllocatePool (sizeof (VOID *) +
+              Arena->ElementSize * Arena->ElementsPerChunk);
+    if (Chunk == NULL) {
+      return FALSE;
+    }
+    *(VOID **)Chunk  = Arena->ChunkList;
+    Arena->ChunkList = Chunk;
+    for (Index = Arena->ElementsPerChunk; Index > 0; Index--) {
+      ArenaFree (Arena,
+        Chunk + sizeof (VOID *) + (Index - 1) * Arena->ElementSize);
+    }
+  }
+  return TRUE;
+}
+
+
+/**
+  Take a free element from the arena. The caller is responsible for reserving
+  it with ArenaReserve() first.
+
+  @param[in,out] Arena  The arena to allocate from.
+
+  @return  The uninitialized element.
+**/
+STATIC
+VOID *
+ArenaAllocate (
+  IN OUT B_TREE_ARENA *Arena
+  )
+{
+  VOID *Element;
+
+  ASSERT (Arena->FreeCount > 0);
+  Element         = Arena->FreeList;
+  Arena->FreeList = *(VOID **)Element;
+  Arena->FreeCount--;
+  return Element;
+}
+
+
+/**
+  Release all chunks of the arena with FreePool().
+
+  @param[in,out] Arena  The arena whose elements are all free.
+**/
+STATIC
+VOID
+ArenaRelease (
+  IN OUT B_TREE_ARENA *Arena
+  )
+{
+  VOID *Chunk;
+
+  while (Arena->ChunkList != NULL) {
+    Chunk            = Arena->ChunkList;
+    Arena->ChunkList = *(VOID **)Chunk;
+    FreePool (Chunk);
+  }
+  Arena->FreeList  = NULL;
+  Arena->FreeCount = 0;
+}
+
+
+/**
+  Take an empty node from the node arena.
+
+  @param[in,out] Tree    The tree whose node arena has a node reserved.
+
+  @param[in]     Parent  The parent of the new node.
+
+  @return  The new node with no keys and no children.
+**/
+STATIC
+B_TREE_NODE *
+BTreeNewNode (
+  IN OUT B_TREE      *Tree,
+  IN     B_TREE_NODE *Parent
+  )
+{
+  B_TREE_NODE *Node;
+  UINTN       Index;
+
+  Node = ArenaAllocate (&Tree->NodeArena);
+  Node->Parent   = Parent;
+  Node->KeyCount = 0;
+  for (Index = 0; Index <= B_TREE_MAX_KEYS; Index++) {
+    Node->Child[Index] = NULL;
+  }
+  return Node;
+}
+
+
+/**
+  Search a node for the standalone key with binary search.
+
+  @param[in]  Node     The node to search.
+
+  @param[in]  Compare  The function ordering Key against user structures.
+
+  @param[in]  Key      The key to search for.
+
+  @param[out] Found    TRUE if the user structure at the returned index
+                       matches Key, FALSE otherwise.
+
+  @return  The index of the least user structure in Node that is not less than
+           Key, or Node->KeyCount if there's none.
+**/
+STATIC
+UINTN
+BTreeNodeSearch (
+  IN  CONST B_TREE_NODE  *Node,
+  IN  B_TREE_KEY_COMPARE Compare,
+  IN  CONST VOID         *Key,
+  OUT BOOLEAN            *Found
+  )
+{
+  UINTN Left;
+  UINTN Right;
+  UINTN Middle;
+  INTN  Result;
+
+  Left  = 0;
+  Right = Node->KeyCount;
+  while (Left < Right) {
+    Middle = (Left + Right) / 2;
+    Result = Compare (Key, Node->Entry[Middle]->UserStruct);
+    if (Result == 0) {
+      *Found = TRUE;
+      return Middle;
+    }
+    if (Result < 0) {
+      Right = Middle;
+    } else {
+      Left = Middle + 1;
+    }
+  }
+  *Found = FALSE;
+  return Left;
+}
+
+
+/**
+  Return the index of the entry within its node.
+
+  @param[in] Entry  The entry to locate.
+
+  @return  The index of Entry in Entry->Node->Entry.
+**/
+STATIC
+UINTN
+BTreeEntryIndex (
+  IN CONST B_TREE_ENTRY *Entry
+  )
+{
+  UINTN Index;
+
+  for (Index = 0; Entry->Node->Entry[Index] != Entry; Index++) {
+    ASSERT (Index < Entry->Node->KeyCount);
+  }
+  return Index;
+}
+
+
+/**
+  Return the index of the node within the children of its parent.
+
+  @param[in] Node  The non-root node to locate.
+
+  @return  The index of Node in Node->Parent->Child.
+**/
+STATIC
+UINTN
+BTreeChildIndex (
+  IN CONST B_TREE_NODE *Node
+  )
+{
+  UINTN Index;
+
+  for (Index = 0; Node->Parent->Child[Index] != Node; Index++) {
+    ASSERT (Index < Node->Parent->KeyCount);
+  }
+  return Index;
+}
+
+
+/**
+  Retrieve the user structure linked by the specified tree entry.
+
+  Read-only operation.
+
+  @param[in] Entry  Pointer to the tree entry whose associated user structure
+                    we want to retrieve. The caller is responsible for passing
+                    a non-NULL argument.
+
+  @return  Pointer to user structure linked by Entry.
+**/
+VOID *
+EFIAPI
+OrderedCollectionUserStruct (
+  IN CONST B_TREE_ENTRY *Entry
+  )
+{
+  return Entry->UserStruct;
+}
+
+/**
+  A slow function that asserts that the tree is a valid B-tree, and that it
+  orders user structures correctly.
+
+  Read-only operation.
+
+  This function uses the stack for recursion and is not recommended for
+  "production use".
+
+  @param[in] Tree  The tree to validate.
+**/
+VOID
+BTreeValidate (
+  IN CONST B_TREE *Tree
+  );
+
+
+/**
+  Allocate and initialize the B_TREE structure.
+
+  Allocation occurs via MemoryAllocationLib's AllocatePool() function.
+
+  @param[in]  UserStructCompare  This caller-provided function will be used to
+                                 order two user structures linked into the
+                                 tree, during the insertion procedure.
+
+  @param[in]  KeyCompare         This caller-provided function will be used to
+                                 order the standalone search key against user
+                                 structures linked into the tree, during the
+                                 lookup procedure.
+
+  @retval NULL  If allocation failed.
+
+  @return       Pointer to the allocated, initialized B_TREE structure,
+                otherwise.
+**/
+B_TREE *
+EFIAPI
+OrderedCollectionInit (
+  IN B_TREE_USER_COMPARE UserStructCompare,
+  IN B_TREE_KEY_COMPARE  KeyCompare
+  )
+{
+  B_TREE *Tree;
+
+  Tree = AllocatePool (sizeof *Tree);
+  if (Tree == NULL) {
+    return NULL;
+  }
+
+  Tree->Root              = NULL;
+  Tree->UserStructCompare = UserStructCompare;
+  Tree->KeyCompare        = KeyCompare;
+
+  Tree->EntryArena.ChunkList        = NULL;
+  Tree->EntryArena.FreeList         = NULL;
+  Tree->EntryArena.FreeCount        = 0;
+  Tree->EntryArena.ElementSize      = sizeof (B_TREE_ENTRY);
+  Tree->EntryArena.ElementsPerChunk = B_TREE_ENTRIES_PER_CHUNK;
+
+  Tree->NodeArena.ChunkList         = NULL;
+  Tree->NodeArena.FreeList          = NULL;
+  Tree->NodeArena.FreeCount         = 0;
+  Tree->NodeArena.ElementSize       = sizeof (B_TREE_NODE);
+  Tree->NodeArena.ElementsPerChunk  = B_TREE_NODES_PER_CHUNK;
+
+  if (FeaturePcdGet (PcdValidateOrderedCollection)) {
+    BTreeValidate (Tree);
+  }
+  return Tree;
+}
+
+
+/**
+  Check whether the tree is empty (has no entries).
+
+  Read-only operation.
+
+  @param[in] Tree  The tree to check for emptiness.
+
+  @retval TRUE   The tree is empty.
+
+  @retval FALSE  The tree is not empty.
+**/
+BOOLEAN
+EFIAPI
+OrderedCollectionIsEmpty (
+  IN CONST B_TREE *Tree
+  )
+{
+  return (BOOLEAN)(Tree->Root == NULL);
+}
+
+
+/**
+  Uninitialize and release an empty B_TREE structure.
+
+  Read-write operation.
+
+  Release occurs via MemoryAllocationLib's FreePool() function, including the
+  arena chunks that held the deleted entries and nodes.
+
+  It is the caller's responsibility to delete all entries from the tree before
+  calling this function.
+
+  @param[in] Tree  The empty tree to uninitialize and release.
+**/
+VOID
+EFIAPI
+OrderedCollectionUninit (
+  IN B_TREE *Tree
+  )
+{
+  ASSERT (OrderedCollectionIsEmpty (Tree));
+  ArenaRelease (&Tree->EntryArena);
+  ArenaRelease (&Tree->NodeArena);
+  FreePool (Tree);
+}
+
+
+/**
+  Look up the tree entry that links the user structure that matches the
+  specified standalone key.
+
+  Read-only operation.
+
+  @param[in] Tree           The tree to search for StandaloneKey.
+
+  @param[in] StandaloneKey  The key to locate among the user structures linked
+                            into Tree. StandaloneKey will be passed to
+                            Tree->KeyCompare().
+
+  @retval NULL  StandaloneKey could not be found.
+
+  @return       The tree entry that links to the user structure matching
+                StandaloneKey, otherwise.
+**/
+B_TREE_ENTRY *
+EFIAPI
+OrderedCollectionFind (
+  IN CONST B_TREE *Tree,
+  IN CONST VOID   *StandaloneKey
+  )
+{
+  B_TREE_NODE *Node;
+  UINTN       Index;
+  BOOLEAN     Found;
+
+  Node = Tree->Root;
+  while (Node != NULL) {
+    Index = BTreeNodeSearch (Node, Tree->KeyCompare, StandaloneKey, &Found);
+    if (Found) {
+      return Node->Entry[Index];
+    }
+    Node = Node->Child[Index];
+  }
+  return NULL;
+}
+
+
+/**
+  Find the tree entry of the minimum user structure stored in the tree.
+
+  Read-only operation.
+
+  @param[in] Tree  The tree to return the minimum entry of. The user structure
+                   linked by the minimum entry compares less than all other
+                   user structures in the tree.
+
+  @retval NULL  If Tree is empty.
+
+  @return       The tree entry that links the minimum user structure,
+                otherwise.
+**/
+B_TREE_ENTRY *
+EFIAPI
+OrderedCollectionMin (
+  IN CONST B_TREE *Tree
+  )
+{
+  B_TREE_NODE *Node;
+
+  Node = Tree->Root;
+  if (Node == NULL) {
+    return NULL;
+  }
+  while (Node->Child[0] != NULL) {
+    Node = Node->Child[0];
+  }
+  return Node->Entry[0];
+}
+
+
+/**
+  Find the tree entry of the maximum user structure stored in the tree.
+
+  Read-only operation.
+
+  @param[in] Tree  The tree to return the maximum entry of. The user structure
+                   linked by the maximum entry compares greater than all other
+                   user structures in the tree.
+
+  @retval NULL  If Tree is empty.
+
+  @return       The tree entry that links the maximum user structure,
+                otherwise.
+**/
+B_TREE_ENTRY *
+EFIAPI
+OrderedCollectionMax (
+  IN CONST B_TREE *Tree
+  )
+{
+  B_TREE_NODE *Node;
+
+  Node = Tree->Root;
+  if (Node == NULL) {
+    return NULL;
+  }
+  while (Node->Child[Node->KeyCount] != NULL) {
+    Node = Node->Child[Node->KeyCount];
+  }
+  return Node->Entry[Node->KeyCount - 1];
+}
+
+
+/**
+  Get the tree entry of the least user structure that is greater than the one
+  linked by Entry.
+
+  Read-only operation.
+
+  @param[in] Entry  The entry to get the successor entry of.
+
+  @retval NULL  If Entry is NULL, or Entry is the maximum entry of its
+                containing tree (ie. Entry has no successor entry).
+
+  @return       The tree entry linking the least user structure that is
+                greater than the one linked by Entry, otherwise.
+**/
+B_TREE_ENTRY *
+EFIAPI
+OrderedCollectionNext (
+  IN CONST B_TREE_ENTRY *Entry
+  )
+{
+  B_TREE_NODE *Node;
+  UINTN       Index;
+
+  if (Entry == NULL) {
+    return NULL;
+  }
+
+  Node  = Entry->Node;
+  Index = BTreeEntryIndex (Entry);
+
+  //
+  // In an internal node, the successor is the minimum entry of the subtree
+  // right to Entry.
+  //
+  if (Node->Child[0] != NULL) {
+    Node = Node->Child[Index + 1];
+    while (Node->Child[0] != NULL) {
+      Node = Node->Child[0];
+    }
+    return Node->Entry[0];
+  }
+
+  if (Index + 1 < Node->KeyCount) {
+    return Node->Entry[Index + 1];
+  }
+
+  //
+  // Otherwise we have to ascend as long as we're our parent's last child.
+  //
+  while (Node->Parent != NULL) {
+    Index = BTreeChildIndex (Node);
+    Node  = Node->Parent;
+    if (Index < Node->KeyCount) {
+      return Node->Entry[Index];
+    }
+  }
+  return NULL;
+}
+
+
+/**
+  Get the tree entry of the greatest user structure that is less than the one
+  linked by Entry.
+
+  Read-only operation.
+
+  @param[in] Entry  The entry to get the predecessor entry of.
+
+  @retval NULL  If Entry is NULL, or Entry is the minimum entry of its
+                containing tree (ie. Entry has no predecessor entry).
+
+  @return       The tree entry linking the greatest user structure that is
+                less than the one linked by Entry, otherwise.
+**/
+B_TREE_ENTRY *
+EFIAPI
+OrderedCollectionPrev (
+  IN CONST B_TREE_ENTRY *Entry
+  )
+{
+  B_TREE_NODE *Node;
+  UINTN       Index;
+
+  if (Entry == NULL) {
+    return NULL;
+  }
+
+  Node  = Entry->Node;
+  Index = BTreeEntryIndex (Entry);
+
+  //
+  // In an internal node, the predecessor is the maximum entry of the subtree
+  // left to Entry.
+  //
+  if (Node->Child[0] != NULL) {
+    Node = Node->Child[Index];
+    while (Node->Child[Node->KeyCount] != NULL) {
+      Node = Node->Child[Node->KeyCount];
+    }
+    return Node->Entry[Node->KeyCount - 1];
+  }
+
+  if (Index > 0) {
+    return Node->Entry[Index - 1];
+  }
+
+  //
+  // Otherwise we have to ascend as long as we're our parent's first child.
+  //
+  while (Node->Parent != NULL) {
+    Index = BTreeChildIndex (Node);
+    Node  = Node->Parent;
+    if (Index > 0) {
+      return Node->Entry[Index - 1];
+    }
+  }
+  return NULL;
+}
+
+
+/**
+  Insert an entry, and the child right to it, into a node. Full nodes are split
+  around their median entry, which is then inserted into the parent, up to the
+  root.
+
+  Internal read-write operation.
+
+  @param[in,out] Tree        The tree to insert into. The node arena must have
+                             one node reserved for each level of the tree, plus
+                             one.
+
+  @param[in,out] Node        The node to insert into.
+
+  @param[in]     Index       The position of Entry in Node.
+
+  @param[in]     Entry       The entry to insert.
+
+  @param[in]     RightChild  The subtree with user structures greater than the
+                             one linked by Entry, or NULL if Node is a leaf.
+**/
+STATIC
+VOID
+BTreeInsertEntry (
+  IN OUT B_TREE       *Tree,
+  IN OUT B_TREE_NODE  *Node,
+  IN     UINTN        Index,
+  IN     B_TREE_ENTRY *Entry,
+  IN     B_TREE_NODE  *RightChild
+  )
+{
+  B_TREE_ENTRY *Entries[B_TREE_MAX_KEYS + 1];
+  B_TREE_NODE  *Children[B_TREE_MAX_KEYS + 2];
+  B_TREE_NODE  *NewNode;
+  B_TREE_NODE  *NewRoot;
+  UINTN        Loop;
+  UINTN        Median;
+
+  while (Node->KeyCount == B_TREE_MAX_KEYS) {
+    //
+    // Collect the entries and children of the full node with the new ones.
+    //
+    for (Loop = 0; Loop < Index; Loop++) {
+      Entries[Loop]  = Node->Entry[Loop];
+      Children[Loop] = Node->Child[Loop];
+    }
+    Children[Index]     = Node->Child[Index];
+    Entries[Index]      = Entry;
+    Children[Index + 1] = RightChild;
+    for (Loop = Index; Loop < B_TREE_MAX_KEYS; Loop++) {
+      Entries[Loop + 1]  = Node->Entry[Loop];
+      Children[Loop + 2] = Node->Child[Loop + 1];
+    }
+
+    //
+    // Node keeps the entries left to the median, NewNode takes the entries
+    // right to it.
+    //
+    Median  = (B_TREE_MAX_KEYS + 1) / 2;
+    NewNode = BTreeNewNode (Tree, Node->Parent);
+    for (Loop = 0; Loop <= B_TREE_MAX_KEYS; Loop++) {
+      Node->Child[Loop] = NULL;
+    }
+    for (Loop = 0; Loop < Median; Loop++) {
+      Node->Entry[Loop]        = Entries[Loop];
+      Node->Entry[Loop]->Node  = Node;
+      Node->Child[Loop]        = Children[Loop];
+    }
+    Node->Child[Median] = Children[Median];
+    Node->KeyCount      = Median;
+    for (Loop = Median + 1; Loop <= B_TREE_MAX_KEYS; Loop++) {
+      NewNode->Entry[Loop - Median - 1]       = Entries[Loop];
+      NewNode->Entry[Loop - Median - 1]->Node = NewNode;
+      NewNode->Child[Loop - Median - 1]       = Children[Loop];
+    }
+    NewNode->Child[B_TREE_MAX_KEYS - Median] = Children[B_TREE_MAX_KEYS + 1];
+    NewNode->KeyCount                        = B_TREE_MAX_KEYS - Median;
+    for (Loop = 0; Loop <= NewNode->KeyCount; Loop++) {
+      if (NewNode->Child[Loop] != NULL) {
+        NewNode->Child[Loop]->Parent = NewNode;
+      }
+    }
+    for (Loop = 0; Loop <= Node->KeyCount; Loop++) {
+      if (Node->Child[Loop] != NULL) {
+        Node->Child[Loop]->Parent = Node;
+      }
+    }
+
+    //
+    // The median goes up to the parent. Splitting the root grows the tree.
+    //
+    Entry      = Entries[Median];
+    RightChild = NewNode;
+    if (Node->Parent == NULL) {
+      NewRoot           = BTreeNewNode (Tree, NULL);
+      NewRoot->Entry[0] = Entry;
+      NewRoot->Child[0] = Node;
+      NewRoot->Child[1] = NewNode;
+      NewRoot->KeyCount = 1;
+      Entry->Node       = NewRoot;
+      Node->Parent      = NewRoot;
+      NewNode->Parent   = NewRoot;
+      Tree->Root        = NewRoot;
+      return;
+    }
+    Index = BTreeChildIndex (Node);
+    Node  = Node->Parent;
+  }
+
+  for (Loop = Node->KeyCount; Loop > Index; Loop--) {
+    Node->Entry[Loop]     = Node->Entry[Loop - 1];
+    Node->Child[Loop + 1] = Node->Child[Loop];
+  }
+  Node->Entry[Index]     = Entry;
+  Node->Child[Index + 1] = RightChild;
+  Node->KeyCount++;
+  Entry->Node = Node;
+  if (RightChild != NULL) {
+    RightChild->Parent = Node;
+  }
+}
+
+
+/**
+  Insert (link) a user structure into the tree.
+
+  Read-write operation.
+
+  This function takes the new tree entry from the arena of the tree, which is
+  grown with MemoryAllocationLib's AllocatePool() function if necessary.
+
+  @param[in,out] Tree        The tree to insert UserStruct into.
+
+  @param[out]    Entry       The meaning of this optional, output-only
+                             parameter depends on the return value of the
+                             function.
+
+                             When insertion is successful (RETURN_SUCCESS),
+                             Entry is set on output to the new tree entry that
+                             now links UserStruct.
+
+                             When insertion fails due to lack of memory
+                             (RETURN_OUT_OF_RESOURCES), Entry is not changed.
+
+                             When insertion fails due to key collision (ie.
+                             another user structure is already in the tree that
+                             compares equal to UserStruct), with return value
+                             RETURN_ALREADY_STARTED, then Entry is set on
+                             output to the entry that links the colliding user
+                             structure. This enables "find-or-insert" in one
+                             function call, or helps with later removal of the
+                             colliding element.
+
+  @param[in]     UserStruct  The user structure to link into the tree.
+                             UserStruct is ordered against in-tree user
+                             structures with the Tree->UserStructCompare()
+                             function.
+
+  @retval RETURN_SUCCESS           Insertion successful. A new tree entry has
+                                   been allocated, linking UserStruct. The new
+                                   tree entry is reported back in Entry (if the
+                                   caller requested it).
+
+                                   Existing B_TREE_ENTRY pointers into Tree
+                                   remain valid. For example, on-going
+                                   iterations in the caller can continue with
+                                   OrderedCollectionNext() /
+                                   OrderedCollectionPrev(), and they will
+                                   return the new entry at some point if user
+                                   structure order dictates it.
+
+  @retval RETURN_OUT_OF_RESOURCES  AllocatePool() failed to allocate memory for
+                                   the new tree entry or nodes. The tree has
+                                   not been changed. Existing B_TREE_ENTRY
+                                   pointers into Tree remain valid.
+
+  @retval RETURN_ALREADY_STARTED   A user structure has been found in the tree
+                                   that compares equal to UserStruct. The entry
+                                   linking the colliding user structure is
+                                   reported back in Entry (if the caller
+                                   requested it). The tree has not been
+                                   changed. Existing B_TREE_ENTRY pointers into
+                                   Tree remain valid.
+**/
+RETURN_STATUS
+EFIAPI
+OrderedCollectionInsert (
+  IN OUT B_TREE       *Tree,
+  OUT    B_TREE_ENTRY **Entry      OPTIONAL,
+  IN     VOID         *UserStruct
+  )
+{
+  B_TREE_NODE   *Node;
+  B_TREE_NODE   *Leaf;
+  B_TREE_ENTRY  *NewEntry;
+  UINTN         Index;
+  UINTN         Levels;
+  BOOLEAN       Found;
+  RETURN_STATUS Status;
+
+  //
+  // First look for a collision, saving the leaf and position for the case when
+  // there's no collision.
+  //
+  Leaf   = NULL;
+  Index  = 0;
+  Levels = 0;
+  for (Node = Tree->Root; Node != NULL; Node = Node->Child[Index]) {
+    Index = BTreeNodeSearch (
+              Node,
+              (B_TREE_KEY_COMPARE)Tree->UserStructCompare,
+              UserStruct,
+              &Found
+              );
+    if (Found) {
+      if (Entry != NULL) {
+        *Entry = Node->Entry[Index];
+      }
+      Status = RETURN_ALREADY_STARTED;
+      goto Done;
+    }
+    Leaf = Node;
+    Levels++;
+  }
+
+  //
+  // No collision. Reserve everything that may be needed up front, so the tree
+  // is not touched if memory is short: the entry, and a node for each level
+  // split plus a new root.
+  //
+  if (!ArenaReserve (&Tree->EntryArena, 1) ||
+      !ArenaReserve (&Tree->NodeArena, Levels + 1)) {
+    Status = RETURN_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  NewEntry             = ArenaAllocate (&Tree->EntryArena);
+  NewEntry->UserStruct = UserStruct;
+  if (Entry != NULL) {
+    *Entry = NewEntry;
+  }
+
+  if (Leaf == NULL) {
+    Leaf       = BTreeNewNode (Tree, NULL);
+    Tree->Root = Leaf;
+  }
+  BTreeInsertEntry (Tree, Leaf, Index, NewEntry, NULL);
+  Status = RETURN_SUCCESS;
+
+Done:
+  if (FeaturePcdGet (PcdValidateOrderedCollection)) {
+    BTreeValidate (Tree);
+  }
+  return Status;
+}
+
+
+/**
+  Merge the child right to the separator entry of Parent into the child left
+  to it, pulling the separator entry down between them.
+
+  Internal read-write operation.
+
+  @param[in,out] Tree    The tree to release the right child to.
+
+  @param[in,out] Parent  The parent of the children to merge.
+
+  @param[in]     Index   The index of the separator entry in Parent.
+**/
+STATIC
+VOID
+BTreeMergeChildren (
+  IN OUT B_TREE      *Tree,
+  IN OUT B_TREE_NODE *Parent,
+  IN     UINTN       Index
+  )
+{
+  B_TREE_NODE *Left;
+  B_TREE_NODE *Right;
+  UINTN       Loop;
+
+  Left  = Parent->Child[Index];
+  Right = Parent->Child[Index + 1];
+  ASSERT (Left->KeyCount + Right->KeyCount < B_TREE_MAX_KEYS);
+
+  Left->Entry[Left->KeyCount]       = Parent->Entry[Index];
+  Left->Entry[Left->KeyCount]->Node = Left;
+  for (Loop = 0; Loop < Right->KeyCount; Loop++) {
+    Left->Entry[Left->KeyCount + 1 + Loop]       = Right->Entry[Loop];
+    Left->Entry[Left->KeyCount + 1 + Loop]->Node = Left;
+  }
+  for (Loop = 0; Loop <= Right->KeyCount; Loop++) {
+    Left->Child[Left->KeyCount + 1 + Loop] = Right->Child[Loop];
+    if (Right->Child[Loop] != NULL) {
+      Right->Child[Loop]->Parent = Left;
+    }
+  }
+  Left->KeyCount += Right->KeyCount + 1;
+
+  for (Loop = Index; Loop + 1 < Parent->KeyCount; Loop++) {
+    Parent->Entry[Loop]     = Parent->Entry[Loop + 1];
+    Parent->Child[Loop + 1] = Parent->Child[Loop + 2];
+  }
+  Parent->Child[Parent->KeyCount] = NULL;
+  Parent->KeyCount--;
+
+  ArenaFree (&Tree->NodeArena, Right);
+}
+
+
+/**
+  Restore the minimum number of entries in a node, by borrowing an entry from
+  a sibling through the parent, or by merging with a sibling. Merging may leave
+  the parent short of entries, which is then fixed up to the root.
+
+  Internal read-write operation.
+
+  @param[in,out] Tree  The tree the node belongs to.
+
+  @param[in,out] Node  The node an entry has been removed from.
+**/
+STATIC
+VOID
+BTreeRebalance (
+  IN OUT B_TREE      *Tree,
+  IN OUT B_TREE_NODE *Node
+  )
+{
+  B_TREE_NODE *Parent;
+  B_TREE_NODE *Left;
+  B_TREE_NODE *Right;
+  UINTN       Index;
+  UINTN       Loop;
+
+  while (Node->Parent != NULL && Node->KeyCount < B_TREE_MIN_KEYS) {
+    Parent = Node->Parent;
+    Index  = BTreeChildIndex (Node);
+    Left   = (Index > 0) ? Parent->Child[Index - 1] : NULL;
+    Right  = (Index < Parent->KeyCount) ? Parent->Child[Index + 1] : NULL;
+
+    if (Left != NULL && Left->KeyCount > B_TREE_MIN_KEYS) {
+      //
+      // Rotate the last entry of the left sibling up to the parent, and the
+      // separator down to the front of Node.
+      //
+      for (Loop = Node->KeyCount; Loop > 0; Loop--) {
+        Node->Entry[Loop]     = Node->Entry[Loop - 1];
+        Node->Child[Loop + 1] = Node->Child[Loop];
+      }
+      Node->Child[1]       = Node->Child[0];
+      Node->Entry[0]       = Parent->Entry[Index - 1];
+      Node->Entry[0]->Node = Node;
+      Node->Child[0]       = Left->Child[Left->KeyCount];
+      if (Node->Child[0] != NULL) {
+        Node->Child[0]->Parent = Node;
+      }
+      Node->KeyCount++;
+
+      Parent->Entry[Index - 1]       = Left->Entry[Left->KeyCount - 1];
+      Parent->Entry[Index - 1]->Node = Parent;
+      Left->Child[Left->KeyCount]    = NULL;
+      Left->KeyCount--;
+      return;
+    }
+
+    if (Right != NULL && Right->KeyCount > B_TREE_MIN_KEYS) {
+      //
+      // Rotate the first entry of the right sibling up to the parent, and the
+      // separator down to the end of Node.
+      //
+      Node->Entry[Node->KeyCount]       = Parent->Entry[Index];
+      Node->Entry[Node->KeyCount]->Node = Node;
+      Node->Child[Node->KeyCount + 1]   = Right->Child[0];
+      if (Right->Child[0] != NULL) {
+        Right->Child[0]->Parent = Node;
+      }
+      Node->KeyCount++;
+
+      Parent->Entry[Index]       = Right->Entry[0];
+      Parent->Entry[Index]->Node = Parent;
+      for (Loop = 0; Loop + 1 < Right->KeyCount; Loop++) {
+        Right->Entry[Loop] = Right->Entry[Loop + 1];
+        Right->Child[Loop] = Right->Child[Loop + 1];
+      }
+      Right->Child[Right->KeyCount - 1] = Right->Child[Right->KeyCount];
+      Right->Child[Right->KeyCount]     = NULL;
+      Right->KeyCount--;
+      return;
+    }
+
+    //
+    // Both siblings have the minimum number of entries; merge with one of
+    // them and continue with the parent.
+    //
+    BTreeMergeChildren (Tree, Parent, (Left != NULL) ? Index - 1 : Index);
+    Node = Parent;
+  }
+
+  //
+  // An empty root is replaced by its only child, if any.
+  //
+  if (Node->Parent == NULL && Node->KeyCount == 0) {
+    Tree->Root = Node->Child[0];
+    if (Tree->Root != NULL) {
+      Tree->Root->Parent = NULL;
+    }
+    ArenaFree (&Tree->NodeArena, Node);
+  }
+}
+
+
+/**
+  Delete an entry from the tree, unlinking the associated user structure.
+
+  Read-write operation.
+
+  @param[in,out] Tree        The tree to delete Entry from.
+
+  @param[in]     Entry       The tree entry to delete from Tree. The caller is
+                             responsible for ensuring that Entry belongs to
+                             Tree, and that Entry is non-NULL and valid. Entry
+                             is typically an earlier return value, or output
+                             parameter, of:
+
+                             - OrderedCollectionFind(), for deleting an entry
+                               by user structure key,
+
+                             - OrderedCollectionMin() / OrderedCollectionMax(),
+                               for deleting the minimum / maximum entry,
+
+                             - OrderedCollectionNext() /
+                               OrderedCollectionPrev(), for deleting an entry
+                               found during an iteration,
+
+                             - OrderedCollectionInsert() with return value
+                               RETURN_ALREADY_STARTED, for deleting an entry
+                               whose linked user structure caused collision
+                               during insertion.
+
+                             Entry is returned to the arena of the tree, and
+                             the memory is released by
+                             OrderedCollectionUninit().
+
+                             Existing B_TREE_ENTRY pointers (ie. iterators)
+                             *different* from Entry remain valid. For example:
+
+                             - OrderedCollectionNext() /
+                               OrderedCollectionPrev() iterations in the caller
+                               can be continued from Entry, if
+                               OrderedCollectionNext() or
+                               OrderedCollectionPrev() is called on Entry
+                               *before* OrderedCollectionDelete() is. That is,
+                               fetch the successor / predecessor entry first,
+                               then delete Entry.
+
+                             - On-going iterations in the caller that would
+                               have otherwise returned Entry at some point, as
+                               dictated by user structure order, will correctly
+                               reflect the absence of Entry after
+                               OrderedCollectionDelete() is called
+                               mid-iteration.
+
+  @param[out]    UserStruct  If the caller provides this optional output-only
+                             parameter, then on output it is set to the user
+                             structure originally linked by Entry (which is now
+                             freed).
+
+                             This is a convenience that may save the caller a
+                             OrderedCollectionUserStruct() invocation before
+                             calling OrderedCollectionDelete(), in order to
+                             retrieve the user structure being unlinked.
+**/
+VOID
+EFIAPI
+OrderedCollectionDelete (
+  IN OUT B_TREE       *Tree,
+  IN     B_TREE_ENTRY *Entry,
+  OUT    VOID         **UserStruct OPTIONAL
+  )
+{
+  B_TREE_NODE  *Node;
+  B_TREE_NODE  *Leaf;
+  B_TREE_ENTRY *Predecessor;
+  UINTN        Index;
+
+  if (UserStruct != NULL) {
+    *UserStruct = Entry->UserStruct;
+  }
+
+  Node  = Entry->Node;
+  Index = BTreeEntryIndex (Entry);
+
+  //
+  // Entries are only removed from leaves. An entry of an internal node is
+  // replaced by its predecessor, which is always in a leaf.
+  //
+  if (Node->Child[0] != NULL) {
+    Leaf = Node->Child[Index];
+    while (Leaf->Child[Leaf->KeyCount] != NULL) {
+      Leaf = Leaf->Child[Leaf->KeyCount];
+    }
+    Predecessor        = Leaf->Entry[Leaf->KeyCount - 1];
+    Node->Entry[Index] = Predecessor;
+    Predecessor->Node  = Node;
+    Node               = Leaf;
+    Index              = Leaf->KeyCount - 1;
+  }
+
+  for (; Index + 1 < Node->KeyCount; Index++) {
+    Node->Entry[Index] = Node->Entry[Index + 1];
+  }
+  Node->KeyCount--;
+  ArenaFree (&Tree->EntryArena, Entry);
+
+  BTreeRebalance (Tree, Node);
+
+  if (FeaturePcdGet (PcdValidateOrderedCollection)) {
+    BTreeValidate (Tree);
+  }
+}
+
+
+/**
+  Recursively check the B-tree properties on a node: the number of entries,
+  the links between entries, nodes and parents, and the ordering of the user
+  structures within the node.
+
+  @param[in] Tree    The tree the node belongs to.
+
+  @param[in] Node    The root of the subtree to validate.
+
+  @param[in] Parent  The expected parent of Node.
+
+  @retval  The height of the subtree.
+**/
+UINT32
+BTreeRecursiveCheck (
+  IN CONST B_TREE      *Tree,
+  IN CONST B_TREE_NODE *Node,
+  IN CONST B_TREE_NODE *Parent
+  )
+{
+  UINTN  Index;
+  UINT32 Height;
+
+  ASSERT (Node->Parent == Parent);
+  ASSERT (Node->KeyCount <= B_TREE_MAX_KEYS);
+  ASSERT (Node->KeyCount >= ((Parent == NULL) ? 1 : B_TREE_MIN_KEYS));
+
+  for (Index = 0; Index < Node->KeyCount; Index++) {
+    ASSERT (Node->Entry[Index]->Node == Node);
+    if (Index > 0) {
+      ASSERT (Tree->UserStructCompare (Node->Entry[Index - 1]->UserStruct,
+                Node->Entry[Index]->UserStruct) < 0);
+    }
+  }
+  for (Index = Node->KeyCount + 1; Index <= B_TREE_MAX_KEYS; Index++) {
+    ASSERT (Node->Child[Index] == NULL);
+  }
+
+  //
+  // All leaves are at the same depth.
+  //
+  if (Node->Child[0] == NULL) {
+    for (Index = 1; Index <= Node->KeyCount; Index++) {
+      ASSERT (Node->Child[Index] == NULL);
+    }
+    return 1;
+  }
+  Height = BTreeRecursiveCheck (Tree, Node->Child[0], Node);
+  for (Index = 1; Index <= Node->KeyCount; Index++) {
+    ASSERT (Node->Child[Index] != NULL);
+    ASSERT (BTreeRecursiveCheck (Tree, Node->Child[Index], Node) == Height);
+  }
+  return Height + 1;
+}
+
+
+/**
+  A slow function that asserts that the tree is a valid B-tree, and that it
+  orders user structures correctly.
+
+  Read-only operation.
+
+  This function uses the stack for recursion and is not recommended for
+  "production use".
+
+  @param[in] Tree  The tree to validate.
+**/
+VOID
+BTreeValidate (
+  IN CONST B_TREE *Tree
+  )
+{
+  UINT32             Height;
+  UINT32             ForwardCount;
+  UINT32             BackwardCount;
+  CONST B_TREE_ENTRY *Last;
+  CONST B_TREE_ENTRY *Entry;
+
+  DEBUG ((DEBUG_VERBOSE, "%a: Tree=%p\n", __FUNCTION__, Tree));
+
+  Height = 0;
+  if (Tree->Root != NULL) {
+    Height = BTreeRecursiveCheck (Tree, Tree->Root, NULL);
+  }
+
+  //
+  // forward ordering
+  //
+  Last = OrderedCollectionMin (Tree);
+  ForwardCount = (Last != NULL);
+  for (Entry = OrderedCollectionNext (Last); Entry != NULL;
+       Entry = OrderedCollectionNext (Last)) {
+    ASSERT (Tree->UserStructCompare (Last->UserStruct, Entry->UserStruct) < 0);
+    Last = Entry;
+    ++ForwardCount;
+  }
+
+  //
+  // backward ordering
+  //
+  Last = OrderedCollectionMax (Tree);
+  BackwardCount = (Last != NULL);
+  for (Entry = OrderedCollectionPrev (Last); Entry != NULL;
+       Entry = OrderedCollectionPrev (Last)) {
+    ASSERT (Tree->UserStructCompare (Last->UserStruct, Entry->UserStruct) > 0);
+    Last = Entry;
+    ++BackwardCount;
+  }
+
+  ASSERT (ForwardCount == BackwardCount);
+
+  DEBUG ((DEBUG_VERBOSE, "%a: Tree=%p Height=%Ld Count=%Ld\n",
+    __FUNCTION__, Tree, (INT64)Height, (INT64)ForwardCount));
+}
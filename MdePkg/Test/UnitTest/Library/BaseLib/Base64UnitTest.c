@@ -383,6 +383,132 @@ SafeStringContraintCheckTest (
   return UNIT_TEST_PASSED;
 }
 
+#define STRING_TEST_MAX_OFFSET  16
+#define STRING_TEST_MAX_LENGTH  40
+#define STRING_TEST_BUFFER_SIZE (STRING_TEST_MAX_OFFSET + STRING_TEST_MAX_LENGTH + 2)
+
+/**
+  Check StrLen(), StrnLenS() and StrCmp(), which scan whole UINTN words at a
+  time, against the expected results for all the string alignments, lengths
+  and positions of the first mismatched character.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+UnicodeStringLengthAndCompareTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT64  FirstBuffer[STRING_TEST_BUFFER_SIZE * sizeof (CHAR16) / sizeof (UINT64) + 1];
+  UINT64  SecondBuffer[STRING_TEST_BUFFER_SIZE * sizeof (CHAR16) / sizeof (UINT64) + 1];
+  CHAR16  *First;
+  CHAR16  *Second;
+  UINTN   Offset;
+  UINTN   SecondOffset;
+  UINTN   Length;
+  UINTN   MaxSize;
+  UINTN   Index;
+
+  for (Offset = 0; Offset < STRING_TEST_MAX_OFFSET; Offset++) {
+    for (Length = 0; Length <= STRING_TEST_MAX_LENGTH; Length++) {
+      //
+      // The characters after the Null-terminator are non-zero, so a scan going
+      // past it is noticed.
+      //
+      SetMem (FirstBuffer, sizeof (FirstBuffer), 0xA5);
+      First = (CHAR16 *) FirstBuffer + Offset;
+      for (Index = 0; Index < Length; Index++) {
+        First[Index] = (CHAR16) (BIT15 | (Index + 1));
+      }
+      First[Length] = L'\0';
+
+      UT_ASSERT_EQUAL (StrLen (First), Length);
+      for (MaxSize = 0; MaxSize <= Length + 1; MaxSize++) {
+        UT_ASSERT_EQUAL (StrnLenS (First, MaxSize), MIN (Length, MaxSize));
+      }
+
+      for (SecondOffset = 0; SecondOffset < STRING_TEST_MAX_OFFSET; SecondOffset++) {
+        SetMem (SecondBuffer, sizeof (SecondBuffer), 0x5A);
+        Second = (CHAR16 *) SecondBuffer + SecondOffset;
+        CopyMem (Second, First, (Length + 1) * sizeof (CHAR16));
+        UT_ASSERT_EQUAL (StrCmp (First, Second), 0);
+
+        for (Index = 0; Index < Length; Index++) {
+          Second[Index] ^= BIT14;
+          UT_ASSERT_EQUAL (StrCmp (First, Second), (INTN) First[Index] - (INTN) Second[Index]);
+          Second[Index] ^= BIT14;
+        }
+
+        Second[Length]     = L'A';
+        Second[Length + 1] = L'\0';
+        UT_ASSERT_EQUAL (StrCmp (First, Second), -(INTN) L'A');
+        UT_ASSERT_EQUAL (StrCmp (Second, First), (INTN) L'A');
+      }
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Check AsciiStrLen(), AsciiStrnLenS() and AsciiStrCmp(), which scan whole
+  UINTN words at a time, against the expected results for all the string
+  alignments, lengths and positions of the first mismatched character.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+AsciiStringLengthAndCompareTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT64  FirstBuffer[STRING_TEST_BUFFER_SIZE / sizeof (UINT64) + 1];
+  UINT64  SecondBuffer[STRING_TEST_BUFFER_SIZE / sizeof (UINT64) + 1];
+  CHAR8   *First;
+  CHAR8   *Second;
+  UINTN   Offset;
+  UINTN   SecondOffset;
+  UINTN   Length;
+  UINTN   MaxSize;
+  UINTN   Index;
+
+  for (Offset = 0; Offset < STRING_TEST_MAX_OFFSET; Offset++) {
+    for (Length = 0; Length <= STRING_TEST_MAX_LENGTH; Length++) {
+      SetMem (FirstBuffer, sizeof (FirstBuffer), 0xA5);
+      First = (CHAR8 *) FirstBuffer + Offset;
+      for (Index = 0; Index < Length; Index++) {
+        First[Index] = (CHAR8) (BIT7 | (Index + 1));
+      }
+      First[Length] = '\0';
+
+      UT_ASSERT_EQUAL (AsciiStrLen (First), Length);
+      for (MaxSize = 0; MaxSize <= Length + 1; MaxSize++) {
+        UT_ASSERT_EQUAL (AsciiStrnLenS (First, MaxSize), MIN (Length, MaxSize));
+      }
+
+      for (SecondOffset = 0; SecondOffset < STRING_TEST_MAX_OFFSET; SecondOffset++) {
+        SetMem (SecondBuffer, sizeof (SecondBuffer), 0x5A);
+        Second = (CHAR8 *) SecondBuffer + SecondOffset;
+        CopyMem (Second, First, Length + 1);
+        UT_ASSERT_EQUAL (AsciiStrCmp (First, Second), 0);
+
+        for (Index = 0; Index < Length; Index++) {
+          Second[Index] ^= BIT6;
+          UT_ASSERT_EQUAL (AsciiStrCmp (First, Second), (INTN) First[Index] - (INTN) Second[Index]);
+          Second[Index] ^= BIT6;
+        }
+
+        Second[Length]     = 'A';
+        Second[Length + 1] = '\0';
+        UT_ASSERT_EQUAL (AsciiStrCmp (First, Second), -(INTN) 'A');
+        UT_ASSERT_EQUAL (AsciiStrCmp (Second, First), (INTN) 'A');
+      }
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
 /**
   Initialze the unit test framework, suite, and unit tests for the
   Base64 conversion APIs of BaseLib and run the unit tests.
@@ -473,6 +599,8 @@ UnitTestingEntry (
 
   // --------------Suite-----------Description--------------Class Name----------Function--------Pre---Post-------------------Context-----------
   AddTestCase (SafeStringTests, "SAFE_STRING_CONSTRAINT_CHECK", "SafeStringContraintCheckTest", SafeStringContraintCheckTest, NULL, NULL, NULL);
+  AddTestCase (SafeStringTests, "Unicode string length and compare", "UnicodeStringLengthAndCompareTest", UnicodeStringLengthAndCompareTest, NULL, NULL, NULL);
+  AddTestCase (SafeStringTests, "Ascii string length and compare", "AsciiStringLengthAndCompareTest", AsciiStringLengthAndCompareTest, NULL, NULL, NULL);
 
   //
   // Execute the tests.
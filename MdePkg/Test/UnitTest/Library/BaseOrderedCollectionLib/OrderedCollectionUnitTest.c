@@ -0,0 +1,520 @@
+/** @file
+  Unit tests of the OrderedCollectionLib class.
+
+  The tests only use the library class interface, so they are built against
+  every instance: BaseOrderedCollectionBTreeLib and
+  BaseOrderedCollectionRedBlackTreeLib. The benchmark timings of the two builds
+  compare the instances.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/OrderedCollectionLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "OrderedCollectionLib Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define TEST_SEED                 0x4F524443
+#define TEST_ITEM_COUNT           10000
+#define BENCHMARK_MAX_ITEM_COUNT  1000000
+
+typedef struct {
+  UINTN  Key;
+} TEST_ITEM;
+
+/**
+  Compare two TEST_ITEM by key.
+
+  @param[in]  UserStruct1  Pointer to the first TEST_ITEM.
+  @param[in]  UserStruct2  Pointer to the second TEST_ITEM.
+
+  @retval <0  UserStruct1 compares less than UserStruct2.
+  @retval 0   UserStruct1 compares equal to UserStruct2.
+  @retval >0  UserStruct1 compares greater than UserStruct2.
+**/
+STATIC
+INTN
+EFIAPI
+ItemCompare (
+  IN CONST VOID  *UserStruct1,
+  IN CONST VOID  *UserStruct2
+  )
+{
+  UINTN  Key1;
+  UINTN  Key2;
+
+  Key1 = ((CONST TEST_ITEM *)UserStruct1)->Key;
+  Key2 = ((CONST TEST_ITEM *)UserStruct2)->Key;
+  return (Key1 < Key2) ? -1 : (Key1 > Key2) ? 1 : 0;
+}
+
+/**
+  Compare a standalone key with the key of a TEST_ITEM.
+
+  @param[in]  StandaloneKey  Pointer to the UINTN key.
+  @param[in]  UserStruct     Pointer to the TEST_ITEM.
+
+  @retval <0  StandaloneKey compares less than UserStruct's key.
+  @retval 0   StandaloneKey compares equal to UserStruct's key.
+  @retval >0  StandaloneKey compares greater than UserStruct's key.
+**/
+STATIC
+INTN
+EFIAPI
+KeyCompare (
+  IN CONST VOID  *StandaloneKey,
+  IN CONST VOID  *UserStruct
+  )
+{
+  UINTN  Key1;
+  UINTN  Key2;
+
+  Key1 = *(CONST UINTN *)StandaloneKey;
+  Key2 = ((CONST TEST_ITEM *)UserStruct)->Key;
+  return (Key1 < Key2) ? -1 : (Key1 > Key2) ? 1 : 0;
+}
+
+/**
+  Return a random number below Limit, also on hosts whose RAND_MAX is 0x7FFF.
+
+  @param[in]  Limit  The upper bound, exclusive.
+
+  @return The random number.
+**/
+STATIC
+UINTN
+Random (
+  IN UINTN  Limit
+  )
+{
+  return (((UINTN)rand () << 15) ^ (UINTN)rand ()) % Limit;
+}
+
+/**
+  Allocate Count items with the even keys 0, 2, ... 2 * (Count - 1), in random
+  order. The odd keys are never inserted.
+
+  @param[in]  Count  The number of items.
+
+  @return The items, or NULL if out of memory.
+**/
+STATIC
+TEST_ITEM *
+CreateShuffledItems (
+  IN UINTN  Count
+  )
+{
+  TEST_ITEM  *Items;
+  UINTN      Index;
+  UINTN      Other;
+  UINTN      Key;
+
+  Items = AllocatePool (Count * sizeof (TEST_ITEM));
+  if (Items == NULL) {
+    return NULL;
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    Items[Index].Key = 2 * Index;
+  }
+  srand (TEST_SEED);
+  for (Index = Count; Index > 1; Index--) {
+    Other                = Random (Index);
+    Key                  = Items[Index - 1].Key;
+    Items[Index - 1].Key = Items[Other].Key;
+    Items[Other].Key     = Key;
+  }
+
+  return Items;
+}
+
+/**
+  Walk the collection both ways and check it holds Count items in order.
+
+  @param[in]  Collection  The collection to check.
+  @param[in]  Count       The expected number of items.
+
+  @retval UNIT_TEST_PASSED             The collection is ordered.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+CheckOrder (
+  IN ORDERED_COLLECTION  *Collection,
+  IN UINTN               Count
+  )
+{
+  ORDERED_COLLECTION_ENTRY  *Entry;
+  ORDERED_COLLECTION_ENTRY  *Previous;
+  UINTN                     Seen;
+
+  Previous = NULL;
+  Seen     = 0;
+  for (Entry = OrderedCollectionMin (Collection); Entry != NULL; Entry = OrderedCollectionNext (Entry)) {
+    if (Previous != NULL) {
+      UT_ASSERT_TRUE (ItemCompare (OrderedCollectionUserStruct (Previous), OrderedCollectionUserStruct (Entry)) < 0);
+      UT_ASSERT_EQUAL ((UINTN)OrderedCollectionPrev (Entry), (UINTN)Previous);
+    }
+    Previous = Entry;
+    Seen++;
+  }
+  UT_ASSERT_EQUAL (Seen, Count);
+  UT_ASSERT_EQUAL ((UINTN)OrderedCollectionMax (Collection), (UINTN)Previous);
+
+  Seen = 0;
+  for (Entry = OrderedCollectionMax (Collection); Entry != NULL; Entry = OrderedCollectionPrev (Entry)) {
+    Seen++;
+  }
+  UT_ASSERT_EQUAL (Seen, Count);
+  UT_ASSERT_EQUAL (OrderedCollectionIsEmpty (Collection), (BOOLEAN)(Count == 0));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Inserted items should be found, in order, and inserted only once.
+
+  @param[in]  Context  Ignored.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+InsertShouldBeFound (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ORDERED_COLLECTION        *Collection;
+  ORDERED_COLLECTION_ENTRY  *Entry;
+  ORDERED_COLLECTION_ENTRY  *Found;
+  TEST_ITEM                 *Items;
+  TEST_ITEM                 Duplicate;
+  UINTN                     Index;
+  UINTN                     Key;
+  VOID                      *UserStruct;
+
+  Items      = CreateShuffledItems (TEST_ITEM_COUNT);
+  Collection = OrderedCollectionInit (ItemCompare, KeyCompare);
+  UT_ASSERT_NOT_NULL (Items);
+  UT_ASSERT_NOT_NULL (Collection);
+  UT_ASSERT_TRUE (OrderedCollectionIsEmpty (Collection));
+  UT_ASSERT_EQUAL ((UINTN)OrderedCollectionMin (Collection), (UINTN)NULL);
+  UT_ASSERT_EQUAL ((UINTN)OrderedCollectionMax (Collection), (UINTN)NULL);
+
+  for (Index = 0; Index < TEST_ITEM_COUNT; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (OrderedCollectionInsert (Collection, &Entry, &Items[Index]));
+    UT_ASSERT_EQUAL ((UINTN)OrderedCollectionUserStruct (Entry), (UINTN)&Items[Index]);
+  }
+  UT_ASSERT_EQUAL (CheckOrder (Collection, TEST_ITEM_COUNT), UNIT_TEST_PASSED);
+
+  for (Index = 0; Index < TEST_ITEM_COUNT; Index++) {
+    Found = OrderedCollectionFind (Collection, &Items[Index].Key);
+    UT_ASSERT_NOT_NULL (Found);
+    UT_ASSERT_EQUAL ((UINTN)OrderedCollectionUserStruct (Found), (UINTN)&Items[Index]);
+
+    //
+    // An item with the same key is not inserted, and the existing entry is
+    // returned.
+    //
+    Duplicate.Key = Items[Index].Key;
+    UT_ASSERT_STATUS_EQUAL (OrderedCollectionInsert (Collection, &Entry, &Duplicate), RETURN_ALREADY_STARTED);
+    UT_ASSERT_EQUAL ((UINTN)Entry, (UINTN)Found);
+
+    Key = Items[Index].Key + 1;
+    UT_ASSERT_EQUAL ((UINTN)OrderedCollectionFind (Collection, &Key), (UINTN)NULL);
+  }
+  UT_ASSERT_EQUAL (CheckOrder (Collection, TEST_ITEM_COUNT), UNIT_TEST_PASSED);
+
+  while (!OrderedCollectionIsEmpty (Collection)) {
+    OrderedCollectionDelete (Collection, OrderedCollectionMin (Collection), &UserStruct);
+  }
+  OrderedCollectionUninit (Collection);
+  FreePool (Items);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Deleting items should keep the others in order, and link the neighbors of
+  every deleted entry together.
+
+  @param[in]  Context  Ignored.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+DeleteShouldKeepOrder (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ORDERED_COLLECTION        *Collection;
+  ORDERED_COLLECTION_ENTRY  *Entry;
+  ORDERED_COLLECTION_ENTRY  *Previous;
+  ORDERED_COLLECTION_ENTRY  *Next;
+  TEST_ITEM                 *Items;
+  UINTN                     Index;
+  VOID                      *UserStruct;
+
+  Items      = CreateShuffledItems (TEST_ITEM_COUNT);
+  Collection = OrderedCollectionInit (ItemCompare, KeyCompare);
+  UT_ASSERT_NOT_NULL (Items);
+  UT_ASSERT_NOT_NULL (Collection);
+
+  for (Index = 0; Index < TEST_ITEM_COUNT; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (OrderedCollectionInsert (Collection, NULL, &Items[Index]));
+  }
+
+  //
+  // Delete in the random order of insertion, so that entries are taken from
+  // leaves and inner nodes alike.
+  //
+  for (Index = 0; Index < TEST_ITEM_COUNT; Index++) {
+    Entry = OrderedCollectionFind (Collection, &Items[Index].Key);
+    UT_ASSERT_NOT_NULL (Entry);
+    Previous = OrderedCollectionPrev (Entry);
+    Next     = OrderedCollectionNext (Entry);
+
+    UserStruct = NULL;
+    OrderedCollectionDelete (Collection, Entry, &UserStruct);
+    UT_ASSERT_EQUAL ((UINTN)UserStruct, (UINTN)&Items[Index]);
+    UT_ASSERT_EQUAL ((UINTN)OrderedCollectionFind (Collection, &Items[Index].Key), (UINTN)NULL);
+
+    if (Previous != NULL) {
+      UT_ASSERT_EQUAL ((UINTN)OrderedCollectionNext (Previous), (UINTN)Next);
+    } else {
+      UT_ASSERT_EQUAL ((UINTN)OrderedCollectionMin (Collection), (UINTN)Next);
+    }
+    if (Next != NULL) {
+      UT_ASSERT_EQUAL ((UINTN)OrderedCollectionPrev (Next), (UINTN)Previous);
+    } else {
+      UT_ASSERT_EQUAL ((UINTN)OrderedCollectionMax (Collection), (UINTN)Previous);
+    }
+
+    if ((Index % (TEST_ITEM_COUNT / 10)) == 0) {
+      UT_ASSERT_EQUAL (CheckOrder (Collection, TEST_ITEM_COUNT - Index - 1), UNIT_TEST_PASSED);
+    }
+  }
+  UT_ASSERT_EQUAL (CheckOrder (Collection, 0), UNIT_TEST_PASSED);
+
+  OrderedCollectionUninit (Collection);
+  FreePool (Items);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A collection emptied by deletes should be reusable, then released by
+  OrderedCollectionUninit().
+
+  @param[in]  Context  Ignored.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+UninitShouldReleaseEmptyCollection (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ORDERED_COLLECTION        *Collection;
+  TEST_ITEM                 *Items;
+  UINTN                     Round;
+  UINTN                     Index;
+  VOID                      *UserStruct;
+
+  //
+  // A collection never used.
+  //
+  Collection = OrderedCollectionInit (ItemCompare, KeyCompare);
+  UT_ASSERT_NOT_NULL (Collection);
+  OrderedCollectionUninit (Collection);
+
+  Items      = CreateShuffledItems (TEST_ITEM_COUNT);
+  Collection = OrderedCollectionInit (ItemCompare, KeyCompare);
+  UT_ASSERT_NOT_NULL (Items);
+  UT_ASSERT_NOT_NULL (Collection);
+
+  for (Round = 0; Round < 3; Round++) {
+    for (Index = 0; Index < TEST_ITEM_COUNT; Index++) {
+      UT_ASSERT_NOT_EFI_ERROR (OrderedCollectionInsert (Collection, NULL, &Items[Index]));
+    }
+    UT_ASSERT_EQUAL (CheckOrder (Collection, TEST_ITEM_COUNT), UNIT_TEST_PASSED);
+
+    while (!OrderedCollectionIsEmpty (Collection)) {
+      OrderedCollectionDelete (Collection, OrderedCollectionMax (Collection), &UserStruct);
+    }
+    UT_ASSERT_EQUAL (CheckOrder (Collection, 0), UNIT_TEST_PASSED);
+  }
+
+  OrderedCollectionUninit (Collection);
+  FreePool (Items);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Benchmark of the OrderedCollectionLib instance.
+
+  For 10^3 to 10^6 items in random order, the time taken to insert all items,
+  find all of them, walk the collection in order, and delete all of them is
+  logged.
+
+  @param[in]  Context  Ignored.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+OrderedCollectionBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ORDERED_COLLECTION        *Collection;
+  ORDERED_COLLECTION_ENTRY  *Entry;
+  TEST_ITEM                 *Items;
+  UINTN                     Count;
+  UINTN                     Index;
+  UINTN                     Seen;
+  clock_t                   Start;
+  clock_t                   Insert;
+  clock_t                   Find;
+  clock_t                   Walk;
+  clock_t                   Delete;
+
+  for (Count = 1000; Count <= BENCHMARK_MAX_ITEM_COUNT; Count *= 10) {
+    Items      = CreateShuffledItems (Count);
+    Collection = OrderedCollectionInit (ItemCompare, KeyCompare);
+    UT_ASSERT_NOT_NULL (Items);
+    UT_ASSERT_NOT_NULL (Collection);
+
+    Start = clock ();
+    for (Index = 0; Index < Count; Index++) {
+      OrderedCollectionInsert (Collection, NULL, &Items[Index]);
+    }
+    Insert = clock () - Start;
+
+    Start = clock ();
+    Seen  = 0;
+    for (Index = 0; Index < Count; Index++) {
+      if (OrderedCollectionFind (Collection, &Items[Index].Key) != NULL) {
+        Seen++;
+      }
+    }
+    Find = clock () - Start;
+    UT_ASSERT_EQUAL (Seen, Count);
+
+    Start = clock ();
+    Seen  = 0;
+    for (Entry = OrderedCollectionMin (Collection); Entry != NULL; Entry = OrderedCollectionNext (Entry)) {
+      Seen++;
+    }
+    Walk = clock () - Start;
+    UT_ASSERT_EQUAL (Seen, Count);
+
+    Start = clock ();
+    for (Index = 0; Index < Count; Index++) {
+      OrderedCollectionDelete (Collection, OrderedCollectionFind (Collection, &Items[Index].Key), NULL);
+    }
+    Delete = clock () - Start;
+    UT_ASSERT_TRUE (OrderedCollectionIsEmpty (Collection));
+
+    UT_LOG_INFO (
+      "%a, %Lu items: insert %Lu us, find %Lu us, walk %Lu us, delete %Lu us\n",
+      gEfiCallerBaseName,
+      (UINT64)Count,
+      (UINT64)Insert * 1000000 / CLOCKS_PER_SEC,
+      (UINT64)Find * 1000000 / CLOCKS_PER_SEC,
+      (UINT64)Walk * 1000000 / CLOCKS_PER_SEC,
+      (UINT64)Delete * 1000000 / CLOCKS_PER_SEC
+      );
+
+    OrderedCollectionUninit (Collection);
+    FreePool (Items);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  OrderedCollectionLib class and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      CollectionTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&CollectionTests, Framework, "OrderedCollectionLib Tests", "OrderedCollectionLib", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for CollectionTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (CollectionTests, "Inserted items should be found in order", "Insert", InsertShouldBeFound, NULL, NULL, NULL);
+  AddTestCase (CollectionTests, "Deletes should keep the order", "Delete", DeleteShouldKeepOrder, NULL, NULL, NULL);
+  AddTestCase (CollectionTests, "Uninit should release an emptied collection", "Uninit", UninitShouldReleaseEmptyCollection, NULL, NULL, NULL);
+  AddTestCase (CollectionTests, "Benchmark OrderedCollectionLib", "Benchmark", OrderedCollectionBenchmark, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
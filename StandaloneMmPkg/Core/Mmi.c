@@ -25,6 +25,7 @@ typedef struct {
 
   EFI_GUID    HandlerType; // Type of interrupt
   LIST_ENTRY  MmiHandlers; // All handlers
+  LIST_ENTRY  HashLink;    // Link on the mMmiEntryHash bucket of HandlerType
 } MMI_ENTRY;
 
 #define MMI_HANDLER_SIGNATURE  SIGNATURE_32('m','m','i','h')
@@ -39,6 +40,35 @@ typedef struct {
 LIST_ENTRY  mRootMmiHandlerList = INITIALIZE_LIST_HEAD_VARIABLE (mRootMmiHandlerList);
 LIST_ENTRY  mMmiEntryList       = INITIALIZE_LIST_HEAD_VARIABLE (mMmiEntryList);
 
+//
+// MMI entries hashed by HandlerType, so that MmiManage() does not need to walk
+// every registered entry on each MM communication. The buckets are initialized
+// statically: the library constructors StandaloneMmMain() calls first may
+// already register MMI handlers.
+//
+#define MMI_ENTRY_HASH_BUCKETS(Index) \
+  INITIALIZE_LIST_HEAD_VARIABLE (mMmiEntryHash[(Index)]),     \
+  INITIALIZE_LIST_HEAD_VARIABLE (mMmiEntryHash[(Index) + 1]), \
+  INITIALIZE_LIST_HEAD_VARIABLE (mMmiEntryHash[(Index) + 2]), \
+  INITIALIZE_LIST_HEAD_VARIABLE (mMmiEntryHash[(Index) + 3]), \
+  INITIALIZE_LIST_HEAD_VARIABLE (mMmiEntryHash[(Index) + 4]), \
+  INITIALIZE_LIST_HEAD_VARIABLE (mMmiEntryHash[(Index) + 5]), \
+  INITIALIZE_LIST_HEAD_VARIABLE (mMmiEntryHash[(Index) + 6]), \
+  INITIALIZE_LIST_HEAD_VARIABLE (mMmiEntryHash[(Index) + 7])
+
+LIST_ENTRY  mMmiEntryHash[] = {
+  MMI_ENTRY_HASH_BUCKETS (0),
+  MMI_ENTRY_HASH_BUCKETS (8),
+  MMI_ENTRY_HASH_BUCKETS (16),
+  MMI_ENTRY_HASH_BUCKETS (24),
+  MMI_ENTRY_HASH_BUCKETS (32),
+  MMI_ENTRY_HASH_BUCKETS (40),
+  MMI_ENTRY_HASH_BUCKETS (48),
+  MMI_ENTRY_HASH_BUCKETS (56)
+};
+
+#define MMI_ENTRY_HASH_SIZE  ARRAY_SIZE (mMmiEntryHash)
+
 /**
   Finds the MMI entry for the requested handler type.
 
@@ -55,19 +85,22 @@ MmCoreFindMmiEntry (
   IN BOOLEAN   Create
   )
 {
+  LIST_ENTRY  *Bucket;
   LIST_ENTRY  *Link;
   MMI_ENTRY   *Item;
   MMI_ENTRY   *MmiEntry;
 
+  Bucket = &mMmiEntryHash[ReadUnaligned32 ((UINT32 *) HandlerType) % MMI_ENTRY_HASH_SIZE];
+
   //
-  // Search the MMI entry list for the matching GUID
+  // Search the MMI entry hash bucket for the matching GUID
   //
   MmiEntry = NULL;
-  for (Link = mMmiEntryList.ForwardLink;
-       Link != &mMmiEntryList;
+  for (Link = Bucket->ForwardLink;
+       Link != Bucket;
        Link = Link->ForwardLink) {
 
-    Item = CR (Link, MMI_ENTRY, AllEntries, MMI_ENTRY_SIGNATURE);
+    Item = CR (Link, MMI_ENTRY, HashLink, MMI_ENTRY_SIGNATURE);
     if (CompareGuid (&Item->HandlerType, HandlerType)) {
       //
       // This is the MMI entry
@@ -95,6 +128,7 @@ MmCoreFindMmiEntry (
       // Add it to MMI entry list
       //
       InsertTailList (&mMmiEntryList, &MmiEntry->AllEntries);
+      InsertTailList (Bucket, &MmiEntry->HashLink);
     }
   }
   return MmiEntry;
@@ -323,6 +357,7 @@ MmiHandlerUnRegister (
     // No handler registered for this interrupt now, remove the MMI_ENTRY
     //
     RemoveEntryList (&MmiEntry->AllEntries);
+    RemoveEntryList (&MmiEntry->HashLink);
 
     FreePool (MmiEntry);
   }
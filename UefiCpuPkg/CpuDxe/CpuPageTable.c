@@ -60,6 +60,8 @@
 #define MAX_DEBUG_MESSAGE_LENGTH  0x100
 #define IA32_PF_EC_ID             BIT4
 
+#define MAX_MERGED_PAGE_TABLE_COUNT  64
+
 typedef enum {
   PageNone,
   Page4K,
@@ -87,6 +89,7 @@ PAGE_ATTRIBUTE_TABLE mPageAttributeTable[] = {
 
 PAGE_TABLE_POOL                   *mPageTablePool = NULL;
 BOOLEAN                           mPageTablePoolLock = FALSE;
+VOID                              *mFreePageTableList = NULL;
 PAGE_TABLE_LIB_PAGING_CONTEXT     mPagingContext;
 EFI_SMM_BASE2_PROTOCOL            *mSmmBase2 = NULL;
 
@@ -353,6 +356,60 @@ GetPageTableEntry (
   return &L1PageTable[Index1];
 }
 
+/**
+  Return the page directory entry at 2M or 1G level which covers the address,
+  no matter whether it maps a large page or points to a next level page table.
+
+  @param[in]  PagingContext     The paging context.
+  @param[in]  Address           The address to be checked.
+  @param[in]  PageAttribute     The level of the entry, Page2M or Page1G.
+
+  @return The page directory entry, or NULL if the address is mapped by a
+          larger page or not mapped.
+**/
+UINT64 *
+GetPageDirectoryEntry (
+  IN  PAGE_TABLE_LIB_PAGING_CONTEXT     *PagingContext,
+  IN  PHYSICAL_ADDRESS                  Address,
+  IN  PAGE_ATTRIBUTE                    PageAttribute
+  )
+{
+  UINT64                *PageTable;
+  UINT64                *PageEntry;
+  UINTN                 Level;
+  UINTN                 StopLevel;
+  UINT64                AddressEncMask;
+
+  ASSERT (PageAttribute == Page2M || PageAttribute == Page1G);
+
+  AddressEncMask = PcdGet64 (PcdPteMemoryEncryptionAddressOrMask) & PAGING_1G_ADDRESS_MASK_64;
+
+  if (PagingContext->MachineType == IMAGE_FILE_MACHINE_X64) {
+    PageTable = (UINT64 *)(UINTN)PagingContext->ContextData.X64.PageTableBase;
+    if ((PagingContext->ContextData.X64.Attributes & PAGE_TABLE_LIB_PAGING_CONTEXT_IA32_X64_ATTRIBUTES_5_LEVEL) != 0) {
+      Level = 5;
+    } else {
+      Level = 4;
+    }
+  } else {
+    PageTable = (UINT64 *)(UINTN)PagingContext->ContextData.Ia32.PageTableBase;
+    Level = 3;
+  }
+
+  StopLevel = (PageAttribute == Page1G) ? 3 : 2;
+  while (TRUE) {
+    PageEntry = &PageTable[(UINTN)RShiftU64 (Address, 12 + 9 * (Level - 1)) & PAGING_PAE_INDEX_MASK];
+    if (Level == StopLevel) {
+      return PageEntry;
+    }
+    if ((*PageEntry == 0) || ((Level == 3) && ((*PageEntry & IA32_PG_PS) != 0))) {
+      return NULL;
+    }
+    PageTable = (UINT64 *)(UINTN)(*PageEntry & ~AddressEncMask & PAGING_4K_ADDRESS_MASK_64);
+    Level--;
+  }
+}
+
 /**
   Return memory attributes of page entry.
 
@@ -590,6 +647,75 @@ SplitPage (
   }
 }
 
+/**
+  This function merges the page table pointed by a page directory entry into
+  one large page, if all entries in the page table map contiguous memory with
+  the same attributes. It is the reverse operation of SplitPage().
+
+  @param[in, out]  PageEntry      The page directory entry to be merged.
+  @param[in]       PageAttribute  The page attribute of the merged page, Page2M or Page1G.
+
+  @return The page table which is no longer used, or NULL if nothing is merged.
+**/
+VOID *
+MergePage (
+  IN OUT UINT64                         *PageEntry,
+  IN     PAGE_ATTRIBUTE                 PageAttribute
+  )
+{
+  UINT64   *PageTable;
+  UINT64   FirstEntry;
+  UINT64   EntryLength;
+  UINTN    Index;
+  UINT64   AddressEncMask;
+
+  ASSERT (PageAttribute == Page2M || PageAttribute == Page1G);
+
+  if ((*PageEntry == 0) || ((*PageEntry & IA32_PG_PS) != 0)) {
+    return NULL;
+  }
+
+  AddressEncMask = PcdGet64 (PcdPteMemoryEncryptionAddressOrMask) & PAGING_1G_ADDRESS_MASK_64;
+  PageTable  = (UINT64 *)(UINTN)(*PageEntry & ~AddressEncMask & PAGING_4K_ADDRESS_MASK_64);
+  FirstEntry = PageTable[0] & ~(UINT64)(IA32_PG_A | IA32_PG_D);
+
+  if (PageAttribute == Page2M) {
+    //
+    // The PAT bit of 4K entry is at the position of PS bit in 2M entry.
+    //
+    if ((FirstEntry & IA32_PG_PAT_4K) != 0 ||
+        (FirstEntry & ~AddressEncMask & PAGING_4K_ADDRESS_MASK_64 & PAGING_2M_MASK) != 0) {
+      return NULL;
+    }
+    EntryLength = SIZE_4KB;
+  } else {
+    if ((FirstEntry & IA32_PG_PS) == 0 ||
+        (FirstEntry & ~AddressEncMask & PAGING_2M_ADDRESS_MASK_64 & PAGING_1G_MASK) != 0) {
+      return NULL;
+    }
+    EntryLength = SIZE_2MB;
+  }
+
+  //
+  // The attributes in the directory entry also apply to the pages. Don't merge
+  // if it is more restrictive than the pages, otherwise access would be granted.
+  //
+  if ((FirstEntry & ~(*PageEntry) & (IA32_PG_P | IA32_PG_RW | IA32_PG_U)) != 0 ||
+      ((*PageEntry) & ~FirstEntry & IA32_PG_NX) != 0) {
+    return NULL;
+  }
+
+  for (Index = 1; Index < SIZE_4KB / sizeof(UINT64); Index++) {
+    if ((PageTable[Index] & ~(UINT64)(IA32_PG_A | IA32_PG_D)) != FirstEntry + EntryLength * Index) {
+      return NULL;
+    }
+  }
+
+  DEBUG ((DEBUG_VERBOSE, "Merge - 0x%x\n", PageTable));
+  *PageEntry = PageTable[0] | IA32_PG_PS;
+  return PageTable;
+}
+
 /**
  Check the WP status in CR0 register. This bit is used to lock or unlock write
  access to pages marked as read-only.
@@ -832,6 +958,121 @@ Done:
   return Status;
 }
 
+/**
+  This function flushes TLB and then returns the page tables unlinked by
+  merging pages to the page table pool.
+
+  Returning a page table to the pool overwrites its first entry, which the
+  processor may still read through paging-structure caches until TLB is
+  flushed.
+
+  @param[in]      PageTables      The unlinked page tables.
+  @param[in, out] PageTableCount  The number of unlinked page tables. Set to 0
+                                  on return.
+**/
+STATIC
+VOID
+ReleaseMergedPageTables (
+  IN     VOID                           **PageTables,
+  IN OUT UINTN                          *PageTableCount
+  )
+{
+  UINTN                             Index;
+
+  CpuFlushTlb ();
+  for (Index = 0; Index < *PageTableCount; Index++) {
+    FreePageTableMemory (PageTables[Index]);
+  }
+  *PageTableCount = 0;
+}
+
+/**
+  This function merges the page tables of the current paging context mapping the
+  memory region specified by BaseAddress and Length back into large pages,
+  wherever all pages in a 2M or 1G region have the same attributes again.
+
+  The page tables no longer used are returned to the page table pool after TLB
+  is flushed. TLB is not flushed if no page table is merged.
+
+  @param[in]  BaseAddress       The physical address that is the start address of a memory region.
+  @param[in]  Length            The size in bytes of the memory region.
+
+  @retval TRUE    Some page tables are merged, and TLB is flushed.
+  @retval FALSE   No page table is merged.
+**/
+BOOLEAN
+MergeMemoryPageEntries (
+  IN  PHYSICAL_ADDRESS                  BaseAddress,
+  IN  UINT64                            Length
+  )
+{
+  PAGE_TABLE_LIB_PAGING_CONTEXT     PagingContext;
+  PHYSICAL_ADDRESS                  Address;
+  PHYSICAL_ADDRESS                  EndAddress;
+  UINT64                            *PageEntry;
+  VOID                              *PageTable;
+  VOID                              *MergedPageTables[MAX_MERGED_PAGE_TABLE_COUNT];
+  UINTN                             MergedPageTableCount;
+  BOOLEAN                           IsWpEnabled;
+  BOOLEAN                           IsMerged;
+
+  GetCurrentPagingContext (&PagingContext);
+  if ((PagingContext.MachineType == IMAGE_FILE_MACHINE_I386) &&
+      (PagingContext.ContextData.Ia32.PageTableBase == 0)) {
+    return FALSE;
+  }
+
+  IsWpEnabled = IsReadOnlyPageWriteProtected ();
+  if (IsWpEnabled) {
+    DisableReadOnlyPageWriteProtect ();
+  }
+
+  IsMerged             = FALSE;
+  MergedPageTableCount = 0;
+  EndAddress           = BaseAddress + Length;
+  for (Address = BaseAddress & ~(UINT64)PAGING_2M_MASK; Address < EndAddress; Address += SIZE_2MB) {
+    PageEntry = GetPageDirectoryEntry (&PagingContext, Address, Page2M);
+    if (PageEntry != NULL) {
+      PageTable = MergePage (PageEntry, Page2M);
+      if (PageTable != NULL) {
+        if (MergedPageTableCount == MAX_MERGED_PAGE_TABLE_COUNT) {
+          ReleaseMergedPageTables (MergedPageTables, &MergedPageTableCount);
+        }
+        MergedPageTables[MergedPageTableCount++] = PageTable;
+        IsMerged = TRUE;
+      }
+    }
+  }
+
+  //
+  // Merging 2M pages could make the whole 1G region uniform.
+  //
+  if (IsMerged && (PagingContext.MachineType == IMAGE_FILE_MACHINE_X64) &&
+      ((PagingContext.ContextData.X64.Attributes & PAGE_TABLE_LIB_PAGING_CONTEXT_IA32_X64_ATTRIBUTES_PAGE_1G_SUPPORT) != 0)) {
+    for (Address = BaseAddress & ~(UINT64)PAGING_1G_MASK; Address < EndAddress; Address += SIZE_1GB) {
+      PageEntry = GetPageDirectoryEntry (&PagingContext, Address, Page1G);
+      if (PageEntry != NULL) {
+        PageTable = MergePage (PageEntry, Page1G);
+        if (PageTable != NULL) {
+          if (MergedPageTableCount == MAX_MERGED_PAGE_TABLE_COUNT) {
+            ReleaseMergedPageTables (MergedPageTables, &MergedPageTableCount);
+          }
+          MergedPageTables[MergedPageTableCount++] = PageTable;
+        }
+      }
+    }
+  }
+
+  if (IsMerged) {
+    ReleaseMergedPageTables (MergedPageTables, &MergedPageTableCount);
+  }
+
+  if (IsWpEnabled) {
+    EnableReadOnlyPageWriteProtect ();
+  }
+  return IsMerged;
+}
+
 /**
   This function assigns the page attributes for the memory region specified by BaseAddress and
   Length from their current attributes to the attributes specified by Attributes.
@@ -879,13 +1120,19 @@ AssignMemoryPageAttributes (
   if (!EFI_ERROR(Status)) {
     if ((PagingContext == NULL) && IsModified) {
       //
-      // Flush TLB as last step.
+      // Splitted pages may have the same attributes again, so merge them back
+      // into large pages. TLB is already flushed if any page is merged.
       //
-      // Note: Since APs will always init CR3 register in HLT loop mode or do
-      // TLB flush in MWAIT loop mode, there's no need to flush TLB for them
-      // here.
-      //
-      CpuFlushTlb();
+      if (!MergeMemoryPageEntries (BaseAddress, Length)) {
+        //
+        // Flush TLB as last step.
+        //
+        // Note: Since APs will always init CR3 register in HLT loop mode or do
+        // TLB flush in MWAIT loop mode, there's no need to flush TLB for them
+        // here.
+        //
+        CpuFlushTlb();
+      }
     }
   }
 
@@ -1166,6 +1413,15 @@ AllocatePageTableMemory (
     return NULL;
   }
 
+  //
+  // Reuse the page freed by merging page tables first.
+  //
+  if ((Pages == 1) && (mFreePageTableList != NULL)) {
+    Buffer = mFreePageTableList;
+    mFreePageTableList = *(VOID **)Buffer;
+    return Buffer;
+  }
+
   //
   // Renew the pool if necessary.
   //
@@ -1184,6 +1440,49 @@ AllocatePageTableMemory (
   return Buffer;
 }
 
+/**
+  Return one page of page table to the page table pool.
+
+  The page is reused by AllocatePageTableMemory(). Caller must make sure the
+  page is no longer referenced by any page table and TLB.
+
+  @param  Buffer                The page of page table to free.
+
+  @retval TRUE    The page is returned to the pool.
+  @retval FALSE   The page is not allocated from the pool.
+**/
+BOOLEAN
+FreePageTableMemory (
+  IN VOID            *Buffer
+  )
+{
+  PAGE_TABLE_POOL                 *Pool;
+
+  if (mPageTablePool == NULL) {
+    return FALSE;
+  }
+
+  //
+  // Page tables not allocated from the pool, such as the ones created before
+  // DXE, are left untouched.
+  //
+  Pool = mPageTablePool;
+  do {
+    if (((UINTN)Buffer > (UINTN)Pool) &&
+        ((UINTN)Buffer < (UINTN)Pool + Pool->Offset)) {
+      //
+      // The pool is read-only. Caller has write protection disabled.
+      //
+      *(VOID **)Buffer = mFreePageTableList;
+      mFreePageTableList = Buffer;
+      return TRUE;
+    }
+    Pool = Pool->NextPool;
+  } while (Pool != mPageTablePool);
+
+  return FALSE;
+}
+
 /**
   Special handler for #DB exception, which will restore the page attributes
   (not-present). It should work with #PF handler which will set pages to
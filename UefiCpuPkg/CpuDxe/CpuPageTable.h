@@ -139,6 +139,22 @@ AllocatePageTableMemory (
   IN UINTN           Pages
   );
 
+/**
+  Return one page of page table to the page table pool.
+
+  The page is reused by AllocatePageTableMemory(). Caller must make sure the
+  page is no longer referenced by any page table and TLB.
+
+  @param  Buffer                The page of page table to free.
+
+  @retval TRUE    The page is returned to the pool.
+  @retval FALSE   The page is not allocated from the pool.
+**/
+BOOLEAN
+FreePageTableMemory (
+  IN VOID            *Buffer
+  );
+
 /**
   Get paging details.
 
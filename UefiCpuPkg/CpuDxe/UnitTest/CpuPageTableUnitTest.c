@@ -0,0 +1,503 @@
+/** @file
+  Host based unit tests of splitting and merging page tables in CpuDxe.
+
+  The page table is a fake identity mapping of the whole 48 bits address space
+  by 1G pages, installed through the CR3 emulation of the host BaseLib. It is
+  never loaded into a processor, so host memory used as page tables and as the
+  page table pool can be marked read-only in it safely.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "../CpuDxe.h"
+#include "../CpuPageTable.h"
+#include <Register/Intel/Cpuid.h>
+#include <Library/UnitTestLib.h>
+#include <Library/UnitTestHostBaseLib.h>
+
+#define UNIT_TEST_APP_NAME        "CpuDxe Page Table Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define TEST_PG_P                 BIT0
+#define TEST_PG_RW                BIT1
+#define TEST_PG_PS                BIT7
+#define TEST_PG_ADDRESS_MASK      0x000FFFFFFFFFF000ull
+#define TEST_PG_INDEX_MASK        0x1FF
+
+//
+// Mocked services of the DXE phase used by CpuPageTable.c.
+//
+EFI_BOOT_SERVICES         *gBS;
+EFI_DXE_SERVICES          *gDS;
+
+STATIC EFI_BOOT_SERVICES  mBootServices;
+STATIC UINT64             *mPml4;
+
+/**
+  Mock of LocateProtocol(). No SMM is running.
+
+  @param[in]   Protocol      Provides the protocol to search for.
+  @param[in]   Registration  Optional registration key.
+  @param[out]  Interface     On return, NULL.
+
+  @retval EFI_NOT_FOUND  Always.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockLocateProtocol (
+  IN  EFI_GUID  *Protocol,
+  IN  VOID      *Registration  OPTIONAL,
+  OUT VOID      **Interface
+  )
+{
+  *Interface = NULL;
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Mock of DumpCpuContext(), used by the page fault handlers only.
+
+  @param[in]  ExceptionType  Exception type.
+  @param[in]  SystemContext  Pointer to EFI_SYSTEM_CONTEXT.
+**/
+VOID
+EFIAPI
+DumpCpuContext (
+  IN EFI_EXCEPTION_TYPE   ExceptionType,
+  IN EFI_SYSTEM_CONTEXT   SystemContext
+  )
+{
+}
+
+/**
+  Mock of MpInitLibWhoAmI(). The test runs on the BSP.
+
+  @param[out]  ProcessorNumber  On return, 0.
+
+  @retval EFI_SUCCESS  Always.
+**/
+EFI_STATUS
+EFIAPI
+MpInitLibWhoAmI (
+  OUT UINTN  *ProcessorNumber
+  )
+{
+  *ProcessorNumber = 0;
+  return EFI_SUCCESS;
+}
+
+/**
+  Emulation of CPUID, reporting support of execute disable and 1G pages.
+
+  @param[in]   Index  The 32-bit value to load into EAX prior to invoking the CPUID instruction.
+  @param[out]  Eax    The pointer to the 32-bit EAX value returned by the CPUID instruction.
+  @param[out]  Ebx    The pointer to the 32-bit EBX value returned by the CPUID instruction.
+  @param[out]  Ecx    The pointer to the 32-bit ECX value returned by the CPUID instruction.
+  @param[out]  Edx    The pointer to the 32-bit EDX value returned by the CPUID instruction.
+
+  @return Index.
+**/
+STATIC
+UINT32
+EFIAPI
+UnitTestPageTableAsmCpuid (
+  IN  UINT32  Index,
+  OUT UINT32  *Eax,  OPTIONAL
+  OUT UINT32  *Ebx,  OPTIONAL
+  OUT UINT32  *Ecx,  OPTIONAL
+  OUT UINT32  *Edx   OPTIONAL
+  )
+{
+  CPUID_EXTENDED_CPU_SIG_EDX  RegEdx;
+
+  RegEdx.Uint32 = 0;
+  if (Index == CPUID_EXTENDED_CPU_SIG) {
+    RegEdx.Bits.NX      = 1;
+    RegEdx.Bits.Page1GB = 1;
+  }
+
+  if (Eax != NULL) {
+    *Eax = (Index == CPUID_EXTENDED_FUNCTION) ? CPUID_VIR_PHY_ADDRESS_SIZE : 0;
+  }
+  if (Ebx != NULL) {
+    *Ebx = 0;
+  }
+  if (Ecx != NULL) {
+    *Ecx = 0;
+  }
+  if (Edx != NULL) {
+    *Edx = RegEdx.Uint32;
+  }
+
+  return Index;
+}
+
+/**
+  Emulation of RDMSR, reporting execute disable as activated.
+
+  @param[in]  MsrIndex  The 32-bit MSR index to read.
+
+  @return The value of the MSR.
+**/
+STATIC
+UINT64
+EFIAPI
+UnitTestPageTableAsmReadMsr64 (
+  IN UINT32  MsrIndex
+  )
+{
+  MSR_IA32_EFER_REGISTER  Efer;
+
+  Efer.Uint64 = 0;
+  if (MsrIndex == MSR_IA32_EFER) {
+    Efer.Bits.LME = 1;
+    Efer.Bits.LMA = 1;
+    Efer.Bits.NXE = 1;
+  }
+
+  return Efer.Uint64;
+}
+
+/**
+  Return the entry mapping an address in the fake page table.
+
+  @param[in]   Address  The address to look up.
+  @param[out]  Length   On return, the size of the page mapped by the entry.
+
+  @return Pointer to the entry.
+**/
+STATIC
+UINT64 *
+LookupPageEntry (
+  IN  UINT64  Address,
+  OUT UINT64  *Length
+  )
+{
+  UINT64  *Table;
+  UINT64  *Entry;
+  UINTN   Shift;
+
+  Table = mPml4;
+  for (Shift = 39; ; Shift -= 9) {
+    Entry = &Table[(Address >> Shift) & TEST_PG_INDEX_MASK];
+    if ((Shift == 12) || ((Shift < 39) && ((*Entry & TEST_PG_PS) != 0))) {
+      *Length = LShiftU64 (1, Shift);
+      return Entry;
+    }
+    Table = (UINT64 *)(UINTN)(*Entry & TEST_PG_ADDRESS_MASK);
+  }
+}
+
+/**
+  Return the table an entry of the fake page table points to.
+
+  @param[in]  Address  The address mapped by the table.
+  @param[in]  Shift    The shift of the address bits indexing the directory
+                       holding the entry, 30 for the 1G level and 21 for the
+                       2M level.
+
+  @return Pointer to the table, or NULL if the entry maps a large page.
+**/
+STATIC
+VOID *
+GetPageTable (
+  IN UINT64  Address,
+  IN UINTN   Shift
+  )
+{
+  UINT64  *Table;
+  UINT64  Entry;
+  UINTN   Level;
+
+  Table = mPml4;
+  for (Level = 39; ; Level -= 9) {
+    Entry = Table[(Address >> Level) & TEST_PG_INDEX_MASK];
+    if ((Level < 39) && ((Entry & TEST_PG_PS) != 0)) {
+      return NULL;
+    }
+    Table = (UINT64 *)(UINTN)(Entry & TEST_PG_ADDRESS_MASK);
+    if (Level == Shift) {
+      return Table;
+    }
+  }
+}
+
+/**
+  Build the fake page table and hook the BaseLib functions reading the paging
+  context.
+**/
+STATIC
+VOID
+EFIAPI
+InitializePageTable (
+  VOID
+  )
+{
+  UINT64    *Pdpt;
+  UINTN     Index;
+  IA32_CR0  Cr0;
+  IA32_CR4  Cr4;
+
+  mBootServices.LocateProtocol = MockLocateProtocol;
+  gBS = &mBootServices;
+  gDS = NULL;
+
+  //
+  // 512 PDPTs of 512 1G pages each.
+  //
+  mPml4 = AllocateAlignedPages (1, SIZE_4KB);
+  Pdpt  = AllocateAlignedPages (512, SIZE_4KB);
+  ASSERT (mPml4 != NULL && Pdpt != NULL);
+  for (Index = 0; Index < 512; Index++) {
+    mPml4[Index] = (UINT64)(UINTN)&Pdpt[Index * 512] | TEST_PG_P | TEST_PG_RW;
+  }
+  for (Index = 0; Index < 512 * 512; Index++) {
+    Pdpt[Index] = LShiftU64 (Index, 30) | TEST_PG_PS | TEST_PG_P | TEST_PG_RW;
+  }
+
+  gUnitTestHostBaseLib.X86->AsmCpuid     = UnitTestPageTableAsmCpuid;
+  gUnitTestHostBaseLib.X86->AsmReadMsr64 = UnitTestPageTableAsmReadMsr64;
+
+  Cr0.UintN    = 0;
+  Cr0.Bits.PE  = 1;
+  Cr0.Bits.WP  = 1;
+  Cr0.Bits.PG  = 1;
+  Cr4.UintN    = 0;
+  Cr4.Bits.PAE = 1;
+  AsmWriteCr4 (Cr4.UintN);
+  AsmWriteCr3 ((UINTN)mPml4);
+  AsmWriteCr0 (Cr0.UintN);
+}
+
+/**
+  Skip the tests on IA32, which does not use the 4-level fake page table.
+
+  @param[in]  Context  Ignored.
+
+  @retval UNIT_TEST_PASSED                      Running on X64.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  Running on IA32.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+CheckX64 (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (sizeof (UINTN) != sizeof (UINT64)) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Splitting a 1G page for a 4K page and restoring its attributes should bring
+  back the original 1G page.
+
+  @param[in]  Context  Ignored.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SplitThenRestoreShouldRebuildLargePage (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT64  Address;
+  UINT64  Original;
+  UINT64  *Entry;
+  UINT64  Length;
+
+  Address  = SIZE_1GB + 3 * SIZE_2MB + 5 * SIZE_4KB;
+  Original = *LookupPageEntry (Address, &Length);
+  UT_ASSERT_EQUAL (Length, SIZE_1GB);
+
+  UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributes (NULL, Address, SIZE_4KB, EFI_MEMORY_RO, NULL));
+  Entry = LookupPageEntry (Address, &Length);
+  UT_ASSERT_EQUAL (Length, SIZE_4KB);
+  UT_ASSERT_EQUAL (*Entry & TEST_PG_RW, 0);
+  Entry = LookupPageEntry (Address + SIZE_4KB, &Length);
+  UT_ASSERT_EQUAL (Length, SIZE_4KB);
+  UT_ASSERT_EQUAL (*Entry & TEST_PG_RW, TEST_PG_RW);
+  Entry = LookupPageEntry (Address + SIZE_2MB, &Length);
+  UT_ASSERT_EQUAL (Length, SIZE_2MB);
+  UT_ASSERT_EQUAL (*Entry & TEST_PG_RW, TEST_PG_RW);
+
+  UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributes (NULL, Address, SIZE_4KB, 0, NULL));
+  Entry = LookupPageEntry (Address, &Length);
+  UT_ASSERT_EQUAL (Length, SIZE_1GB);
+  UT_ASSERT_EQUAL (*Entry, Original);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A 1G page should be rebuilt only once all its 2M regions are uniform again.
+
+  @param[in]  Context  Ignored.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+NonUniformRegionShouldStaySplit (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT64  First;
+  UINT64  Second;
+  UINT64  Original;
+  UINT64  *Entry;
+  UINT64  Length;
+
+  First    = MultU64x32 (SIZE_1GB, 2) + SIZE_4KB;
+  Second   = MultU64x32 (SIZE_1GB, 2) + SIZE_2MB + SIZE_4KB;
+  Original = *LookupPageEntry (First, &Length);
+  UT_ASSERT_EQUAL (Length, SIZE_1GB);
+
+  UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributes (NULL, First, SIZE_4KB, EFI_MEMORY_RO, NULL));
+  UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributes (NULL, Second, SIZE_4KB, EFI_MEMORY_XP, NULL));
+
+  //
+  // The first 2M region is uniform again, but the 1G region is not.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributes (NULL, First, SIZE_4KB, 0, NULL));
+  Entry = LookupPageEntry (First, &Length);
+  UT_ASSERT_EQUAL (Length, SIZE_2MB);
+  UT_ASSERT_EQUAL (*Entry & TEST_PG_RW, TEST_PG_RW);
+  UT_ASSERT_EQUAL (*Entry & TEST_PG_ADDRESS_MASK, First & ~(UINT64)(SIZE_2MB - 1));
+  Entry = LookupPageEntry (Second, &Length);
+  UT_ASSERT_EQUAL (Length, SIZE_4KB);
+  UT_ASSERT_NOT_EQUAL (*Entry & BIT63, 0);
+
+  UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributes (NULL, Second, SIZE_4KB, 0, NULL));
+  Entry = LookupPageEntry (Second, &Length);
+  UT_ASSERT_EQUAL (Length, SIZE_1GB);
+  UT_ASSERT_EQUAL (*Entry, Original);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The page tables freed by merging should be used again by the next split.
+
+  @param[in]  Context  Ignored.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+FreedPageTablesShouldBeReused (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT64  First;
+  UINT64  Second;
+  VOID    *PageDirectory;
+  VOID    *PageTable;
+  UINT64  Length;
+
+  First  = MultU64x32 (SIZE_1GB, 3) + SIZE_4KB;
+  Second = MultU64x32 (SIZE_1GB, 4) + 7 * SIZE_2MB;
+
+  UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributes (NULL, First, SIZE_4KB, EFI_MEMORY_RO, NULL));
+  PageDirectory = GetPageTable (First, 30);
+  PageTable     = GetPageTable (First, 21);
+  UT_ASSERT_NOT_NULL (PageDirectory);
+  UT_ASSERT_NOT_NULL (PageTable);
+  UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributes (NULL, First, SIZE_4KB, 0, NULL));
+  LookupPageEntry (First, &Length);
+  UT_ASSERT_EQUAL (Length, SIZE_1GB);
+
+  //
+  // Split another 1G region: no new page is taken from the pool.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributes (NULL, Second, SIZE_4KB, EFI_MEMORY_RO, NULL));
+  UT_ASSERT_EQUAL ((UINTN)GetPageTable (Second, 30), (UINTN)PageDirectory);
+  UT_ASSERT_EQUAL ((UINTN)GetPageTable (Second, 21), (UINTN)PageTable);
+  UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributes (NULL, Second, SIZE_4KB, 0, NULL));
+  LookupPageEntry (Second, &Length);
+  UT_ASSERT_EQUAL (Length, SIZE_1GB);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the page
+  table management of CpuDxe and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      MergeTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&MergeTests, Framework, "Page Table Merge Tests", "CpuDxe.PageTable.Merge", InitializePageTable, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for MergeTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (MergeTests, "Restoring a split page should rebuild the large page", "Rebuild", SplitThenRestoreShouldRebuildLargePage, CheckX64, NULL, NULL);
+  AddTestCase (MergeTests, "A non-uniform region should stay split", "NonUniform", NonUniformRegionShouldStaySplit, CheckX64, NULL, NULL);
+  AddTestCase (MergeTests, "Freed page tables should be reused", "Reuse", FreedPageTablesShouldBeReused, CheckX64, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
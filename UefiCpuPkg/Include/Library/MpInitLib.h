@@ -378,4 +378,53 @@ MpInitLibStartupAllCPUs (
   IN  VOID                      *ProcedureArgument      OPTIONAL
   );
 
+/**
+  The function prototype for a task run by MpInitLibRunTasks().
+
+  @param[in]  Context     The Context passed to MpInitLibRunTasks().
+  @param[in]  TaskIndex   The zero-based index of the task to process.
+
+**/
+typedef
+VOID
+(EFIAPI *MP_INIT_TASK_PROCEDURE)(
+  IN  VOID                      *Context,
+  IN  UINTN                     TaskIndex
+  );
+
+/**
+  This service splits a job into TaskCount independent tasks and runs them
+  on all enabled CPUs, including the BSP.
+
+  Rather than assigning a fixed share of the work to each processor, every
+  CPU repeatedly claims the next unprocessed task index until all tasks are
+  claimed. Fast processors therefore take over the work of slow ones and
+  many small tasks can be dispatched with a single wakeup of the APs.
+
+  The order in which the tasks run and the processor running each task are
+  not defined. This service returns after all tasks have completed.
+
+  @param[in]  Procedure               A pointer to the function that processes
+                                      one task. See type MP_INIT_TASK_PROCEDURE.
+  @param[in]  TaskCount               The number of tasks. Procedure is invoked
+                                      once for each index in [0, TaskCount).
+  @param[in]  Context                 The parameter passed into Procedure for
+                                      all tasks.
+
+  @retval EFI_SUCCESS             All tasks have completed.
+  @retval EFI_DEVICE_ERROR        Caller processor is AP.
+  @retval EFI_NOT_READY           Any enabled APs are busy.
+  @retval EFI_NOT_READY           MP Initialize Library is not initialized.
+  @retval EFI_INVALID_PARAMETER   Procedure is NULL.
+  @retval EFI_INVALID_PARAMETER   TaskCount is greater than MAX_UINT32.
+
+**/
+EFI_STATUS
+EFIAPI
+MpInitLibRunTasks (
+  IN  MP_INIT_TASK_PROCEDURE    Procedure,
+  IN  UINTN                     TaskCount,
+  IN  VOID                      *Context                OPTIONAL
+  );
+
 #endif
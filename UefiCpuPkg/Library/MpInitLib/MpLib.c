@@ -446,6 +446,8 @@ GetProcessorNumber (
 {
   UINTN                   TotalProcessorNumber;
   UINTN                   Index;
+  UINTN                   Low;
+  UINTN                   High;
   CPU_INFO_IN_HOB         *CpuInfoInHob;
   UINT32                  CurrentApicId;
 
@@ -453,6 +455,33 @@ GetProcessorNumber (
 
   TotalProcessorNumber = CpuMpData->CpuCount;
   CurrentApicId = GetApicId ();
+
+  //
+  // Every AP calls this on each wakeup, so a linear scan makes waking all
+  // APs quadratic in the CPU count. SortApicId() keeps the entries in
+  // ascending APIC ID order once enumeration is done, so try a binary
+  // search first. APIC IDs are unique, so any hit is the right entry even
+  // if the array is not sorted yet.
+  //
+  Low  = 0;
+  High = TotalProcessorNumber;
+  while (Low < High) {
+    Index = Low + (High - Low) / 2;
+    if (CpuInfoInHob[Index].ApicId == CurrentApicId) {
+      *ProcessorNumber = Index;
+      return EFI_SUCCESS;
+    }
+    if (CpuInfoInHob[Index].ApicId < CurrentApicId) {
+      Low = Index + 1;
+    } else {
+      High = Index;
+    }
+  }
+
+  //
+  // Fall back to a linear scan while the entries are not sorted, e.g.
+  // before SortApicId() runs or while the BSP is being switched.
+  //
   for (Index = 0; Index < TotalProcessorNumber; Index ++) {
     if (CpuInfoInHob[Index].ApicId == CurrentApicId) {
       *ProcessorNumber = Index;
@@ -463,6 +492,32 @@ GetProcessorNumber (
   return EFI_NOT_FOUND;
 }
 
+/**
+  Get the time elapsed since a performance counter value.
+
+  @param[in] StartTime        The performance counter value to measure from.
+
+  @return  Elapsed time in microseconds.
+**/
+STATIC
+UINT64
+GetElapsedMicroseconds (
+  IN UINT64              StartTime
+  )
+{
+  UINT64  Start;
+  UINT64  End;
+  UINT64  Ticks;
+
+  GetPerformanceCounterProperties (&Start, &End);
+  if (Start < End) {
+    Ticks = GetPerformanceCounter () - StartTime;
+  } else {
+    Ticks = StartTime - GetPerformanceCounter ();
+  }
+  return DivU64x32 (GetTimeInNanoSecond (Ticks), 1000);
+}
+
 /**
   This function will get CPU count in the system.
 
@@ -478,13 +533,21 @@ CollectProcessorCount (
   UINTN                  Index;
   CPU_INFO_IN_HOB        *CpuInfoInHob;
   BOOLEAN                X2Apic;
+  UINT64                 StartTime;
 
   //
   // Send 1st broadcast IPI to APs to wakeup APs
   //
+  StartTime = GetPerformanceCounter ();
   CpuMpData->InitFlag = ApInitConfig;
   WakeUpAP (CpuMpData, TRUE, 0, NULL, NULL, TRUE);
   CpuMpData->InitFlag = ApInitDone;
+  DEBUG ((
+    DEBUG_INFO,
+    "MpInitLib: %d APs checked in after %ld us\n",
+    CpuMpData->FinishedCount,
+    GetElapsedMicroseconds (StartTime)
+    ));
   //
   // When InitFlag == ApInitConfig, WakeUpAP () guarantees all APs are checked in.
   // FinishedCount is the number of check-in APs.
@@ -515,6 +578,7 @@ CollectProcessorCount (
 
   if (X2Apic) {
     DEBUG ((DEBUG_INFO, "Force x2APIC mode!\n"));
+    StartTime = GetPerformanceCounter ();
     //
     // Wakeup all APs to enable x2APIC mode
     //
@@ -535,12 +599,23 @@ CollectProcessorCount (
     for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
       SetApState (&CpuMpData->CpuData[Index], CpuStateIdle);
     }
+    DEBUG ((
+      DEBUG_INFO,
+      "MpInitLib: x2APIC mode enabled on all CPUs in %ld us\n",
+      GetElapsedMicroseconds (StartTime)
+      ));
   }
   DEBUG ((DEBUG_INFO, "APIC MODE is %d\n", GetApicMode ()));
   //
   // Sort BSP/Aps by CPU APIC ID in ascending order
   //
+  StartTime = GetPerformanceCounter ();
   SortApicId (CpuMpData);
+  DEBUG ((
+    DEBUG_INFO,
+    "MpInitLib: Sorted processors by APIC ID in %ld us\n",
+    GetElapsedMicroseconds (StartTime)
+    ));
 
   DEBUG ((DEBUG_INFO, "MpInitLib: Find %d processors in system.\n", CpuMpData->CpuCount));
 
@@ -2922,3 +2997,104 @@ MpInitLibStartupAllCPUs (
            NULL
            );
 }
+
+/**
+  This service splits a job into TaskCount independent tasks and runs them
+  on all enabled CPUs, including the BSP.
+
+  Rather than assigning a fixed share of the work to each processor, every
+  CPU repeatedly claims the next unprocessed task index until all tasks are
+  claimed. Fast processors therefore take over the work of slow ones and
+  many small tasks can be dispatched with a single wakeup of the APs.
+
+  The order in which the tasks run and the processor running each task are
+  not defined. This service returns after all tasks have completed.
+
+  @param[in]  Procedure               A pointer to the function that processes
+                                      one task. See type MP_INIT_TASK_PROCEDURE.
+  @param[in]  TaskCount               The number of tasks. Procedure is invoked
+                                      once for each index in [0, TaskCount).
+  @param[in]  Context                 The parameter passed into Procedure for
+                                      all tasks.
+
+  @retval EFI_SUCCESS             All tasks have completed.
+  @retval EFI_DEVICE_ERROR        Caller processor is AP.
+  @retval EFI_NOT_READY           Any enabled APs are busy.
+  @retval EFI_NOT_READY           MP Initialize Library is not initialized.
+  @retval EFI_INVALID_PARAMETER   Procedure is NULL.
+  @retval EFI_INVALID_PARAMETER   TaskCount is greater than MAX_UINT32.
+
+**/
+EFI_STATUS
+EFIAPI
+MpInitLibRunTasks (
+  IN  MP_INIT_TASK_PROCEDURE    Procedure,
+  IN  UINTN                     TaskCount,
+  IN  VOID                      *Context                OPTIONAL
+  )
+{
+  MP_TASK_POOL            TaskPool;
+  UINTN                   TaskIndex;
+  CPU_MP_DATA             *CpuMpData;
+  UINTN                   ProcessorNumber;
+  UINTN                   CallerNumber;
+  CPU_STATE               ApState;
+
+  if (Procedure == NULL || TaskCount > MAX_UINT32) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  CpuMpData = GetCpuMpData ();
+
+  //
+  // Check whether caller processor is BSP
+  //
+  MpInitLibWhoAmI (&CallerNumber);
+  if (CallerNumber != CpuMpData->BspNumber) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  //
+  // Check whether all enabled APs are idle, also when the tasks end up
+  // running on the BSP only, so that the result does not depend on
+  // TaskCount.
+  //
+  CheckAndUpdateApsStatus ();
+  for (ProcessorNumber = 0; ProcessorNumber < CpuMpData->CpuCount; ProcessorNumber++) {
+    if (ProcessorNumber != CpuMpData->BspNumber) {
+      ApState = GetApState (&CpuMpData->CpuData[ProcessorNumber]);
+      if (ApState != CpuStateDisabled && ApState != CpuStateIdle) {
+        return EFI_NOT_READY;
+      }
+    }
+  }
+
+  if (TaskCount == 0) {
+    return EFI_SUCCESS;
+  }
+
+  if (TaskCount == 1 || CpuMpData->CpuCount == 1) {
+    //
+    // Waking up the APs is not worth it when there is nothing to share.
+    //
+    for (TaskIndex = 0; TaskIndex < TaskCount; TaskIndex++) {
+      Procedure (Context, TaskIndex);
+    }
+    return EFI_SUCCESS;
+  }
+
+  TaskPool.Procedure = Procedure;
+  TaskPool.Context   = Context;
+  TaskPool.TaskCount = (UINT32) TaskCount;
+  TaskPool.NextTask  = 0;
+
+  return StartupAllCPUsWorker (
+           RunTaskPool,
+           FALSE,
+           FALSE,
+           NULL,
+           0,
+           &TaskPool,
+           NULL
+           );
+}
@@ -294,6 +294,16 @@ struct _CPU_MP_DATA {
   UINT64                         GhcbBase;
 };
 
+//
+// Shared state of the tasks dispatched by MpInitLibRunTasks()
+//
+typedef struct {
+  MP_INIT_TASK_PROCEDURE         Procedure;
+  VOID                           *Context;
+  UINT32                         TaskCount;
+  volatile UINT32                NextTask;
+} MP_TASK_POOL;
+
 #define AP_SAFE_STACK_SIZE  128
 #define AP_RESET_STACK_SIZE AP_SAFE_STACK_SIZE
 
@@ -741,5 +751,17 @@ PlatformShadowMicrocode (
   IN OUT CPU_MP_DATA             *CpuMpData
   );
 
+/**
+  Claim and run tasks from the task pool until all tasks are claimed.
+
+  @param[in]  Buffer  Pointer to the MP_TASK_POOL.
+
+**/
+VOID
+EFIAPI
+RunTaskPool (
+  IN VOID                       *Buffer
+  );
+
 #endif
 
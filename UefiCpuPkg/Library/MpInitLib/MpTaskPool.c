@@ -0,0 +1,47 @@
+/** @file
+  Task pool shared by the processors running MpInitLibRunTasks().
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "MpLib.h"
+
+/**
+  Claim and run tasks from the task pool until all tasks are claimed.
+
+  @param[in]  Buffer  Pointer to the MP_TASK_POOL.
+
+**/
+VOID
+EFIAPI
+RunTaskPool (
+  IN VOID                       *Buffer
+  )
+{
+  MP_TASK_POOL            *TaskPool;
+  UINT32                  TaskIndex;
+  UINT32                  Claimed;
+
+  TaskPool  = (MP_TASK_POOL *) Buffer;
+  TaskIndex = TaskPool->NextTask;
+  while (TaskIndex < TaskPool->TaskCount) {
+    //
+    // Only advance NextTask past an index that is still free, so that it
+    // never goes beyond TaskCount and cannot wrap around for a TaskCount
+    // close to MAX_UINT32. On a lost race, retry with the index the
+    // winner left behind.
+    //
+    Claimed = InterlockedCompareExchange32 (
+                (UINT32 *) &TaskPool->NextTask,
+                TaskIndex,
+                TaskIndex + 1
+                );
+    if (Claimed != TaskIndex) {
+      TaskIndex = Claimed;
+      continue;
+    }
+    TaskPool->Procedure (TaskPool->Context, TaskIndex);
+    TaskIndex = TaskPool->NextTask;
+  }
+}
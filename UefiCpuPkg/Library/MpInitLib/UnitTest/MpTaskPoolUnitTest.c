@@ -0,0 +1,268 @@
+/** @file
+  Host based unit tests of the task pool of MpInitLibRunTasks().
+
+  The processors sharing the pool are simulated by POSIX threads that all
+  enter RunTaskPool() at the same time, the way the BSP and the APs do once
+  StartupAllCPUsWorker() has woken them up.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <pthread.h>
+
+#include "../MpLib.h"
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "MpInitLib Task Pool Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define SIMULATED_CPU_COUNT       8
+#define TEST_TASK_COUNT           100000
+#define TEST_TAIL_REPEAT_COUNT    20
+
+typedef struct {
+  //
+  // Index of the task counted in RunCount[0].
+  //
+  UINT32            FirstTask;
+  volatile UINT32   *RunCount;
+} TASK_RECORD;
+
+typedef struct {
+  MP_TASK_POOL        *TaskPool;
+  pthread_barrier_t   *Barrier;
+} SIMULATED_CPU;
+
+/**
+  Count the runs of a task.
+
+  @param[in]  Context    Pointer to the TASK_RECORD.
+  @param[in]  TaskIndex  The index of the task.
+**/
+STATIC
+VOID
+EFIAPI
+RecordTask (
+  IN VOID   *Context,
+  IN UINTN  TaskIndex
+  )
+{
+  TASK_RECORD  *Record;
+
+  Record = (TASK_RECORD *) Context;
+  InterlockedIncrement (&Record->RunCount[TaskIndex - Record->FirstTask]);
+}
+
+/**
+  Thread entry of a simulated processor.
+
+  @param[in]  Argument  Pointer to the SIMULATED_CPU.
+
+  @return NULL.
+**/
+STATIC
+VOID *
+SimulatedCpu (
+  IN VOID  *Argument
+  )
+{
+  SIMULATED_CPU  *Cpu;
+
+  Cpu = (SIMULATED_CPU *) Argument;
+  pthread_barrier_wait (Cpu->Barrier);
+  RunTaskPool (Cpu->TaskPool);
+  return NULL;
+}
+
+/**
+  Run the task pool on SIMULATED_CPU_COUNT processors, the calling thread
+  being one of them, and wait for all of them to return.
+
+  @param[in]  TaskPool  The task pool.
+
+  @retval UNIT_TEST_PASSED  All processors returned.
+**/
+STATIC
+UNIT_TEST_STATUS
+RunOnSimulatedCpus (
+  IN MP_TASK_POOL  *TaskPool
+  )
+{
+  pthread_t          Threads[SIMULATED_CPU_COUNT - 1];
+  pthread_barrier_t  Barrier;
+  SIMULATED_CPU      Cpu;
+  UINTN              Index;
+
+  Cpu.TaskPool = TaskPool;
+  Cpu.Barrier  = &Barrier;
+  UT_ASSERT_EQUAL (pthread_barrier_init (&Barrier, NULL, SIMULATED_CPU_COUNT), 0);
+  for (Index = 0; Index < ARRAY_SIZE (Threads); Index++) {
+    UT_ASSERT_EQUAL (pthread_create (&Threads[Index], NULL, SimulatedCpu, &Cpu), 0);
+  }
+  SimulatedCpu (&Cpu);
+  for (Index = 0; Index < ARRAY_SIZE (Threads); Index++) {
+    pthread_join (Threads[Index], NULL);
+  }
+  pthread_barrier_destroy (&Barrier);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Run the tasks [FirstTask, TaskCount) of a pool and check that every one of
+  them ran exactly once.
+
+  @param[in]  FirstTask  The index of the first unclaimed task.
+  @param[in]  TaskCount  The number of tasks of the pool.
+
+  @retval UNIT_TEST_PASSED  Every task ran once and NextTask stopped at TaskCount.
+**/
+STATIC
+UNIT_TEST_STATUS
+RunAndCheckTasks (
+  IN UINT32  FirstTask,
+  IN UINT32  TaskCount
+  )
+{
+  MP_TASK_POOL  TaskPool;
+  TASK_RECORD   Record;
+  UINTN         Index;
+
+  Record.FirstTask = FirstTask;
+  Record.RunCount  = AllocateZeroPool ((TaskCount - FirstTask) * sizeof (UINT32));
+  UT_ASSERT_NOT_NULL ((VOID *) Record.RunCount);
+
+  TaskPool.Procedure = RecordTask;
+  TaskPool.Context   = &Record;
+  TaskPool.TaskCount = TaskCount;
+  TaskPool.NextTask  = FirstTask;
+  UT_ASSERT_EQUAL (RunOnSimulatedCpus (&TaskPool), UNIT_TEST_PASSED);
+
+  for (Index = 0; Index < TaskCount - FirstTask; Index++) {
+    UT_ASSERT_EQUAL (Record.RunCount[Index], 1);
+  }
+  UT_ASSERT_EQUAL (TaskPool.NextTask, TaskCount);
+
+  FreePool ((VOID *) Record.RunCount);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Every task runs exactly once when all processors race for the tasks.
+
+  @param[in]  Context  Unit test case context
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+TasksShouldRunOnce (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT32  TaskCount;
+
+  for (TaskCount = 1; TaskCount <= 2 * SIMULATED_CPU_COUNT; TaskCount++) {
+    UT_ASSERT_EQUAL (RunAndCheckTasks (0, TaskCount), UNIT_TEST_PASSED);
+  }
+  return RunAndCheckTasks (0, TEST_TASK_COUNT);
+}
+
+/**
+  NextTask does not wrap around when TaskCount is close to MAX_UINT32, so
+  no task runs twice and processors joining late do not start over.
+
+  The processors only overshoot NextTask when they race for the last task,
+  so the run is repeated to make that race likely.
+
+  @param[in]  Context  Unit test case context
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+NextTaskShouldNotWrap (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Repeat;
+
+  for (Repeat = 0; Repeat < TEST_TAIL_REPEAT_COUNT; Repeat++) {
+    UT_ASSERT_EQUAL (RunAndCheckTasks (MAX_UINT32 - TEST_TASK_COUNT, MAX_UINT32), UNIT_TEST_PASSED);
+  }
+
+  //
+  // All tasks claimed already: a processor entering now runs nothing.
+  //
+  return RunAndCheckTasks (MAX_UINT32, MAX_UINT32);
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the task
+  pool and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      TaskPoolTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&TaskPoolTests, Framework, "MpInitLib Task Pool Tests", "MpInitLib.TaskPool", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for TaskPoolTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (TaskPoolTests, "Every task should run exactly once", "RunOnce", TasksShouldRunOnce, NULL, NULL, NULL);
+  AddTestCase (TaskPoolTests, "NextTask should not wrap around near MAX_UINT32", "NoWrap", NextTaskShouldNotWrap, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -12,6 +12,7 @@
 #include <Library/DebugLib.h>
 #include <Library/LocalApicLib.h>
 #include <Library/HobLib.h>
+#include <Library/MpInitLib.h>
 
 /**
   MP Initialize Library initialization.
@@ -440,3 +441,40 @@ MpInitLibStartupAllCPUs (
 
   return EFI_SUCCESS;
 }
+
+/**
+  This service splits a job into TaskCount independent tasks and runs them
+  on all enabled CPUs, including the BSP.
+
+  @param[in]  Procedure               A pointer to the function that processes
+                                      one task. See type MP_INIT_TASK_PROCEDURE.
+  @param[in]  TaskCount               The number of tasks. Procedure is invoked
+                                      once for each index in [0, TaskCount).
+  @param[in]  Context                 The parameter passed into Procedure for
+                                      all tasks.
+
+  @retval EFI_SUCCESS             All tasks have completed.
+  @retval EFI_INVALID_PARAMETER   Procedure is NULL.
+  @retval EFI_INVALID_PARAMETER   TaskCount is greater than MAX_UINT32.
+
+**/
+EFI_STATUS
+EFIAPI
+MpInitLibRunTasks (
+  IN  MP_INIT_TASK_PROCEDURE    Procedure,
+  IN  UINTN                     TaskCount,
+  IN  VOID                      *Context                OPTIONAL
+  )
+{
+  UINTN  TaskIndex;
+
+  if (Procedure == NULL || TaskCount > MAX_UINT32) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (TaskIndex = 0; TaskIndex < TaskCount; TaskIndex++) {
+    Procedure (Context, TaskIndex);
+  }
+
+  return EFI_SUCCESS;
+}
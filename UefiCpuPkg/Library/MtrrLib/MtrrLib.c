@@ -1060,7 +1060,11 @@ MtrrLibSetMemoryType (
 /**
   Return the number of memory types in range [BaseAddress, BaseAddress + Length).
 
+  The search for the range holding BaseAddress is a binary search because this
+  function is called for every vertex pair when calculating the MTRR settings.
+
   @param Ranges      Array holding memory type settings for all memory regions.
+                     The ranges are sorted by base address and don't overlap.
   @param RangeCount  The count of memory ranges the array holds.
   @param BaseAddress Base address.
   @param Length      Length.
@@ -1078,12 +1082,28 @@ MtrrLibGetNumberOfTypes (
   )
 {
   UINTN                          Index;
+  UINTN                          Left;
+  UINTN                          Right;
   UINT8                          TypeCount;
   UINT8                          LocalTypes;
 
+  //
+  // Find the last range whose base address is not above BaseAddress.
+  //
+  Left  = 0;
+  Right = RangeCount;
+  while (Right - Left > 1) {
+    Index = (Left + Right) / 2;
+    if (Ranges[Index].BaseAddress <= BaseAddress) {
+      Left = Index;
+    } else {
+      Right = Index;
+    }
+  }
+
   TypeCount = 0;
   LocalTypes = 0;
-  for (Index = 0; Index < RangeCount; Index++) {
+  for (Index = Left; Index < RangeCount; Index++) {
     if ((Ranges[Index].BaseAddress <= BaseAddress) &&
         (BaseAddress < Ranges[Index].BaseAddress + Ranges[Index].Length)
         ) {
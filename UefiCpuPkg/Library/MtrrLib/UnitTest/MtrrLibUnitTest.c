@@ -65,6 +65,19 @@ typedef struct {
   CONST MTRR_LIB_SYSTEM_PARAMETER *SystemParameter;
 } MTRR_LIB_GET_FIRMWARE_VARIABLE_MTRR_COUNT_CONTEXT;
 
+//
+// Context structure to be used for MtrrSetMemoryAttributesInMtrrSettings() benchmark.
+// The buffers are allocated by BuildBenchmarkLayouts() and freed by FreeBenchmarkLayouts().
+//
+typedef struct {
+  CONST MTRR_LIB_SYSTEM_PARAMETER *SystemParameter;
+  MTRR_MEMORY_RANGE               (*ExpectedMemoryRanges)[MTRR_NUMBER_OF_FIXED_MTRR * sizeof (UINT64) + 2 * MTRR_NUMBER_OF_VARIABLE_MTRR + 1];
+  UINTN                           *ExpectedMemoryRangesCount;
+  MTRR_SETTINGS                   *LocalMtrrs;
+  UINT8                           *Scratch;
+  UINTN                           ScratchSize;
+} MTRR_LIB_BENCHMARK_CONTEXT;
+
 STATIC CHAR8 *mCacheDescription[] = { "UC", "WC", "N/A", "N/A", "WT", "WP", "WB" };
 
 /**
@@ -274,6 +287,262 @@ UnitTestMtrrSetMemoryAttributesInMtrrSettings (
   return UNIT_TEST_PASSED;
 }
 
+/**
+  Unit test of MtrrLib service MtrrSetMemoryAttributesInMtrrSettings() with
+  a fixed memory layout holding several MMIO holes.
+
+  The ranges sit both at the start and at the end of the sorted range array
+  the MTRR calculation searches, so a wrong lookup of the range holding a
+  vertex shows up as a wrong memory type.
+
+  @param[in]  Context    Pointer to MTRR_LIB_SYSTEM_PARAMETER.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestMtrrSetMemoryAttributesWithMmioHoles (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CONST MTRR_LIB_SYSTEM_PARAMETER *SystemParameter;
+  RETURN_STATUS                   Status;
+  UINT8                           Scratch[SCRATCH_BUFFER_SIZE];
+  UINTN                           ScratchSize;
+  MTRR_SETTINGS                   LocalMtrrs;
+  MTRR_MEMORY_RANGE               ActualMemoryRanges[MTRR_NUMBER_OF_FIXED_MTRR * sizeof (UINT64) + 2 * MTRR_NUMBER_OF_VARIABLE_MTRR + 1];
+  UINT32                          ActualVariableMtrrUsage;
+  UINTN                           ActualMemoryRangesCount;
+
+  STATIC MTRR_MEMORY_RANGE        MemoryRanges[] = {
+    { 0,                              SIZE_2GB + SIZE_1GB, CacheWriteBack      },
+    { SIZE_2GB + SIZE_1GB,            SIZE_256MB,          CacheWriteCombining },
+    { SIZE_4GB,                       SIZE_64GB - SIZE_4GB, CacheWriteBack     },
+    { SIZE_32GB,                      SIZE_16MB,           CacheUncacheable    },
+    { SIZE_32GB + SIZE_16GB,          SIZE_2MB,            CacheUncacheable    },
+    { SIZE_32GB + SIZE_16GB + SIZE_8GB, SIZE_1GB,          CacheWriteThrough   }
+  };
+  STATIC MTRR_MEMORY_RANGE        ExpectedMemoryRanges[] = {
+    { 0,                                         SIZE_2GB + SIZE_1GB,                   CacheWriteBack      },
+    { SIZE_2GB + SIZE_1GB,                       SIZE_256MB,                            CacheWriteCombining },
+    { SIZE_2GB + SIZE_1GB + SIZE_256MB,          SIZE_1GB - SIZE_256MB,                 CacheUncacheable    },
+    { SIZE_4GB,                                  SIZE_32GB - SIZE_4GB,                  CacheWriteBack      },
+    { SIZE_32GB,                                 SIZE_16MB,                             CacheUncacheable    },
+    { SIZE_32GB + SIZE_16MB,                     SIZE_16GB - SIZE_16MB,                 CacheWriteBack      },
+    { SIZE_32GB + SIZE_16GB,                     SIZE_2MB,                              CacheUncacheable    },
+    { SIZE_32GB + SIZE_16GB + SIZE_2MB,          SIZE_8GB - SIZE_2MB,                   CacheWriteBack      },
+    { SIZE_32GB + SIZE_16GB + SIZE_8GB,          SIZE_1GB,                              CacheWriteThrough   },
+    { SIZE_32GB + SIZE_16GB + SIZE_8GB + SIZE_1GB, SIZE_8GB - SIZE_1GB,                 CacheWriteBack      },
+    { SIZE_64GB,                                 SIZE_4TB - SIZE_64GB,                  CacheUncacheable    }
+  };
+
+  SystemParameter = (MTRR_LIB_SYSTEM_PARAMETER *) Context;
+  UT_ASSERT_EQUAL (SystemParameter->DefaultCacheType, CacheUncacheable);
+  UT_ASSERT_EQUAL (SystemParameter->PhysicalAddressBits, 42);
+
+  ZeroMem (&LocalMtrrs, sizeof (LocalMtrrs));
+  LocalMtrrs.MtrrDefType = MtrrGetDefaultMemoryType ();
+  ScratchSize            = sizeof (Scratch);
+  Status = MtrrSetMemoryAttributesInMtrrSettings (&LocalMtrrs, Scratch, &ScratchSize, MemoryRanges, ARRAY_SIZE (MemoryRanges));
+  UT_ASSERT_STATUS_EQUAL (Status, RETURN_SUCCESS);
+
+  ActualMemoryRangesCount = ARRAY_SIZE (ActualMemoryRanges);
+  CollectTestResult (
+    SystemParameter->DefaultCacheType, SystemParameter->PhysicalAddressBits, SystemParameter->VariableMtrrCount,
+    &LocalMtrrs, ActualMemoryRanges, &ActualMemoryRangesCount, &ActualVariableMtrrUsage
+    );
+  UT_LOG_INFO ("--- Actual Memory Ranges [%d] ---\n", ActualMemoryRangesCount);
+  DumpMemoryRanges (ActualMemoryRanges, ActualMemoryRangesCount);
+  UT_ASSERT_EQUAL (
+    VerifyMemoryRanges (ExpectedMemoryRanges, ARRAY_SIZE (ExpectedMemoryRanges), ActualMemoryRanges, ActualMemoryRangesCount),
+    UNIT_TEST_PASSED
+    );
+  UT_ASSERT_TRUE (ActualVariableMtrrUsage <= SystemParameter->VariableMtrrCount);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free the buffers of a MtrrSetMemoryAttributesInMtrrSettings() benchmark.
+
+  @param Context  Pointer to MTRR_LIB_BENCHMARK_CONTEXT.
+**/
+VOID
+EFIAPI
+FreeBenchmarkLayouts (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MTRR_LIB_BENCHMARK_CONTEXT  *LocalContext;
+
+  LocalContext = (MTRR_LIB_BENCHMARK_CONTEXT *) Context;
+  free (LocalContext->ExpectedMemoryRanges);
+  free (LocalContext->ExpectedMemoryRangesCount);
+  free (LocalContext->LocalMtrrs);
+  free (LocalContext->Scratch);
+  LocalContext->ExpectedMemoryRanges      = NULL;
+  LocalContext->ExpectedMemoryRangesCount = NULL;
+  LocalContext->LocalMtrrs                = NULL;
+  LocalContext->Scratch                   = NULL;
+}
+
+/**
+  Prep routine for UnitTestMtrrSetMemoryAttributesInMtrrSettingsBenchmark().
+
+  Initializes the MTRR registers and builds MTRR_LIB_BENCHMARK_LAYOUT_COUNT
+  memory layouts with the same random-range generator as
+  UnitTestMtrrSetMemoryAttributesInMtrrSettings().
+
+  The layouts always come from rand () seeded with a constant. The fixed
+  inputs in RandomNumber.c were generated for a RAND_MAX of 0x7FFF and give
+  single-range layouts on hosts with a larger RAND_MAX, which would time
+  nothing. mRandomInput is restored before returning.
+
+  @param Context  Pointer to MTRR_LIB_BENCHMARK_CONTEXT.
+
+  @retval UNIT_TEST_PASSED                    The layouts were built.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET The buffers could not be allocated.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BuildBenchmarkLayouts (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MTRR_LIB_BENCHMARK_CONTEXT      *LocalContext;
+  CONST MTRR_LIB_SYSTEM_PARAMETER *SystemParameter;
+  BOOLEAN                         RandomInput;
+  UINT32                          UcCount;
+  UINT32                          WtCount;
+  UINT32                          WbCount;
+  UINT32                          WpCount;
+  UINT32                          WcCount;
+  UINTN                           Index;
+  MTRR_MEMORY_RANGE               RawMtrrRange[MTRR_NUMBER_OF_VARIABLE_MTRR];
+
+  LocalContext    = (MTRR_LIB_BENCHMARK_CONTEXT *) Context;
+  SystemParameter = LocalContext->SystemParameter;
+
+  InitializeMtrrRegs ((MTRR_LIB_SYSTEM_PARAMETER *) SystemParameter);
+
+  LocalContext->ExpectedMemoryRanges      = calloc (MTRR_LIB_BENCHMARK_LAYOUT_COUNT, sizeof (*LocalContext->ExpectedMemoryRanges));
+  LocalContext->ExpectedMemoryRangesCount = calloc (MTRR_LIB_BENCHMARK_LAYOUT_COUNT, sizeof (*LocalContext->ExpectedMemoryRangesCount));
+  LocalContext->LocalMtrrs                = calloc (MTRR_LIB_BENCHMARK_LAYOUT_COUNT, sizeof (*LocalContext->LocalMtrrs));
+  LocalContext->ScratchSize               = SCRATCH_BUFFER_SIZE;
+  LocalContext->Scratch                   = calloc (LocalContext->ScratchSize, sizeof (UINT8));
+  if ((LocalContext->ExpectedMemoryRanges == NULL) || (LocalContext->ExpectedMemoryRangesCount == NULL) ||
+      (LocalContext->LocalMtrrs == NULL) || (LocalContext->Scratch == NULL)) {
+    FreeBenchmarkLayouts (Context);
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  RandomInput  = mRandomInput;
+  mRandomInput = TRUE;
+  srand (MTRR_LIB_BENCHMARK_SEED);
+  for (Index = 0; Index < MTRR_LIB_BENCHMARK_LAYOUT_COUNT; Index++) {
+    GenerateRandomMemoryTypeCombination (
+      SystemParameter->VariableMtrrCount - PatchPcdGet32 (PcdCpuNumberOfReservedVariableMtrrs),
+      &UcCount, &WtCount, &WbCount, &WpCount, &WcCount
+      );
+    GenerateValidAndConfigurableMtrrPairs (
+      SystemParameter->PhysicalAddressBits, RawMtrrRange,
+      UcCount, WtCount, WbCount, WpCount, WcCount
+      );
+    LocalContext->ExpectedMemoryRangesCount[Index] = ARRAY_SIZE (LocalContext->ExpectedMemoryRanges[Index]);
+    GetEffectiveMemoryRanges (
+      SystemParameter->DefaultCacheType,
+      SystemParameter->PhysicalAddressBits,
+      RawMtrrRange, UcCount + WtCount + WbCount + WpCount + WcCount,
+      LocalContext->ExpectedMemoryRanges[Index], &LocalContext->ExpectedMemoryRangesCount[Index]
+      );
+    LocalContext->LocalMtrrs[Index].MtrrDefType = MtrrGetDefaultMemoryType ();
+  }
+  mRandomInput = RandomInput;
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Benchmark of MtrrLib service MtrrSetMemoryAttributesInMtrrSettings().
+
+  Logs the time taken to calculate the MTRR settings of the memory layouts
+  built by BuildBenchmarkLayouts(). Every result is checked, so the
+  benchmark also runs as a test.
+
+  @param[in]  Context    Pointer to MTRR_LIB_BENCHMARK_CONTEXT.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestMtrrSetMemoryAttributesInMtrrSettingsBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MTRR_LIB_BENCHMARK_CONTEXT      *LocalContext;
+  CONST MTRR_LIB_SYSTEM_PARAMETER *SystemParameter;
+  RETURN_STATUS                   Status;
+  UINTN                           Index;
+  UINT8                           *Scratch;
+  UINTN                           ScratchSize;
+  MTRR_MEMORY_RANGE               ActualMemoryRanges[MTRR_NUMBER_OF_FIXED_MTRR * sizeof (UINT64) + 2 * MTRR_NUMBER_OF_VARIABLE_MTRR + 1];
+  UINT32                          ActualVariableMtrrUsage;
+  UINTN                           ActualMemoryRangesCount;
+  clock_t                         Start;
+  clock_t                         Elapsed;
+
+  LocalContext    = (MTRR_LIB_BENCHMARK_CONTEXT *) Context;
+  SystemParameter = LocalContext->SystemParameter;
+
+  Start = clock ();
+  for (Index = 0; Index < MTRR_LIB_BENCHMARK_LAYOUT_COUNT; Index++) {
+    ScratchSize = LocalContext->ScratchSize;
+    Status = MtrrSetMemoryAttributesInMtrrSettings (
+               &LocalContext->LocalMtrrs[Index], LocalContext->Scratch, &ScratchSize,
+               LocalContext->ExpectedMemoryRanges[Index], LocalContext->ExpectedMemoryRangesCount[Index]
+               );
+    if (Status == RETURN_BUFFER_TOO_SMALL) {
+      Scratch = realloc (LocalContext->Scratch, ScratchSize);
+      UT_ASSERT_NOT_NULL (Scratch);
+      LocalContext->Scratch     = Scratch;
+      LocalContext->ScratchSize = ScratchSize;
+      Status = MtrrSetMemoryAttributesInMtrrSettings (
+                 &LocalContext->LocalMtrrs[Index], LocalContext->Scratch, &ScratchSize,
+                 LocalContext->ExpectedMemoryRanges[Index], LocalContext->ExpectedMemoryRangesCount[Index]
+                 );
+    }
+    UT_ASSERT_STATUS_EQUAL (Status, RETURN_SUCCESS);
+  }
+  Elapsed = clock () - Start;
+
+  UT_LOG_INFO (
+    "%d memory layouts in %d ms, %d us per layout\n",
+    MTRR_LIB_BENCHMARK_LAYOUT_COUNT,
+    (UINT32) (Elapsed * 1000 / CLOCKS_PER_SEC),
+    (UINT32) (Elapsed * 1000000 / CLOCKS_PER_SEC / MTRR_LIB_BENCHMARK_LAYOUT_COUNT)
+    );
+
+  for (Index = 0; Index < MTRR_LIB_BENCHMARK_LAYOUT_COUNT; Index++) {
+    ActualMemoryRangesCount = ARRAY_SIZE (ActualMemoryRanges);
+    CollectTestResult (
+      SystemParameter->DefaultCacheType, SystemParameter->PhysicalAddressBits, SystemParameter->VariableMtrrCount,
+      &LocalContext->LocalMtrrs[Index], ActualMemoryRanges, &ActualMemoryRangesCount, &ActualVariableMtrrUsage
+      );
+    UT_ASSERT_EQUAL (
+      VerifyMemoryRanges (LocalContext->ExpectedMemoryRanges[Index], LocalContext->ExpectedMemoryRangesCount[Index], ActualMemoryRanges, ActualMemoryRangesCount),
+      UNIT_TEST_PASSED
+      );
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
 /**
   Test routine to check whether invalid base/size can be rejected.
 
@@ -1031,6 +1300,7 @@ RestorePcdValue (
 
   @param Iteration               Iteration of testing MtrrSetMemoryAttributeInMtrrSettings
                                  and MtrrSetMemoryAttributesInMtrrSettings using random inputs.
+  @param Benchmark               TRUE to also run the MtrrLib Benchmark Suite.
 
   @retval  EFI_SUCCESS           All test cases were dispatched.
   @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
@@ -1040,17 +1310,21 @@ STATIC
 EFI_STATUS
 EFIAPI
 UnitTestingEntry (
-  UINTN                       Iteration
+  UINTN                       Iteration,
+  BOOLEAN                     Benchmark
   )
 {
   EFI_STATUS                                        Status;
   UNIT_TEST_FRAMEWORK_HANDLE                        Framework;
   UNIT_TEST_SUITE_HANDLE                            MtrrApiTests;
+  UNIT_TEST_SUITE_HANDLE                            MtrrBenchmarks;
   UINTN                                             Index;
   UINTN                                             SystemIndex;
   MTRR_LIB_TEST_CONTEXT                             Context;
   MTRR_LIB_GET_FIRMWARE_VARIABLE_MTRR_COUNT_CONTEXT GetFirmwareVariableMtrrCountContext;
+  MTRR_LIB_BENCHMARK_CONTEXT                        BenchmarkContext[ARRAY_SIZE (mSystemParameters)];
 
+  ZeroMem (BenchmarkContext, sizeof (BenchmarkContext));
   Context.SystemParameter                             = &mDefaultSystemParameter;
   GetFirmwareVariableMtrrCountContext.SystemParameter = &mDefaultSystemParameter;
   Framework = NULL;
@@ -1095,6 +1369,25 @@ UnitTestingEntry (
       AddTestCase (MtrrApiTests, "Test MtrrSetMemoryAttributesInMtrrSettings", "MtrrSetMemoryAttributesInMtrrSettings", UnitTestMtrrSetMemoryAttributesInMtrrSettings, InitializeSystem, NULL, &mSystemParameters[SystemIndex]);
     }
   }
+
+  AddTestCase (MtrrApiTests, "Test MtrrSetMemoryAttributesInMtrrSettings with MMIO holes", "MtrrSetMemoryAttributesWithMmioHoles", UnitTestMtrrSetMemoryAttributesWithMmioHoles, InitializeSystem, NULL, &mSystemParameters[5]);
+
+  //
+  // Populate the MtrrLib Benchmark Suite only when it is asked for.
+  //
+  if (Benchmark) {
+    Status = CreateUnitTestSuite (&MtrrBenchmarks, Framework, "MtrrLib Benchmarks", "MtrrLib.Benchmark", NULL, NULL);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for MtrrLib Benchmarks\n"));
+      Status = EFI_OUT_OF_RESOURCES;
+      goto EXIT;
+    }
+    for (SystemIndex = 0; SystemIndex < ARRAY_SIZE (mSystemParameters); SystemIndex++) {
+      BenchmarkContext[SystemIndex].SystemParameter = &mSystemParameters[SystemIndex];
+      AddTestCase (MtrrBenchmarks, "Benchmark MtrrSetMemoryAttributesInMtrrSettings", "MtrrSetMemoryAttributesInMtrrSettingsBenchmark", UnitTestMtrrSetMemoryAttributesInMtrrSettingsBenchmark, BuildBenchmarkLayouts, FreeBenchmarkLayouts, &BenchmarkContext[SystemIndex]);
+    }
+  }
+
   //
   // Execute the tests.
   //
@@ -1123,6 +1416,7 @@ main (
   )
 {
   UINTN    Count;
+  BOOLEAN  Benchmark;
 
   DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
   srand ((unsigned int) time (NULL));
@@ -1140,12 +1434,17 @@ main (
   //
   // MtrrLibUnitTest [<iterations>]
   //                 <iterations> [fixed|random]
+  //                 benchmark
   //   Default <iterations> is 10.
   //   Default uses fixed inputs.
+  //   benchmark also runs the MtrrLib Benchmark Suite with the defaults.
   //
   Count        = 10;
   mRandomInput = FALSE;
-  if ((Argc == 2) || (Argc == 3)) {
+  Benchmark    = FALSE;
+  if ((Argc == 2) && (AsciiStriCmp ("benchmark", Argv[1]) == 0)) {
+    Benchmark = TRUE;
+  } else if ((Argc == 2) || (Argc == 3)) {
     Count = atoi (Argv[1]);
     if (Argc == 3) {
       if (AsciiStriCmp ("fixed", Argv[2]) == 0) {
@@ -1158,6 +1457,7 @@ main (
 
   DEBUG ((DEBUG_INFO, "Iterations = %d\n", Count));
   DEBUG ((DEBUG_INFO, "Input      = %a\n", mRandomInput ? "random" : "fixed"));
+  DEBUG ((DEBUG_INFO, "Benchmark  = %a\n", Benchmark ? "yes" : "no"));
 
-  return UnitTestingEntry (Count);
+  return UnitTestingEntry (Count, Benchmark);
 }
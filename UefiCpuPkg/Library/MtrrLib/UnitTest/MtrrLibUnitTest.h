@@ -34,6 +34,13 @@
 
 #define SCRATCH_BUFFER_SIZE       SIZE_16KB
 
+//
+// Count of the random memory layouts the MTRR settings are calculated for
+// by the MtrrSetMemoryAttributesInMtrrSettings() benchmark.
+//
+#define MTRR_LIB_BENCHMARK_LAYOUT_COUNT  1000
+#define MTRR_LIB_BENCHMARK_SEED          0x4D545252
+
 typedef struct {
   UINT8                  PhysicalAddressBits;
   BOOLEAN                MtrrSupported;
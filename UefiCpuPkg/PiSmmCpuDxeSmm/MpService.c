@@ -116,6 +116,12 @@ LockdownSemaphore (
 /**
   Wait all APs to performs an atomic compare exchange operation to release semaphore.
 
+  Rather than acquiring the BSP Run semaphore once per AP, consume every
+  release that has already been posted with a single compare exchange. This
+  keeps the BSP from contending with the arriving APs on the semaphore cache
+  line once per AP, which dominates SMI rendezvous latency on systems with
+  many threads.
+
   @param   NumberOfAPs      AP number
 
 **/
@@ -124,11 +130,25 @@ WaitForAllAPs (
   IN      UINTN                     NumberOfAPs
   )
 {
-  UINTN                             BspIndex;
+  volatile UINT32                   *Run;
+  UINT32                            Value;
+  UINT32                            Count;
 
-  BspIndex = mSmmMpSyncData->BspIndex;
-  while (NumberOfAPs-- > 0) {
-    WaitForSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+  Run = mSmmMpSyncData->CpuData[mSmmMpSyncData->BspIndex].Run;
+  while (NumberOfAPs > 0) {
+    Value = *Run;
+    if (Value == 0) {
+      CpuPause ();
+      continue;
+    }
+    Count = (UINT32) MIN (Value, NumberOfAPs);
+    if (InterlockedCompareExchange32 (
+          (UINT32*)Run,
+          Value,
+          Value - Count
+          ) == Value) {
+      NumberOfAPs -= Count;
+    }
   }
 }
 